@@ -626,15 +626,18 @@ do {                                                                   \
 /* key comparison function; return 0 if keys equal */
 #define HASH_KEYCMP(a,b,len) memcmp(a,b,len) 
 
+/* whether a key matches another, given both lengths; may be overridden */
+#ifndef HASH_KEYMATCH
+#define HASH_KEYMATCH(a,alen,b,blen) ((alen) == (blen) && HASH_KEYCMP(a,b,alen) == 0)
+#endif
+
 /* iterate over items in a known bucket to find desired item */
 #define HASH_FIND_IN_BKT(tbl,hh,head,keyptr,keylen_in,out)                       \
 do {                                                                             \
  if (head.hh_head) DECLTYPE_ASSIGN(out,ELMT_FROM_HH(tbl,head.hh_head));          \
  else out=NULL;                                                                  \
  while (out) {                                                                   \
-    if ((out)->hh.keylen == keylen_in) {                                           \
-        if ((HASH_KEYCMP((out)->hh.key,keyptr,keylen_in)) == 0) break;             \
-    }                                                                            \
+    if (HASH_KEYMATCH((out)->hh.key,(out)->hh.keylen,keyptr,keylen_in)) break;    \
     if ((out)->hh.hh_next) DECLTYPE_ASSIGN(out,ELMT_FROM_HH(tbl,(out)->hh.hh_next)); \
     else out = NULL;                                                             \
  }                                                                               \
@@ -243,6 +243,19 @@ struct MVMSTable {
      * above). */
     MVMuint16 mode_flags;
 
+    /* Whether objects of this type are allocated straight into the second
+     * generation, since they almost all survive long enough to end up there
+     * anyway. */
+    MVMuint8 pretenure;
+
+    /* Survival statistics the GC keeps to decide the above. While not
+     * pretenured, how many objects were promoted and how many died in the
+     * nursery; while pretenured, how many were allocated and how many then
+     * died in the second generation. Updated without synchronization, as
+     * they are only a heuristic. */
+    MVMuint32 gc_survived;
+    MVMuint32 gc_died;
+
     /* An ID solely for use in caches that last a VM instance. Thus it
      * should never, ever be serialized and you should NEVER make a
      * type directory based upon this ID. Otherwise you'll create memory
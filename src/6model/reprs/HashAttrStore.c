@@ -17,57 +17,45 @@ static MVMObject * type_object_for(MVMThreadContext *tc, MVMObject *HOW) {
     return st->WHAT;
 }
 
-static void extract_key(MVMThreadContext *tc, void **kdata, size_t *klen, MVMObject *key) {
-    MVM_HASH_EXTRACT_KEY(tc, kdata, klen, key, "HashAttrStore representation requires MVMString keys")
+static MVMString * get_key(MVMThreadContext *tc, MVMString *name) {
+    return MVM_HASH_KEY(tc, (MVMObject *)name, "HashAttrStore representation requires MVMString keys");
 }
 
 /* Copies the body of one object to another. */
 static void copy_to(MVMThreadContext *tc, MVMSTable *st, void *src, MVMObject *dest_root, void *dest) {
     MVMHashAttrStoreBody *src_body  = (MVMHashAttrStoreBody *)src;
     MVMHashAttrStoreBody *dest_body = (MVMHashAttrStoreBody *)dest;
-    MVMHashEntry *current, *tmp;
-
-    /* NOTE: if we really wanted to, we could avoid rehashing... */
-    HASH_ITER(hash_handle, src_body->hash_head, current, tmp) {
-        size_t klen;
-        void *kdata;
-        MVMHashEntry *new_entry = malloc(sizeof(MVMHashEntry));
-        MVM_ASSIGN_REF(tc, &(dest_root->header), new_entry->key, current->key);
-        MVM_ASSIGN_REF(tc, &(dest_root->header), new_entry->value, current->value);
-        extract_key(tc, &kdata, &klen, new_entry->key);
-
-        HASH_ADD_KEYPTR(hash_handle, dest_body->hash_head, kdata, klen, new_entry);
+    MVMuint32 i;
+
+    MVM_str_hash_copy(tc, &dest_body->hashtable, &src_body->hashtable);
+    for (i = 0; i < dest_body->hashtable.num_slots; i++) {
+        if (dest_body->hashtable.hashes[i]) {
+            MVMStrHashEntry *entry = &dest_body->hashtable.entries[i];
+            MVM_gc_write_barrier(tc, &(dest_root->header), (MVMCollectable *)entry->key);
+            MVM_gc_write_barrier(tc, &(dest_root->header), (MVMCollectable *)entry->value.o);
+        }
     }
 }
 
 /* Adds held objects to the GC worklist. */
 static void gc_mark(MVMThreadContext *tc, MVMSTable *st, void *data, MVMGCWorklist *worklist) {
     MVMHashAttrStoreBody *body = (MVMHashAttrStoreBody *)data;
-    MVMHashEntry *current, *tmp;
-
-    HASH_ITER(hash_handle, body->hash_head, current, tmp) {
-        MVM_gc_worklist_add(tc, worklist, &current->key);
-        MVM_gc_worklist_add(tc, worklist, &current->value);
-    }
+    MVM_str_hash_gc_mark(tc, &body->hashtable, worklist, 1);
 }
 
 /* Called by the VM in order to free memory associated with this object. */
 static void gc_free(MVMThreadContext *tc, MVMObject *obj) {
     MVMHashAttrStore *h = (MVMHashAttrStore *)obj;
-    MVM_HASH_DESTROY(hash_handle, MVMHashEntry, h->body.hash_head);
+    MVM_str_hash_demolish(tc, &h->body.hashtable);
 }
 
 static void get_attribute(MVMThreadContext *tc, MVMSTable *st, MVMObject *root,
         void *data, MVMObject *class_handle, MVMString *name, MVMint64 hint,
         MVMRegister *result_reg, MVMuint16 kind) {
     MVMHashAttrStoreBody *body = (MVMHashAttrStoreBody *)data;
-    void *kdata;
-    MVMHashEntry *entry;
-    size_t klen;
     if (kind == MVM_reg_obj) {
-        extract_key(tc, &kdata, &klen, (MVMObject *)name);
-        HASH_FIND(hash_handle, body->hash_head, kdata, klen, entry);
-        result_reg->o = entry != NULL ? entry->value : tc->instance->VMNull;
+        MVMStrHashEntry *entry = MVM_str_hash_fetch(tc, &body->hashtable, get_key(tc, name));
+        result_reg->o = entry != NULL ? entry->value.o : tc->instance->VMNull;
     }
     else {
         MVM_exception_throw_adhoc(tc,
@@ -79,22 +67,10 @@ static void bind_attribute(MVMThreadContext *tc, MVMSTable *st, MVMObject *root,
         void *data, MVMObject *class_handle, MVMString *name, MVMint64 hint,
         MVMRegister value_reg, MVMuint16 kind) {
     MVMHashAttrStoreBody *body = (MVMHashAttrStoreBody *)data;
-    void *kdata;
-    MVMHashEntry *entry;
-    size_t klen;
     if (kind == MVM_reg_obj) {
-        extract_key(tc, &kdata, &klen, (MVMObject *)name);
-
-        /* first check whether we must update the old entry. */
-        HASH_FIND(hash_handle, body->hash_head, kdata, klen, entry);
-        if (!entry) {
-            entry = malloc(sizeof(MVMHashEntry));
-            HASH_ADD_KEYPTR(hash_handle, body->hash_head, kdata, klen, entry);
-        }
-        else
-            entry->hash_handle.key = (void *)kdata;
-        MVM_ASSIGN_REF(tc, &(root->header), entry->key, (MVMObject *)name);
-        MVM_ASSIGN_REF(tc, &(root->header), entry->value, value_reg.o);
+        MVMStrHashEntry *entry = MVM_str_hash_lvalue_fetch(tc, &body->hashtable, get_key(tc, name));
+        MVM_ASSIGN_REF(tc, &(root->header), entry->key, name);
+        MVM_ASSIGN_REF(tc, &(root->header), entry->value.o, value_reg.o);
     }
     else {
         MVM_exception_throw_adhoc(tc,
@@ -104,13 +80,7 @@ static void bind_attribute(MVMThreadContext *tc, MVMSTable *st, MVMObject *root,
 
 static MVMint64 is_attribute_initialized(MVMThreadContext *tc, MVMSTable *st, void *data, MVMObject *class_handle, MVMString *name, MVMint64 hint) {
     MVMHashAttrStoreBody *body = (MVMHashAttrStoreBody *)data;
-    void *kdata;
-    MVMHashEntry *entry;
-    size_t klen;
-
-    extract_key(tc, &kdata, &klen, (MVMObject *)name);
-    HASH_FIND(hash_handle, body->hash_head, kdata, klen, entry);
-    return entry != NULL;
+    return MVM_str_hash_fetch(tc, &body->hashtable, get_key(tc, name)) != NULL;
 }
 
 static MVMint64 hint_for(MVMThreadContext *tc, MVMSTable *st, MVMObject *class_handle, MVMString *name) {
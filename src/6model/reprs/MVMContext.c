@@ -42,50 +42,52 @@ static void at_key(MVMThreadContext *tc, MVMSTable *st, MVMObject *root, void *d
     MVMString      *name  = (MVMString *)key;
     MVMContextBody *body  = (MVMContextBody *)data;
     MVMFrame       *frame = body->context;
-    MVMLexicalRegistry *lexical_names = frame->static_info->body.lexical_names, *entry;
-    if (!lexical_names) {
+    MVMStrHashTable *lexical_names = &frame->static_info->body.lexical_names;
+    MVMStrHashEntry *entry;
+    if (!lexical_names->num_items) {
        MVM_exception_throw_adhoc(tc,
             "Lexical with name '%s' does not exist in this frame",
                 MVM_string_utf8_encode_C_string(tc, name));
     }
-    MVM_HASH_GET(tc, lexical_names, name, entry);
+    entry = MVM_str_hash_fetch(tc, lexical_names, name);
     if (!entry) {
        MVM_exception_throw_adhoc(tc,
             "Lexical with name '%s' does not exist in this frame",
                 MVM_string_utf8_encode_C_string(tc, name));
     }
-    if (frame->static_info->body.lexical_types[entry->value] != kind) {
+    if (frame->static_info->body.lexical_types[entry->value.i] != kind) {
        MVM_exception_throw_adhoc(tc,
             "Lexical with name '%s' has a different type in this frame",
                 MVM_string_utf8_encode_C_string(tc, name));
     }
-    *result = frame->env[entry->value];
+    *result = frame->env[entry->value.i];
     if (kind == MVM_reg_obj && !result->o)
-        result->o = MVM_frame_vivify_lexical(tc, frame, entry->value);
+        result->o = MVM_frame_vivify_lexical(tc, frame, entry->value.i);
 }
 
 static void bind_key(MVMThreadContext *tc, MVMSTable *st, MVMObject *root, void *data, MVMObject *key, MVMRegister value, MVMuint16 kind) {
     MVMString      *name  = (MVMString *)key;
     MVMContextBody *body  = (MVMContextBody *)data;
     MVMFrame       *frame = body->context;
-    MVMLexicalRegistry *lexical_names = frame->static_info->body.lexical_names, *entry;
-    if (!lexical_names) {
+    MVMStrHashTable *lexical_names = &frame->static_info->body.lexical_names;
+    MVMStrHashEntry *entry;
+    if (!lexical_names->num_items) {
        MVM_exception_throw_adhoc(tc,
             "Lexical with name '%s' does not exist in this frame",
                 MVM_string_utf8_encode_C_string(tc, name));
     }
-    MVM_HASH_GET(tc, lexical_names, name, entry);
+    entry = MVM_str_hash_fetch(tc, lexical_names, name);
     if (!entry) {
        MVM_exception_throw_adhoc(tc,
             "Lexical with name '%s' does not exist in this frame",
                 MVM_string_utf8_encode_C_string(tc, name));
     }
-    if (frame->static_info->body.lexical_types[entry->value] != kind) {
+    if (frame->static_info->body.lexical_types[entry->value.i] != kind) {
        MVM_exception_throw_adhoc(tc,
             "Lexical with name '%s' has a different type in this frame",
                 MVM_string_utf8_encode_C_string(tc, name));
     }
-    frame->env[entry->value] = value;
+    frame->env[entry->value.i] = value;
 }
 
 static MVMuint64 elems(MVMThreadContext *tc, MVMSTable *st, MVMObject *root, void *data) {
@@ -96,11 +98,12 @@ static MVMuint64 elems(MVMThreadContext *tc, MVMSTable *st, MVMObject *root, voi
 static MVMint64 exists_key(MVMThreadContext *tc, MVMSTable *st, MVMObject *root, void *data, MVMObject *key) {
     MVMContextBody *body = (MVMContextBody *)data;
     MVMFrame *frame = body->context;
-    MVMLexicalRegistry *lexical_names = frame->static_info->body.lexical_names, *entry;
+    MVMStrHashTable *lexical_names = &frame->static_info->body.lexical_names;
+    MVMStrHashEntry *entry;
     MVMString *name = (MVMString *)key;
-    if (!lexical_names)
+    if (!lexical_names->num_items)
         return 0;
-    MVM_HASH_GET(tc, lexical_names, name, entry);
+    entry = MVM_str_hash_fetch(tc, lexical_names, name);
     return entry ? 1 : 0;
 }
 
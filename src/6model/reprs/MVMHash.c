@@ -17,55 +17,45 @@ static MVMObject * type_object_for(MVMThreadContext *tc, MVMObject *HOW) {
     return st->WHAT;
 }
 
-static void extract_key(MVMThreadContext *tc, void **kdata, size_t *klen, MVMObject *key) {
-    MVM_HASH_EXTRACT_KEY(tc, kdata, klen, key, "MVMHash representation requires MVMString keys")
+static MVMString * get_key(MVMThreadContext *tc, MVMObject *key) {
+    return MVM_HASH_KEY(tc, key, "MVMHash representation requires MVMString keys");
 }
 
 /* Copies the body of one object to another. */
 static void copy_to(MVMThreadContext *tc, MVMSTable *st, void *src, MVMObject *dest_root, void *dest) {
     MVMHashBody *src_body  = (MVMHashBody *)src;
     MVMHashBody *dest_body = (MVMHashBody *)dest;
-    MVMHashEntry *current, *tmp;
-
-    /* NOTE: if we really wanted to, we could avoid rehashing... */
-    HASH_ITER(hash_handle, src_body->hash_head, current, tmp) {
-        size_t klen;
-        void *kdata;
-        MVMHashEntry *new_entry = malloc(sizeof(MVMHashEntry));
-        MVM_ASSIGN_REF(tc, &(dest_root->header), new_entry->key, current->key);
-        MVM_ASSIGN_REF(tc, &(dest_root->header), new_entry->value, current->value);
-        extract_key(tc, &kdata, &klen, new_entry->key);
-
-        HASH_ADD_KEYPTR(hash_handle, dest_body->hash_head, kdata, klen, new_entry);
+    MVMuint32 i;
+
+    /* The entries can be copied as they are, since the hash codes are the
+     * same; we just need to do the write barriers for them. */
+    MVM_str_hash_copy(tc, &dest_body->hashtable, &src_body->hashtable);
+    for (i = 0; i < dest_body->hashtable.num_slots; i++) {
+        if (dest_body->hashtable.hashes[i]) {
+            MVMStrHashEntry *entry = &dest_body->hashtable.entries[i];
+            MVM_gc_write_barrier(tc, &(dest_root->header), (MVMCollectable *)entry->key);
+            MVM_gc_write_barrier(tc, &(dest_root->header), (MVMCollectable *)entry->value.o);
+        }
     }
 }
 
 /* Adds held objects to the GC worklist. */
 static void gc_mark(MVMThreadContext *tc, MVMSTable *st, void *data, MVMGCWorklist *worklist) {
     MVMHashBody *body = (MVMHashBody *)data;
-    MVMHashEntry *current, *tmp;
-
-    HASH_ITER(hash_handle, body->hash_head, current, tmp) {
-        MVM_gc_worklist_add(tc, worklist, &current->key);
-        MVM_gc_worklist_add(tc, worklist, &current->value);
-    }
+    MVM_str_hash_gc_mark(tc, &body->hashtable, worklist, 1);
 }
 
 /* Called by the VM in order to free memory associated with this object. */
 static void gc_free(MVMThreadContext *tc, MVMObject *obj) {
     MVMHash *h = (MVMHash *)obj;
-    MVM_HASH_DESTROY(hash_handle, MVMHashEntry, h->body.hash_head);
+    MVM_str_hash_demolish(tc, &h->body.hashtable);
 }
 
 static void at_key(MVMThreadContext *tc, MVMSTable *st, MVMObject *root, void *data, MVMObject *key, MVMRegister *result, MVMuint16 kind) {
     MVMHashBody *body = (MVMHashBody *)data;
-    void *kdata;
-    MVMHashEntry *entry;
-    size_t klen;
-    extract_key(tc, &kdata, &klen, key);
-    HASH_FIND(hash_handle, body->hash_head, kdata, klen, entry);
+    MVMStrHashEntry *entry = MVM_str_hash_fetch(tc, &body->hashtable, get_key(tc, key));
     if (kind == MVM_reg_obj)
-        result->o = entry != NULL ? entry->value : tc->instance->VMNull;
+        result->o = entry != NULL ? entry->value.o : tc->instance->VMNull;
     else
         MVM_exception_throw_adhoc(tc,
             "MVMHash representation does not support native type storage");
@@ -73,58 +63,32 @@ static void at_key(MVMThreadContext *tc, MVMSTable *st, MVMObject *root, void *d
 
 static void bind_key(MVMThreadContext *tc, MVMSTable *st, MVMObject *root, void *data, MVMObject *key, MVMRegister value, MVMuint16 kind) {
     MVMHashBody *body = (MVMHashBody *)data;
-    void *kdata;
-    MVMHashEntry *entry;
-    size_t klen;
-
-    extract_key(tc, &kdata, &klen, key);
+    MVMString *name = get_key(tc, key);
+    MVMStrHashEntry *entry;
 
-    /* first check whether we can must update the old entry. */
-    HASH_FIND(hash_handle, body->hash_head, kdata, klen, entry);
-    if (!entry) {
-        entry = malloc(sizeof(MVMHashEntry));
-        HASH_ADD_KEYPTR(hash_handle, body->hash_head, kdata, klen, entry);
-    }
-    else
-        entry->hash_handle.key = (void *)kdata;
-    MVM_ASSIGN_REF(tc, &(root->header), entry->key, key);
-    if (kind == MVM_reg_obj) {
-        MVM_ASSIGN_REF(tc, &(root->header), entry->value, value.o);
-    }
-    else {
+    if (kind != MVM_reg_obj)
         MVM_exception_throw_adhoc(tc,
             "MVMHash representation does not support native type storage");
-    }
+
+    /* Finds the existing entry, or adds a new one. */
+    entry = MVM_str_hash_lvalue_fetch(tc, &body->hashtable, name);
+    MVM_ASSIGN_REF(tc, &(root->header), entry->key, name);
+    MVM_ASSIGN_REF(tc, &(root->header), entry->value.o, value.o);
 }
 
 static MVMuint64 elems(MVMThreadContext *tc, MVMSTable *st, MVMObject *root, void *data) {
     MVMHashBody *body = (MVMHashBody *)data;
-    return HASH_CNT(hash_handle, body->hash_head);
+    return MVM_str_hash_count(tc, &body->hashtable);
 }
 
 static MVMint64 exists_key(MVMThreadContext *tc, MVMSTable *st, MVMObject *root, void *data, MVMObject *key) {
     MVMHashBody *body = (MVMHashBody *)data;
-    void *kdata;
-    MVMHashEntry *entry;
-    size_t klen;
-    extract_key(tc, &kdata, &klen, key);
-
-    HASH_FIND(hash_handle, body->hash_head, kdata, klen, entry);
-    return entry != NULL;
+    return MVM_str_hash_fetch(tc, &body->hashtable, get_key(tc, key)) != NULL;
 }
 
 static void delete_key(MVMThreadContext *tc, MVMSTable *st, MVMObject *root, void *data, MVMObject *key) {
     MVMHashBody *body = (MVMHashBody *)data;
-    MVMHashEntry *old_entry;
-    size_t klen;
-    void *kdata;
-    extract_key(tc, &kdata, &klen, key);
-
-    HASH_FIND(hash_handle, body->hash_head, kdata, klen, old_entry);
-    if (old_entry) {
-        HASH_DELETE(hash_handle, body->hash_head, old_entry);
-        free(old_entry);
-    }
+    MVM_str_hash_delete(tc, &body->hashtable, get_key(tc, key));
 }
 
 static MVMStorageSpec get_value_storage_spec(MVMThreadContext *tc, MVMSTable *st) {
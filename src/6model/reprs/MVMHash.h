@@ -1,21 +1,8 @@
 /* Representation used by VM-level hashes. */
 
-struct MVMHashEntry {
-    /* key object (must be MVMString REPR) */
-    MVMObject *key;
-
-    /* value object */
-    MVMObject *value;
-
-    /* the uthash hash handle inline struct. */
-    UT_hash_handle hash_handle;
-};
-
 struct MVMHashBody {
-
-    /* uthash updates this pointer directly. */
-    MVMHashEntry *hash_head;
-
+    /* The hash table itself; keys are MVMString, values objects. */
+    MVMStrHashTable hashtable;
 };
 struct MVMHash {
     MVMObject common;
@@ -25,25 +12,23 @@ struct MVMHash {
 /* Function for REPR setup. */
 const MVMREPROps * MVMHash_initialize(MVMThreadContext *tc);
 
-#define MVM_HASH_ACTION(tc, hash, name, entry, action, member, size) \
-    action(hash_handle, hash, \
-        name->body.int32s, NUM_GRAPHS(name) * sizeof(size), entry); \
-
-#define MVM_HASH_ACTION_CACHE(tc, hash, name, entry, action, member, size) \
-    action(hash_handle, hash, name->body.int32s, \
-        NUM_GRAPHS(name) * sizeof(size), name->body.cached_hash_code, entry); \
-
-#define MVM_HASH_ACTION_SELECT(tc, hash, name, entry, action) \
-if (IS_WIDE(name)) \
-    MVM_HASH_ACTION(tc, hash, name, entry, action, int32s, MVMCodepoint32) \
-else \
-    MVM_HASH_ACTION(tc, hash, name, entry, action, uint8s, MVMCodepoint8)
+/* Keys of the uthash based registries are the storage of flat strings,
+ * which may be 8 or 32 bits per grapheme. A key's length is its number of
+ * graphemes, tagged so MVM_string_hash_key_match can tell it's a string and
+ * how wide, and compare keys stored either way. The cached hash code doesn't
+ * depend on the storage either. */
+#define MVM_HASH_KEY_STR  0x80000000
+#define MVM_HASH_KEY_WIDE 0x40000000
+#define MVM_HASH_KEY_LEN(name) \
+    (MVM_HASH_KEY_STR | (IS_WIDE(name) ? MVM_HASH_KEY_WIDE : 0) | NUM_GRAPHS(name))
 
 #define MVM_HASH_ACTION_SELECT_CACHE(tc, hash, name, entry, action) \
-if (IS_WIDE(name)) \
-    MVM_HASH_ACTION_CACHE(tc, hash, name, entry, action, int32s, MVMCodepoint32) \
-else \
-    MVM_HASH_ACTION_CACHE(tc, hash, name, entry, action, uint8s, MVMCodepoint8)
+{ \
+    MVM_string_flatten(tc, name); \
+    MVM_string_hash_code(tc, name); \
+    action(hash_handle, hash, name->body.storage, MVM_HASH_KEY_LEN(name), \
+        name->body.cached_hash_code, entry); \
+}
 
 #define MVM_HASH_BIND(tc, hash, name, entry) \
     MVM_HASH_ACTION_SELECT_CACHE(tc, hash, name, entry, HASH_ADD_KEYPTR_CACHE)
@@ -51,21 +36,10 @@ else \
 #define MVM_HASH_GET(tc, hash, name, entry) \
     MVM_HASH_ACTION_SELECT_CACHE(tc, hash, name, entry, HASH_FIND_CACHE)
 
-#define MVM_HASH_EXTRACT_KEY(tc, kdata, klen, key, error) \
-if (REPR(key)->ID == MVM_REPR_ID_MVMString && IS_CONCRETE(key)) { \
-    MVM_string_flatten(tc, (MVMString *)key); \
-    if (IS_WIDE(key)) { \
-        *kdata = ((MVMString *)key)->body.int32s; \
-        *klen  = ((MVMString *)key)->body.graphs * sizeof(MVMCodepoint32); \
-    } \
-    else { \
-        *kdata = ((MVMString *)key)->body.uint8s; \
-        *klen  = ((MVMString *)key)->body.graphs * sizeof(MVMCodepoint8); \
-    } \
-} \
-else { \
-    MVM_exception_throw_adhoc(tc, error); \
-}
+#define MVM_HASH_KEY(tc, key, error) \
+    (REPR(key)->ID == MVM_REPR_ID_MVMString && IS_CONCRETE(key) \
+        ? (MVMString *)(key) \
+        : (MVM_exception_throw_adhoc(tc, error), (MVMString *)NULL))
 
 #define MVM_HASH_DESTROY(hash_handle, hashentry_type, head_node) do { \
     hashentry_type *current, *tmp; \
@@ -103,19 +103,11 @@ static void shift(MVMThreadContext *tc, MVMSTable *st, MVMObject *root, void *da
             }
             return;
         case MVM_ITER_MODE_HASH:
-            if (!body->hash_state.curr) {
-                if (body->hash_state.next) {
-                    body->hash_state.curr = body->hash_state.next;
-                    body->hash_state.next = body->hash_state.next->hash_handle.next;
-                }
-                else {
-                    MVM_exception_throw_adhoc(tc, "Iteration past end of iterator");
-                }
-            }
-            else {
-                body->hash_state.curr = body->hash_state.curr->hash_handle.next;
-                body->hash_state.next = body->hash_state.curr->hash_handle.next;
-            }
+            if (!body->hash_state.next)
+                MVM_exception_throw_adhoc(tc, "Iteration past end of iterator");
+            body->hash_state.curr = body->hash_state.next;
+            body->hash_state.next = MVM_str_hash_next(tc,
+                &((MVMHash *)target)->body.hashtable, body->hash_state.curr);
             value->o = root;
             return;
         default:
@@ -212,7 +204,9 @@ MVMObject * MVM_iter(MVMThreadContext *tc, MVMObject *target) {
             iterator = (MVMIter *)MVM_repr_alloc_init(tc,
                 MVM_hll_current(tc)->hash_iterator_type);
             iterator->body.mode = MVM_ITER_MODE_HASH;
-            iterator->body.hash_state.next = ((MVMHash *)target)->body.hash_head;
+            iterator->body.hash_state.curr = 0;
+            iterator->body.hash_state.next = MVM_str_hash_first(tc,
+                &((MVMHash *)target)->body.hashtable);
             MVM_ASSIGN_REF(tc, &(iterator->common.header), iterator->body.target, target);
         }
         else if (REPR(target)->ID == MVM_REPR_ID_MVMContext) {
@@ -222,12 +216,13 @@ MVMObject * MVM_iter(MVMThreadContext *tc, MVMObject *target) {
             MVMROOT(tc, ctx_hash, {
                 MVMContext *ctx = (MVMContext *)target;
                 MVMFrame *frame = ctx->body.context;
-                MVMLexicalRegistry *lexical_names = frame->static_info->body.lexical_names;
-                MVMLexicalRegistry *current;
-                MVMLexicalRegistry *tmp;
-                HASH_ITER(hash_handle, lexical_names, current, tmp) {
+                MVMStrHashTable *lexical_names = &frame->static_info->body.lexical_names;
+                MVMStrHashIterator pos = MVM_str_hash_first(tc, lexical_names);
+                while (pos) {
                     /* XXX For now, just the symbol names is enough. */
-                    MVM_repr_bind_key_o(tc, ctx_hash, (MVMString *)current->key, NULL);
+                    MVM_repr_bind_key_o(tc, ctx_hash,
+                        MVM_str_hash_current(tc, lexical_names, pos)->key, NULL);
+                    pos = MVM_str_hash_next(tc, lexical_names, pos);
                 }
             });
 
@@ -252,20 +247,28 @@ MVMint64 MVM_iter_istrue(MVMThreadContext *tc, MVMIter *iter) {
             return iter->body.array_state.index + 1 < iter->body.array_state.limit ? 1 : 0;
             break;
         case MVM_ITER_MODE_HASH:
-            return iter->body.hash_state.next != NULL ? 1 : 0;
+            return iter->body.hash_state.next != 0 ? 1 : 0;
             break;
         default:
             MVM_exception_throw_adhoc(tc, "Invalid iteration mode used");
     }
 }
 
+/* Gets the hash entry a hash iterator is currently at. */
+static MVMStrHashEntry * current_entry(MVMThreadContext *tc, MVMIter *iterator) {
+    MVMStrHashEntry *entry = MVM_str_hash_current(tc,
+        &((MVMHash *)iterator->body.target)->body.hashtable,
+        iterator->body.hash_state.curr);
+    if (!entry)
+        MVM_exception_throw_adhoc(tc, "You have not advanced to the first item of the hash iterator, or have gone past the end");
+    return entry;
+}
+
 MVMString * MVM_iterkey_s(MVMThreadContext *tc, MVMIter *iterator) {
     if (REPR(iterator)->ID != MVM_REPR_ID_MVMIter
             || iterator->body.mode != MVM_ITER_MODE_HASH)
         MVM_exception_throw_adhoc(tc, "This is not a hash iterator");
-    if (!iterator->body.hash_state.curr)
-        MVM_exception_throw_adhoc(tc, "You have not advanced to the first item of the hash iterator, or have gone past the end");
-    return (MVMString *)iterator->body.hash_state.curr->key;
+    return current_entry(tc, iterator)->key;
 }
 
 MVMObject * MVM_iterval(MVMThreadContext *tc, MVMIter *iterator) {
@@ -282,9 +285,7 @@ MVMObject * MVM_iterval(MVMThreadContext *tc, MVMIter *iterator) {
         REPR(target)->pos_funcs.at_pos(tc, STABLE(target), target, OBJECT_BODY(target), body->array_state.index, &result, MVM_reg_obj);
     }
     else if (iterator->body.mode == MVM_ITER_MODE_HASH) {
-        if (!iterator->body.hash_state.curr)
-        MVM_exception_throw_adhoc(tc, "You have not advanced to the first item of the hash iterator, or have gone past the end");
-        result.o = iterator->body.hash_state.curr->value;
+        result.o = current_entry(tc, iterator)->value.o;
         if (!result.o)
             result.o = tc->instance->VMNull;
     }
@@ -16,8 +16,8 @@ struct MVMIterBody {
     /* next hash item to give or next array index */
     union {
         struct {
-            MVMHashEntry *next;
-            MVMHashEntry *curr;
+            MVMStrHashIterator next;
+            MVMStrHashIterator curr;
         } hash_state;
         struct {
             MVMint64 index;
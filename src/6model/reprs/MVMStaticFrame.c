@@ -61,21 +61,14 @@ static void copy_to(MVMThreadContext *tc, MVMSTable *st, void *src, MVMObject *d
         dest_body->lexical_types = lexical_types;
     }
     {
-        MVMLexicalRegistry *current, *tmp;
-
-        /* NOTE: if we really wanted to, we could avoid rehashing... */
-        HASH_ITER(hash_handle, src_body->lexical_names, current, tmp) {
-            size_t klen;
-            void *kdata;
-            MVMLexicalRegistry *new_entry = malloc(sizeof(MVMLexicalRegistry));
-
-            /* don't need to clone the string */
-            MVM_ASSIGN_REF(tc, &(dest_root->header), new_entry->key, current->key);
-            new_entry->value = current->value;
-
-            MVM_HASH_EXTRACT_KEY(tc, &kdata, &klen, current->key, "really broken")
-            HASH_ADD_KEYPTR(hash_handle, dest_body->lexical_names, kdata, klen, new_entry);
-        }
+        MVMuint32 i;
+
+        /* The keys are the same strings, so just need write barriers. */
+        MVM_str_hash_copy(tc, &dest_body->lexical_names, &src_body->lexical_names);
+        for (i = 0; i < dest_body->lexical_names.num_slots; i++)
+            if (dest_body->lexical_names.hashes[i])
+                MVM_gc_write_barrier(tc, &(dest_root->header),
+                    (MVMCollectable *)dest_body->lexical_names.entries[i].key);
     }
 
     /* Static environment needs to be copied, and any objects WB'd. */
@@ -116,7 +109,6 @@ static void copy_to(MVMThreadContext *tc, MVMSTable *st, void *src, MVMObject *d
 /* Adds held objects to the GC worklist. */
 static void gc_mark(MVMThreadContext *tc, MVMSTable *st, void *data, MVMGCWorklist *worklist) {
     MVMStaticFrameBody *body = (MVMStaticFrameBody *)data;
-    MVMLexicalRegistry *current, *tmp;
 
     /* mvmobjects */
     MVM_gc_worklist_add(tc, worklist, &body->cu);
@@ -125,9 +117,12 @@ static void gc_mark(MVMThreadContext *tc, MVMSTable *st, void *data, MVMGCWorkli
     MVM_gc_worklist_add(tc, worklist, &body->outer);
     MVM_gc_worklist_add(tc, worklist, &body->static_code);
 
-    /* lexical names hash keys */
-    HASH_ITER(hash_handle, body->lexical_names, current, tmp) {
-        MVM_gc_worklist_add(tc, worklist, &current->key);
+    /* lexical names hash keys, and the same names in the list */
+    MVM_str_hash_gc_mark(tc, &body->lexical_names, worklist, 0);
+    if (body->lexical_names_list) {
+        MVMuint32 i;
+        for (i = 0; i < body->num_lexicals; i++)
+            MVM_gc_worklist_add(tc, worklist, &body->lexical_names_list[i]);
     }
 
     /* static env */
@@ -175,7 +170,7 @@ static void gc_free(MVMThreadContext *tc, MVMObject *obj) {
     MVM_checked_free_null(body->lexical_types);
     MVM_checked_free_null(body->lexical_names_list);
     MVM_checked_free_null(body->instr_offsets);
-    MVM_HASH_DESTROY(hash_handle, MVMLexicalRegistry, body->lexical_names);
+    MVM_str_hash_demolish(tc, &body->lexical_names);
     if (body->orig_bytecode != body->bytecode) {
         free(body->bytecode);
         body->bytecode = body->orig_bytecode;
@@ -12,9 +12,10 @@ struct MVMStaticFrameBody {
     /* The list of lexical types. */
     MVMuint16 *lexical_types;
 
-    /* Lexicals name map. */
-    MVMLexicalRegistry *lexical_names;
-    MVMLexicalRegistry **lexical_names_list;
+    /* Lexicals name map, from name to lexical index, and the names in
+     * index order. */
+    MVMStrHashTable lexical_names;
+    MVMString **lexical_names_list;
 
     /* Defaults for lexicals upon new frame creation. */
     MVMRegister *static_env;
@@ -32,11 +33,20 @@ struct MVMStaticFrameBody {
      * count, but that's fine; it's just a rough indicator, used to make
      * decisions about optimization. */
     MVMuint32 invocations;
-    
+
+    /* Rough count of backward branches taken in this frame's code, so loop
+     * iterations; counted in the same way as invocations, and added to them
+     * to tell how hot the frame is. */
+    MVMuint32 back_edges;
+
     /* Specializations array, if there are any. */
     MVMSpeshCandidate *spesh_candidates;
     MVMuint32          num_spesh_candidates;
 
+    /* Non-zero while the spesh worker has a candidate to set up for this
+     * frame, so it's only asked for one at a time. */
+    AO_t spesh_setup_pending;
+
     /* The size in bytes to allocate for the lexical environment. */
     MVMuint32 env_size;
 
@@ -22,7 +22,7 @@ static void copy_to(MVMThreadContext *tc, MVMSTable *st, void *src, MVMObject *d
     MVMStringBody *src_body  = (MVMStringBody *)src;
     MVMStringBody *dest_body = (MVMStringBody *)dest;
     dest_body->codes  = src_body->codes;
-    dest_body->flags  = src_body->flags;
+    dest_body->flags  = src_body->flags & MVM_STRING_TYPE_MASK;
     switch(src_body->flags & MVM_STRING_TYPE_MASK) {
         case MVM_STRING_TYPE_INT32:
             if ((dest_body->graphs = src_body->graphs)) {
@@ -64,6 +64,8 @@ static void gc_mark(MVMThreadContext *tc, MVMSTable *st, void *data, MVMGCWorkli
 /* Called by the VM in order to free memory associated with this object. */
 static void gc_free(MVMThreadContext *tc, MVMObject *obj) {
     MVMString *str = (MVMString *)obj;
+    if (str->body.flags & MVM_STRING_INTERNED)
+        MVM_string_intern_remove(tc, str);
     MVM_checked_free_null(str->body.storage);
     str->body.graphs = str->body.codes = str->body.flags = 0;
 }
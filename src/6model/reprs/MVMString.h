@@ -2,13 +2,18 @@
 
 typedef MVMuint32 MVMStrandIndex;
 typedef MVMint32 MVMCodepoint32;
-/* 8-bit-only (optimization) strings don't have synthetics
+/* 32-bit strings are in NFG, with synthetics (see strings/nfg.h) as
+negative codepoints. 8-bit-only (optimization) strings don't have synthetics.
 Note though that an enormous 8-bit string can have a tiny
 wide synthetic codepoint in the middle of it via the
 strands system.  Another thing to optimize someday [soon]. */
 typedef MVMuint8 MVMCodepoint8;
 typedef MVMuint64 MVMStringIndex;
 
+/* The most graphemes a string may have; lengths and offsets are passed
+ * around in 32 bits in places. */
+#define MVM_STRING_MAX_GRAPHS 0xFFFFFFFFULL
+
 /* An entry in the strands table of a rope. */
 struct MVMStrand {
     union {
@@ -32,8 +37,11 @@ struct MVMStrand {
         MVMStringIndex strand_depth;
     };
 
-    /* repeat count. currently unused. */
-    /* MVMStringIndex repeat_count; */
+    /* The number of times the part of the referred string the strand
+        covers is repeated; the strand's length is this times the
+        length of that part. It's 1 for strands made by anything but
+        repeat. */
+    MVMStringIndex repeat_count;
 };
 
 #define MVM_STRING_TYPE_INT32 0
@@ -41,6 +49,9 @@ struct MVMStrand {
 #define MVM_STRING_TYPE_ROPE 2
 #define MVM_STRING_TYPE_MASK 3
 
+/* Flag set on strings in the instance's intern table. */
+#define MVM_STRING_INTERNED 4
+
 struct MVMStringBody {
     /* The string data (signed integer or unsigned char array
         of graphemes or strands). */
@@ -55,10 +66,9 @@ struct MVMStringBody {
         /* For a rope, An array of MVMStrand, each representing a
             segment of the string, up to the last one, which
             represents the end of the string and has values
-            compare_offset=#graphs, string=null, string_offset=0,
-            lower_index=0, higher_index=0.  The first one has
-            compare_offset=0, and lower/higher_index=midpoint of
-            strand array. */
+            compare_offset=#graphs, string=null, strand_depth=1.
+            The strands only ever refer to flat (int32 or uint8)
+            strings, so a rope is never more than one level deep. */
         MVMStrand *strands;
 
         /* generic pointer for the union */
@@ -75,14 +85,16 @@ struct MVMStringBody {
     };
 
     /* The number of codepoints the string is
-        made up of were it not in NFG form. Lazily populated and cached.
+        made up of were it not in NFG form. Lazily populated and cached
+        by MVM_string_codes.
      */
     MVMStringIndex codes;
 
-    /* Cached hash code. */
+    /* Cached hash code, or 0 if it's not been computed yet. */
     unsigned cached_hash_code;
 
-    /* Lowest 2 bits: type of string: int32, uint8, or Rope. */
+    /* Lowest 2 bits: type of string: int32, uint8, or Rope. Above them,
+        MVM_STRING_INTERNED. */
     MVMuint8 flags;
 };
 struct MVMString {
@@ -308,135 +308,199 @@ static MVMint64 quicksort(MVMint64 *arr, MVMint64 elements) {
     return 1;
 }
 
+/* Makes sure the scratch space has room for the specified number of fates.
+ * New fate stamps are zeroed, which is before any generation. */
+static void grow_fates(MVMNFAScratch *scratch, MVMint64 num_fates) {
+    MVMint64 old = scratch->alloc_fates;
+    if (num_fates <= old)
+        return;
+    scratch->fates     = realloc(scratch->fates, num_fates * sizeof(MVMint64));
+    scratch->fate_seen = realloc(scratch->fate_seen, num_fates * sizeof(MVMint64));
+    memset(scratch->fate_seen + old, 0, (num_fates - old) * sizeof(MVMint64));
+    scratch->alloc_fates = num_fates;
+}
+
+/* Gets this thread's NFA scratch space, making sure it has room for the
+ * specified number of states and fates. */
+static MVMNFAScratch * get_scratch(MVMThreadContext *tc, MVMint64 num_states, MVMint64 num_fates) {
+    MVMNFAScratch *scratch = tc->nfa_scratch;
+    if (!scratch)
+        scratch = tc->nfa_scratch = calloc(1, sizeof(MVMNFAScratch));
+    if (num_states > scratch->alloc_states) {
+        MVMint64 old = scratch->alloc_states;
+        scratch->done   = realloc(scratch->done, num_states * sizeof(MVMint64));
+        scratch->queued = realloc(scratch->queued, num_states * sizeof(MVMint64));
+        scratch->curst  = realloc(scratch->curst, num_states * sizeof(MVMint64));
+        scratch->nextst = realloc(scratch->nextst, num_states * sizeof(MVMint64));
+        memset(scratch->done + old, 0, (num_states - old) * sizeof(MVMint64));
+        memset(scratch->queued + old, 0, (num_states - old) * sizeof(MVMint64));
+        scratch->alloc_states = num_states;
+    }
+    grow_fates(scratch, num_fates);
+    return scratch;
+}
+
+/* Frees a thread's NFA scratch space. */
+void MVM_nfa_destroy_scratch(MVMThreadContext *tc) {
+    MVMNFAScratch *scratch = tc->nfa_scratch;
+    if (scratch) {
+        MVM_checked_free_null(scratch->done);
+        MVM_checked_free_null(scratch->queued);
+        MVM_checked_free_null(scratch->curst);
+        MVM_checked_free_null(scratch->nextst);
+        MVM_checked_free_null(scratch->fates);
+        MVM_checked_free_null(scratch->fate_seen);
+        MVM_checked_free_null(tc->nfa_scratch);
+    }
+}
+
 /* Does a run of the NFA. Produces a list of integers indicating the
- * chosen ordering. */
-static MVMint64 * nqp_nfa_run(MVMThreadContext *tc, MVMNFABody *nfa, MVMString *target, MVMint64 offset, MVMint64 *total_fates_out) {
-    MVMint64  eos     = NUM_GRAPHS(target);
-    MVMint64  gen     = 1;
-    MVMint64  numcur  = 0;
-    MVMint64  numnext = 0;
-    MVMint64 *done, *fates, *curst, *nextst;
-    MVMint64  i, fate_arr_len, num_states, total_fates, prev_fates;
-
-    /* Allocate "done states", "current states" and "next states" arrays. */
-    num_states = nfa->num_states;
-    done   = (MVMint64 *)malloc((num_states + 1) * sizeof(MVMint64));
-    curst  = (MVMint64 *)malloc((num_states + 1) * sizeof(MVMint64));
-    nextst = (MVMint64 *)malloc((num_states + 1) * sizeof(MVMint64));
-    memset(done, 0, (num_states + 1) * sizeof(MVMint64));
-
-    /* Allocate fates array. */
-    fate_arr_len = 1 + MVM_repr_elems(tc, nfa->fates);
-    fates = (MVMint64 *)malloc(sizeof(MVMint64) * fate_arr_len);
-    total_fates = 0;
-
-    nextst[numnext++] = 1;
+ * chosen ordering, which lives in the thread's scratch space and so is only
+ * good until the next run.
+ *
+ * The states at each offset are worked through as a set: a state is added
+ * to the current or next set only if it's not in there already, so that
+ * it's looked at once per offset. The order they're looked at in doesn't
+ * matter, as the fates found at an offset are sorted afterwards. The
+ * codepoint at each offset is read once, with a cursor, rather than once
+ * per edge. */
+static MVMint64 nqp_nfa_run(MVMThreadContext *tc, MVMNFABody *nfa, MVMString *target, MVMint64 offset, MVMint64 **fates_out) {
+    MVMint64        eos          = NUM_GRAPHS(target);
+    MVMint64        num_states   = nfa->num_states;
+    MVMint64        fate_arr_len = 1 + MVM_repr_elems(tc, nfa->fates);
+    MVMNFAScratch  *scratch      = get_scratch(tc, num_states + 1, fate_arr_len);
+    MVMint64       *done         = scratch->done;
+    MVMint64       *queued       = scratch->queued;
+    MVMint64       *curst        = scratch->curst;
+    MVMint64       *nextst       = scratch->nextst;
+    MVMint64       *fates        = scratch->fates;
+    MVMint64       *fate_seen    = scratch->fate_seen;
+    MVMint64        run_gen      = ++scratch->gen;
+    MVMint64        gen          = run_gen;
+    MVMint64        numcur       = 0;
+    MVMint64        numnext      = 0;
+    MVMint64        total_fates  = 0;
+    MVMint64        i, prev_fates;
+    MVMStringCursor cursor;
+
+    if (offset >= 0 && offset < eos)
+        MVM_string_cursor_init(tc, &cursor, target, offset, eos - offset);
+    else
+        cursor.remaining = 0;
+
+    if (num_states > 0)
+        nextst[numnext++] = 1;
     while (numnext && offset <= eos) {
-        /* Swap next and current */
-        MVMint64 *temp = curst;
+        /* Swap next and current, marking everything we start with as done. */
+        MVMint64      *temp   = curst;
+        MVMuint8       has_cp = cursor.remaining > 0;
+        MVMCodepoint32 cp     = has_cp ? MVM_string_cursor_next(tc, &cursor) : 0;
         curst   = nextst;
         nextst  = temp;
         numcur  = numnext;
         numnext = 0;
 
+        /* States are stamped done with this offset's generation, and queued
+         * with the next one. Both are claimed in the scratch space before
+         * anything is stamped, so that if anything throws, the next run
+         * still starts with a generation that was never used. */
+        scratch->gen = gen + 1;
+        for (i = 0; i < numcur; i++)
+            done[curst[i]] = gen;
+
         /* Save how many fates we have before this position is considered. */
         prev_fates = total_fates;
 
         while (numcur) {
-            MVMNFAStateInfo *edge_info;
-            MVMint64         edge_info_elems;
-
-            MVMint64 st = curst[--numcur];
-            if (st <= num_states) {
-                if (done[st] == gen)
-                    continue;
-                done[st] = gen;
-            }
-
-            edge_info = nfa->states[st - 1];
-            edge_info_elems = nfa->num_state_edges[st - 1];
+            MVMint64         st              = curst[--numcur];
+            MVMNFAStateInfo *edge_info       = nfa->states[st - 1];
+            MVMint64         edge_info_elems = nfa->num_state_edges[st - 1];
             for (i = 0; i < edge_info_elems; i++) {
                 MVMint64 act = edge_info[i].act;
                 MVMint64 to  = edge_info[i].to;
+                MVMint64 matched;
 
                 if (act == MVM_NFA_EDGE_FATE) {
-                    /* Crossed a fate edge. Check if we already saw this, and
-                     * if so bump the entry we already saw. */
-                    MVMint64 arg = edge_info[i].arg.i;
-                    MVMint64 j;
+                    /* Crossed a fate edge. If it's one we've not seen in
+                     * this run, just add it; otherwise, move the entry we
+                     * already have to the end. */
+                    MVMint64 arg        = edge_info[i].arg.i;
                     MVMint64 found_fate = 0;
-                    for (j = 0; j < total_fates; j++) {
-                        if (found_fate)
-                            fates[j - 1] = fates[j];
-                        if (fates[j] == arg) {
-                            found_fate = 1;
-                            if (j < prev_fates)
-                                prev_fates--;
-                        }
-                    }
-                    if (found_fate) {
-                        fates[total_fates - 1] = arg;
+                    if (arg >= 0 && arg < fate_arr_len && fate_seen[arg] != run_gen) {
+                        fate_seen[arg] = run_gen;
                     }
                     else {
-                        if (total_fates >= fate_arr_len) {
-                            fate_arr_len = total_fates + 1;
-                            fates = (MVMint64 *)realloc(fates,
-                                sizeof(MVMint64) * fate_arr_len);
+                        MVMint64 j;
+                        for (j = 0; j < total_fates; j++) {
+                            if (found_fate)
+                                fates[j - 1] = fates[j];
+                            if (fates[j] == arg) {
+                                found_fate = 1;
+                                if (j < prev_fates)
+                                    prev_fates--;
+                            }
+                        }
+                        if (found_fate)
+                            fates[total_fates - 1] = arg;
+                    }
+                    if (!found_fate) {
+                        if (total_fates >= scratch->alloc_fates) {
+                            grow_fates(scratch, total_fates + 1);
+                            fates     = scratch->fates;
+                            fate_seen = scratch->fate_seen;
                         }
                         fates[total_fates++] = arg;
                     }
+                    continue;
                 }
-                else if (act == MVM_NFA_EDGE_EPSILON && to <= num_states && done[to] != gen) {
-                    curst[numcur++] = to;
-                }
-                else if (offset >= eos) {
-                    /* Can't match, so drop state. */
-                }
-                else if (act == MVM_NFA_EDGE_CODEPOINT) {
-                    MVMint64 arg = edge_info[i].arg.i;
-                    if (MVM_string_get_codepoint_at_nocheck(tc, target, offset) == arg)
-                        nextst[numnext++] = to;
-                }
-                else if (act == MVM_NFA_EDGE_CODEPOINT_NEG) {
-                    MVMint64 arg = edge_info[i].arg.i;
-                    if (MVM_string_get_codepoint_at_nocheck(tc, target, offset) != arg)
-                        nextst[numnext++] = to;
-                }
-                else if (act == MVM_NFA_EDGE_CHARCLASS) {
-                    MVMint64 arg = edge_info[i].arg.i;
-                    if (MVM_string_is_cclass(tc, arg, target, offset))
-                        nextst[numnext++] = to;
-                }
-                else if (act == MVM_NFA_EDGE_CHARCLASS_NEG) {
-                    MVMint64 arg = edge_info[i].arg.i;
-                    if (!MVM_string_is_cclass(tc, arg, target, offset))
-                        nextst[numnext++] = to;
-                }
-                else if (act == MVM_NFA_EDGE_CHARLIST) {
-                    MVMString *arg    = edge_info[i].arg.s;
-                    MVMCodepoint32 cp = MVM_string_get_codepoint_at_nocheck(tc, target, offset);
-                    if (MVM_string_index_of_codepoint(tc, arg, cp) >= 0)
-                        nextst[numnext++] = to;
-                }
-                else if (act == MVM_NFA_EDGE_CHARLIST_NEG) {
-                    MVMString *arg    = edge_info[i].arg.s;
-                    MVMCodepoint32 cp = MVM_string_get_codepoint_at_nocheck(tc, target, offset);
-                    if (MVM_string_index_of_codepoint(tc, arg, cp) < 0)
-                        nextst[numnext++] = to;
+
+                /* Only states we have are worth following. */
+                if (to <= 0 || to > num_states)
+                    continue;
+
+                if (act == MVM_NFA_EDGE_EPSILON) {
+                    if (done[to] != gen) {
+                        done[to] = gen;
+                        curst[numcur++] = to;
+                    }
+                    continue;
                 }
-                else if (act == MVM_NFA_EDGE_CODEPOINT_I) {
-                    MVMCodepoint32 uc_arg = edge_info[i].arg.uclc.uc;
-                    MVMCodepoint32 lc_arg = edge_info[i].arg.uclc.lc;
-                    MVMCodepoint32 ord    = MVM_string_get_codepoint_at_nocheck(tc, target, offset);
-                    if (ord == lc_arg || ord == uc_arg)
-                        nextst[numnext++] = to;
+
+                /* At the end of the string we can't match, so drop state. */
+                if (!has_cp)
+                    continue;
+
+                switch (act) {
+                    case MVM_NFA_EDGE_CODEPOINT:
+                        matched = cp == edge_info[i].arg.i;
+                        break;
+                    case MVM_NFA_EDGE_CODEPOINT_NEG:
+                        matched = cp != edge_info[i].arg.i;
+                        break;
+                    case MVM_NFA_EDGE_CHARCLASS:
+                        matched = MVM_string_codepoint_is_cclass(tc, edge_info[i].arg.i, cp);
+                        break;
+                    case MVM_NFA_EDGE_CHARCLASS_NEG:
+                        matched = !MVM_string_codepoint_is_cclass(tc, edge_info[i].arg.i, cp);
+                        break;
+                    case MVM_NFA_EDGE_CHARLIST:
+                        matched = MVM_string_index_of_codepoint(tc, edge_info[i].arg.s, cp) >= 0;
+                        break;
+                    case MVM_NFA_EDGE_CHARLIST_NEG:
+                        matched = MVM_string_index_of_codepoint(tc, edge_info[i].arg.s, cp) < 0;
+                        break;
+                    case MVM_NFA_EDGE_CODEPOINT_I:
+                        matched = cp == edge_info[i].arg.uclc.lc || cp == edge_info[i].arg.uclc.uc;
+                        break;
+                    case MVM_NFA_EDGE_CODEPOINT_I_NEG:
+                        matched = cp != edge_info[i].arg.uclc.lc && cp != edge_info[i].arg.uclc.uc;
+                        break;
+                    default:
+                        matched = 0;
                 }
-                else if (act == MVM_NFA_EDGE_CODEPOINT_I_NEG) {
-                    MVMCodepoint32 uc_arg = edge_info[i].arg.uclc.uc;
-                    MVMCodepoint32 lc_arg = edge_info[i].arg.uclc.lc;
-                    MVMCodepoint32 ord    = MVM_string_get_codepoint_at_nocheck(tc, target, offset);
-                    if (ord != lc_arg && ord != uc_arg)
-                        nextst[numnext++] = to;
+                if (matched && queued[to] != gen + 1) {
+                    queued[to] = gen + 1;
+                    nextst[numnext++] = to;
                 }
             }
         }
@@ -457,26 +521,23 @@ static MVMint64 * nqp_nfa_run(MVMThreadContext *tc, MVMNFABody *nfa, MVMString *
                 fates[i] = -fates[i];
         }
     }
-    free(done);
-    free(curst);
-    free(nextst);
 
-    *total_fates_out = total_fates;
-    return fates;
+    *fates_out = fates;
+    return total_fates;
 }
 
 /* Takes an NFA, a target string in and an offset. Runs the NFA and returns
  * the order to try the fates in. */
 MVMObject * MVM_nfa_run_proto(MVMThreadContext *tc, MVMObject *nfa, MVMString *target, MVMint64 offset) {
     /* Run the NFA. */
-    MVMint64  total_fates, i;
-    MVMint64 *fates = nqp_nfa_run(tc, (MVMNFABody *)OBJECT_BODY(nfa), target, offset, &total_fates);
+    MVMint64 *fates;
+    MVMint64  i;
+    MVMint64  total_fates = nqp_nfa_run(tc, (MVMNFABody *)OBJECT_BODY(nfa), target, offset, &fates);
 
     /* Copy results into an integer array. */
     MVMObject *fateres = MVM_repr_alloc_init(tc, tc->instance->boot_types.BOOTIntArray);
     for (i = 0; i < total_fates; i++)
         MVM_repr_bind_pos_i(tc, fateres, i, fates[i]);
-    free(fates);
 
     return fateres;
 }
@@ -488,8 +549,9 @@ MVMObject * MVM_nfa_run_proto(MVMThreadContext *tc, MVMObject *nfa, MVMString *t
 void MVM_nfa_run_alt(MVMThreadContext *tc, MVMObject *nfa, MVMString *target,
         MVMint64 offset, MVMObject *bstack, MVMObject *cstack, MVMObject *labels) {
     /* Run the NFA. */
-    MVMint64  total_fates, i;
-    MVMint64 *fates = nqp_nfa_run(tc, (MVMNFABody *)OBJECT_BODY(nfa), target, offset, &total_fates);
+    MVMint64 *fates;
+    MVMint64  i;
+    MVMint64  total_fates = nqp_nfa_run(tc, (MVMNFABody *)OBJECT_BODY(nfa), target, offset, &fates);
 
     /* Push the results onto the bstack. */
     MVMint64 caps = cstack && IS_CONCRETE(cstack)
@@ -501,5 +563,4 @@ void MVM_nfa_run_alt(MVMThreadContext *tc, MVMObject *nfa, MVMString *target,
         MVM_repr_push_i(tc, bstack, 0);
         MVM_repr_push_i(tc, bstack, caps);
     }
-    free(fates);
 }
@@ -37,6 +37,29 @@ struct MVMNFA {
     MVMNFABody body;
 };
 
+/* Scratch space for running NFAs, kept per thread so that a run need not
+ * allocate. The arrays indexed by state hold generation stamps rather than
+ * flags; the generation goes up at each offset of every run and is never
+ * reset, so nothing needs clearing between runs. */
+struct MVMNFAScratch {
+    /* The generation in which each state was last added to the current or
+     * the next set of states, and those sets. */
+    MVMint64 *done;
+    MVMint64 *queued;
+    MVMint64 *curst;
+    MVMint64 *nextst;
+    MVMint64  alloc_states;
+
+    /* The fates found so far, and the first generation of the run in which
+     * each fate was last found. */
+    MVMint64 *fates;
+    MVMint64 *fate_seen;
+    MVMint64  alloc_fates;
+
+    /* The current generation. */
+    MVMint64  gen;
+};
+
 /* Function for REPR setup. */
 const MVMREPROps * MVMNFA_initialize(MVMThreadContext *tc);
 
@@ -45,3 +68,4 @@ MVMObject * MVM_nfa_from_statelist(MVMThreadContext *tc, MVMObject *states, MVMO
 MVMObject * MVM_nfa_run_proto(MVMThreadContext *tc, MVMObject *nfa, MVMString *target, MVMint64 offset);
 void MVM_nfa_run_alt(MVMThreadContext *tc, MVMObject *nfa, MVMString *target,
     MVMint64 offset, MVMObject *bstack, MVMObject *cstack, MVMObject *labels);
+void MVM_nfa_destroy_scratch(MVMThreadContext *tc);
@@ -50,7 +50,7 @@ MVM_STATIC_INLINE void MVM_set_idx_in_sc(MVMCollectable *col, MVMuint32 i) {
         sci->sc_idx = col->sc_forward_u.sc.sc_idx;
         sci->idx = i;
         col->sc_forward_u.sci = sci;
-        col->flags |= MVM_CF_SERIALZATION_INDEX_ALLOCATED;
+        MVM_gc_flags_set(col, MVM_CF_SERIALZATION_INDEX_ALLOCATED);
     } else
 #endif
     {
@@ -58,10 +58,11 @@ MVM_STATIC_INLINE void MVM_set_idx_in_sc(MVMCollectable *col, MVMuint32 i) {
     }
 }
 
-/* Gets a collectable's SC. */
+/* Gets a collectable's SC. Outside of GC, only objects that incremental
+ * generation 2 marking has got to are marked live. */
 MVM_STATIC_INLINE MVMSerializationContext * MVM_sc_get_collectable_sc(MVMThreadContext *tc, MVMCollectable *col) {
     MVMuint32 sc_idx;
-    assert(!(col->flags & MVM_CF_GEN2_LIVE));
+    assert(!(col->flags & MVM_CF_GEN2_LIVE) || tc->gc_gen2_marking);
     assert(!(col->flags & MVM_CF_FORWARDER_VALID));
     sc_idx = MVM_get_idx_of_sc(col);
     assert(sc_idx != ~0);
@@ -80,7 +81,7 @@ MVM_STATIC_INLINE MVMSerializationContext * MVM_sc_get_stable_sc(MVMThreadContex
 
 /* Sets a collectable's SC. */
 MVM_STATIC_INLINE void MVM_sc_set_collectable_sc(MVMThreadContext *tc, MVMCollectable *col, MVMSerializationContext *sc) {
-    assert(!(col->flags & MVM_CF_GEN2_LIVE));
+    assert(!(col->flags & MVM_CF_GEN2_LIVE) || tc->gc_gen2_marking);
     assert(!(col->flags & MVM_CF_FORWARDER_VALID));
 #ifdef MVM_USE_OVERFLOW_SERIALIZATION_INDEX
     if (col->flags & MVM_CF_SERIALZATION_INDEX_ALLOCATED) {
@@ -97,7 +98,7 @@ MVM_STATIC_INLINE void MVM_sc_set_collectable_sc(MVMThreadContext *tc, MVMCollec
             sci->sc_idx = sc->body->sc_idx;
             sci->idx = ~0;
             col->sc_forward_u.sci = sci;
-            col->flags |= MVM_CF_SERIALZATION_INDEX_ALLOCATED;
+            MVM_gc_flags_set(col, MVM_CF_SERIALZATION_INDEX_ALLOCATED);
         } else
 #endif
         {
@@ -147,7 +148,7 @@ void MVM_sc_wb_hit_obj(MVMThreadContext *tc, MVMObject *obj);
 void MVM_sc_wb_hit_st(MVMThreadContext *tc, MVMSTable *st);
 
 MVM_STATIC_INLINE void MVM_SC_WB_OBJ(MVMThreadContext *tc, MVMObject *obj) {
-    assert(!(obj->header.flags & MVM_CF_GEN2_LIVE));
+    assert(!(obj->header.flags & MVM_CF_GEN2_LIVE) || tc->gc_gen2_marking);
     assert(!(obj->header.flags & MVM_CF_FORWARDER_VALID));
     assert(MVM_get_idx_of_sc(&obj->header) != ~0);
     if (MVM_get_idx_of_sc(&obj->header) > 0)
@@ -155,7 +156,7 @@ MVM_STATIC_INLINE void MVM_SC_WB_OBJ(MVMThreadContext *tc, MVMObject *obj) {
 }
 
 MVM_STATIC_INLINE void MVM_SC_WB_ST(MVMThreadContext *tc, MVMSTable *st) {
-    assert(!(st->header.flags & MVM_CF_GEN2_LIVE));
+    assert(!(st->header.flags & MVM_CF_GEN2_LIVE) || tc->gc_gen2_marking);
     assert(!(st->header.flags & MVM_CF_FORWARDER_VALID));
     assert(MVM_get_idx_of_sc(&st->header) != ~0);
     if (MVM_get_idx_of_sc(&st->header) > 0)
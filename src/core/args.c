@@ -720,10 +720,11 @@ static void flatten_args(MVMThreadContext *tc, MVMArgProcContext *ctx) {
             continue;
 
         if (arg_info.arg.o && REPR(arg_info.arg.o)->ID == MVM_REPR_ID_MVMHash) {
-            MVMHashBody *body = &((MVMHash *)arg_info.arg.o)->body;
-            MVMHashEntry *current, *tmp;
+            MVMStrHashTable *hashtable = &((MVMHash *)arg_info.arg.o)->body.hashtable;
+            MVMStrHashIterator pos;
 
-            HASH_ITER(hash_handle, body->hash_head, current, tmp) {
+            for (pos = MVM_str_hash_first(tc, hashtable); pos; pos = MVM_str_hash_next(tc, hashtable, pos)) {
+                MVMStrHashEntry *current = MVM_str_hash_current(tc, hashtable, pos);
 
                 if (new_arg_pos + 1 >= new_args_size) {
                     new_args = realloc(new_args, (new_args_size *= 2) * sizeof(MVMRegister));
@@ -732,8 +733,8 @@ static void flatten_args(MVMThreadContext *tc, MVMArgProcContext *ctx) {
                     new_arg_flags = realloc(new_arg_flags, (new_arg_flags_size *= 2) * sizeof(MVMCallsiteEntry));
                 }
 
-                (new_args + new_arg_pos++)->s = (MVMString *)current->key;
-                (new_args + new_arg_pos++)->o = current->value;
+                (new_args + new_arg_pos++)->s = current->key;
+                (new_args + new_arg_pos++)->o = current->value.o;
                 new_arg_flags[new_flag_pos++] = MVM_CALLSITE_ARG_NAMED | MVM_CALLSITE_ARG_OBJ;
             }
         }
@@ -281,7 +281,8 @@ static MVMString ** deserialize_strings(MVMThreadContext *tc, MVMCompUnit *cu, R
         /* Ensure we can read in the string of this size, and decode
          * it if so. */
         ensure_can_read(tc, cu, rs, pos, ss);
-        MVM_ASSIGN_REF(tc, &(cu->common.header), strings[i], MVM_string_utf8_decode(tc, tc->instance->VMString, pos, ss));
+        MVM_ASSIGN_REF(tc, &(cu->common.header), strings[i], MVM_string_intern(tc,
+            MVM_string_utf8_decode(tc, tc->instance->VMString, pos, ss)));
         pos += ss;
 
         /* Add alignment. */
@@ -575,19 +576,18 @@ static MVMStaticFrame ** deserialize_frames(MVMThreadContext *tc, MVMCompUnit *c
             /* Read in data. */
             ensure_can_read(tc, cu, rs, pos, 6 * static_frame_body->num_lexicals);
             if (static_frame_body->num_lexicals) {
-                static_frame_body->lexical_names_list = malloc(sizeof(MVMLexicalRegistry *) * static_frame_body->num_lexicals);
+                static_frame_body->lexical_names_list = calloc(static_frame_body->num_lexicals, sizeof(MVMString *));
             }
             for (j = 0; j < static_frame_body->num_lexicals; j++) {
                 MVMString *name = get_heap_string(tc, cu, rs, pos, 6 * j + 2);
-                MVMLexicalRegistry *entry = calloc(1, sizeof(MVMLexicalRegistry));
-
-                MVM_ASSIGN_REF(tc, &(static_frame->common.header), entry->key, name);
-                static_frame_body->lexical_names_list[j] = entry;
-                entry->value = j;
+                MVMStrHashEntry *entry;
 
+                MVM_ASSIGN_REF(tc, &(static_frame->common.header), static_frame_body->lexical_names_list[j], name);
                 static_frame_body->lexical_types[j] = read_int16(pos, 6 * j);
-                MVM_string_flatten(tc, name);
-                MVM_HASH_BIND(tc, static_frame_body->lexical_names, name, entry)
+
+                entry = MVM_str_hash_lvalue_fetch(tc, &static_frame_body->lexical_names, name);
+                MVM_ASSIGN_REF(tc, &(static_frame->common.header), entry->key, name);
+                entry->value.i = j;
             }
             pos += 6 * static_frame_body->num_lexicals;
         }
@@ -58,7 +58,6 @@ char * MVM_bytecode_dump(MVMThreadContext *tc, MVMCompUnit *cu) {
     MVMuint32 i, j, k, q;
     char *o = calloc(sizeof(char) * s, 1);
     char ***frame_lexicals = malloc(sizeof(char **) * cu->body.num_frames);
-    MVMString *name = MVM_string_utf8_decode(tc, tc->instance->VMString, "", 0);
 
     a("\nMoarVM dump of binary compilation unit:\n\n");
 
@@ -101,15 +100,11 @@ char * MVM_bytecode_dump(MVMThreadContext *tc, MVMCompUnit *cu) {
 
     for (k = 0; k < cu->body.num_frames; k++) {
         MVMStaticFrame *frame = cu->body.frames[k];
-        MVMLexicalRegistry *current, *tmp;
         char **lexicals = malloc(sizeof(char *) * frame->body.num_lexicals);
         frame_lexicals[k] = lexicals;
 
-        HASH_ITER(hash_handle, frame->body.lexical_names, current, tmp) {
-            name->body.int32s = (MVMint32 *)current->hash_handle.key;
-            name->body.graphs = (MVMuint32)current->hash_handle.keylen / sizeof(MVMCodepoint32);
-            lexicals[current->value] = MVM_string_utf8_encode_C_string(tc, name);
-        }
+        for (j = 0; j < frame->body.num_lexicals; j++)
+            lexicals[j] = MVM_string_utf8_encode_C_string(tc, frame->body.lexical_names_list[j]);
     }
     for (k = 0; k < cu->body.num_frames; k++) {
         MVMStaticFrame *frame = cu->body.frames[k];
@@ -53,3 +53,11 @@ void MVM_callsite_try_intern(MVMThreadContext *tc, MVMCallsite **cs_ptr) {
     /* Finally, release mutex. */
     uv_mutex_unlock(&tc->instance->mutex_callsite_interns);
 }
+
+/* Gets the interned callsite with no arguments, for the VM to use when it
+ * invokes a frame itself, so such frames can be specialized too. */
+MVMCallsite * MVM_callsite_get_no_arg(MVMThreadContext *tc) {
+    MVMCallsite *cs = calloc(1, sizeof(MVMCallsite));
+    MVM_callsite_try_intern(tc, &cs);
+    return cs;
+}
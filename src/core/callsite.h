@@ -77,3 +77,4 @@ struct MVMCallsiteInterns {
 
 /* Callsite interning function. */
 void MVM_callsite_try_intern(MVMThreadContext *tc, MVMCallsite **cs);
+MVMCallsite * MVM_callsite_get_no_arg(MVMThreadContext *tc);
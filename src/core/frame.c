@@ -135,7 +135,7 @@ void MVM_frame_invoke(MVMThreadContext *tc, MVMStaticFrame *static_frame,
                       MVMFrame *outer, MVMObject *code_ref) {
     MVMFrame *frame;
 
-    MVMuint32 pool_index, found_spesh;
+    MVMuint32 pool_index, found_spesh, work_size, num_locals;
     MVMFrame *node;
     int fresh = 0;
     MVMStaticFrameBody *static_frame_body = &static_frame->body;
@@ -201,21 +201,6 @@ void MVM_frame_invoke(MVMThreadContext *tc, MVMStaticFrame *static_frame,
     else {
         frame->env = NULL;
     }
-    if (static_frame_body->work_size) {
-        if (fresh || !frame->work)
-            frame->work = calloc(1, static_frame_body->work_size);
-        else
-            memset(frame->work, 0, static_frame_body->work_size);
-    }
-    else {
-        frame->work = NULL;
-    }
-
-    /* Calculate args buffer position and make sure current call site starts
-     * empty. */
-    frame->args = static_frame_body->work_size ?
-        frame->work + static_frame_body->num_locals :
-        NULL;
     frame->cur_args_callsite = NULL;
 
     /* Outer. */
@@ -278,61 +263,18 @@ void MVM_frame_invoke(MVMThreadContext *tc, MVMStaticFrame *static_frame,
 
     /* See if any specializations apply. */
     found_spesh = 0;
-    if (++static_frame_body->invocations >= 10 && callsite->is_interned) {
+    if (++static_frame_body->invocations + static_frame_body->back_edges
+            >= tc->instance->spesh_threshold && callsite->is_interned) {
         /* Look for specialized bytecode. */
-        MVMint32 num_spesh = static_frame_body->num_spesh_candidates;
-        MVMSpeshCandidate *chosen_cand = NULL;
-        MVMint32 i, j;
-        for (i = 0; i < num_spesh; i++) {
-            MVMSpeshCandidate *cand = &static_frame_body->spesh_candidates[i];
-            if (cand->cs == callsite) {
-                MVMint32 match = 1;
-                for (j = 0; j < cand->num_guards; j++) {
-                    MVMint32   pos = cand->guards[j].slot;
-                    MVMSTable *st  = (MVMSTable *)cand->guards[j].match;
-                    MVMObject *arg = args[pos].o;
-                    if (!arg) {
-                        match = 0;
-                        break;
-                    }
-                    switch (cand->guards[j].kind) {
-                    case MVM_SPESH_GUARD_CONC:
-                        if (!IS_CONCRETE(arg) || STABLE(arg) != st)
-                            match = 0;
-                        break;
-                    case MVM_SPESH_GUARD_TYPE:
-                        if (IS_CONCRETE(arg) || STABLE(arg) != st)
-                            match = 0;
-                        break;
-                    case MVM_SPESH_GUARD_DC_CONC: {
-                        MVMRegister dc;
-                        STABLE(arg)->container_spec->fetch(tc, arg, &dc);
-                        if (!dc.o || !IS_CONCRETE(dc.o) || STABLE(dc.o) != st)
-                            match = 0;
-                        break;
-                    }
-                    case MVM_SPESH_GUARD_DC_TYPE: {
-                        MVMRegister dc;
-                        STABLE(arg)->container_spec->fetch(tc, arg, &dc);
-                        if (!dc.o || IS_CONCRETE(dc.o) || STABLE(dc.o) != st)
-                            match = 0;
-                        break;
-                    }
-                    }
-                    if (!match)
-                        break;
-                }
-                if (match) {
-                    chosen_cand = cand;
-                    break;
-                }
-            }
-        }
+        MVMSpeshCandidate *chosen_cand = MVM_spesh_candidate_find(tc,
+            static_frame, callsite, args);
 
         /* If we didn't find any, and we're below the limit, can set up a
-         * specialization. */
-        if (!chosen_cand && num_spesh < MVM_SPESH_LIMIT && tc->instance->spesh_enabled)
-            chosen_cand = MVM_spesh_candidate_setup(tc, static_frame,
+         * specialization. If that's left to the spesh worker, there's no
+         * candidate to use yet. */
+        if (!chosen_cand && static_frame_body->num_spesh_candidates < MVM_SPESH_LIMIT
+                && tc->instance->spesh_enabled)
+            chosen_cand = MVM_spesh_worker_setup(tc, static_frame,
                 callsite, args);
 
         /* Now try to use specialized bytecode. We may need to compete to
@@ -355,8 +297,11 @@ void MVM_frame_invoke(MVMThreadContext *tc, MVMStaticFrame *static_frame,
                 }
             }
             else {
-                /* In the post-specialize phase; can safely used the code. */
-                frame->effective_bytecode    = chosen_cand->bytecode;
+                /* In the post-specialize phase; can safely used the code,
+                 * or the machine code compiled from it if there is some. */
+                frame->effective_bytecode    = chosen_cand->jitcode
+                    ? chosen_cand->jitcode->bytecode
+                    : chosen_cand->bytecode;
                 frame->effective_handlers    = chosen_cand->handlers;
                 frame->effective_spesh_slots = chosen_cand->spesh_slots;
                 frame->spesh_cand            = chosen_cand;
@@ -371,6 +316,34 @@ void MVM_frame_invoke(MVMThreadContext *tc, MVMStaticFrame *static_frame,
         frame->spesh_cand         = NULL;
     }
 
+    /* Allocate the work area, now we know if it's for specialized code that
+     * needs more registers than the static frame has. */
+    if (found_spesh && frame->spesh_log_idx < 0) {
+        work_size  = frame->spesh_cand->work_size;
+        num_locals = frame->spesh_cand->num_locals;
+    }
+    else {
+        work_size  = static_frame_body->work_size;
+        num_locals = static_frame_body->num_locals;
+    }
+    if (work_size) {
+        if (fresh || !frame->work || frame->allocd_work < work_size) {
+            if (!fresh && frame->work)
+                free(frame->work);
+            frame->work        = calloc(1, work_size);
+            frame->allocd_work = work_size;
+        }
+        else {
+            memset(frame->work, 0, work_size);
+        }
+    }
+    else {
+        frame->work = NULL;
+    }
+
+    /* Calculate args buffer position. */
+    frame->args = work_size ? frame->work + num_locals : NULL;
+
     /* Update interpreter and thread context, so next execution will use this
      * frame. */
     tc->cur_frame = frame;
@@ -466,6 +439,45 @@ MVMFrame * MVM_frame_create_context_only(MVMThreadContext *tc, MVMStaticFrame *s
     return frame;
 }
 
+/* Creates the frame that a callee inlined into the current frame would have
+ * had, when we de-optimize while running the inlined code, and makes it the
+ * current frame. It runs the callee's original bytecode; the caller of this
+ * must put its registers in place and set where it resumes. Inlined callees
+ * have no lexicals or handlers, and have already bound their args, which
+ * keeps this simple. */
+MVMFrame * MVM_frame_create_for_deopt(MVMThreadContext *tc, MVMStaticFrame *static_frame,
+        MVMCode *code_ref, MVMCallsite *callsite) {
+    MVMStaticFrameBody *static_frame_body = &static_frame->body;
+    MVMFrame           *frame             = calloc(1, sizeof(MVMFrame));
+
+    frame->tc          = tc;
+    frame->static_info = static_frame;
+    frame->code_ref    = (MVMObject *)code_ref;
+
+    /* Work area, with an args buffer that nothing was passed in. */
+    frame->work        = calloc(1, static_frame_body->work_size);
+    frame->allocd_work = static_frame_body->work_size;
+    frame->args        = frame->work + static_frame_body->num_locals;
+    MVM_args_proc_init(tc, &frame->params, callsite, frame->args);
+
+    /* Outer is that of the code object; caller is the current frame. */
+    if (code_ref->body.outer)
+        frame->outer = MVM_frame_inc_ref(tc, code_ref->body.outer);
+    frame->caller    = MVM_frame_inc_ref(tc, tc->cur_frame);
+    frame->ref_count = 1;
+
+    /* Runs the original bytecode. */
+    frame->effective_bytecode = static_frame_body->bytecode;
+    frame->effective_handlers = static_frame_body->handlers;
+
+    /* Make it the current frame. */
+    tc->cur_frame = frame;
+    *(tc->interp_bytecode_start) = frame->effective_bytecode;
+    *(tc->interp_reg_base)       = frame->work;
+    *(tc->interp_cu)             = static_frame_body->cu;
+    return frame;
+}
+
 /* Removes a single frame, as part of a return or unwind. Done after any exit
  * handler has already been run. */
 static MVMuint64 remove_one_frame(MVMThreadContext *tc, MVMuint8 unwind) {
@@ -473,10 +485,10 @@ static MVMuint64 remove_one_frame(MVMThreadContext *tc, MVMuint8 unwind) {
     MVMFrame *caller   = returner->caller;
 
     /* See if we were in a logging spesh frame, and need to complete the
-     * specialization. */
+     * specialization (or have the spesh worker do so). */
     if (returner->spesh_cand && returner->spesh_log_idx >= 0)
         if (MVM_decr(&(returner->spesh_cand->log_exits_remaining)) == 1)
-            MVM_spesh_candidate_specialize(tc, returner->static_info,
+            MVM_spesh_worker_specialize(tc, returner->static_info,
                 returner->spesh_cand);
 
     /* Some cleanup we only need do if we're not a frame involved in a
@@ -753,20 +765,19 @@ MVMObject * MVM_frame_vivify_lexical(MVMThreadContext *tc, MVMFrame *f, MVMuint1
  * if it does not exist. Incorrect type always throws. */
 MVMRegister * MVM_frame_find_lexical_by_name(MVMThreadContext *tc, MVMString *name, MVMuint16 type) {
     MVMFrame *cur_frame = tc->cur_frame;
-    MVM_string_flatten(tc, name);
     while (cur_frame != NULL) {
-        MVMLexicalRegistry *lexical_names = cur_frame->static_info->body.lexical_names;
-        if (lexical_names) {
+        MVMStrHashTable *lexical_names = &cur_frame->static_info->body.lexical_names;
+        if (lexical_names->num_items) {
             /* Indexes were formerly stored off-by-one to avoid semi-predicate issue. */
-            MVMLexicalRegistry *entry;
+            MVMStrHashEntry *entry;
 
-            MVM_HASH_GET(tc, lexical_names, name, entry)
+            entry = MVM_str_hash_fetch(tc, lexical_names, name);
 
             if (entry) {
-                if (cur_frame->static_info->body.lexical_types[entry->value] == type) {
-                    MVMRegister *result = &cur_frame->env[entry->value];
+                if (cur_frame->static_info->body.lexical_types[entry->value.i] == type) {
+                    MVMRegister *result = &cur_frame->env[entry->value.i];
                     if (type == MVM_reg_obj && !result->o)
-                        MVM_frame_vivify_lexical(tc, cur_frame, entry->value);
+                        MVM_frame_vivify_lexical(tc, cur_frame, entry->value.i);
                     return result;
                 }
                 else {
@@ -787,20 +798,19 @@ MVMRegister * MVM_frame_find_lexical_by_name(MVMThreadContext *tc, MVMString *na
 /* Looks up the address of the lexical with the specified name, starting with
  * the specified frame. Only works if it's an object lexical.  */
 MVMRegister * MVM_frame_find_lexical_by_name_rel(MVMThreadContext *tc, MVMString *name, MVMFrame *cur_frame) {
-    MVM_string_flatten(tc, name);
     while (cur_frame != NULL) {
-        MVMLexicalRegistry *lexical_names = cur_frame->static_info->body.lexical_names;
-        if (lexical_names) {
+        MVMStrHashTable *lexical_names = &cur_frame->static_info->body.lexical_names;
+        if (lexical_names->num_items) {
             /* Indexes were formerly stored off-by-one to avoid semi-predicate issue. */
-            MVMLexicalRegistry *entry;
+            MVMStrHashEntry *entry;
 
-            MVM_HASH_GET(tc, lexical_names, name, entry)
+            entry = MVM_str_hash_fetch(tc, lexical_names, name);
 
             if (entry) {
-                if (cur_frame->static_info->body.lexical_types[entry->value] == MVM_reg_obj) {
-                    MVMRegister *result = &cur_frame->env[entry->value];
+                if (cur_frame->static_info->body.lexical_types[entry->value.i] == MVM_reg_obj) {
+                    MVMRegister *result = &cur_frame->env[entry->value.i];
                     if (!result->o)
-                        MVM_frame_vivify_lexical(tc, cur_frame, entry->value);
+                        MVM_frame_vivify_lexical(tc, cur_frame, entry->value.i);
                     return result;
                 }
                 else {
@@ -818,22 +828,21 @@ MVMRegister * MVM_frame_find_lexical_by_name_rel(MVMThreadContext *tc, MVMString
 /* Looks up the address of the lexical with the specified name, starting with
  * the specified frame. It checks all outer frames of the caller frame chain.  */
 MVMRegister * MVM_frame_find_lexical_by_name_rel_caller(MVMThreadContext *tc, MVMString *name, MVMFrame *cur_caller_frame) {
-    MVM_string_flatten(tc, name);
     while (cur_caller_frame != NULL) {
         MVMFrame *cur_frame = cur_caller_frame;
         while (cur_frame != NULL) {
-            MVMLexicalRegistry *lexical_names = cur_frame->static_info->body.lexical_names;
-            if (lexical_names) {
+            MVMStrHashTable *lexical_names = &cur_frame->static_info->body.lexical_names;
+            if (lexical_names->num_items) {
                 /* Indexes were formerly stored off-by-one to avoid semi-predicate issue. */
-                MVMLexicalRegistry *entry;
+                MVMStrHashEntry *entry;
 
-                MVM_HASH_GET(tc, lexical_names, name, entry)
+                entry = MVM_str_hash_fetch(tc, lexical_names, name);
 
                 if (entry) {
-                    if (cur_frame->static_info->body.lexical_types[entry->value] == MVM_reg_obj) {
-                        MVMRegister *result = &cur_frame->env[entry->value];
+                    if (cur_frame->static_info->body.lexical_types[entry->value.i] == MVM_reg_obj) {
+                        MVMRegister *result = &cur_frame->env[entry->value.i];
                         if (!result->o)
-                            MVM_frame_vivify_lexical(tc, cur_frame, entry->value);
+                            MVM_frame_vivify_lexical(tc, cur_frame, entry->value.i);
                         return result;
                     }
                     else {
@@ -856,19 +865,18 @@ MVMRegister * MVM_frame_find_contextual_by_name(MVMThreadContext *tc, MVMString
     if (!name) {
         MVM_exception_throw_adhoc(tc, "Contextual name cannot be null");
     }
-    MVM_string_flatten(tc, name);
     while (cur_frame != NULL) {
-        MVMLexicalRegistry *lexical_names = cur_frame->static_info->body.lexical_names;
-        if (lexical_names) {
-            MVMLexicalRegistry *entry;
+        MVMStrHashTable *lexical_names = &cur_frame->static_info->body.lexical_names;
+        if (lexical_names->num_items) {
+            MVMStrHashEntry *entry;
 
-            MVM_HASH_GET(tc, lexical_names, name, entry)
+            entry = MVM_str_hash_fetch(tc, lexical_names, name);
 
             if (entry) {
-                MVMRegister *result = &cur_frame->env[entry->value];
-                *type = cur_frame->static_info->body.lexical_types[entry->value];
+                MVMRegister *result = &cur_frame->env[entry->value.i];
+                *type = cur_frame->static_info->body.lexical_types[entry->value.i];
                 if (vivify && *type == MVM_reg_obj && !result->o)
-                    MVM_frame_vivify_lexical(tc, cur_frame, entry->value);
+                    MVM_frame_vivify_lexical(tc, cur_frame, entry->value.i);
                 return result;
             }
         }
@@ -960,13 +968,12 @@ void MVM_frame_binddynlex(MVMThreadContext *tc, MVMString *name, MVMObject *valu
 /* Returns the storage unit for the lexical in the specified frame. Does not
  * try to vivify anything - gets exactly what is there. */
 MVMRegister * MVM_frame_lexical(MVMThreadContext *tc, MVMFrame *f, MVMString *name) {
-    MVMLexicalRegistry *lexical_names = f->static_info->body.lexical_names;
-    if (lexical_names) {
-        MVMLexicalRegistry *entry;
-        MVM_string_flatten(tc, name);
-        MVM_HASH_GET(tc, lexical_names, name, entry)
+    MVMStrHashTable *lexical_names = &f->static_info->body.lexical_names;
+    if (lexical_names->num_items) {
+        MVMStrHashEntry *entry;
+        entry = MVM_str_hash_fetch(tc, lexical_names, name);
         if (entry)
-            return &f->env[entry->value];
+            return &f->env[entry->value.i];
     }
     MVM_exception_throw_adhoc(tc, "Frame has no lexical with name '%s'",
         MVM_string_utf8_encode_C_string(tc, name));
@@ -974,15 +981,14 @@ MVMRegister * MVM_frame_lexical(MVMThreadContext *tc, MVMFrame *f, MVMString *na
 
 /* Returns the storage unit for the lexical in the specified frame. */
 MVMRegister * MVM_frame_try_get_lexical(MVMThreadContext *tc, MVMFrame *f, MVMString *name, MVMuint16 type) {
-    MVMLexicalRegistry *lexical_names = f->static_info->body.lexical_names;
-    if (lexical_names) {
-        MVMLexicalRegistry *entry;
-        MVM_string_flatten(tc, name);
-        MVM_HASH_GET(tc, lexical_names, name, entry)
-        if (entry && f->static_info->body.lexical_types[entry->value] == type) {
-            MVMRegister *result = &f->env[entry->value];
+    MVMStrHashTable *lexical_names = &f->static_info->body.lexical_names;
+    if (lexical_names->num_items) {
+        MVMStrHashEntry *entry;
+        entry = MVM_str_hash_fetch(tc, lexical_names, name);
+        if (entry && f->static_info->body.lexical_types[entry->value.i] == type) {
+            MVMRegister *result = &f->env[entry->value.i];
             if (type == MVM_reg_obj && !result->o)
-                MVM_frame_vivify_lexical(tc, f, entry->value);
+                MVM_frame_vivify_lexical(tc, f, entry->value.i);
             return result;
         }
     }
@@ -991,13 +997,12 @@ MVMRegister * MVM_frame_try_get_lexical(MVMThreadContext *tc, MVMFrame *f, MVMSt
 
 /* Returns the primitive type specification for a lexical. */
 MVMuint16 MVM_frame_lexical_primspec(MVMThreadContext *tc, MVMFrame *f, MVMString *name) {
-    MVMLexicalRegistry *lexical_names = f->static_info->body.lexical_names;
-    if (lexical_names) {
-        MVMLexicalRegistry *entry;
-        MVM_string_flatten(tc, name);
-        MVM_HASH_GET(tc, lexical_names, name, entry)
+    MVMStrHashTable *lexical_names = &f->static_info->body.lexical_names;
+    if (lexical_names->num_items) {
+        MVMStrHashEntry *entry;
+        entry = MVM_str_hash_fetch(tc, lexical_names, name);
         if (entry) {
-            switch (f->static_info->body.lexical_types[entry->value]) {
+            switch (f->static_info->body.lexical_types[entry->value.i]) {
                 case MVM_reg_int64:
                     return MVM_STORAGE_SPEC_BP_INT;
                 case MVM_reg_num64:
@@ -1139,10 +1144,10 @@ MVMFrame * MVM_frame_clone(MVMThreadContext *tc, MVMFrame *f) {
         clone->env = malloc(f->static_info->body.env_size);
         memcpy(clone->env, f->env, f->static_info->body.env_size);
     }
-    if (f->static_info->body.work_size) {
-        clone->work = malloc(f->static_info->body.work_size);
-        memcpy(clone->work, f->work, f->static_info->body.work_size);
-        clone->args = clone->work + f->static_info->body.num_locals;
+    if (f->work) {
+        clone->work = malloc(f->allocd_work);
+        memcpy(clone->work, f->work, f->allocd_work);
+        clone->args = clone->work + (f->args - f->work);
     }
 
     /* Ref-count of the clone is 1. */
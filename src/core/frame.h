@@ -6,18 +6,6 @@
 #define MVM_FRAME_FLAG_HLL_3            1 << 5
 #define MVM_FRAME_FLAG_HLL_4            1 << 6
 
-/* Lexical hash entry for ->lexical_names on a frame. */
-struct MVMLexicalRegistry {
-    /* key string */
-    MVMString *key;
-
-    /* index of the lexical entry. */
-    MVMuint32 value;
-
-    /* the uthash hash handle inline struct. */
-    UT_hash_handle hash_handle;
-};
-
 /* Entry in the linked list of continuation tags for the frame. */
 struct MVMContinuationTag {
     /* The tag itself. */
@@ -57,6 +45,11 @@ struct MVMFrame {
      * decrease number of allocations. */
     MVMRegister *args;
 
+    /* The size in bytes of the work area. Usually the static frame's work
+     * size, but more if the frame is running a specialization with inlined
+     * code; kept so a frame from the pool knows if it has enough. */
+    MVMuint32 allocd_work;
+
     /* Callsite that indicates how the current args buffer is being used, if
      * it is. */
     MVMCallsite *cur_args_callsite;
@@ -183,6 +176,8 @@ void MVM_frame_invoke(MVMThreadContext *tc, MVMStaticFrame *static_frame,
                       MVMFrame *outer, MVMObject *code_ref);
 MVMFrame * MVM_frame_create_context_only(MVMThreadContext *tc, MVMStaticFrame *static_frame,
         MVMObject *code_ref);
+MVMFrame * MVM_frame_create_for_deopt(MVMThreadContext *tc, MVMStaticFrame *static_frame,
+        MVMCode *code_ref, MVMCallsite *callsite);
 MVM_PUBLIC MVMuint64 MVM_frame_try_return(MVMThreadContext *tc);
 void MVM_frame_unwind_to(MVMThreadContext *tc, MVMFrame *frame, MVMuint8 *abs_addr,
                          MVMuint32 rel_addr, MVMObject *return_value);
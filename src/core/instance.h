@@ -142,9 +142,45 @@ struct MVMInstance {
     /* Log file for specializations, if we're to log them. */
     FILE *spesh_log_fh;
 
+    /* Report file for which frames got specialized and why, if we're to
+     * write one. */
+    FILE *spesh_report_fh;
+
+    /* How hot (invocations plus loop iterations) a static frame must get
+     * before it's specialized. */
+    MVMuint32 spesh_threshold;
+
     /* Flag for if spesh is enabled. */
     MVMint32 spesh_enabled;
 
+    /* Flag for if specialization work is done on the thread that needs it,
+     * as soon as it does, rather than by the spesh worker. */
+    MVMint32 spesh_blocking;
+
+    /* Flag for if the optimizer inlines small callees it's sure of. */
+    MVMint32 spesh_inline_enabled;
+
+    /* Flag for if specializations are compiled to machine code, where we
+     * know how to. */
+    MVMint32 jit_enabled;
+
+    /* The chunk of pages machine code is being put in, how much of it is
+     * used, and a mutex for handing it out; see jit/compile.c. */
+    MVMuint8   *jit_code_chunk;
+    size_t      jit_code_chunk_pos;
+    uv_mutex_t  mutex_jit_code;
+
+    /* The spesh worker thread, if it's running, and its queue of work; see
+     * spesh/worker.c. Also flags for the worker being asked to stop, and
+     * having done so. */
+    MVMThreadContext *spesh_thread;
+    MVMSpeshWorkItem *spesh_queue_head;
+    MVMSpeshWorkItem *spesh_queue_tail;
+    uv_mutex_t        mutex_spesh_queue;
+    uv_cond_t         cond_spesh_queue;
+    MVMuint8          spesh_worker_stopping;
+    MVMuint8          spesh_worker_stopped;
+
     /* Number of representations registered so far. */
     MVMuint32 num_reprs;
 
@@ -177,6 +213,38 @@ struct MVMInstance {
     AO_t gc_intrays_clearing;
     /* The number of threads that have yet to acknowledge the finish. */
     AO_t gc_ack;
+    /* Chunks of marking work offered up by busy threads during a full
+     * collection, for threads that ran out of work to steal. */
+    MVMGCPassedWork *gc_steal_pool;
+    /* The number of threads that are out of work and waiting to steal. */
+    AO_t gc_steal_waiting;
+    /* Whether work stealing is enabled for full collections. */
+    MVMint32 gc_steal_enabled;
+    /* Whether types whose objects mostly survive the nursery may have them
+     * allocated directly in generation 2. */
+    MVMint32 gc_pretenure_enabled;
+    /* Where threads wait for each other during a GC run. */
+    MVMGCBarrier gc_barrier;
+    /* Statistics about GC runs, and the number of threads yet to add their
+     * share to those for the latest run. */
+    MVMGCStats *gc_stats;
+    AO_t gc_stats_pending;
+    /* The file to write a heap snapshot to at the end of the next full
+     * collection, if one has been asked for, and whether writing the last
+     * one failed. */
+    char *heap_snapshot_path;
+    MVMint32 heap_snapshot_failed;
+    /* If non-zero, generation 2 is marked incrementally, with each thread
+     * spending at most this many nanoseconds on it per GC run. */
+    MVMuint64 gc_mark_budget;
+    /* Where we are in an incremental generation 2 collection (one of
+     * MVMGCGen2Phase), and the GC run it started in. */
+    AO_t gc_gen2_phase;
+    AO_t gc_gen2_phase_start;
+    /* The size a thread's nursery starts out at, and whether it then adapts
+     * to how the thread allocates. */
+    MVMuint32 nursery_size;
+    MVMint32 nursery_adaptive;
     /* Linked list (via forwarder) of STables to free. */
     MVMSTable *stables_to_free;
 
@@ -256,6 +324,17 @@ struct MVMInstance {
     MVMCallsiteInterns *callsite_interns;
     uv_mutex_t          mutex_callsite_interns;
 
+    /* The seed the string hash starts from. */
+    MVMuint64 string_hash_seed;
+
+    /* Synthetic graphemes, and the rest of what NFG needs; see
+     * strings/nfg.h. */
+    MVMNFGState *nfg;
+
+    /* Interned strings. The table holds them weakly; see strings/intern.c. */
+    MVMStrHashTable *string_interns;
+    uv_mutex_t       mutex_string_interns;
+
     /* Standard file handles. */
     MVMObject *stdin_handle;
     MVMObject *stdout_handle;
@@ -13,6 +13,26 @@
 
 #define NEXT_OP (op = *(MVMuint16 *)(cur_op), cur_op += 2, op)
 
+/* Branches to a place in the bytecode. Branching backwards is counted as a
+ * loop iteration, towards how hot the current frame's static frame is. For
+ * if_o and unless_o, where MVM_coerce_istrue does the branching, a backward
+ * branch is counted whether it's taken or not. Every so often, a backward
+ * branch in a frame running its original bytecode looks at switching it over
+ * to specialized code, at the loop head being branched to. */
+#define COUNT_BACK_EDGE(target) do { \
+    if ((target) < cur_op) \
+        tc->cur_frame->static_info->body.back_edges++; \
+} while (0)
+#define BRANCH(target) do { \
+    MVMuint8 *branch_target = (target); \
+    if (branch_target < cur_op) { \
+        MVMuint32 back_edges = ++tc->cur_frame->static_info->body.back_edges; \
+        if ((back_edges & MVM_SPESH_OSR_MASK) == 0 && !tc->cur_frame->spesh_cand) \
+            branch_target = MVM_spesh_osr(tc, branch_target); \
+    } \
+    cur_op = branch_target; \
+} while (0)
+
 #if MVM_CGOTO
 #define DISPATCH(op)
 #define OP(name) OP_ ## name
@@ -25,6 +45,16 @@
 
 static int tracing_enabled = 0;
 
+/* Allocates an instance of the specified type. P6opaque, which most of the
+ * objects made by create and box ops are, allocates with nothing more than
+ * MVM_gc_allocate_object once composed, so do that inline. */
+MVM_STATIC_INLINE MVMObject * allocate_instance(MVMThreadContext *tc, MVMObject *type) {
+    MVMSTable *st = STABLE(type);
+    if (st->REPR->ID == MVM_REPR_ID_P6opaque && st->size)
+        return MVM_gc_allocate_object_fast(tc, st);
+    return st->REPR->allocate(tc, st);
+}
+
 /* This is the interpreter run loop. We have one of these per thread. */
 void MVM_interp_run(MVMThreadContext *tc, void (*initial_invoke)(MVMThreadContext *, void *), void *invoke_data) {
 #if MVM_CGOTO
@@ -81,12 +111,12 @@ void MVM_interp_run(MVMThreadContext *tc, void (*initial_invoke)(MVMThreadContex
             OP(no_op):
                 goto NEXT;
             OP(goto):
-                cur_op = bytecode_start + GET_UI32(cur_op, 0);
+                BRANCH(bytecode_start + GET_UI32(cur_op, 0));
                 GC_SYNC_POINT(tc);
                 goto NEXT;
             OP(if_i):
                 if (GET_REG(cur_op, 0).i64)
-                    cur_op = bytecode_start + GET_UI32(cur_op, 2);
+                    BRANCH(bytecode_start + GET_UI32(cur_op, 2));
                 else
                     cur_op += 6;
                 GC_SYNC_POINT(tc);
@@ -95,12 +125,12 @@ void MVM_interp_run(MVMThreadContext *tc, void (*initial_invoke)(MVMThreadContex
                 if (GET_REG(cur_op, 0).i64)
                     cur_op += 6;
                 else
-                    cur_op = bytecode_start + GET_UI32(cur_op, 2);
+                    BRANCH(bytecode_start + GET_UI32(cur_op, 2));
                 GC_SYNC_POINT(tc);
                 goto NEXT;
             OP(if_n):
                 if (GET_REG(cur_op, 0).n64 != 0.0)
-                    cur_op = bytecode_start + GET_UI32(cur_op, 2);
+                    BRANCH(bytecode_start + GET_UI32(cur_op, 2));
                 else
                     cur_op += 6;
                 GC_SYNC_POINT(tc);
@@ -109,7 +139,7 @@ void MVM_interp_run(MVMThreadContext *tc, void (*initial_invoke)(MVMThreadContex
                 if (GET_REG(cur_op, 0).n64 != 0.0)
                     cur_op += 6;
                 else
-                    cur_op = bytecode_start + GET_UI32(cur_op, 2);
+                    BRANCH(bytecode_start + GET_UI32(cur_op, 2));
                 GC_SYNC_POINT(tc);
                 goto NEXT;
             OP(if_s): {
@@ -117,14 +147,14 @@ void MVM_interp_run(MVMThreadContext *tc, void (*initial_invoke)(MVMThreadContex
                 if (!str || NUM_GRAPHS(str) == 0)
                     cur_op += 6;
                 else
-                    cur_op = bytecode_start + GET_UI32(cur_op, 2);
+                    BRANCH(bytecode_start + GET_UI32(cur_op, 2));
                 GC_SYNC_POINT(tc);
                 goto NEXT;
             }
             OP(unless_s): {
                 MVMString *str = GET_REG(cur_op, 0).s;
                 if (!str || NUM_GRAPHS(str) == 0)
-                    cur_op = bytecode_start + GET_UI32(cur_op, 2);
+                    BRANCH(bytecode_start + GET_UI32(cur_op, 2));
                 else
                     cur_op += 6;
                 GC_SYNC_POINT(tc);
@@ -135,14 +165,14 @@ void MVM_interp_run(MVMThreadContext *tc, void (*initial_invoke)(MVMThreadContex
                 if (!MVM_coerce_istrue_s(tc, str))
                     cur_op += 6;
                 else
-                    cur_op = bytecode_start + GET_UI32(cur_op, 2);
+                    BRANCH(bytecode_start + GET_UI32(cur_op, 2));
                 GC_SYNC_POINT(tc);
                 goto NEXT;
             }
             OP(unless_s0): {
                 MVMString *str = GET_REG(cur_op, 0).s;
                 if (!MVM_coerce_istrue_s(tc, str))
-                    cur_op = bytecode_start + GET_UI32(cur_op, 2);
+                    BRANCH(bytecode_start + GET_UI32(cur_op, 2));
                 else
                     cur_op += 6;
                 GC_SYNC_POINT(tc);
@@ -150,6 +180,7 @@ void MVM_interp_run(MVMThreadContext *tc, void (*initial_invoke)(MVMThreadContex
             }
             OP(if_o):
                 GC_SYNC_POINT(tc);
+                COUNT_BACK_EDGE(bytecode_start + GET_UI32(cur_op, 2));
                 MVM_coerce_istrue(tc, GET_REG(cur_op, 0).o, NULL,
                     bytecode_start + GET_UI32(cur_op, 2),
                     cur_op + 6,
@@ -157,6 +188,7 @@ void MVM_interp_run(MVMThreadContext *tc, void (*initial_invoke)(MVMThreadContex
                 goto NEXT;
             OP(unless_o):
                 GC_SYNC_POINT(tc);
+                COUNT_BACK_EDGE(bytecode_start + GET_UI32(cur_op, 2));
                 MVM_coerce_istrue(tc, GET_REG(cur_op, 0).o, NULL,
                     bytecode_start + GET_UI32(cur_op, 2),
                     cur_op + 6,
@@ -899,15 +931,11 @@ void MVM_interp_run(MVMThreadContext *tc, void (*initial_invoke)(MVMThreadContex
                 if (IS_CONCRETE(code) && REPR(code)->ID == MVM_REPR_ID_MVMCode) {
                     MVMStaticFrame *sf = ((MVMCode *)code)->body.sf;
                     MVMuint8 found = 0;
-                    MVM_string_flatten(tc, name);
-                    if (sf->body.lexical_names) {
-                        MVMLexicalRegistry *entry;
-                        MVM_HASH_GET(tc, sf->body.lexical_names, name, entry);
-                        if (entry && sf->body.lexical_types[entry->value] == MVM_reg_obj) {
-                            MVM_ASSIGN_REF(tc, &(sf->common.header), sf->body.static_env[entry->value].o, val);
-                            sf->body.static_env_flags[entry->value] = (MVMuint8)flag;
-                            found = 1;
-                        }
+                    MVMStrHashEntry *entry = MVM_str_hash_fetch(tc, &sf->body.lexical_names, name);
+                    if (entry && sf->body.lexical_types[entry->value.i] == MVM_reg_obj) {
+                        MVM_ASSIGN_REF(tc, &(sf->common.header), sf->body.static_env[entry->value.i].o, val);
+                        sf->body.static_env_flags[entry->value.i] = (MVMuint8)flag;
+                        found = 1;
                     }
                     if (!found)
                         MVM_exception_throw_adhoc(tc, "setstaticlex given invalid lexical name");
@@ -1368,7 +1396,7 @@ void MVM_interp_run(MVMThreadContext *tc, void (*initial_invoke)(MVMThreadContex
                 cur_op += 4;
                 goto NEXT;
             OP(codes_s):
-                GET_REG(cur_op, 0).i64 = GET_REG(cur_op, 2).s->body.codes;
+                GET_REG(cur_op, 0).i64 = MVM_string_codes(tc, GET_REG(cur_op, 2).s);
                 cur_op += 4;
                 goto NEXT;
             OP(eq_s):
@@ -1539,7 +1567,6 @@ void MVM_interp_run(MVMThreadContext *tc, void (*initial_invoke)(MVMThreadContex
                     MVM_exception_throw_adhoc(tc, "ord string is null or blank");
                 }
                 GET_REG(cur_op, 0).i64 = MVM_string_get_codepoint_at(tc, s, GET_REG(cur_op, 4).i64);
-                /* XXX what to do with synthetics?  return them? */
                 cur_op += 6;
                 goto NEXT;
             }
@@ -2014,7 +2041,7 @@ void MVM_interp_run(MVMThreadContext *tc, void (*initial_invoke)(MVMThreadContex
                  * to put things on the temporary stack. The GC will
                  * know to update it in the register if it moved. */
                 MVMObject *type = GET_REG(cur_op, 2).o;
-                MVMObject *obj  = REPR(type)->allocate(tc, STABLE(type));
+                MVMObject *obj  = allocate_instance(tc, type);
                 GET_REG(cur_op, 0).o = obj;
                 if (REPR(obj)->initialize)
                     REPR(obj)->initialize(tc, STABLE(obj), obj, OBJECT_BODY(obj));
@@ -2335,18 +2362,21 @@ void MVM_interp_run(MVMThreadContext *tc, void (*initial_invoke)(MVMThreadContex
                 goto NEXT;
             }
             OP(box_i): {
+                /* As with create, we write the box into the result register
+                 * before initializing it, so the GC will update it there if
+                 * initialize allocates, rather than us having to root it. */
                 MVMObject *type = GET_REG(cur_op, 4).o;
                 MVMObject *box;
                 box = MVM_intcache_get(tc, type, GET_REG(cur_op, 2).i64);
                 if (box == 0) {
-                    box = REPR(type)->allocate(tc, STABLE(type));
-                    MVMROOT(tc, box, {
-                        if (REPR(box)->initialize)
-                            REPR(box)->initialize(tc, STABLE(box), box, OBJECT_BODY(box));
-                        REPR(box)->box_funcs.set_int(tc, STABLE(box), box,
-                            OBJECT_BODY(box), GET_REG(cur_op, 2).i64);
-                        GET_REG(cur_op, 0).o = box;
-                    });
+                    box = allocate_instance(tc, type);
+                    GET_REG(cur_op, 0).o = box;
+                    if (REPR(box)->initialize) {
+                        REPR(box)->initialize(tc, STABLE(box), box, OBJECT_BODY(box));
+                        box = GET_REG(cur_op, 0).o;
+                    }
+                    REPR(box)->box_funcs.set_int(tc, STABLE(box), box,
+                        OBJECT_BODY(box), GET_REG(cur_op, 2).i64);
                 } else {
                     GET_REG(cur_op, 0).o = box;
                 }
@@ -2355,27 +2385,27 @@ void MVM_interp_run(MVMThreadContext *tc, void (*initial_invoke)(MVMThreadContex
             }
             OP(box_n): {
                 MVMObject *type = GET_REG(cur_op, 4).o;
-                MVMObject *box  = REPR(type)->allocate(tc, STABLE(type));
-                MVMROOT(tc, box, {
-                    if (REPR(box)->initialize)
-                        REPR(box)->initialize(tc, STABLE(box), box, OBJECT_BODY(box));
-                    REPR(box)->box_funcs.set_num(tc, STABLE(box), box,
-                        OBJECT_BODY(box), GET_REG(cur_op, 2).n64);
-                    GET_REG(cur_op, 0).o = box;
-                });
+                MVMObject *box  = allocate_instance(tc, type);
+                GET_REG(cur_op, 0).o = box;
+                if (REPR(box)->initialize) {
+                    REPR(box)->initialize(tc, STABLE(box), box, OBJECT_BODY(box));
+                    box = GET_REG(cur_op, 0).o;
+                }
+                REPR(box)->box_funcs.set_num(tc, STABLE(box), box,
+                    OBJECT_BODY(box), GET_REG(cur_op, 2).n64);
                 cur_op += 6;
                 goto NEXT;
             }
             OP(box_s): {
                 MVMObject *type = GET_REG(cur_op, 4).o;
-                MVMObject *box  = REPR(type)->allocate(tc, STABLE(type));
-                MVMROOT(tc, box, {
-                    if (REPR(box)->initialize)
-                        REPR(box)->initialize(tc, STABLE(box), box, OBJECT_BODY(box));
-                    REPR(box)->box_funcs.set_str(tc, STABLE(box), box,
-                        OBJECT_BODY(box), GET_REG(cur_op, 2).s);
-                    GET_REG(cur_op, 0).o = box;
-                });
+                MVMObject *box  = allocate_instance(tc, type);
+                GET_REG(cur_op, 0).o = box;
+                if (REPR(box)->initialize) {
+                    REPR(box)->initialize(tc, STABLE(box), box, OBJECT_BODY(box));
+                    box = GET_REG(cur_op, 0).o;
+                }
+                REPR(box)->box_funcs.set_str(tc, STABLE(box), box,
+                    OBJECT_BODY(box), GET_REG(cur_op, 2).s);
                 cur_op += 6;
                 goto NEXT;
             }
@@ -4357,6 +4387,18 @@ void MVM_interp_run(MVMThreadContext *tc, void (*initial_invoke)(MVMThreadContex
                 }
                 goto NEXT;
             }
+            OP(gcrunstats):
+                GET_REG(cur_op, 0).o = MVM_gc_stats_runs(tc, GET_REG(cur_op, 2).i64);
+                cur_op += 4;
+                goto NEXT;
+            OP(gcstats):
+                GET_REG(cur_op, 0).o = MVM_gc_stats_totals(tc);
+                cur_op += 2;
+                goto NEXT;
+            OP(heapsnapshot):
+                MVM_gc_snapshot_take(tc, GET_REG(cur_op, 0).s);
+                cur_op += 2;
+                goto NEXT;
             OP(sp_log):
                 if (tc->cur_frame->spesh_log_idx >= 0) {
                     MVM_ASSIGN_REF(tc, &(tc->cur_frame->static_info->common.header),
@@ -4487,12 +4529,22 @@ void MVM_interp_run(MVMThreadContext *tc, void (*initial_invoke)(MVMThreadContex
             }
             OP(sp_fastcreate): {
                 /* Assume we're in normal code, so doing a nursery allocation.
-                 * Also, that there is no initialize. */
+                 * Also, that there is no initialize. Try to just bump the
+                 * nursery pointer, unless the type is pretenured. */
                 MVMuint16 size       = GET_UI16(cur_op, 2);
-                MVMObject *obj       = MVM_gc_allocate_zeroed(tc, size);
-                obj->st              = (MVMSTable *)tc->cur_frame->effective_spesh_slots[GET_UI16(cur_op, 4)];
-                obj->header.size     = size;
-                obj->header.owner    = tc->thread_id;
+                MVMSTable *st        = (MVMSTable *)tc->cur_frame->effective_spesh_slots[GET_UI16(cur_op, 4)];
+                MVMObject *obj;
+                if (st->pretenure) {
+                    obj = MVM_gc_allocate_object(tc, st);
+                }
+                else {
+                    obj = MVM_gc_allocate_nursery_fast(tc, size);
+                    if (!obj)
+                        obj = MVM_gc_allocate_zeroed(tc, size);
+                    obj->st           = (MVMSTable *)tc->cur_frame->effective_spesh_slots[GET_UI16(cur_op, 4)];
+                    obj->header.size  = size;
+                    obj->header.owner = tc->thread_id;
+                }
                 GET_REG(cur_op, 0).o = obj;
                 cur_op += 6;
                 goto NEXT;
@@ -4601,6 +4653,11 @@ void MVM_interp_run(MVMThreadContext *tc, void (*initial_invoke)(MVMThreadContex
                 cur_op += 6;
                 goto NEXT;
             }
+            OP(sp_jit_enter):
+                /* The machine code leaves cur_op where we should go on. */
+                if (tc->cur_frame->spesh_cand->jitcode->func(tc, reg_base) == 0)
+                    goto return_label;
+                goto NEXT;
 #if MVM_CGOTO
             OP_CALL_EXTOP: {
                 /* Bounds checking? Never heard of that. */
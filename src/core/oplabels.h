@@ -609,6 +609,9 @@ static const void * const LABELS[] = {
     &&OP_param_on2_n,
     &&OP_param_on2_s,
     &&OP_param_on2_o,
+    &&OP_gcrunstats,
+    &&OP_gcstats,
+    &&OP_heapsnapshot,
     &&OP_sp_log,
     &&OP_sp_guardconc,
     &&OP_sp_guardtype,
@@ -639,10 +642,7 @@ static const void * const LABELS[] = {
     &&OP_sp_p6obind_i,
     &&OP_sp_p6obind_n,
     &&OP_sp_p6obind_s,
-    NULL,
-    NULL,
-    NULL,
-    NULL,
+    &&OP_sp_jit_enter,
     NULL,
     NULL,
     NULL,
@@ -5474,6 +5474,33 @@ static MVMOpInfo MVM_op_infos[] = {
         0,
         { MVM_operand_write_reg | MVM_operand_obj, MVM_operand_str, MVM_operand_str, MVM_operand_ins }
     },
+    {
+        MVM_OP_gcrunstats,
+        "gcrunstats",
+        "  ",
+        2,
+        0,
+        0,
+        { MVM_operand_write_reg | MVM_operand_obj, MVM_operand_read_reg | MVM_operand_int64 }
+    },
+    {
+        MVM_OP_gcstats,
+        "gcstats",
+        "  ",
+        1,
+        0,
+        0,
+        { MVM_operand_write_reg | MVM_operand_obj }
+    },
+    {
+        MVM_OP_heapsnapshot,
+        "heapsnapshot",
+        "  ",
+        1,
+        0,
+        0,
+        { MVM_operand_read_reg | MVM_operand_str }
+    },
     {
         MVM_OP_sp_log,
         "sp_log",
@@ -5744,9 +5771,17 @@ static MVMOpInfo MVM_op_infos[] = {
         0,
         { MVM_operand_read_reg | MVM_operand_obj, MVM_operand_int16, MVM_operand_read_reg | MVM_operand_str }
     },
+    {
+        MVM_OP_sp_jit_enter,
+        "sp_jit_enter",
+        ".s",
+        0,
+        0,
+        0,
+    },
 };
 
-static unsigned short MVM_op_counts = 638;
+static unsigned short MVM_op_counts = 642;
 
 MVMOpInfo * MVM_op_get_op(unsigned short op) {
     if (op >= MVM_op_counts)
@@ -609,36 +609,40 @@
 #define MVM_OP_param_on2_n 605
 #define MVM_OP_param_on2_s 606
 #define MVM_OP_param_on2_o 607
-#define MVM_OP_sp_log 608
-#define MVM_OP_sp_guardconc 609
-#define MVM_OP_sp_guardtype 610
-#define MVM_OP_sp_guardcontconc 611
-#define MVM_OP_sp_guardconttype 612
-#define MVM_OP_sp_getarg_o 613
-#define MVM_OP_sp_getarg_i 614
-#define MVM_OP_sp_getarg_n 615
-#define MVM_OP_sp_getarg_s 616
-#define MVM_OP_sp_getspeshslot 617
-#define MVM_OP_sp_findmeth 618
-#define MVM_OP_sp_fastcreate 619
-#define MVM_OP_sp_get_o 620
-#define MVM_OP_sp_get_i 621
-#define MVM_OP_sp_get_n 622
-#define MVM_OP_sp_get_s 623
-#define MVM_OP_sp_bind_o 624
-#define MVM_OP_sp_bind_i 625
-#define MVM_OP_sp_bind_n 626
-#define MVM_OP_sp_bind_s 627
-#define MVM_OP_sp_p6oget_o 628
-#define MVM_OP_sp_p6ogetvt_o 629
-#define MVM_OP_sp_p6ogetvc_o 630
-#define MVM_OP_sp_p6oget_i 631
-#define MVM_OP_sp_p6oget_n 632
-#define MVM_OP_sp_p6oget_s 633
-#define MVM_OP_sp_p6obind_o 634
-#define MVM_OP_sp_p6obind_i 635
-#define MVM_OP_sp_p6obind_n 636
-#define MVM_OP_sp_p6obind_s 637
+#define MVM_OP_gcrunstats 608
+#define MVM_OP_gcstats 609
+#define MVM_OP_heapsnapshot 610
+#define MVM_OP_sp_log 611
+#define MVM_OP_sp_guardconc 612
+#define MVM_OP_sp_guardtype 613
+#define MVM_OP_sp_guardcontconc 614
+#define MVM_OP_sp_guardconttype 615
+#define MVM_OP_sp_getarg_o 616
+#define MVM_OP_sp_getarg_i 617
+#define MVM_OP_sp_getarg_n 618
+#define MVM_OP_sp_getarg_s 619
+#define MVM_OP_sp_getspeshslot 620
+#define MVM_OP_sp_findmeth 621
+#define MVM_OP_sp_fastcreate 622
+#define MVM_OP_sp_get_o 623
+#define MVM_OP_sp_get_i 624
+#define MVM_OP_sp_get_n 625
+#define MVM_OP_sp_get_s 626
+#define MVM_OP_sp_bind_o 627
+#define MVM_OP_sp_bind_i 628
+#define MVM_OP_sp_bind_n 629
+#define MVM_OP_sp_bind_s 630
+#define MVM_OP_sp_p6oget_o 631
+#define MVM_OP_sp_p6ogetvt_o 632
+#define MVM_OP_sp_p6ogetvc_o 633
+#define MVM_OP_sp_p6oget_i 634
+#define MVM_OP_sp_p6oget_n 635
+#define MVM_OP_sp_p6oget_s 636
+#define MVM_OP_sp_p6obind_o 637
+#define MVM_OP_sp_p6obind_i 638
+#define MVM_OP_sp_p6obind_n 639
+#define MVM_OP_sp_p6obind_s 640
+#define MVM_OP_sp_jit_enter 641
 
 #define MVM_OP_EXT_BASE 1024
 #define MVM_OP_EXT_CU_LIMIT 1024
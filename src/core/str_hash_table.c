@@ -0,0 +1,218 @@
+#include "moar.h"
+
+/* Gets the hash code stored for a key. Zero marks an empty slot, which is
+ * fine as string hash codes are never zero. */
+static MVMuint32 hash_key(MVMThreadContext *tc, MVMString *key) {
+    return MVM_string_hash_code(tc, key);
+}
+
+/* Checks if two keys are equal, whatever their storage. */
+static MVMint32 keys_equal(MVMThreadContext *tc, MVMString *a, MVMString *b) {
+    return a == b || MVM_string_equal(tc, a, b);
+}
+
+/* Allocates the storage for the entries and hash codes of a table with the
+ * specified number of slots, which share a single allocation. */
+static MVMStrHashEntry * allocate_storage(MVMuint32 num_slots) {
+    size_t           size    = (size_t)num_slots * (sizeof(MVMStrHashEntry) + sizeof(MVMuint32));
+    MVMStrHashEntry *entries = malloc(size);
+    if (!entries)
+        MVM_panic(1, "Out of memory allocating %llu bytes for a hash table", (unsigned long long)size);
+    return entries;
+}
+
+/* Sets up empty storage for a table with the specified number of buckets. */
+static void allocate_slots(MVMThreadContext *tc, MVMStrHashTable *table, MVMuint32 num_buckets) {
+    MVMuint32 extra = num_buckets < MVM_STR_HASH_MAX_PROBE ? num_buckets : MVM_STR_HASH_MAX_PROBE;
+    table->num_buckets = num_buckets;
+    table->num_slots   = num_buckets + extra;
+    table->entries     = allocate_storage(table->num_slots);
+    table->hashes      = (MVMuint32 *)(table->entries + table->num_slots);
+    memset(table->hashes, 0, table->num_slots * sizeof(MVMuint32));
+}
+
+/* Finds the slot a new entry with the given hash code should go in, and
+ * moves along the entries from there up to the next empty slot to make room
+ * for it. Since entries in a run of occupied slots are in order of the
+ * bucket they hash to, this keeps it that way. Returns the slot, or -1 if
+ * there is no empty slot before the end, in which case nothing is changed. */
+static MVMint64 make_room(MVMStrHashTable *table, MVMuint32 hash) {
+    MVMuint32 mask  = table->num_buckets - 1;
+    MVMuint32 home  = hash & mask;
+    MVMuint32 slot  = home;
+    MVMuint32 empty;
+    while (slot < table->num_slots && table->hashes[slot] && (table->hashes[slot] & mask) <= home)
+        slot++;
+    empty = slot;
+    while (empty < table->num_slots && table->hashes[empty])
+        empty++;
+    if (empty == table->num_slots)
+        return -1;
+    if (empty != slot) {
+        memmove(&table->entries[slot + 1], &table->entries[slot],
+            (empty - slot) * sizeof(MVMStrHashEntry));
+        memmove(&table->hashes[slot + 1], &table->hashes[slot],
+            (empty - slot) * sizeof(MVMuint32));
+    }
+    table->hashes[slot] = hash;
+    return slot;
+}
+
+/* Finds the furthest any entry in the table is from its bucket. */
+static MVMuint32 max_probe_distance(MVMStrHashTable *table) {
+    MVMuint32 mask = table->num_buckets - 1;
+    MVMuint32 max  = 0;
+    MVMuint32 slot;
+    for (slot = 0; slot < table->num_slots; slot++)
+        if (table->hashes[slot] && slot - (table->hashes[slot] & mask) > max)
+            max = slot - (table->hashes[slot] & mask);
+    return max;
+}
+
+/* Grows the table to the specified number of buckets, moving all the
+ * entries over. Should the entries not fit, which can only happen with a
+ * lot of keys that have the same hash code, or should the table be as big
+ * as we allow already, the table is left as it was and 0 is returned. */
+static MVMint32 grow(MVMThreadContext *tc, MVMStrHashTable *table, MVMuint32 num_buckets) {
+    MVMStrHashTable old = *table;
+    MVMuint32 i;
+    if (num_buckets > (1 << 30))
+        return 0;
+    allocate_slots(tc, table, num_buckets);
+    for (i = 0; i < old.num_slots; i++) {
+        if (old.hashes[i]) {
+            MVMint64 slot = make_room(table, old.hashes[i]);
+            if (slot < 0) {
+                free(table->entries);
+                *table = old;
+                return 0;
+            }
+            table->entries[slot] = old.entries[i];
+        }
+    }
+    free(old.entries);
+    return 1;
+}
+
+/* Looks up a key, returning its entry or NULL if it is not in the table. */
+MVMStrHashEntry * MVM_str_hash_fetch(MVMThreadContext *tc, MVMStrHashTable *table, MVMString *key) {
+    MVMuint32 hash, mask, home, slot;
+    if (!table->num_items)
+        return NULL;
+    hash = hash_key(tc, key);
+    mask = table->num_buckets - 1;
+    home = hash & mask;
+    for (slot = home; slot < table->num_slots && table->hashes[slot]; slot++) {
+        MVMuint32 slot_hash = table->hashes[slot];
+        if (slot_hash == hash && keys_equal(tc, key, table->entries[slot].key))
+            return &table->entries[slot];
+        if ((slot_hash & mask) > home)
+            break;
+    }
+    return NULL;
+}
+
+/* Looks up a key, adding an entry for it if it's not in the table already.
+ * A new entry has a zeroed value and its key is left NULL; the caller must
+ * set the key right away, doing any write barrier needed. */
+MVMStrHashEntry * MVM_str_hash_lvalue_fetch(MVMThreadContext *tc, MVMStrHashTable *table, MVMString *key) {
+    MVMStrHashEntry *entry = MVM_str_hash_fetch(tc, table, key);
+    MVMuint32 hash;
+    MVMint64  slot;
+    if (entry)
+        return entry;
+
+    hash = hash_key(tc, key);
+    if (!table->entries)
+        allocate_slots(tc, table, MVM_STR_HASH_MIN_BUCKETS);
+    else if ((MVMuint64)(table->num_items + 1) * 100 > (MVMuint64)table->num_buckets * MVM_STR_HASH_MAX_LOAD)
+        grow(tc, table, table->num_buckets * 2);
+
+    /* If there's no room for it, growing spreads the entries out, unless a
+     * lot of them have the same hash code; once growing stops helping, we
+     * give up, rather than grow the table without end. */
+    while ((slot = make_room(table, hash)) < 0) {
+        MVMuint32 distance = max_probe_distance(table);
+        if (!grow(tc, table, table->num_buckets * 2) || max_probe_distance(table) >= distance)
+            MVM_exception_throw_adhoc(tc, "Hash table has too many colliding keys");
+    }
+
+    table->num_items++;
+    entry          = &table->entries[slot];
+    entry->key     = NULL;
+    entry->value.i = 0;
+    return entry;
+}
+
+/* Deletes a key from the table, if it's there. The entries after it that
+ * are not in their own bucket are shifted back a slot to fill the gap. */
+void MVM_str_hash_delete(MVMThreadContext *tc, MVMStrHashTable *table, MVMString *key) {
+    MVMStrHashEntry *entry = MVM_str_hash_fetch(tc, table, key);
+    MVMuint32 mask, slot, end;
+    if (!entry)
+        return;
+    mask = table->num_buckets - 1;
+    slot = entry - table->entries;
+    end  = slot + 1;
+    while (end < table->num_slots && table->hashes[end] && (table->hashes[end] & mask) != end)
+        end++;
+    if (end != slot + 1) {
+        memmove(&table->entries[slot], &table->entries[slot + 1],
+            (end - slot - 1) * sizeof(MVMStrHashEntry));
+        memmove(&table->hashes[slot], &table->hashes[slot + 1],
+            (end - slot - 1) * sizeof(MVMuint32));
+    }
+    table->hashes[end - 1] = 0;
+    table->num_items--;
+}
+
+/* Makes dest a copy of src, which entry for entry it can be since the hash
+ * codes don't change. Any write barriers are the caller's business. */
+void MVM_str_hash_copy(MVMThreadContext *tc, MVMStrHashTable *dest, MVMStrHashTable *src) {
+    *dest = *src;
+    if (src->entries) {
+        size_t size   = src->num_slots * (sizeof(MVMStrHashEntry) + sizeof(MVMuint32));
+        dest->entries = allocate_storage(src->num_slots);
+        dest->hashes  = (MVMuint32 *)(dest->entries + dest->num_slots);
+        memcpy(dest->entries, src->entries, size);
+    }
+}
+
+/* Frees the storage of a table, leaving it empty. */
+void MVM_str_hash_demolish(MVMThreadContext *tc, MVMStrHashTable *table) {
+    MVM_checked_free_null(table->entries);
+    table->hashes      = NULL;
+    table->num_items   = 0;
+    table->num_buckets = 0;
+    table->num_slots   = 0;
+}
+
+/* Iteration goes from the last occupied slot to the first. The entry at an
+ * iterator position may have been deleted, or the table grown, since it was
+ * obtained; the next position is still found from it. */
+static MVMStrHashIterator settle(MVMStrHashTable *table, MVMuint32 position) {
+    if (position > table->num_slots)
+        position = table->num_slots;
+    while (position && !table->hashes[position - 1])
+        position--;
+    return position;
+}
+MVMStrHashIterator MVM_str_hash_first(MVMThreadContext *tc, MVMStrHashTable *table) {
+    return settle(table, table->num_slots);
+}
+MVMStrHashIterator MVM_str_hash_next(MVMThreadContext *tc, MVMStrHashTable *table, MVMStrHashIterator iterator) {
+    return iterator ? settle(table, iterator - 1) : 0;
+}
+
+/* Adds the keys in the table, and optionally the values, to the GC
+ * worklist. */
+void MVM_str_hash_gc_mark(MVMThreadContext *tc, MVMStrHashTable *table, MVMGCWorklist *worklist, MVMuint8 mark_values) {
+    MVMuint32 i;
+    for (i = 0; i < table->num_slots; i++) {
+        if (table->hashes[i]) {
+            MVM_gc_worklist_add(tc, worklist, &table->entries[i].key);
+            if (mark_values)
+                MVM_gc_worklist_add(tc, worklist, &table->entries[i].value.o);
+        }
+    }
+}
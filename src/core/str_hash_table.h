@@ -0,0 +1,74 @@
+/* A hash table keyed on strings, used for VM-level hashes, hash attribute
+ * stores and lexical name lookups. It uses open addressing with Robin Hood
+ * insertion, so entries are stored inline, and a lookup usually touches
+ * just the one cache line of hash codes and then the entry itself.
+ *
+ * There is no wrap-around at the end of the slots; instead, there are some
+ * extra slots past the end for probes to run into, and the table grows if
+ * an insertion would need to go beyond them. Deletion shifts the following
+ * entries back, so there are no tombstones. */
+struct MVMStrHashEntry {
+    /* The key. A newly added entry has this set to NULL; the caller must
+     * then set it (with a write barrier as needed) before anything else is
+     * done with the table. */
+    MVMString *key;
+
+    /* The value; an object, or for lexical names, an index. */
+    union {
+        MVMObject *o;
+        MVMuint64  i;
+    } value;
+};
+
+struct MVMStrHashTable {
+    /* The entries, and alongside them the hash codes of their keys, with 0
+     * marking an empty slot. */
+    MVMStrHashEntry *entries;
+    MVMuint32       *hashes;
+
+    /* The number of entries in the table. */
+    MVMuint32 num_items;
+
+    /* The number of slots hashes are reduced to (a power of 2), and the
+     * number actually allocated, which includes the extra ones past the
+     * end. */
+    MVMuint32 num_buckets;
+    MVMuint32 num_slots;
+};
+
+/* The smallest table we allocate, and the percentage of the buckets that
+ * may be filled before we grow. */
+#define MVM_STR_HASH_MIN_BUCKETS 8
+#define MVM_STR_HASH_MAX_LOAD    75
+
+/* The most slots past its bucket an entry may be placed in. */
+#define MVM_STR_HASH_MAX_PROBE   255
+
+/* A position in a hash table, for iterating over it. Iteration goes from the
+ * last slot to the first, so that deleting the current entry (which shifts
+ * entries from later slots back) doesn't cause any to be skipped. Zero is
+ * the end of the iteration. */
+typedef MVMuint32 MVMStrHashIterator;
+
+/* Functions. */
+MVMStrHashEntry * MVM_str_hash_fetch(MVMThreadContext *tc, MVMStrHashTable *table, MVMString *key);
+MVMStrHashEntry * MVM_str_hash_lvalue_fetch(MVMThreadContext *tc, MVMStrHashTable *table, MVMString *key);
+void MVM_str_hash_delete(MVMThreadContext *tc, MVMStrHashTable *table, MVMString *key);
+void MVM_str_hash_copy(MVMThreadContext *tc, MVMStrHashTable *dest, MVMStrHashTable *src);
+void MVM_str_hash_demolish(MVMThreadContext *tc, MVMStrHashTable *table);
+MVMStrHashIterator MVM_str_hash_first(MVMThreadContext *tc, MVMStrHashTable *table);
+MVMStrHashIterator MVM_str_hash_next(MVMThreadContext *tc, MVMStrHashTable *table, MVMStrHashIterator iterator);
+void MVM_str_hash_gc_mark(MVMThreadContext *tc, MVMStrHashTable *table, MVMGCWorklist *worklist, MVMuint8 mark_values);
+
+/* Gets the entry at an iterator's position, or NULL if it has since been
+ * deleted. */
+MVM_STATIC_INLINE MVMStrHashEntry * MVM_str_hash_current(MVMThreadContext *tc, MVMStrHashTable *table, MVMStrHashIterator iterator) {
+    return iterator && iterator <= table->num_slots && table->hashes[iterator - 1]
+        ? &table->entries[iterator - 1]
+        : NULL;
+}
+
+/* Gets the number of entries in the table. */
+MVM_STATIC_INLINE MVMuint32 MVM_str_hash_count(MVMThreadContext *tc, MVMStrHashTable *table) {
+    return table->num_items;
+}
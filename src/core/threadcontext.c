@@ -10,10 +10,13 @@ MVMThreadContext * MVM_tc_create(MVMInstance *instance) {
     tc->instance = instance;
 
     /* Set up GC nursery. */
-    tc->nursery_fromspace   = calloc(1, MVM_NURSERY_SIZE);
-    tc->nursery_tospace     = calloc(1, MVM_NURSERY_SIZE);
-    tc->nursery_alloc       = tc->nursery_tospace;
-    tc->nursery_alloc_limit = (char *)tc->nursery_alloc + MVM_NURSERY_SIZE;
+    tc->nursery_size           = instance->nursery_size;
+    tc->nursery_fromspace_size = tc->nursery_size;
+    tc->nursery_tospace_size   = tc->nursery_size;
+    tc->nursery_fromspace      = calloc(1, tc->nursery_size);
+    tc->nursery_tospace        = calloc(1, tc->nursery_size);
+    tc->nursery_alloc          = tc->nursery_tospace;
+    tc->nursery_alloc_limit    = (char *)tc->nursery_alloc + tc->nursery_size;
 
     /* Set up temporary root handling. */
     tc->num_temproots   = 0;
@@ -25,8 +28,10 @@ MVMThreadContext * MVM_tc_create(MVMInstance *instance) {
     tc->alloc_gen2roots = 64;
     tc->gen2roots       = malloc(sizeof(MVMCollectable *) * tc->alloc_gen2roots);
 
-    /* Set up the second generation allocator. */
+    /* Set up the second generation allocator. If we're created while
+     * generation 2 is being marked incrementally, we must take part. */
     tc->gen2 = MVM_gc_gen2_create(instance);
+    tc->gc_gen2_marking = MVM_load(&instance->gc_gen2_phase) != MVMGCGen2Phase_Idle;
 
     /* Set up table of per-static-frame chains. */
     /* XXX For non-first threads, make them start with the size of the
@@ -71,6 +76,9 @@ void MVM_tc_destroy(MVMThreadContext *tc) {
     MVM_checked_free_null(tc->gc_work);
     MVM_checked_free_null(tc->temproots);
     MVM_checked_free_null(tc->gen2roots);
+    MVM_checked_free_null(tc->gen2marks);
+    MVM_checked_free_null(tc->gc_run_stats);
+    MVM_nfa_destroy_scratch(tc);
 
     /* Destroy the libuv event loop */
     uv_loop_delete(tc->loop);
@@ -124,6 +124,15 @@ struct MVMThreadContext {
      * allocate new ones. */
     void *nursery_tospace;
 
+    /* The sizes of the fromspace and tospace, and the size this thread's
+     * nursery should be; the spaces catch up with it as they are swapped. */
+    MVMuint32 nursery_fromspace_size;
+    MVMuint32 nursery_tospace_size;
+    MVMuint32 nursery_size;
+
+    /* Bytes promoted out of the nursery in the current GC run. */
+    MVMuint32 nursery_promoted;
+
     /* The second GC generation allocator. */
     MVMGen2Allocator *gen2;
 
@@ -149,6 +158,16 @@ struct MVMThreadContext {
     MVMuint32             alloc_gen2roots;
     MVMCollectable      **gen2roots;
 
+    /* Generation 2 objects that were marked during incremental marking, but
+     * that have yet to be scanned. */
+    MVMuint32             num_gen2marks;
+    MVMuint32             alloc_gen2marks;
+    MVMCollectable      **gen2marks;
+
+    /* Whether generation 2 is being marked incrementally, meaning the write
+     * barrier needs to mark objects that get stored. */
+    MVMuint8              gc_gen2_marking;
+
     /* The GC's cross-thread in-tray of processing work. */
     MVMGCPassedWork *gc_in_tray;
 
@@ -158,6 +177,9 @@ struct MVMThreadContext {
     MVMuint32        gc_work_size;
     MVMuint32        gc_work_count;
 
+    /* This thread's share of the statistics for the current GC run. */
+    MVMGCRunStats   *gc_run_stats;
+
     /* Pool table of chains of frames for each static frame. */
     MVMFrame **frame_pool_table;
 
@@ -178,6 +200,9 @@ struct MVMThreadContext {
     /* Cache of native code callback data. */
     MVMNativeCallbackCacheHead *native_callback_cache;
 
+    /* Scratch space for running NFAs, allocated on first use. */
+    MVMNFAScratch *nfa_scratch;
+
     /* Random number generator state. */
     MVMuint64 rand_state[2];
 
@@ -5,7 +5,6 @@
 typedef struct {
     MVMThreadContext *tc;
     MVMObject        *thread_obj;
-    MVMCallsite       no_arg_callsite;
 } ThreadStart;
 
 /* Creates a new thread handle with the MVMThread representation. Does not
@@ -39,16 +38,10 @@ static void thread_initial_invoke(MVMThreadContext *tc, void *data) {
     });
     });
 
-    /* Dummy, 0-arg callsite. */
-    ts->no_arg_callsite.arg_flags      = NULL;
-    ts->no_arg_callsite.arg_count      = 0;
-    ts->no_arg_callsite.num_pos        = 0;
-    ts->no_arg_callsite.has_flattening = 0;
-    ts->no_arg_callsite.is_interned    = 0;
-
-    /* Create initial frame, which sets up all of the interpreter state also. */
+    /* Create initial frame, which sets up all of the interpreter state also.
+     * The 0-arg callsite is interned, so the frame can be specialized. */
     invokee = MVM_frame_find_invokee(tc, invokee, NULL);
-    STABLE(invokee)->invoke(tc, invokee, &ts->no_arg_callsite, NULL);
+    STABLE(invokee)->invoke(tc, invokee, MVM_callsite_get_no_arg(tc), NULL);
 
     /* This frame should be marked as the thread entry frame, so that any
      * return from it will cause us to drop out of the interpreter and end
@@ -6,7 +6,8 @@
 #include "moar.h"
 
 /* Allocate the specified amount of memory from the nursery. Will
- * trigger a GC run if there is not enough. */
+ * trigger a GC run if there is not enough. Objects that would take up a
+ * big part of the nursery are allocated in the second generation instead. */
 void * MVM_gc_allocate_nursery(MVMThreadContext *tc, size_t size) {
     void *allocated;
 
@@ -17,8 +18,18 @@ void * MVM_gc_allocate_nursery(MVMThreadContext *tc, size_t size) {
     if (tc->gc_status)
         MVM_gc_enter_from_interrupt(tc);
 
+    /* Large objects are costly to copy, so put them straight into the
+     * second generation. Since whoever is allocating will initialize them
+     * as though they were in the nursery, without any write barrier, make
+     * them inter-generational roots; they will drop off the list at the
+     * next run if they turn out not to reference any nursery objects. */
+    if (size > tc->nursery_size / MVM_NURSERY_LARGE_FRACTION) {
+        allocated = MVM_gc_gen2_allocate_zeroed(tc->gen2, size);
+        MVM_gc_root_gen2_add(tc, (MVMCollectable *)allocated);
+    }
+
     /* Guard against 0-byte allocation. */
-    if (size > 0) {
+    else if (size > 0) {
         /* Do a GC run if this allocation won't fit in what we have
          * left in the nursery. Note this is a loop to handle a
          * pathological case: all the objects in the nursery are very
@@ -26,11 +37,8 @@ void * MVM_gc_allocate_nursery(MVMThreadContext *tc, size_t size) {
          * actually gets freed up. The next run will promote them to the
          * second generation. Note that this circumstance is exceptionally
          * unlikely in any non-contrived situation. */
-        while ((char *)tc->nursery_alloc + size >= (char *)tc->nursery_alloc_limit) {
-            if (size > MVM_NURSERY_SIZE)
-                MVM_panic(MVM_exitcode_gcalloc, "Attempt to allocate more than the maximum nursery size");
+        while ((char *)tc->nursery_alloc + size >= (char *)tc->nursery_alloc_limit)
             MVM_gc_enter_from_allocator(tc);
-        }
 
         /* Allocate (just bump the pointer). */
         allocated = tc->nursery_alloc;
@@ -79,21 +87,81 @@ MVMObject * MVM_gc_allocate_type_object(MVMThreadContext *tc, MVMSTable *st) {
     return obj;
 }
 
-/* Allocates a new object, and points it at the specified STable. */
+/* Allocates an object of a pretenured type in the second generation. This
+ * can't trigger GC, so there's no need to root anything. */
+static MVMObject * allocate_pretenured(MVMThreadContext *tc, MVMSTable *st) {
+    MVMObject *obj;
+    MVM_gc_allocate_gen2_default_set(tc);
+    obj               = MVM_gc_allocate_zeroed(tc, st->size);
+    MVM_gc_allocate_gen2_default_clear(tc);
+    obj->header.size  = (MVMuint16)st->size;
+    obj->header.owner = tc->thread_id;
+    MVM_ASSIGN_REF(tc, &(obj->header), obj->st, st);
+
+    /* Whoever allocated it will initialize it as though it were in the
+     * nursery, without any write barrier, so make it an inter-generational
+     * root; it'll drop off the list at the next run if it turns out not to
+     * reference any nursery objects. */
+    MVM_gc_root_gen2_add(tc, (MVMCollectable *)obj);
+
+    /* Count it, so we notice if many of them turn out to die young after
+     * all. Deaths are only seen in full collections, so rather than start
+     * over every so many allocations, older counts are aged out. */
+    if (++st->gc_survived >= MVM_GC_PRETENURE_SAMPLES * MVM_GC_PRETENURE_AGE) {
+        st->gc_survived /= 2;
+        st->gc_died     /= 2;
+    }
+    return obj;
+}
+
+/* Allocates a new object, and points it at the specified STable. Tries the
+ * inline nursery fast path first, so the STable need only be rooted when we
+ * may have to GC. */
 MVMObject * MVM_gc_allocate_object(MVMThreadContext *tc, MVMSTable *st) {
     MVMObject *obj;
+    if (st->pretenure) {
+        if (tc->allocate_in == MVMAllocate_Nursery)
+            return allocate_pretenured(tc, st);
+    }
+    else if ((obj = (MVMObject *)MVM_gc_allocate_nursery_fast(tc, st->size))) {
+        obj->header.size  = (MVMuint16)st->size;
+        obj->header.owner = tc->thread_id;
+        obj->st           = st;
+        return obj;
+    }
     MVMROOT(tc, st, {
         obj               = MVM_gc_allocate_zeroed(tc, st->size);
         obj->header.size  = (MVMuint16)st->size;
         obj->header.owner = tc->thread_id;
         MVM_ASSIGN_REF(tc, &(obj->header), obj->st, st);
         if ((obj->header.flags & MVM_CF_SECOND_GEN))
-            if (REPR(obj)->refs_frames)
+            if (REPR(obj)->refs_frames && !(obj->header.flags & MVM_CF_IN_GEN2_ROOT_LIST))
                 MVM_gc_root_gen2_add(tc, (MVMCollectable *)obj);
     });
     return obj;
 }
 
+/* Called once enough samples of the fate of a type's objects have been
+ * gathered, to decide whether it should be pretenured. A type that isn't is
+ * pretenured if nearly all of its objects live long enough to be promoted;
+ * a type that is stops being if too many of those allocated die in the
+ * second generation. Either way, sampling then starts over. */
+void MVM_gc_allocate_pretenure_update(MVMThreadContext *tc, MVMSTable *st) {
+    MVMuint64 survived = st->gc_survived;
+    MVMuint64 died     = st->gc_died;
+    if (!st->pretenure) {
+        if (tc->instance->gc_pretenure_enabled
+                && survived * 100 >= (survived + died) * MVM_GC_PRETENURE_SURVIVAL)
+            st->pretenure = 1;
+    }
+    else {
+        if (died * 100 > survived * (100 - MVM_GC_PRETENURE_SURVIVAL))
+            st->pretenure = 0;
+    }
+    st->gc_survived = 0;
+    st->gc_died     = 0;
+}
+
 /* Sets allocate for this thread to be from the second generation by
  * default. */
 void MVM_gc_allocate_gen2_default_set(MVMThreadContext *tc) {
@@ -1,11 +1,57 @@
+/* Objects bigger than this fraction of a thread's nursery are allocated
+ * straight into the second generation. */
+#define MVM_NURSERY_LARGE_FRACTION 16
+
+/* How many objects of a type we look at the fate of before deciding whether
+ * it should be pretenured (or stop being), and the percentage of them that
+ * must survive to be promoted for it to be. */
+#define MVM_GC_PRETENURE_SAMPLES  1024
+#define MVM_GC_PRETENURE_SURVIVAL 90
+
+/* For pretenured types, the counts are halved after this many times the
+ * samples have been allocated. */
+#define MVM_GC_PRETENURE_AGE 16
+
 void * MVM_gc_allocate_nursery(MVMThreadContext *tc, size_t size);
 void * MVM_gc_allocate_zeroed(MVMThreadContext *tc, size_t size);
 MVMSTable * MVM_gc_allocate_stable(MVMThreadContext *tc, const MVMREPROps *repr, MVMObject *how);
 MVMObject * MVM_gc_allocate_type_object(MVMThreadContext *tc, MVMSTable *st);
 MVMObject * MVM_gc_allocate_object(MVMThreadContext *tc, MVMSTable *st);
+void MVM_gc_allocate_pretenure_update(MVMThreadContext *tc, MVMSTable *st);
 void MVM_gc_allocate_gen2_default_set(MVMThreadContext *tc);
 void MVM_gc_allocate_gen2_default_clear(MVMThreadContext *tc);
 
 #define MVM_gc_allocate(tc, size) (tc->allocate_in == MVMAllocate_Nursery ? \
     MVM_gc_allocate_nursery(tc, size) : \
     MVM_gc_gen2_allocate_zeroed(tc->gen2, size))
+
+/* Tries to allocate the specified amount of memory by bumping the nursery
+ * pointer. This is the common case of MVM_gc_allocate_nursery, but without
+ * the function call. Returns NULL if the memory must be obtained the slow
+ * way: because we're allocating in the second generation, a GC run is due,
+ * the allocation is large, or there isn't room left in the nursery. */
+MVM_STATIC_INLINE void * MVM_gc_allocate_nursery_fast(MVMThreadContext *tc, size_t size) {
+    void *allocated = tc->nursery_alloc;
+    if (tc->allocate_in != MVMAllocate_Nursery || tc->gc_status
+            || size > tc->nursery_size / MVM_NURSERY_LARGE_FRACTION
+            || (char *)allocated + size >= (char *)tc->nursery_alloc_limit)
+        return NULL;
+    tc->nursery_alloc = (char *)allocated + size;
+    return allocated;
+}
+
+/* Allocates a new object for the specified STable, in the same way as
+ * MVM_gc_allocate_object, which is all many REPRs' allocate functions do.
+ * When the nursery has room, it's all done inline; the STable only needs
+ * rooting on the slow path, which may GC. Pretenured types always take the
+ * slow path. */
+MVM_STATIC_INLINE MVMObject * MVM_gc_allocate_object_fast(MVMThreadContext *tc, MVMSTable *st) {
+    MVMObject *obj = st->pretenure ? NULL :
+        (MVMObject *)MVM_gc_allocate_nursery_fast(tc, st->size);
+    if (!obj)
+        return MVM_gc_allocate_object(tc, st);
+    obj->header.size  = (MVMuint16)st->size;
+    obj->header.owner = tc->thread_id;
+    obj->st           = st;
+    return obj;
+}
@@ -0,0 +1,94 @@
+#include "moar.h"
+#include <platform/threads.h>
+#include <platform/time.h>
+
+/* Tells the CPU we're in a spin loop, so a hyperthreaded sibling gets the
+ * execution resources we'd otherwise burn. */
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define cpu_relax() _mm_pause()
+#elif defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+#define cpu_relax() __asm__ __volatile__("pause")
+#else
+#define cpu_relax()
+#endif
+
+/* Sets up the instance's GC barrier. */
+void MVM_gc_barrier_init(MVMInstance *i) {
+    int init_stat;
+    if ((init_stat = uv_mutex_init(&i->gc_barrier.mutex)) < 0
+            || (init_stat = uv_cond_init(&i->gc_barrier.cond)) < 0) {
+        fprintf(stderr, "MoarVM: Initialization of GC barrier failed\n    %s\n",
+            uv_strerror(init_stat));
+        exit(1);
+    }
+    MVM_store(&i->gc_barrier.parked, 0);
+}
+
+/* Cleans up the instance's GC barrier. */
+void MVM_gc_barrier_destroy(MVMInstance *i) {
+    uv_cond_destroy(&i->gc_barrier.cond);
+    uv_mutex_destroy(&i->gc_barrier.mutex);
+}
+
+/* Waits until the specified counter reaches zero, returning non-zero. If a
+ * poll function is passed and it reports that there is something else to
+ * do, returns zero instead. How long the thread waited is added to its
+ * share of the GC run's statistics. */
+MVMuint32 MVM_gc_barrier_wait(MVMThreadContext *tc, AO_t *counter, MVMGCBarrierPoll poll, void *data) {
+    MVMGCBarrier *b = &tc->instance->gc_barrier;
+    MVMuint32     tries = 0;
+    MVMuint32     parks = 0;
+    MVMuint32     reached;
+    MVMuint64     start;
+
+    /* No need to even look at the clock if there's nothing to wait for. */
+    if (!MVM_load(counter))
+        return 1;
+
+    start = MVM_platform_now();
+    while (1) {
+        if (!MVM_load(counter)) {
+            reached = 1;
+            break;
+        }
+        if (poll && poll(tc, data)) {
+            reached = 0;
+            break;
+        }
+        if (tries < MVM_GC_BARRIER_SPINS) {
+            cpu_relax();
+            tries++;
+        }
+        else if (tries < MVM_GC_BARRIER_SPINS + MVM_GC_BARRIER_YIELDS) {
+            MVM_platform_thread_yield();
+            tries++;
+        }
+        else {
+            /* Park. We increment the parked count before checking again, and
+             * a waker changes what we wait for before checking the parked
+             * count, so one of us will see the other. */
+            MVM_incr(&b->parked);
+            uv_mutex_lock(&b->mutex);
+            if (MVM_load(counter) && !(poll && poll(tc, data)))
+                uv_cond_timedwait(&b->cond, &b->mutex, MVM_GC_BARRIER_PARK_NS);
+            uv_mutex_unlock(&b->mutex);
+            MVM_decr(&b->parked);
+            parks++;
+        }
+    }
+
+    MVM_gc_stats_barrier_wait(tc, MVM_platform_now() - start, parks);
+    return reached;
+}
+
+/* Wakes up any threads parked in the GC barrier. Must be called after any
+ * change that they may be waiting for. */
+void MVM_gc_barrier_wake(MVMThreadContext *tc) {
+    MVMGCBarrier *b = &tc->instance->gc_barrier;
+    if (MVM_load(&b->parked)) {
+        uv_mutex_lock(&b->mutex);
+        uv_cond_broadcast(&b->cond);
+        uv_mutex_unlock(&b->mutex);
+    }
+}
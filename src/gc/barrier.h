@@ -0,0 +1,32 @@
+/* Used by threads taking part in a GC run to wait for each other (not to be
+ * confused with the write barrier). A waiting thread first spins, then
+ * yields its time slice, and finally parks on a condition variable until a
+ * thread that changes something worth waiting for wakes it up. */
+struct MVMGCBarrier {
+    /* Mutex and condition variable that parked threads wait on. */
+    uv_mutex_t mutex;
+    uv_cond_t  cond;
+
+    /* The number of threads currently parked, so that waking them up can be
+     * skipped when there are none. */
+    AO_t parked;
+};
+
+/* Called while waiting to see if a thread has something better to do than
+ * continuing to wait. Should return non-zero if so. */
+typedef MVMuint32 (*MVMGCBarrierPoll)(MVMThreadContext *tc, void *data);
+
+/* How many times we spin before we start yielding, and how many times we
+ * yield before we park. */
+#define MVM_GC_BARRIER_SPINS    1000
+#define MVM_GC_BARRIER_YIELDS   16
+
+/* The longest a parked thread sleeps before re-checking what it waits for,
+ * in nanoseconds. This is only a safety net; normally it is woken. */
+#define MVM_GC_BARRIER_PARK_NS  1000000
+
+/* Functions. */
+void MVM_gc_barrier_init(MVMInstance *i);
+void MVM_gc_barrier_destroy(MVMInstance *i);
+MVMuint32 MVM_gc_barrier_wait(MVMThreadContext *tc, AO_t *counter, MVMGCBarrierPoll poll, void *data);
+void MVM_gc_barrier_wake(MVMThreadContext *tc);
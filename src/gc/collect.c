@@ -1,4 +1,6 @@
 #include "moar.h"
+#include <platform/time.h>
+#include <platform/mmap.h>
 
 /* Combines a piece of work that will be passed to another thread with the
  * ID of the target thread to pass it to. */
@@ -18,6 +20,8 @@ static void process_worklist(MVMThreadContext *tc, MVMGCWorklist *worklist, Work
 static void pass_work_item(MVMThreadContext *tc, WorkToPass *wtp, MVMCollectable **item_ptr);
 static void pass_leftover_work(MVMThreadContext *tc, WorkToPass *wtp);
 static void add_in_tray_to_worklist(MVMThreadContext *tc, MVMGCWorklist *worklist);
+static void offer_work(MVMThreadContext *tc, MVMGCWorklist *worklist);
+static void add_gen2_marks_to_worklist(MVMThreadContext *tc, MVMGCWorklist *worklist);
 
 /* Does a garbage collection run. Exactly what it does is configured by the
  * couple of arguments that it takes.
@@ -40,8 +44,11 @@ static void add_in_tray_to_worklist(MVMThreadContext *tc, MVMGCWorklist *worklis
  * Note that it adds the roots and processes them in phases, to try to avoid
  * building up a huge worklist. */
 void MVM_gc_collect(MVMThreadContext *tc, MVMuint8 what_to_do, MVMuint8 gen) {
-    /* Create a GC worklist. */
-    MVMGCWorklist *worklist = MVM_gc_worklist_create(tc, gen != MVMGCGenerations_Nursery);
+    /* Create a GC worklist. If generation 2 is being marked incrementally,
+     * we want to see generation 2 objects even in a nursery run, so we can
+     * mark them. */
+    MVMGCWorklist *worklist = MVM_gc_worklist_create(tc,
+        gen != MVMGCGenerations_Nursery || tc->gc_gen2_marking);
 
     /* Initialize work passing data structure. */
     WorkToPass wtp;
@@ -54,12 +61,27 @@ void MVM_gc_collect(MVMThreadContext *tc, MVMuint8 what_to_do, MVMuint8 gen) {
         /* Swap fromspace and tospace. */
         void * fromspace = tc->nursery_tospace;
         void * tospace   = tc->nursery_fromspace;
-        tc->nursery_fromspace = fromspace;
-        tc->nursery_tospace   = tospace;
+        MVMuint32 fromspace_size = tc->nursery_tospace_size;
+        MVMuint32 tospace_size   = tc->nursery_fromspace_size;
+
+        /* If the nursery is to change size, this is the point to do it, as
+         * nothing lives in the new tospace. It must still be big enough to
+         * take everything that may survive from the fromspace, though. */
+        if (tospace_size != tc->nursery_size) {
+            MVMuint32 used = (char *)tc->nursery_alloc - (char *)fromspace;
+            tospace_size   = used > tc->nursery_size ? used : tc->nursery_size;
+            free(tospace);
+            tospace = calloc(1, tospace_size);
+        }
+
+        tc->nursery_fromspace      = fromspace;
+        tc->nursery_tospace        = tospace;
+        tc->nursery_fromspace_size = fromspace_size;
+        tc->nursery_tospace_size   = tospace_size;
 
         /* Reset nursery allocation pointers to the new tospace. */
         tc->nursery_alloc       = tospace;
-        tc->nursery_alloc_limit = (char *)tc->nursery_alloc + MVM_NURSERY_SIZE;
+        tc->nursery_alloc_limit = (char *)tc->nursery_alloc + tospace_size;
 
         MVM_gc_worklist_add(tc, worklist, &tc->thread_obj);
         GCDEBUG_LOG(tc, MVM_GC_DEBUG_COLLECT, "Thread %d run %d : processing %d items from thread_obj\n", worklist->items);
@@ -91,6 +113,14 @@ void MVM_gc_collect(MVMThreadContext *tc, MVMuint8 what_to_do, MVMuint8 gen) {
         GCDEBUG_LOG(tc, MVM_GC_DEBUG_COLLECT, "Thread %d run %d : processing %d items from thread temps\n", worklist->items);
         process_worklist(tc, worklist, &wtp, gen);
 
+        /* If generation 2 was being marked incrementally, scan anything that
+         * got marked but not yet scanned. */
+        if (gen == MVMGCGenerations_Both) {
+            add_gen2_marks_to_worklist(tc, worklist);
+            GCDEBUG_LOG(tc, MVM_GC_DEBUG_COLLECT, "Thread %d run %d : processing %d items from gen2 marks\n", worklist->items);
+            process_worklist(tc, worklist, &wtp, gen);
+        }
+
         /* Add things that are roots for the first generation because they are
         * pointed to by objects in the second generation and process them
         * (also per-thread). Note we need not do this if we're doing a full
@@ -151,12 +181,22 @@ static void process_worklist(MVMThreadContext *tc, MVMGCWorklist *worklist, Work
 
     MVM_gc_worklist_mark_frame_roots(tc, worklist);
 
-    while ((item_ptr = MVM_gc_worklist_get(tc, worklist))) {
-        /* Dereference the object we're considering. */
-        MVMCollectable *item = *item_ptr;
+    while (1) {
+        MVMCollectable *item;
         MVMuint8 item_gen2;
         MVMuint8 to_gen2 = 0;
 
+        /* In a full collection, if we've built up a lot of work then offer
+         * some of it to threads that have run out. */
+        if (gen == MVMGCGenerations_Both && worklist->items >= MVM_GC_STEAL_THRESHOLD
+                && tc->instance->gc_steal_enabled)
+            offer_work(tc, worklist);
+
+        /* Dereference the object we're considering. */
+        if (!(item_ptr = MVM_gc_worklist_get(tc, worklist)))
+            break;
+        item = *item_ptr;
+
         /* If the item is NULL, that's fine - it's just a null reference and
          * thus we've no object to consider. */
         if (item == NULL)
@@ -166,8 +206,13 @@ static void process_worklist(MVMThreadContext *tc, MVMGCWorklist *worklist, Work
          * collection, we have nothing to do. */
         item_gen2 = item->flags & MVM_CF_SECOND_GEN;
         if (item_gen2) {
-            if (gen == MVMGCGenerations_Nursery)
+            if (gen == MVMGCGenerations_Nursery) {
+                /* Though if we're marking it incrementally, it's reachable,
+                 * so make sure it gets marked. */
+                if (tc->gc_gen2_marking && !(item->flags & MVM_CF_GEN2_LIVE))
+                    MVM_gc_collect_gen2_shade(tc, item);
                 continue;
+            }
             if (item->flags & MVM_CF_GEN2_LIVE) {
                 /* gen2 and marked as live. */
                 continue;
@@ -196,8 +241,12 @@ static void process_worklist(MVMThreadContext *tc, MVMGCWorklist *worklist, Work
         }
 
         /* If it's owned by a different thread, we need to pass it over to
-         * the owning thread. */
-        if (item->owner != tc->thread_id) {
+         * the owning thread. The exception is a gen2 object in a full
+         * collection when work stealing is on: marking it doesn't move it,
+         * so we can do it ourselves. Should two threads race to mark the
+         * same object, it is just scanned twice, which is harmless. */
+        if (item->owner != tc->thread_id &&
+                !(item_gen2 && tc->instance->gc_steal_enabled)) {
             GCDEBUG_LOG(tc, MVM_GC_DEBUG_COLLECT, "Thread %d run %d : sending a handle %p to object %p to thread %d\n", item_ptr, item, item->owner);
             pass_work_item(tc, wtp, item_ptr);
             continue;
@@ -217,7 +266,7 @@ static void process_worklist(MVMThreadContext *tc, MVMGCWorklist *worklist, Work
             if (MVM_GC_DEBUG_ENABLED(MVM_GC_DEBUG_COLLECT)) {
                 GCDEBUG_LOG(tc, MVM_GC_DEBUG_COLLECT, "Thread %d run %d : handle %p was already %p\n", item_ptr, new_addr);
             }
-            item->flags |= MVM_CF_GEN2_LIVE;
+            MVM_gc_flags_set(item, MVM_CF_GEN2_LIVE);
             assert(*item_ptr == new_addr);
         } else {
             /* Catch NULL stable (always sign of trouble) in debug mode. */
@@ -240,6 +289,7 @@ static void process_worklist(MVMThreadContext *tc, MVMGCWorklist *worklist, Work
                 memcpy(new_addr, item, item->size);
                 new_addr->flags ^= MVM_CF_NURSERY_SEEN;
                 new_addr->flags |= MVM_CF_SECOND_GEN;
+                tc->nursery_promoted += item->size;
 
                 /* If it references frames or static frames, we need to keep
                  * on visiting it. */
@@ -250,8 +300,10 @@ static void process_worklist(MVMThreadContext *tc, MVMGCWorklist *worklist, Work
                 }
 
                 /* If we're going to sweep the second generation, also need
-                 * to mark it as live. */
-                if (gen == MVMGCGenerations_Both)
+                 * to mark it as live. The same goes if we are marking it
+                 * incrementally; in that case, the scan below will shade
+                 * any generation 2 objects it references. */
+                if (gen == MVMGCGenerations_Both || tc->gc_gen2_marking)
                     new_addr->flags |= MVM_CF_GEN2_LIVE;
             }
             else {
@@ -404,8 +456,11 @@ static void push_work_to_thread_in_tray(MVMThreadContext *tc, MVMuint32 target,
         MVMGCPassedWork *orig = *target_tray;
         work->next = orig;
         if (MVM_casptr(target_tray, orig, work) == orig)
-            return;
+            break;
     }
+
+    /* The target may be parked waiting for termination; let it know. */
+    MVM_gc_barrier_wake(tc);
 }
 
 /* Adds work to list of items to pass over to another thread, and if we
@@ -489,6 +544,149 @@ static void add_in_tray_to_worklist(MVMThreadContext *tc, MVMGCWorklist *worklis
     }
 }
 
+/* Adds a chain of chunks of work to the pool of work that may be stolen. */
+static void push_work_to_steal_pool(MVMThreadContext *tc, MVMGCPassedWork *work) {
+    MVMGCPassedWork * volatile *pool = &tc->instance->gc_steal_pool;
+    MVMGCPassedWork *tail = work;
+    while (tail->next)
+        tail = tail->next;
+    while (1) {
+        MVMGCPassedWork *orig = *pool;
+        tail->next = orig;
+        if (MVM_casptr(pool, orig, work) == orig)
+            break;
+    }
+    MVM_gc_barrier_wake(tc);
+}
+
+/* If some thread is out of work and there's nothing left for it to steal,
+ * moves a chunk of items from the top of our worklist into the steal pool. */
+static void offer_work(MVMThreadContext *tc, MVMGCWorklist *worklist) {
+    MVMGCPassedWork *work;
+    MVMuint32 i;
+    if (!MVM_load(&tc->instance->gc_steal_waiting) || MVM_load(&tc->instance->gc_steal_pool))
+        return;
+    work = malloc(sizeof(MVMGCPassedWork));
+    for (i = 0; i < MVM_GC_PASS_WORK_SIZE; i++)
+        work->items[i] = worklist->list[--worklist->items];
+    work->num_items = MVM_GC_PASS_WORK_SIZE;
+    work->next      = NULL;
+    GCDEBUG_LOG(tc, MVM_GC_DEBUG_COLLECT, "Thread %d run %d : offering %d items for stealing\n", work->num_items);
+    push_work_to_steal_pool(tc, work);
+}
+
+/* Tries to steal a chunk of work that another thread offered up during a
+ * full collection, and does it. Returns non-zero if any work was stolen. */
+MVMuint32 MVM_gc_collect_steal(MVMThreadContext *tc, MVMuint8 gen) {
+    MVMGCPassedWork * volatile *pool = &tc->instance->gc_steal_pool;
+    MVMGCPassedWork *head;
+    MVMGCWorklist   *worklist;
+    WorkToPass       wtp;
+    MVMuint32        i;
+
+    /* Take the whole pool (taking just the head would be open to the ABA
+     * problem), then put back all but the first chunk for others. */
+    while (1) {
+        head = *pool;
+        if (head == NULL)
+            return 0;
+        if (MVM_casptr(pool, head, NULL) == head)
+            break;
+    }
+    if (head->next) {
+        push_work_to_steal_pool(tc, head->next);
+        head->next = NULL;
+    }
+
+    /* Process the chunk just like any other work. */
+    GCDEBUG_LOG(tc, MVM_GC_DEBUG_COLLECT, "Thread %d run %d : stole %d items\n", head->num_items);
+    worklist = MVM_gc_worklist_create(tc, gen != MVMGCGenerations_Nursery);
+    wtp.num_target_threads = 0;
+    wtp.target_work = NULL;
+    for (i = 0; i < head->num_items; i++)
+        MVM_gc_worklist_add(tc, worklist, head->items[i]);
+    free(head);
+    process_worklist(tc, worklist, &wtp, gen);
+    MVM_gc_worklist_destroy(tc, worklist);
+    if (wtp.num_target_threads) {
+        pass_leftover_work(tc, &wtp);
+        free(wtp.target_work);
+    }
+
+    return 1;
+}
+
+/* Marks a generation 2 object during incremental marking, and pushes it
+ * onto the mark stack so that it will be scanned later. */
+void MVM_gc_collect_gen2_shade(MVMThreadContext *tc, MVMCollectable *item) {
+    MVM_gc_flags_set(item, MVM_CF_GEN2_LIVE);
+    if (tc->num_gen2marks == tc->alloc_gen2marks) {
+        tc->alloc_gen2marks = tc->alloc_gen2marks ? tc->alloc_gen2marks * 2 : 64;
+        tc->gen2marks = realloc(tc->gen2marks,
+            sizeof(MVMCollectable *) * tc->alloc_gen2marks);
+    }
+    tc->gen2marks[tc->num_gen2marks++] = item;
+}
+
+/* Does a chunk of incremental generation 2 marking, scanning objects from
+ * the mark stack until it is empty or the deadline passes. Other threads may
+ * still be evacuating their nurseries, and updating the flags of generation
+ * 2 objects we shade, which is why shading sets the mark atomically. It only
+ * reads the objects otherwise. Frames are skipped, as they are written to
+ * without a barrier; all objects that reference frames are in the gen2
+ * roots, which get scanned again in the final pause. Nursery objects are
+ * also skipped, since the final pause will trace them all anyway. */
+void MVM_gc_collect_gen2_increment(MVMThreadContext *tc, MVMuint64 deadline) {
+    MVMGCWorklist   *worklist;
+    MVMCollectable **item_ptr;
+    MVMuint32        scanned = 0;
+
+    if (!tc->num_gen2marks)
+        return;
+
+    worklist = MVM_gc_worklist_create(tc, 1);
+    while (tc->num_gen2marks) {
+        MVMCollectable *item = tc->gen2marks[--tc->num_gen2marks];
+
+        /* Scan it, shading any unmarked generation 2 objects it points to. */
+        MVM_gc_mark_collectable(tc, worklist, item);
+        worklist->frames = 0;
+        while ((item_ptr = MVM_gc_worklist_get(tc, worklist))) {
+            MVMCollectable *child = *item_ptr;
+            if (child && (child->flags & MVM_CF_SECOND_GEN) && !(child->flags & MVM_CF_GEN2_LIVE))
+                MVM_gc_collect_gen2_shade(tc, child);
+        }
+
+        /* Checking the time is not free, so only do it now and then. */
+        if ((++scanned & 127) == 0 && MVM_platform_now() >= deadline)
+            break;
+    }
+    MVM_gc_worklist_destroy(tc, worklist);
+
+    GCDEBUG_LOG(tc, MVM_GC_DEBUG_COLLECT, "Thread %d run %d : scanned %d gen2 objects incrementally, %d left\n",
+        scanned, tc->num_gen2marks);
+}
+
+/* Adds the objects that incremental marking marked but did not get to scan
+ * to the worklist. Marked objects are skipped when reached again, so those
+ * in the gen2 roots are scanned again too: they may have had nursery objects
+ * (or frames, which are written to without a barrier) stored into them since
+ * they were scanned, and nothing else may lead to those. */
+static void add_gen2_marks_to_worklist(MVMThreadContext *tc, MVMGCWorklist *worklist) {
+    MVMuint32 i;
+    while (tc->num_gen2marks) {
+        MVMCollectable *item = tc->gen2marks[--tc->num_gen2marks];
+        MVM_gc_mark_collectable(tc, worklist, item);
+    }
+    if (tc->instance->gc_mark_budget) {
+        for (i = 0; i < tc->num_gen2roots; i++) {
+            MVMCollectable *root = tc->gen2roots[i];
+            if (root->flags & MVM_CF_GEN2_LIVE)
+                MVM_gc_mark_collectable(tc, worklist, root);
+        }
+    }
+}
+
 /* Save dead STable pointers to delete later.. */
 static void MVM_gc_collect_enqueue_stable_for_deletion(MVMThreadContext *tc, MVMSTable *st) {
     MVMSTable *old_head;
@@ -530,6 +728,22 @@ void MVM_gc_collect_free_nursery_uncopied(MVMThreadContext *tc, void *limit) {
             if (dead && item->flags & MVM_CF_SERIALZATION_INDEX_ALLOCATED)
                 free(item->sc_forward_u.sci);
 #endif
+            /* Note whether it died young or was promoted, to decide if its
+             * type should be pretenured. A dead object's STable may itself
+             * have been moved, so follow it; a promoted object's copy has
+             * already had its STable pointer updated. */
+            if (dead) {
+                MVMSTable *st = obj->st;
+                if (st->header.flags & MVM_CF_FORWARDER_VALID)
+                    st = (MVMSTable *)st->header.sc_forward_u.forwarder;
+                if (!st->pretenure && ++st->gc_died + st->gc_survived >= MVM_GC_PRETENURE_SAMPLES)
+                    MVM_gc_allocate_pretenure_update(tc, st);
+            }
+            else if (item->sc_forward_u.forwarder->flags & MVM_CF_SECOND_GEN) {
+                MVMSTable *st = ((MVMObject *)item->sc_forward_u.forwarder)->st;
+                if (!st->pretenure && ++st->gc_survived + st->gc_died >= MVM_GC_PRETENURE_SAMPLES)
+                    MVM_gc_allocate_pretenure_update(tc, st);
+            }
         }
         else if (item->flags & MVM_CF_TYPE_OBJECT) {
             /* Type object */
@@ -575,6 +789,42 @@ void MVM_gc_collect_free_stables(MVMThreadContext *tc) {
     tc->instance->stables_to_free = NULL;
 }
 
+/* Called once a thread's nursery has been collected, with the limit of what
+ * was allocated in its fromspace, to decide how big its nursery should be
+ * from here on. A thread that filled its nursery and saw a good part of it
+ * survive gets a bigger one, so that objects have longer to die before they
+ * are promoted and runs happen less often. A thread that barely used its
+ * nursery gets a smaller one. The new size is applied to the next tospace
+ * when the spaces are next swapped; we can't free the fromspace here, as it
+ * may hold STables that are waiting to be freed. */
+void MVM_gc_collect_adapt_nursery(MVMThreadContext *tc, void *limit) {
+    MVMuint64 capacity = tc->nursery_fromspace_size;
+    MVMuint64 used     = (char *)limit - (char *)tc->nursery_fromspace;
+    MVMuint64 copied   = (char *)tc->nursery_alloc - (char *)tc->nursery_tospace;
+    MVMuint64 survived = copied + tc->nursery_promoted;
+    MVMuint64 size     = tc->nursery_size;
+
+    tc->nursery_promoted = 0;
+    if (!tc->instance->nursery_adaptive)
+        return;
+
+    if (used >= capacity - capacity / 8
+            && survived * 100 >= used * MVM_NURSERY_GROW_SURVIVAL)
+        size *= 2;
+    else if (used < capacity / 4 && copied * 2 <= size / 2)
+        size /= 2;
+
+    if (size < MVM_NURSERY_MIN_SIZE)
+        size = MVM_NURSERY_MIN_SIZE;
+    if (size > MVM_NURSERY_MAX_SIZE)
+        size = MVM_NURSERY_MAX_SIZE;
+    if (size != tc->nursery_size) {
+        GCDEBUG_LOG(tc, MVM_GC_DEBUG_COLLECT, "Thread %d run %d : resizing nursery from %u to %u bytes\n",
+            tc->nursery_size, (MVMuint32)size);
+        tc->nursery_size = (MVMuint32)size;
+    }
+}
+
 /* Goes through the unmarked objects in the second generation heap and builds
  * free lists out of them. Also does any required finalization. */
 void MVM_gc_collect_free_gen2_unmarked(MVMThreadContext *tc) {
@@ -583,6 +833,8 @@ void MVM_gc_collect_free_gen2_unmarked(MVMThreadContext *tc) {
     MVMuint32 bin, obj_size, page, i;
     char ***freelist_insert_pos;
     for (bin = 0; bin < MVM_GEN2_BINS; bin++) {
+        MVMuint32 empty_pages = 0, released_pages = 0;
+
         /* If we've nothing allocated in this size class, skip it. */
         if (gen2->size_classes[bin].pages == NULL)
             continue;
@@ -604,6 +856,12 @@ void MVM_gc_collect_free_gen2_unmarked(MVMThreadContext *tc) {
                 ? gen2->size_classes[bin].alloc_pos
                 : cur_ptr + obj_size * MVM_GEN2_PAGE_ITEMS;
             char **last_insert_pos = NULL;
+
+            /* Keep track of where this page's free list entries start, and
+             * how many there are, so we can tell if it is entirely free. */
+            char ***page_insert_pos = freelist_insert_pos;
+            MVMuint32 free_items = 0;
+
             while (cur_ptr < end_ptr) {
                 MVMCollectable *col = (MVMCollectable *)cur_ptr;
 
@@ -611,13 +869,14 @@ void MVM_gc_collect_free_gen2_unmarked(MVMThreadContext *tc) {
                  * new free list insert position. */
                 if (*freelist_insert_pos == (char **)cur_ptr) {
                     freelist_insert_pos = (char ***)cur_ptr;
+                    free_items++;
                 }
 
                 /* Otherwise, it must be a collectable of some kind. Is it
                  * live? */
                 else if (col->flags & MVM_CF_GEN2_LIVE) {
                     /* Yes; clear the mark. */
-                    col->flags &= ~MVM_CF_GEN2_LIVE;
+                    MVM_gc_flags_clear(col, MVM_CF_GEN2_LIVE);
                 }
                 else {
                     GCDEBUG_LOG(tc, MVM_GC_DEBUG_COLLECT, "Thread %d run %d : collecting an object %p in the gen2\n", col);
@@ -627,6 +886,13 @@ void MVM_gc_collect_free_gen2_unmarked(MVMThreadContext *tc) {
                         MVMObject *obj = (MVMObject *)col;
                         if (REPR(obj)->gc_free)
                             REPR(obj)->gc_free(tc, obj);
+                        if (obj->st->pretenure) {
+                            /* Pretenured; see if too many die anyway. */
+                            MVMSTable *st = obj->st;
+                            if (++st->gc_died * 100 > st->gc_survived * (100 - MVM_GC_PRETENURE_SURVIVAL)
+                                    && st->gc_survived >= MVM_GC_PRETENURE_SAMPLES)
+                                MVM_gc_allocate_pretenure_update(tc, st);
+                        }
 #ifdef MVM_USE_OVERFLOW_SERIALIZATION_INDEX
                         if (col->flags & MVM_CF_SERIALZATION_INDEX_ALLOCATED)
                             free(col->sc_forward_u.sci);
@@ -686,11 +952,43 @@ void MVM_gc_collect_free_gen2_unmarked(MVMThreadContext *tc) {
 
                     /* Update the pointer to the insert position to point to us */
                     freelist_insert_pos = (char ***)cur_ptr;
+                    free_items++;
                 }
 
                 /* Move to the next object. */
                 cur_ptr += obj_size;
             }
+
+            /* If nothing on the page is in use, and it's not the page we're
+             * allocating in, then once we have kept a few such pages around
+             * to allocate into, unlink its slots from the free list and give
+             * the page back. Pages are small enough that malloc would keep
+             * the memory, so we tell the OS it can have it first. */
+            if (free_items == MVM_GEN2_PAGE_ITEMS && page + 1 < gen2->size_classes[bin].num_pages) {
+                if (empty_pages++ >= MVM_GEN2_EMPTY_PAGES_KEPT) {
+                    *page_insert_pos = *freelist_insert_pos;
+                    freelist_insert_pos = page_insert_pos;
+                    MVM_platform_discard_pages(gen2->size_classes[bin].pages[page],
+                        MVM_GEN2_PAGE_ITEMS * obj_size);
+                    free(gen2->size_classes[bin].pages[page]);
+                    gen2->size_classes[bin].pages[page] = NULL;
+                    released_pages++;
+                }
+            }
+        }
+
+        /* Close up the gaps in the page list left by any pages we released,
+         * keeping the page order the free list follows. */
+        if (released_pages) {
+            MVMuint32 num_pages = gen2->size_classes[bin].num_pages;
+            MVMuint32 insert_pos = 0;
+            GCDEBUG_LOG(tc, MVM_GC_DEBUG_COLLECT, "Thread %d run %d : releasing %d empty pages from gen2 bin %d\n",
+                released_pages, bin);
+            for (page = 0; page < num_pages; page++)
+                if (gen2->size_classes[bin].pages[page])
+                    gen2->size_classes[bin].pages[insert_pos++] = gen2->size_classes[bin].pages[page];
+            gen2->size_classes[bin].num_pages = insert_pos;
+            gen2->size_classes[bin].cur_page  = insert_pos - 1;
         }
     }
     
@@ -700,7 +998,7 @@ void MVM_gc_collect_free_gen2_unmarked(MVMThreadContext *tc) {
             MVMCollectable *col = gen2->overflows[i];
             if (col->flags & MVM_CF_GEN2_LIVE) {
                 /* A living over-sized object; just clear the mark. */
-                col->flags &= ~MVM_CF_GEN2_LIVE;
+                MVM_gc_flags_clear(col, MVM_CF_GEN2_LIVE);
             }
             else {
                 /* Dead over-sized object. We know if it's this big it cannot
@@ -1,7 +1,14 @@
-/* How big is the nursery area? Note that since it's semi-space copying, we
- * actually have double this amount allocated. Also it is per thread. (In
- * the future, we'll make this adaptive rather than a constant.) */
-#define MVM_NURSERY_SIZE 4194304
+/* How big is the nursery area by default? Note that since it's semi-space
+ * copying, we actually have double this amount allocated. Also it is per
+ * thread. It can be set at startup, and each thread's nursery then adapts
+ * to how it allocates, staying within the minimum and maximum sizes. */
+#define MVM_NURSERY_SIZE     4194304
+#define MVM_NURSERY_MIN_SIZE 262144
+#define MVM_NURSERY_MAX_SIZE 67108864
+
+/* A thread's nursery grows if it filled up and at least this percentage of
+ * what was allocated survived the run. */
+#define MVM_NURSERY_GROW_SURVIVAL 10
 
 /* How often do we collect the second generation? This is specified as the
  * number of nursery runs that happen per full collection. For example, if
@@ -30,6 +37,20 @@ typedef enum {
     MVMGCGenerations_Both = 1
 } MVMGCGenerations;
 
+/* Where we are in collecting generation 2, when it is marked incrementally
+ * rather than all in one go. */
+typedef enum {
+    /* Not collecting generation 2. */
+    MVMGCGen2Phase_Idle = 0,
+
+    /* Generation 2 is marked a bit at a time, as part of nursery runs. */
+    MVMGCGen2Phase_Marking = 1,
+
+    /* Marking is close to done; the next run will finish it off, in the
+     * same way as a full collection, and then sweep. */
+    MVMGCGen2Phase_Remark = 2
+} MVMGCGen2Phase;
+
 /* The number of items we must reach in a bucket of work before passing it
  * off to the next thread. (Power of 2, minus 2, is a decent choice.) */
 #define MVM_GC_PASS_WORK_SIZE   62
@@ -42,9 +63,18 @@ struct MVMGCPassedWork {
     MVMint32         num_items;
 };
 
+/* The number of items a thread's worklist must hold during a full
+ * collection before it will offer a chunk of them up for idle threads to
+ * steal. */
+#define MVM_GC_STEAL_THRESHOLD  (4 * MVM_GC_PASS_WORK_SIZE)
+
 /* Functions. */
 void MVM_gc_collect(MVMThreadContext *tc, MVMuint8 what_to_do, MVMuint8 gen);
 void MVM_gc_collect_free_nursery_uncopied(MVMThreadContext *tc, void *limit);
+void MVM_gc_collect_adapt_nursery(MVMThreadContext *tc, void *limit);
 void MVM_gc_collect_free_gen2_unmarked(MVMThreadContext *tc);
 void MVM_gc_mark_collectable(MVMThreadContext *tc, MVMGCWorklist *worklist, MVMCollectable *item);
 void MVM_gc_collect_free_stables(MVMThreadContext *tc);
+MVMuint32 MVM_gc_collect_steal(MVMThreadContext *tc, MVMuint8 gen);
+void MVM_gc_collect_gen2_shade(MVMThreadContext *tc, MVMCollectable *item);
+void MVM_gc_collect_gen2_increment(MVMThreadContext *tc, MVMuint64 deadline);
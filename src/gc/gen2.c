@@ -240,6 +240,16 @@ void MVM_gc_gen2_transfer(MVMThreadContext *src, MVMThreadContext *dest) {
         free(src->gen2roots);
         src->gen2roots = NULL;
     }
+    { /* ...and anything incremental marking has yet to scan. */
+        MVMuint32 i, n = src->num_gen2marks;
+        for ( i = 0; i < n; i++) {
+            MVM_gc_collect_gen2_shade(dest, src->gen2marks[i]);
+        }
+        src->num_gen2marks = 0;
+        src->alloc_gen2marks = 0;
+        free(src->gen2marks);
+        src->gen2marks = NULL;
+    }
 }
 
 
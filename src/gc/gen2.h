@@ -64,6 +64,10 @@ struct MVMGen2Allocator {
 /* The number of items that go into each page. */
 #define MVM_GEN2_PAGE_ITEMS 256
 
+/* The number of entirely free pages a size class holds on to after a full
+ * collection; any more are released. */
+#define MVM_GEN2_EMPTY_PAGES_KEPT 2
+
 /* Functions. */
 MVMGen2Allocator * MVM_gc_gen2_create(MVMInstance *i);
 void * MVM_gc_gen2_allocate(MVMGen2Allocator *al, MVMuint32 size);
@@ -1,5 +1,6 @@
 #include "moar.h"
 #include <platform/threads.h>
+#include <platform/time.h>
 
 /* If we have the job of doing GC for a thread, we add it to our work
  * list. */
@@ -114,30 +115,120 @@ static int process_in_tray(MVMThreadContext *tc, MVMuint8 gen) {
     return 0;
 }
 
+/* Does work in the in-trays of the threads we're doing GC for and, in a
+ * full collection, any work offered up for stealing, until there's none
+ * left. */
+static void do_extra_work(MVMThreadContext *tc, MVMuint8 gen) {
+    MVMuint32 i, did_work = 1;
+    while (did_work) {
+        did_work = 0;
+        for (i = 0; i < tc->gc_work_count; i++)
+            did_work += process_in_tray(tc->gc_work[i].tc, gen);
+        if (gen == MVMGCGenerations_Both && tc->instance->gc_steal_enabled)
+            did_work += MVM_gc_collect_steal(tc, gen);
+    }
+}
+
+/* Checks if there is work for a thread that already voted to finish. Used
+ * as a GC barrier poll function, so the generation is passed by pointer. */
+static MVMuint32 extra_work_available(MVMThreadContext *tc, void *gen_ptr) {
+    MVMuint8  gen = *(MVMuint8 *)gen_ptr;
+    MVMuint32 i;
+    if (gen == MVMGCGenerations_Both && tc->instance->gc_steal_enabled
+            && MVM_load(&tc->instance->gc_steal_pool))
+        return 1;
+    for (i = 0; i < tc->gc_work_count; i++)
+        if (MVM_load(&tc->gc_work[i].tc->gc_in_tray))
+            return 1;
+    return 0;
+}
+
+/* Takes back a vote to finish, provided termination was not yet agreed.
+ * Returns non-zero on success. */
+static MVMuint32 try_unvote(MVMThreadContext *tc) {
+    AO_t curr;
+    while ((curr = MVM_load(&tc->instance->gc_finish)) > 0)
+        if (MVM_trycas(&tc->instance->gc_finish, curr, curr + 1))
+            return 1;
+    return 0;
+}
+
+/* With incremental generation 2 marking, decides what the next GC run will
+ * do. Called by the co-ordinator once all threads are done with this run. A
+ * heap snapshot needs a full collection, so if one is waiting we go straight
+ * to the final pause. */
+static void update_gen2_phase(MVMThreadContext *tc) {
+    MVMInstance *i   = tc->instance;
+    AO_t         seq = MVM_load(&i->gc_seq_number);
+    MVMThread   *cur_thread;
+
+    switch (MVM_load(&i->gc_gen2_phase)) {
+        case MVMGCGen2Phase_Idle:
+            if (seq % MVM_GC_GEN2_RATIO == 0) {
+                GCDEBUG_LOG(tc, MVM_GC_DEBUG_ORCHESTRATE,
+                    "Thread %d run %d : starting incremental gen2 marking\n");
+                MVM_store(&i->gc_gen2_phase_start, seq);
+                MVM_store(&i->gc_gen2_phase, MVMGCGen2Phase_Marking);
+            }
+            else if (MVM_load(&i->heap_snapshot_path)) {
+                MVM_store(&i->gc_gen2_phase, MVMGCGen2Phase_Remark);
+            }
+            return;
+        case MVMGCGen2Phase_Marking:
+            /* If marking is dragging on, because the mutators keep giving
+             * us more, just finish it in one go. */
+            if (seq - MVM_load(&i->gc_gen2_phase_start) < MVM_GC_GEN2_RATIO
+                    && !MVM_load(&i->heap_snapshot_path)) {
+                cur_thread = (MVMThread *)MVM_load(&i->threads);
+                while (cur_thread) {
+                    if (cur_thread->body.tc && cur_thread->body.tc->num_gen2marks)
+                        return;
+                    cur_thread = cur_thread->body.next;
+                }
+            }
+            GCDEBUG_LOG(tc, MVM_GC_DEBUG_ORCHESTRATE,
+                "Thread %d run %d : incremental gen2 marking ready for final pause\n");
+            MVM_store(&i->gc_gen2_phase, MVMGCGen2Phase_Remark);
+            return;
+        case MVMGCGen2Phase_Remark:
+            MVM_store(&i->gc_gen2_phase, MVMGCGen2Phase_Idle);
+            return;
+    }
+}
+
 /* Called by a thread when it thinks it is done with GC. It may get some more
  * work yet, though. */
 static void finish_gc(MVMThreadContext *tc, MVMuint8 gen, MVMuint8 is_coordinator) {
     MVMuint32 i, did_work;
+    MVMuint32 may_steal = gen == MVMGCGenerations_Both && tc->instance->gc_steal_enabled;
 
     /* Do any extra work that we have been passed. */
     GCDEBUG_LOG(tc, MVM_GC_DEBUG_ORCHESTRATE,
         "Thread %d run %d : doing any work in thread in-trays\n");
-    did_work = 1;
-    while (did_work) {
-        did_work = 0;
-        for (i = 0; i < tc->gc_work_count; i++)
-            did_work += process_in_tray(tc->gc_work[i].tc, gen);
-    }
+    do_extra_work(tc, gen);
 
-    /* Decrement gc_finish to say we're done, and wait for termination. */
+    /* Decrement gc_finish to say we're done, and wait for termination. If
+     * more work turns up while we wait, take back our vote and do it. */
     GCDEBUG_LOG(tc, MVM_GC_DEBUG_ORCHESTRATE, "Thread %d run %d : Voting to finish\n");
+    if (may_steal)
+        MVM_incr(&tc->instance->gc_steal_waiting);
     MVM_decr(&tc->instance->gc_finish);
-    while (MVM_load(&tc->instance->gc_finish)) {
-        for (i = 0; i < 1000; i++)
-            ; /* XXX Something HT-efficienter. */
-        /* XXX Here we can look to see if we got passed any work, and if so
-         * try to un-vote. */
+    MVM_gc_barrier_wake(tc);
+    while (!MVM_gc_barrier_wait(tc, &tc->instance->gc_finish, extra_work_available, &gen)) {
+        if (try_unvote(tc)) {
+            GCDEBUG_LOG(tc, MVM_GC_DEBUG_ORCHESTRATE,
+                "Thread %d run %d : Un-voted to do extra work\n");
+            if (may_steal)
+                MVM_decr(&tc->instance->gc_steal_waiting);
+            do_extra_work(tc, gen);
+            if (may_steal)
+                MVM_incr(&tc->instance->gc_steal_waiting);
+            MVM_decr(&tc->instance->gc_finish);
+            MVM_gc_barrier_wake(tc);
+        }
     }
+    if (may_steal)
+        MVM_decr(&tc->instance->gc_steal_waiting);
     GCDEBUG_LOG(tc, MVM_GC_DEBUG_ORCHESTRATE, "Thread %d run %d : Termination agreed\n");
 
     /* Co-ordinator should do final check over all the in-trays, and trigger
@@ -155,6 +246,8 @@ static void finish_gc(MVMThreadContext *tc, MVMuint8 gen, MVMuint8 is_coordinato
                     did_work += process_in_tray(cur_thread->body.tc, gen);
                 cur_thread = cur_thread->body.next;
             }
+            if (may_steal)
+                did_work += MVM_gc_collect_steal(tc, gen);
         }
         if (gen == MVMGCGenerations_Both) {
             MVMThread *cur_thread = (MVMThread *)MVM_load(&tc->instance->threads);
@@ -164,16 +257,22 @@ static void finish_gc(MVMThreadContext *tc, MVMuint8 gen, MVMuint8 is_coordinato
                 cur_thread = cur_thread->body.next;
             }
         }
+        if (gen == MVMGCGenerations_Both && MVM_load(&tc->instance->heap_snapshot_path)) {
+            GCDEBUG_LOG(tc, MVM_GC_DEBUG_ORCHESTRATE,
+                "Thread %d run %d : Co-ordinator writing heap snapshot\n");
+            MVM_gc_snapshot_write(tc);
+        }
+        if (tc->instance->gc_mark_budget)
+            update_gen2_phase(tc);
         GCDEBUG_LOG(tc, MVM_GC_DEBUG_ORCHESTRATE,
             "Thread %d run %d : Co-ordinator signalling in-trays clear\n");
         MVM_store(&tc->instance->gc_intrays_clearing, 0);
+        MVM_gc_barrier_wake(tc);
     }
     else {
         GCDEBUG_LOG(tc, MVM_GC_DEBUG_ORCHESTRATE,
             "Thread %d run %d : Waiting for in-tray clearing completion\n");
-        while (MVM_load(&tc->instance->gc_intrays_clearing))
-            for (i = 0; i < 1000; i++)
-                ; /* XXX Something HT-efficienter. */
+        MVM_gc_barrier_wait(tc, &tc->instance->gc_intrays_clearing, NULL, NULL);
         GCDEBUG_LOG(tc, MVM_GC_DEBUG_ORCHESTRATE,
             "Thread %d run %d : Got in-tray clearing complete notice\n");
     }
@@ -213,6 +312,7 @@ static void finish_gc(MVMThreadContext *tc, MVMuint8 gen, MVMuint8 is_coordinato
         /* Set it to zero (we're guaranteed the only ones trying to write to
          * it here). Actual STable free in MVM_gc_enter_from_allocator. */
         MVM_store(&tc->instance->gc_ack, 0);
+        MVM_gc_barrier_wake(tc);
     }
 }
 
@@ -251,23 +351,52 @@ void MVM_gc_mark_thread_unblocked(MVMThreadContext *tc) {
 
 static void run_gc(MVMThreadContext *tc, MVMuint8 what_to_do) {
     MVMuint8   gen;
+    MVMuint8   gen2_marking = 0;
     MVMThread *child;
     MVMuint32  i, n;
 
-    /* Decide nursery or full collection. */
-    gen = MVM_load(&tc->instance->gc_seq_number) % MVM_GC_GEN2_RATIO == 0
-        ? MVMGCGenerations_Both
-        : MVMGCGenerations_Nursery;
+    /* Decide nursery or full collection. If generation 2 is marked
+     * incrementally, the full collection only happens to finish off the
+     * marking; otherwise, we work out if we're marking this time. */
+    if (tc->instance->gc_mark_budget) {
+        AO_t phase = MVM_load(&tc->instance->gc_gen2_phase);
+        if (phase == MVMGCGen2Phase_Remark) {
+            gen = MVMGCGenerations_Both;
+        }
+        else {
+            gen = MVMGCGenerations_Nursery;
+            gen2_marking = phase == MVMGCGen2Phase_Marking
+                || MVM_load(&tc->instance->gc_seq_number) % MVM_GC_GEN2_RATIO == 0;
+        }
+    }
+    else {
+        /* A waiting heap snapshot also makes it a full collection. The
+         * snapshot can't be asked for while we're in here, so all threads
+         * agree on this. */
+        gen = MVM_load(&tc->instance->gc_seq_number) % MVM_GC_GEN2_RATIO == 0
+                || MVM_load(&tc->instance->heap_snapshot_path)
+            ? MVMGCGenerations_Both
+            : MVMGCGenerations_Nursery;
+    }
 
     /* Do GC work for ourselve and any work threads. */
     for (i = 0, n = tc->gc_work_count ; i < n; i++) {
         MVMThreadContext *other = tc->gc_work[i].tc;
         tc->gc_work[i].limit = other->nursery_alloc;
+        other->gc_gen2_marking = gen2_marking;
         GCDEBUG_LOG(tc, MVM_GC_DEBUG_ORCHESTRATE, "Thread %d run %d : starting collection for thread %d\n",
             other->thread_id);
         MVM_gc_collect(other, (other == tc ? what_to_do : MVMGCWhatToDo_NoInstance), gen);
     }
 
+    /* If we're marking generation 2 incrementally, do some of that, within
+     * the time budget. */
+    if (gen2_marking) {
+        MVMuint64 deadline = MVM_platform_now() + tc->instance->gc_mark_budget;
+        for (i = 0, n = tc->gc_work_count ; i < n; i++)
+            MVM_gc_collect_gen2_increment(tc->gc_work[i].tc, deadline);
+    }
+
     /* Wait for everybody to agree we're done. */
     finish_gc(tc, gen, what_to_do == MVMGCWhatToDo_All);
 
@@ -293,7 +422,14 @@ static void run_gc(MVMThreadContext *tc, MVMuint8 what_to_do) {
                 other->thread_id);
             MVM_gc_collect_free_gen2_unmarked(other);
         }
+
+        /* Record how it went, then resize the nursery if needed. */
+        MVM_gc_stats_run_add(tc, other, tc->gc_work[i].limit, gen);
+        MVM_gc_collect_adapt_nursery(other, tc->gc_work[i].limit);
     }
+
+    /* Add our share of the statistics for the run. */
+    MVM_gc_stats_run_done(tc);
 }
 
 /* This is called when the allocator finds it has run out of memory and wants
@@ -310,11 +446,9 @@ void MVM_gc_enter_from_allocator(MVMThreadContext *tc) {
         MVMuint32 num_threads = 0;
 
         /* Need to wait for other threads to reset their gc_status. */
-        while (MVM_load(&tc->instance->gc_ack)) {
-            GCDEBUG_LOG(tc, MVM_GC_DEBUG_ORCHESTRATE,
-                "Thread %d run %d : waiting for other thread's gc_ack\n");
-            MVM_platform_thread_yield();
-        }
+        GCDEBUG_LOG(tc, MVM_GC_DEBUG_ORCHESTRATE,
+            "Thread %d run %d : waiting for other thread's gc_ack\n");
+        MVM_gc_barrier_wait(tc, &tc->instance->gc_ack, NULL, NULL);
 
         /* We are the winner of the GC starting race. This gives us some
          * extra responsibilities as well as doing the usual things.
@@ -323,6 +457,7 @@ void MVM_gc_enter_from_allocator(MVMThreadContext *tc) {
         GCDEBUG_LOG(tc, MVM_GC_DEBUG_ORCHESTRATE,
             "Thread %d run %d : GC thread elected coordinator: starting gc seq %d\n",
             (int)MVM_load(&tc->instance->gc_seq_number));
+        MVM_gc_stats_run_start(tc);
 
         /* Ensure our stolen list is empty. */
         tc->gc_work_count = 0;
@@ -349,6 +484,7 @@ void MVM_gc_enter_from_allocator(MVMThreadContext *tc) {
                 if (add) {
                     GCDEBUG_LOG(tc, MVM_GC_DEBUG_ORCHESTRATE, "Thread %d run %d : Found %d other threads\n", add);
                     MVM_add(&tc->instance->gc_start, add);
+                    MVM_gc_barrier_wake(tc);
                     num_threads += add;
                 }
             }
@@ -364,6 +500,7 @@ void MVM_gc_enter_from_allocator(MVMThreadContext *tc) {
          * can also free the STables. */
         MVM_store(&tc->instance->gc_finish, num_threads + 1);
         MVM_store(&tc->instance->gc_ack, num_threads + 2);
+        MVM_store(&tc->instance->gc_stats_pending, num_threads + 1);
         GCDEBUG_LOG(tc, MVM_GC_DEBUG_ORCHESTRATE, "Thread %d run %d : finish votes is %d\n",
             (int)MVM_load(&tc->instance->gc_finish));
 
@@ -371,6 +508,7 @@ void MVM_gc_enter_from_allocator(MVMThreadContext *tc) {
         GCDEBUG_LOG(tc, MVM_GC_DEBUG_ORCHESTRATE, "Thread %d run %d : coordinator signalling start\n");
         if (MVM_decr(&tc->instance->gc_start) != 1)
             MVM_panic(MVM_exitcode_gcorch, "Start votes was %d\n", MVM_load(&tc->instance->gc_start));
+        MVM_gc_barrier_wake(tc);
 
         /* Start collecting. */
         GCDEBUG_LOG(tc, MVM_GC_DEBUG_ORCHESTRATE, "Thread %d run %d : coordinator entering run_gc\n");
@@ -392,32 +530,35 @@ void MVM_gc_enter_from_allocator(MVMThreadContext *tc) {
     }
 }
 
+/* Votes that we're ready to start a GC run. Only want to decrement the count
+ * of votes still needed if it's 2 or greater (0 should never happen; 1 means
+ * the coordinator is still counting up how many threads will join in, so we
+ * should wait until it decides to decrement). Used as a GC barrier poll
+ * function; returns non-zero once the vote is cast. */
+static MVMuint32 try_vote_start(MVMThreadContext *tc, void *unused) {
+    AO_t curr = MVM_load(&tc->instance->gc_start);
+    return curr >= 2 && MVM_trycas(&tc->instance->gc_start, curr, curr - 1);
+}
+
 /* This is called when a thread hits an interrupt at a GC safe point. This means
  * that another thread is already trying to start a GC run, so we don't need to
  * try and do that, just enlist in the run. */
 void MVM_gc_enter_from_interrupt(MVMThreadContext *tc) {
-    AO_t curr;
-
     GCDEBUG_LOG(tc, MVM_GC_DEBUG_ORCHESTRATE, "Thread %d run %d : Entered from interrupt\n");
 
     /* We'll certainly take care of our own work. */
     tc->gc_work_count = 0;
     add_work(tc, tc);
 
-    /* Indicate that we're ready to GC. Only want to decrement it if it's 2 or
-     * greater (0 should never happen; 1 means the coordinator is still counting
-     * up how many threads will join in, so we should wait until it decides to
-     * decrement.) */
-    while ((curr = MVM_load(&tc->instance->gc_start)) < 2
-            || !MVM_trycas(&tc->instance->gc_start, curr, curr - 1)) {
-        /* MVM_platform_thread_yield();*/
-    }
+    /* Indicate that we're ready to GC, waiting until the coordinator has
+     * counted us in if need be. We're among the votes it waits for, so the
+     * count can't reach zero before we cast ours. */
+    MVM_gc_barrier_wait(tc, &tc->instance->gc_start, try_vote_start, NULL);
 
     /* Wait for all threads to indicate readiness to collect. */
     GCDEBUG_LOG(tc, MVM_GC_DEBUG_ORCHESTRATE, "Thread %d run %d : Waiting for other threads\n");
-    while (MVM_load(&tc->instance->gc_start)) {
-        /* MVM_platform_thread_yield();*/
-    }
+    MVM_gc_barrier_wake(tc);
+    MVM_gc_barrier_wait(tc, &tc->instance->gc_start, NULL, NULL);
 
     GCDEBUG_LOG(tc, MVM_GC_DEBUG_ORCHESTRATE, "Thread %d run %d : Entering run_gc\n");
     run_gc(tc, MVMGCWhatToDo_NoInstance);
@@ -427,6 +568,7 @@ void MVM_gc_enter_from_interrupt(MVMThreadContext *tc) {
 /* Run the global destruction phase. */
 void MVM_gc_global_destruction(MVMThreadContext *tc) {
     char *nursery_tmp;
+    MVMuint32 nursery_size_tmp;
 
     /* Must wait until we're the only thread... */
     while (tc->instance->num_user_threads) {
@@ -439,10 +581,19 @@ void MVM_gc_global_destruction(MVMThreadContext *tc) {
     nursery_tmp = tc->nursery_fromspace;
     tc->nursery_fromspace = tc->nursery_tospace;
     tc->nursery_tospace = nursery_tmp;
+    nursery_size_tmp = tc->nursery_fromspace_size;
+    tc->nursery_fromspace_size = tc->nursery_tospace_size;
+    tc->nursery_tospace_size = nursery_size_tmp;
 
-    /* Run the objects' finalizers */
+    /* Run the objects' finalizers. If we were part way through marking
+     * generation 2 incrementally, the first sweep clears the marks, and a
+     * second one is needed to free what was marked. */
     MVM_gc_collect_free_nursery_uncopied(tc, tc->nursery_alloc);
     MVM_gc_root_gen2_cleanup(tc);
+    if (MVM_load(&tc->instance->gc_gen2_phase) != MVMGCGen2Phase_Idle) {
+        tc->num_gen2marks = 0;
+        MVM_gc_collect_free_gen2_unmarked(tc);
+    }
     MVM_gc_collect_free_gen2_unmarked(tc);
     MVM_gc_collect_free_stables(tc);
 }
@@ -48,6 +48,7 @@ void MVM_gc_root_add_instance_roots_to_worklist(MVMThreadContext *tc, MVMGCWorkl
     MVM_gc_worklist_add(tc, worklist, &tc->instance->event_loop_todo_queue);
     MVM_gc_worklist_add(tc, worklist, &tc->instance->event_loop_cancel_queue);
     MVM_gc_worklist_add(tc, worklist, &tc->instance->event_loop_active);
+    MVM_spesh_worker_gc_mark(tc, worklist);
 
     /* okay, so this makes the weak hash slightly less weak.. for certain
      * keys of it anyway... */
@@ -187,7 +188,7 @@ void MVM_gc_root_gen2_add(MVMThreadContext *tc, MVMCollectable *c) {
     tc->num_gen2roots++;
 
     /* Flag it as added, so we don't add it multiple times. */
-    c->flags |= MVM_CF_IN_GEN2_ROOT_LIST;
+    MVM_gc_flags_set(c, MVM_CF_IN_GEN2_ROOT_LIST);
 }
 
 /* Adds the set of thread-local inter-generational roots to a GC worklist. As
@@ -253,7 +254,7 @@ void MVM_gc_root_add_gen2s_to_worklist(MVMThreadContext *tc, MVMGCWorklist *work
 
         /* Otherwise, clear the "in gen2 root list" flag. */
         else {
-            gen2roots[i]->flags ^= MVM_CF_IN_GEN2_ROOT_LIST;
+            MVM_gc_flags_clear(gen2roots[i], MVM_CF_IN_GEN2_ROOT_LIST);
         }
     }
 
@@ -340,10 +341,17 @@ static void scan_registers(MVMThreadContext *tc, MVMGCWorklist *worklist, MVMFra
     MVMuint16 *type_map;
     MVMuint8  *flag_map;
 
-    /* Scan locals. */
+    /* Scan locals. Specialized code may have more of them, if it has had
+     * callees inlined into it. */
     if (frame->work && frame->tc) {
-        type_map = frame->static_info->body.local_types;
-        count    = frame->static_info->body.num_locals;
+        if (frame->spesh_cand && frame->spesh_log_idx < 0) {
+            type_map = frame->spesh_cand->local_types;
+            count    = frame->spesh_cand->num_locals;
+        }
+        else {
+            type_map = frame->static_info->body.local_types;
+            count    = frame->static_info->body.num_locals;
+        }
         for (i = 0; i < count; i++)
             if (type_map[i] == MVM_reg_str || type_map[i] == MVM_reg_obj)
                 MVM_gc_worklist_add(tc, worklist, &frame->work[i].o);
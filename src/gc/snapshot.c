@@ -0,0 +1,165 @@
+#include "moar.h"
+
+/* Writes an unsigned integer as a LEB128 varint. */
+static void write_uint(FILE *fh, MVMuint64 value) {
+    MVMuint8  buffer[10];
+    MVMuint32 length = 0;
+    do {
+        MVMuint8 byte = value & 0x7F;
+        value >>= 7;
+        buffer[length++] = value ? byte | 0x80 : byte;
+    } while (value);
+    fwrite(buffer, 1, length, fh);
+}
+
+/* Writes a string, prefixed with its length. */
+static void write_str(FILE *fh, const char *str, size_t length) {
+    write_uint(fh, length);
+    fwrite(str, 1, length, fh);
+}
+
+/* Writes a record for a live collectable. What it references is found by
+ * marking it into the (otherwise unused) worklist, just as the GC does, and
+ * then emptying that out again. */
+static void write_collectable(MVMThreadContext *tc, FILE *fh, MVMGCWorklist *worklist, MVMCollectable *col) {
+    MVMuint32 sc_idx = MVM_get_idx_of_sc(col);
+    MVMuint32 i;
+
+    if (col->flags & MVM_CF_STABLE) {
+        const char *repr_name = ((MVMSTable *)col)->REPR->name;
+        fputc(MVM_HEAP_SNAPSHOT_STABLE, fh);
+        write_uint(fh, (MVMuint64)(uintptr_t)col);
+        write_str(fh, repr_name, strlen(repr_name));
+    }
+    else {
+        fputc(col->flags & MVM_CF_TYPE_OBJECT
+            ? MVM_HEAP_SNAPSHOT_TYPE_OBJECT
+            : MVM_HEAP_SNAPSHOT_OBJECT, fh);
+        write_uint(fh, (MVMuint64)(uintptr_t)col);
+        write_uint(fh, (MVMuint64)(uintptr_t)((MVMObject *)col)->st);
+    }
+    write_uint(fh, col->size);
+    write_uint(fh, sc_idx);
+    if (sc_idx)
+        write_uint(fh, MVM_get_idx_in_sc(col));
+
+    MVM_gc_mark_collectable(tc, worklist, col);
+    write_uint(fh, worklist->items);
+    for (i = 0; i < worklist->items; i++)
+        write_uint(fh, (MVMuint64)(uintptr_t)*(worklist->list[i]));
+    worklist->items  = 0;
+    worklist->frames = 0;
+}
+
+/* Writes records for everything that survived in a thread's nursery, which
+ * is all of what's been copied into its tospace. */
+static void write_nursery(MVMThreadContext *tc, FILE *fh, MVMGCWorklist *worklist, MVMThreadContext *other) {
+    char *scan = (char *)other->nursery_tospace;
+    while (scan < (char *)other->nursery_alloc) {
+        MVMCollectable *col = (MVMCollectable *)scan;
+        write_collectable(tc, fh, worklist, col);
+        scan += col->size;
+    }
+}
+
+/* Writes records for everything marked live in a thread's generation 2. This
+ * walks the pages in the same way as the sweep, skipping free list slots. */
+static void write_gen2(MVMThreadContext *tc, FILE *fh, MVMGCWorklist *worklist, MVMGen2Allocator *gen2) {
+    MVMuint32 bin, page, i;
+
+    for (bin = 0; bin < MVM_GEN2_BINS; bin++) {
+        MVMuint32 obj_size  = (bin + 1) << MVM_GEN2_BIN_BITS;
+        char    **next_free = gen2->size_classes[bin].free_list;
+        for (page = 0; page < gen2->size_classes[bin].num_pages; page++) {
+            char *cur_ptr = gen2->size_classes[bin].pages[page];
+            char *end_ptr = page + 1 == gen2->size_classes[bin].num_pages
+                ? gen2->size_classes[bin].alloc_pos
+                : cur_ptr + obj_size * MVM_GEN2_PAGE_ITEMS;
+            while (cur_ptr < end_ptr) {
+                MVMCollectable *col = (MVMCollectable *)cur_ptr;
+                if ((char **)cur_ptr == next_free)
+                    next_free = *(char ***)cur_ptr;
+                else if (col->flags & MVM_CF_GEN2_LIVE)
+                    write_collectable(tc, fh, worklist, col);
+                cur_ptr += obj_size;
+            }
+        }
+    }
+
+    for (i = 0; i < gen2->num_overflows; i++)
+        if (gen2->overflows[i] && gen2->overflows[i]->flags & MVM_CF_GEN2_LIVE)
+            write_collectable(tc, fh, worklist, gen2->overflows[i]);
+}
+
+/* Called by the co-ordinator of a full collection once marking is complete,
+ * but before anything is swept, if a snapshot was asked for. Every other
+ * thread is waiting for it at this point, so the heap holds still. Whether
+ * it worked is noted for the thread that asked. */
+void MVM_gc_snapshot_write(MVMThreadContext *tc) {
+    MVMInstance   *i    = tc->instance;
+    FILE          *fh   = fopen(i->heap_snapshot_path, "wb");
+    MVMGCWorklist *worklist;
+    MVMThread     *cur_thread;
+    MVMuint32      sc_idx;
+
+    if (!fh) {
+        i->heap_snapshot_failed = 1;
+        MVM_store(&i->heap_snapshot_path, NULL);
+        return;
+    }
+
+    fwrite(MVM_HEAP_SNAPSHOT_MAGIC, 1, strlen(MVM_HEAP_SNAPSHOT_MAGIC), fh);
+    write_uint(fh, MVM_HEAP_SNAPSHOT_VERSION);
+
+    /* The SCs, so that the collectables' SC indexes can be related to their
+     * handles. */
+    for (sc_idx = 1; sc_idx < i->all_scs_next_idx; sc_idx++) {
+        MVMSerializationContextBody *scb = i->all_scs[sc_idx];
+        if (scb && scb->handle) {
+            char *handle = MVM_string_utf8_encode_C_string(tc, scb->handle);
+            fputc(MVM_HEAP_SNAPSHOT_SC, fh);
+            write_uint(fh, sc_idx);
+            write_str(fh, handle, strlen(handle));
+            free(handle);
+        }
+    }
+
+    /* Then every live collectable of every thread. */
+    worklist   = MVM_gc_worklist_create(tc, 1);
+    cur_thread = (MVMThread *)MVM_load(&i->threads);
+    while (cur_thread) {
+        MVMThreadContext *other = cur_thread->body.tc;
+        if (other) {
+            write_nursery(tc, fh, worklist, other);
+            write_gen2(tc, fh, worklist, other->gen2);
+        }
+        cur_thread = cur_thread->body.next;
+    }
+    MVM_gc_worklist_destroy(tc, worklist);
+
+    fputc(MVM_HEAP_SNAPSHOT_END, fh);
+    i->heap_snapshot_failed = ferror(fh);
+    if (fclose(fh) != 0)
+        i->heap_snapshot_failed = 1;
+    MVM_store(&i->heap_snapshot_path, NULL);
+}
+
+/* Takes a heap snapshot, writing it to the specified file. The snapshot is
+ * written during a full collection, so we keep triggering GC runs until one
+ * of those has happened. */
+void MVM_gc_snapshot_take(MVMThreadContext *tc, MVMString *filename) {
+    char *path = MVM_string_utf8_encode_C_string(tc, filename);
+
+    if (MVM_casptr(&tc->instance->heap_snapshot_path, NULL, path) != NULL) {
+        free(path);
+        MVM_exception_throw_adhoc(tc, "A heap snapshot is already being taken");
+    }
+    while (MVM_load(&tc->instance->heap_snapshot_path))
+        MVM_gc_enter_from_allocator(tc);
+
+    if (tc->instance->heap_snapshot_failed) {
+        tc->instance->heap_snapshot_failed = 0;
+        MVM_exception_throw_adhoc(tc, "Could not write heap snapshot to '%s'", path);
+    }
+    free(path);
+}
@@ -0,0 +1,20 @@
+/* A heap snapshot is a file describing every live collectable at the end of
+ * a full collection: its type, size, owning SC and the collectables it
+ * references. The file starts with MVM_HEAP_SNAPSHOT_MAGIC, followed by the
+ * format version, and then a record per collectable or SC, each starting
+ * with a tag byte. Integers are written as unsigned LEB128 varints, and
+ * collectables are identified by their address. See docs/gc.markdown for
+ * the details, and tools/heapsnapshot.py for something to read them. */
+#define MVM_HEAP_SNAPSHOT_MAGIC   "MOARHEAP"
+#define MVM_HEAP_SNAPSHOT_VERSION 1
+
+/* Record tags. */
+#define MVM_HEAP_SNAPSHOT_OBJECT      'O'
+#define MVM_HEAP_SNAPSHOT_TYPE_OBJECT 'T'
+#define MVM_HEAP_SNAPSHOT_STABLE      'S'
+#define MVM_HEAP_SNAPSHOT_SC          'C'
+#define MVM_HEAP_SNAPSHOT_END         'E'
+
+/* Functions. */
+void MVM_gc_snapshot_take(MVMThreadContext *tc, MVMString *filename);
+void MVM_gc_snapshot_write(MVMThreadContext *tc);
@@ -0,0 +1,243 @@
+#include "moar.h"
+#include <platform/time.h>
+
+/* Sets up the instance's GC statistics. */
+void MVM_gc_stats_init(MVMInstance *i) {
+    int init_stat;
+    i->gc_stats = calloc(1, sizeof(MVMGCStats));
+    if ((init_stat = uv_mutex_init(&i->gc_stats->mutex)) < 0) {
+        fprintf(stderr, "MoarVM: Initialization of GC stats mutex failed\n    %s\n",
+            uv_strerror(init_stat));
+        exit(1);
+    }
+}
+
+/* Cleans up the instance's GC statistics. */
+void MVM_gc_stats_destroy(MVMInstance *i) {
+    if (i->gc_stats->log_fh)
+        fclose(i->gc_stats->log_fh);
+    uv_mutex_destroy(&i->gc_stats->mutex);
+    free(i->gc_stats);
+    i->gc_stats = NULL;
+}
+
+/* Called by the co-ordinator when a GC run starts. A thread from the last
+ * run may still be finishing up, and so not yet have added its share of the
+ * statistics for it; wait for that before starting afresh. */
+void MVM_gc_stats_run_start(MVMThreadContext *tc) {
+    MVMGCRunStats *run = &tc->instance->gc_stats->run;
+    MVM_gc_barrier_wait(tc, &tc->instance->gc_stats_pending, NULL, NULL);
+    memset(run, 0, sizeof(MVMGCRunStats));
+    run->seq   = MVM_load(&tc->instance->gc_seq_number);
+    run->start = MVM_platform_now();
+}
+
+/* Gets this thread's share of the statistics for the current run. */
+static MVMGCRunStats * thread_share(MVMThreadContext *tc) {
+    if (!tc->gc_run_stats)
+        tc->gc_run_stats = calloc(1, sizeof(MVMGCRunStats));
+    return tc->gc_run_stats;
+}
+
+/* Adds statistics about another thread's nursery and generation 2 that this
+ * thread collected, after it has finished with them, into this thread's
+ * share of the statistics for the run. The limit is how far allocation had
+ * got in the nursery's fromspace. */
+void MVM_gc_stats_run_add(MVMThreadContext *tc, MVMThreadContext *other, void *limit, MVMuint8 gen) {
+    MVMGCRunStats    *run  = thread_share(tc);
+    MVMGen2Allocator *gen2 = other->gen2;
+    MVMuint32 bin, i;
+
+    run->full            = gen == MVMGCGenerations_Both;
+    run->nursery_used   += (char *)limit - (char *)other->nursery_fromspace;
+    run->nursery_copied += (char *)other->nursery_alloc - (char *)other->nursery_tospace;
+    run->promoted       += other->nursery_promoted;
+
+    for (bin = 0; bin < MVM_GEN2_BINS; bin++)
+        run->gen2_bytes[bin] += (MVMuint64)gen2->size_classes[bin].num_pages *
+            MVM_GEN2_PAGE_ITEMS * ((bin + 1) << MVM_GEN2_BIN_BITS);
+    for (i = 0; i < gen2->num_overflows; i++)
+        if (gen2->overflows[i])
+            run->gen2_bytes[MVM_GEN2_BINS] += gen2->overflows[i]->size;
+}
+
+/* Adds a wait in the GC barrier, which took the specified time and parked
+ * the specified number of times, to this thread's share of the statistics
+ * for the run. */
+void MVM_gc_stats_barrier_wait(MVMThreadContext *tc, MVMuint64 ns, MVMuint32 parks) {
+    MVMGCRunStats *run = thread_share(tc);
+    run->barrier_waits++;
+    run->barrier_wait_ns += ns;
+    run->barrier_parks   += parks;
+}
+
+/* Writes a line describing a run to the GC statistics log. */
+static void log_run(FILE *fh, MVMGCRunStats *run) {
+    MVMuint32 bin;
+    fprintf(fh, "{\"seq\":%llu,\"full\":%llu,\"start_ns\":%llu,\"duration_ns\":%llu,"
+        "\"threads\":%llu,\"barrier_waits\":%llu,\"barrier_wait_ns\":%llu,\"barrier_parks\":%llu,"
+        "\"nursery_used\":%llu,\"nursery_copied\":%llu,\"promoted\":%llu,\"gen2_bytes\":[",
+        (unsigned long long)run->seq, (unsigned long long)run->full,
+        (unsigned long long)run->start, (unsigned long long)run->duration,
+        (unsigned long long)run->threads, (unsigned long long)run->barrier_waits,
+        (unsigned long long)run->barrier_wait_ns, (unsigned long long)run->barrier_parks,
+        (unsigned long long)run->nursery_used,
+        (unsigned long long)run->nursery_copied, (unsigned long long)run->promoted);
+    for (bin = 0; bin <= MVM_GEN2_BINS; bin++)
+        fprintf(fh, bin ? ",%llu" : "%llu", (unsigned long long)run->gen2_bytes[bin]);
+    fprintf(fh, "]}\n");
+    fflush(fh);
+}
+
+/* Called by each thread that took part in a GC run once it is done with
+ * it, to add in its share of the statistics. The last one to do so records
+ * the run. */
+void MVM_gc_stats_run_done(MVMThreadContext *tc) {
+    MVMGCStats    *stats = tc->instance->gc_stats;
+    MVMGCRunStats *run   = &stats->run;
+    MVMGCRunStats *mine  = tc->gc_run_stats;
+    MVMuint32 bin;
+
+    uv_mutex_lock(&stats->mutex);
+    run->threads++;
+    if (mine) {
+        run->full            |= mine->full;
+        run->barrier_waits   += mine->barrier_waits;
+        run->barrier_wait_ns += mine->barrier_wait_ns;
+        run->barrier_parks   += mine->barrier_parks;
+        run->nursery_used    += mine->nursery_used;
+        run->nursery_copied  += mine->nursery_copied;
+        run->promoted        += mine->promoted;
+        for (bin = 0; bin <= MVM_GEN2_BINS; bin++)
+            run->gen2_bytes[bin] += mine->gen2_bytes[bin];
+        memset(mine, 0, sizeof(MVMGCRunStats));
+    }
+    if (MVM_load(&tc->instance->gc_stats_pending) == 1) {
+        MVMGCTotals *totals = &stats->totals;
+        run->duration = MVM_platform_now() - run->start;
+        stats->runs[stats->num_runs++ % MVM_GC_STATS_RUNS] = *run;
+        totals->runs++;
+        if (run->full)
+            totals->full_runs++;
+        totals->pause_ns += run->duration;
+        if (run->duration > totals->max_pause_ns)
+            totals->max_pause_ns = run->duration;
+        totals->nursery_used    += run->nursery_used;
+        totals->promoted        += run->promoted;
+        totals->barrier_wait_ns += run->barrier_wait_ns;
+        if (stats->log_fh)
+            log_run(stats->log_fh, run);
+    }
+    MVM_decr(&tc->instance->gc_stats_pending);
+    uv_mutex_unlock(&stats->mutex);
+    MVM_gc_barrier_wake(tc);
+}
+
+/* Binds a boxed integer or number into a hash under the specified key. */
+static void bind_int(MVMThreadContext *tc, MVMObject *hash, const char *key, MVMint64 value) {
+    MVMString *key_str;
+    MVMObject *boxed;
+    MVMROOT(tc, hash, {
+        key_str = MVM_string_ascii_decode_nt(tc, tc->instance->VMString, key);
+        MVMROOT(tc, key_str, {
+            boxed = MVM_repr_box_int(tc, MVM_hll_current(tc)->int_box_type, value);
+        });
+        MVM_repr_bind_key_o(tc, hash, key_str, boxed);
+    });
+}
+static void bind_num(MVMThreadContext *tc, MVMObject *hash, const char *key, MVMnum64 value) {
+    MVMString *key_str;
+    MVMObject *boxed;
+    MVMROOT(tc, hash, {
+        key_str = MVM_string_ascii_decode_nt(tc, tc->instance->VMString, key);
+        MVMROOT(tc, key_str, {
+            boxed = MVM_repr_box_num(tc, MVM_hll_current(tc)->num_box_type, value);
+        });
+        MVM_repr_bind_key_o(tc, hash, key_str, boxed);
+    });
+}
+
+/* Makes a hash describing a GC run. */
+static MVMObject * run_to_hash(MVMThreadContext *tc, MVMGCRunStats *run) {
+    MVMObject *hash = MVM_repr_alloc_init(tc, MVM_hll_current(tc)->slurpy_hash_type);
+    MVMObject *gen2 = NULL;
+    MVMuint32  bin;
+    MVMROOT(tc, hash, {
+        bind_int(tc, hash, "seq", run->seq);
+        bind_int(tc, hash, "full", run->full);
+        bind_int(tc, hash, "start_ns", run->start);
+        bind_int(tc, hash, "duration_ns", run->duration);
+        bind_int(tc, hash, "threads", run->threads);
+        bind_int(tc, hash, "barrier_waits", run->barrier_waits);
+        bind_int(tc, hash, "barrier_wait_ns", run->barrier_wait_ns);
+        bind_int(tc, hash, "barrier_parks", run->barrier_parks);
+        bind_int(tc, hash, "nursery_used", run->nursery_used);
+        bind_int(tc, hash, "nursery_copied", run->nursery_copied);
+        bind_int(tc, hash, "promoted", run->promoted);
+        bind_num(tc, hash, "survival", run->nursery_used
+            ? (MVMnum64)(run->nursery_copied + run->promoted) / run->nursery_used
+            : 0.0);
+        gen2 = MVM_repr_alloc_init(tc, MVM_hll_current(tc)->slurpy_array_type);
+        MVMROOT(tc, gen2, {
+            MVMString *key_str;
+            for (bin = 0; bin <= MVM_GEN2_BINS; bin++)
+                MVM_repr_push_o(tc, gen2,
+                    MVM_repr_box_int(tc, MVM_hll_current(tc)->int_box_type, run->gen2_bytes[bin]));
+            key_str = MVM_string_ascii_decode_nt(tc, tc->instance->VMString, "gen2_bytes");
+            MVM_repr_bind_key_o(tc, hash, key_str, gen2);
+        });
+    });
+    return hash;
+}
+
+/* Returns an array of hashes describing up to the specified number of the
+ * most recent GC runs, oldest first. */
+MVMObject * MVM_gc_stats_runs(MVMThreadContext *tc, MVMint64 count) {
+    MVMGCStats    *stats = tc->instance->gc_stats;
+    MVMGCRunStats *runs;
+    MVMObject     *result;
+    MVMuint64      first, i, n;
+
+    /* Copy the runs out first, as making the result may trigger GC, which
+     * would need the lock. */
+    uv_mutex_lock(&stats->mutex);
+    n = stats->num_runs < MVM_GC_STATS_RUNS ? stats->num_runs : MVM_GC_STATS_RUNS;
+    if (count >= 0 && (MVMuint64)count < n)
+        n = count;
+    first = stats->num_runs - n;
+    runs  = malloc(n * sizeof(MVMGCRunStats) + 1);
+    for (i = 0; i < n; i++)
+        runs[i] = stats->runs[(first + i) % MVM_GC_STATS_RUNS];
+    uv_mutex_unlock(&stats->mutex);
+
+    result = MVM_repr_alloc_init(tc, MVM_hll_current(tc)->slurpy_array_type);
+    MVMROOT(tc, result, {
+        for (i = 0; i < n; i++)
+            MVM_repr_push_o(tc, result, run_to_hash(tc, &runs[i]));
+    });
+    free(runs);
+    return result;
+}
+
+/* Returns a hash of totals over all the GC runs there have been. */
+MVMObject * MVM_gc_stats_totals(MVMThreadContext *tc) {
+    MVMGCStats  *stats = tc->instance->gc_stats;
+    MVMGCTotals  totals;
+    MVMObject   *hash;
+
+    uv_mutex_lock(&stats->mutex);
+    totals = stats->totals;
+    uv_mutex_unlock(&stats->mutex);
+
+    hash = MVM_repr_alloc_init(tc, MVM_hll_current(tc)->slurpy_hash_type);
+    MVMROOT(tc, hash, {
+        bind_int(tc, hash, "runs", totals.runs);
+        bind_int(tc, hash, "full_runs", totals.full_runs);
+        bind_int(tc, hash, "pause_ns", totals.pause_ns);
+        bind_int(tc, hash, "max_pause_ns", totals.max_pause_ns);
+        bind_int(tc, hash, "nursery_used", totals.nursery_used);
+        bind_int(tc, hash, "promoted", totals.promoted);
+        bind_int(tc, hash, "barrier_wait_ns", totals.barrier_wait_ns);
+    });
+    return hash;
+}
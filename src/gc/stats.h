@@ -0,0 +1,77 @@
+/* Statistics about a GC run. These are gathered for every run, kept for
+ * the most recent runs, and can also be written to a log file. */
+struct MVMGCRunStats {
+    /* The GC run's sequence number. */
+    MVMuint64 seq;
+
+    /* Non-zero if generation 2 was collected as well as the nursery. */
+    MVMuint64 full;
+
+    /* When the run started (as from MVM_platform_now) and how long it was
+     * until the last thread taking part in it was done, in nanoseconds. */
+    MVMuint64 start;
+    MVMuint64 duration;
+
+    /* The number of threads that took part. */
+    MVMuint64 threads;
+
+    /* How many times threads waited for each other in the GC barrier, for
+     * how long in total (in nanoseconds), and how many times they parked. */
+    MVMuint64 barrier_waits;
+    MVMuint64 barrier_wait_ns;
+    MVMuint64 barrier_parks;
+
+    /* Bytes that were allocated in the nurseries collected, bytes that were
+     * copied within them, and bytes that were promoted to generation 2. */
+    MVMuint64 nursery_used;
+    MVMuint64 nursery_copied;
+    MVMuint64 promoted;
+
+    /* Bytes of pages held by each generation 2 size class after the run,
+     * followed by the bytes of over-sized objects. */
+    MVMuint64 gen2_bytes[MVM_GEN2_BINS + 1];
+};
+
+/* Statistics across all the GC runs there have been. */
+struct MVMGCTotals {
+    MVMuint64 runs;
+    MVMuint64 full_runs;
+    MVMuint64 pause_ns;
+    MVMuint64 max_pause_ns;
+    MVMuint64 nursery_used;
+    MVMuint64 promoted;
+    MVMuint64 barrier_wait_ns;
+};
+
+/* How many of the most recent runs we keep statistics for. */
+#define MVM_GC_STATS_RUNS 64
+
+/* All the GC statistics for an instance. */
+struct MVMGCStats {
+    /* The run that statistics are currently being gathered for. */
+    MVMGCRunStats run;
+
+    /* The most recent runs, used as a ring buffer, and the number of runs
+     * ever put into it. */
+    MVMGCRunStats runs[MVM_GC_STATS_RUNS];
+    MVMuint64     num_runs;
+
+    /* Totals over all runs. */
+    MVMGCTotals totals;
+
+    /* Protects all of the above. */
+    uv_mutex_t mutex;
+
+    /* File to write a line about each run to, if any. */
+    FILE *log_fh;
+};
+
+/* Functions. */
+void MVM_gc_stats_init(MVMInstance *i);
+void MVM_gc_stats_destroy(MVMInstance *i);
+void MVM_gc_stats_run_start(MVMThreadContext *tc);
+void MVM_gc_stats_run_add(MVMThreadContext *tc, MVMThreadContext *other, void *limit, MVMuint8 gen);
+void MVM_gc_stats_barrier_wait(MVMThreadContext *tc, MVMuint64 ns, MVMuint32 parks);
+void MVM_gc_stats_run_done(MVMThreadContext *tc);
+MVMObject * MVM_gc_stats_runs(MVMThreadContext *tc, MVMint64 count);
+MVMObject * MVM_gc_stats_totals(MVMThreadContext *tc);
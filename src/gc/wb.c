@@ -11,3 +11,11 @@ void MVM_gc_write_barrier_hit(MVMThreadContext *tc, MVMCollectable *update_root)
     if (!(update_root->flags & MVM_CF_IN_GEN2_ROOT_LIST))
         MVM_gc_root_gen2_add(tc, update_root);
 }
+
+/* Called when the write barrier sees an unmarked generation 2 object being
+ * stored into another generation 2 object while incremental marking is in
+ * progress. Marks it and queues it to be scanned, so it can't be missed if
+ * the object it was stored into was already scanned. */
+void MVM_gc_write_barrier_shade(MVMThreadContext *tc, MVMCollectable *referenced) {
+    MVM_gc_collect_gen2_shade(tc, referenced);
+}
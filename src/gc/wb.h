@@ -1,12 +1,40 @@
 /* Functions for if the write barriers are hit. */
 MVM_PUBLIC void MVM_gc_write_barrier_hit(MVMThreadContext *tc, MVMCollectable *update_root);
+MVM_PUBLIC void MVM_gc_write_barrier_shade(MVMThreadContext *tc, MVMCollectable *referenced);
+
+/* Sets and clears bits in a collectable's flags. Other threads may update
+ * the flags of the same collectable at the same time, such as marking it, or
+ * adding it to their generation 2 roots, so this is done atomically. There is
+ * no atomic operation on 16 bits everywhere, so it is a compare-and-swap on
+ * the AO_t-sized word the flags are in. */
+MVM_STATIC_INLINE void MVM_gc_flags_update(MVMCollectable *c, MVMuint16 set, MVMuint16 clear) {
+    volatile AO_t *word = (volatile AO_t *)((uintptr_t)&c->flags & ~(uintptr_t)(sizeof(AO_t) - 1));
+    size_t         pos  = (char *)&c->flags - (char *)word;
+    AO_t           old_word, new_word;
+    MVMuint16      flags;
+    do {
+        old_word = AO_load_full(word);
+        new_word = old_word;
+        memcpy(&flags, (char *)&new_word + pos, sizeof(MVMuint16));
+        flags = (flags | set) & ~clear;
+        memcpy((char *)&new_word + pos, &flags, sizeof(MVMuint16));
+    } while (!AO_compare_and_swap_full(word, old_word, new_word));
+}
+#define MVM_gc_flags_set(c, bits)   MVM_gc_flags_update((c), (bits), 0)
+#define MVM_gc_flags_clear(c, bits) MVM_gc_flags_update((c), 0, (bits))
 
 /* Ensures that if a generation 2 object comes to hold a reference to a
  * nursery object, then the generation 2 object becomes an inter-generational
- * root. */
+ * root. Also, while generation 2 is being marked incrementally, ensures that
+ * a generation 2 object that gets stored into another one is marked, since
+ * the object being stored into may already have been scanned. */
 MVM_STATIC_INLINE void MVM_gc_write_barrier(MVMThreadContext *tc, MVMCollectable *update_root, const MVMCollectable *referenced) {
-    if (((update_root->flags & MVM_CF_SECOND_GEN) && referenced && !(referenced->flags & MVM_CF_SECOND_GEN)))
-        MVM_gc_write_barrier_hit(tc, update_root);
+    if ((update_root->flags & MVM_CF_SECOND_GEN) && referenced) {
+        if (!(referenced->flags & MVM_CF_SECOND_GEN))
+            MVM_gc_write_barrier_hit(tc, update_root);
+        else if (tc->gc_gen2_marking && !(referenced->flags & MVM_CF_GEN2_LIVE))
+            MVM_gc_write_barrier_shade(tc, (MVMCollectable *)referenced);
+    }
 }
 
 /* Does an assignment, but makes sure the write barrier MVM_WB is applied
@@ -34,6 +34,9 @@ typedef struct {
 
     /* Decode stream, for turning bytes from disk into strings. */
     MVMDecodeStream *ds;
+
+    /* Current line separator. */
+    MVMDecodeStreamSeparator sep;
 } MVMIOFileData;
 
 /* Closes the file. */
@@ -86,7 +89,8 @@ static MVMint64 tell(MVMThreadContext *tc, MVMOSHandle *h) {
 
 /* Set the line separator. */
 static void set_separator(MVMThreadContext *tc, MVMOSHandle *h, MVMString *sep) {
-    MVM_exception_throw_adhoc(tc, "set_separator NYI on file handles");
+    MVMIOFileData *data = (MVMIOFileData *)h->body.data;
+    MVM_string_decodestream_sep_from_string(tc, &data->sep, sep);
 }
 
 /* Read a bunch of bytes into the current decode stream. */
@@ -117,7 +121,7 @@ static MVMString * read_line(MVMThreadContext *tc, MVMOSHandle *h) {
 
     /* Pull data until we can read a line. */
     do {
-        MVMString *line = MVM_string_decodestream_get_until_sep(tc, data->ds, '\n');
+        MVMString *line = MVM_string_decodestream_get_until_sep(tc, data->ds, &data->sep);
         if (line != NULL)
             return line;
     } while (read_to_buffer(tc, data, CHUNK_SIZE) > 0);
@@ -145,16 +149,21 @@ static MVMString * slurp(MVMThreadContext *tc, MVMOSHandle *h) {
 /* Gets the specified number of characters from the file. */
 static MVMString * read_chars(MVMThreadContext *tc, MVMOSHandle *h, MVMint64 chars) {
     MVMIOFileData *data = (MVMIOFileData *)h->body.data;
+    MVMString     *result;
     ensure_decode_stream(tc, data);
 
     /* Pull data until we can read the chars we want. */
     do {
-        MVMString *result = MVM_string_decodestream_get_chars(tc, data->ds, chars);
+        result = MVM_string_decodestream_get_chars(tc, data->ds, chars, 0);
         if (result != NULL)
             return result;
     } while (read_to_buffer(tc, data, CHUNK_SIZE) > 0);
 
-    /* Reached end of file, so just take what we have. */
+    /* Reached end of file, which ends the last char; if there are still
+     * fewer than we wanted, just take what we have. */
+    result = MVM_string_decodestream_get_chars(tc, data->ds, chars, 1);
+    if (result != NULL)
+        return result;
     return MVM_string_decodestream_get_all(tc, data->ds);
 }
 
@@ -202,7 +211,21 @@ static MVMint64 write_str(MVMThreadContext *tc, MVMOSHandle *h, MVMString *str,
     MVMint64 output_size, bytes_written;
     uv_fs_t req;
 
-    output = MVM_string_encode(tc, str, 0, -1, &output_size, data->encoding);
+    if (data->encoding == MVM_encoding_type_utf8) {
+        /* Size the UTF-8 up front, so it and any newline are encoded
+         * straight into one buffer and written together. */
+        MVMint64 graphs = NUM_GRAPHS(str);
+        output_size = MVM_string_utf8_encode_size(tc, str, 0, graphs);
+        output      = malloc(output_size + 1);
+        MVM_string_utf8_encode_into(tc, str, 0, graphs, output);
+        if (newline) {
+            output[output_size++] = '\n';
+            newline = 0;
+        }
+    }
+    else {
+        output = MVM_string_encode(tc, str, 0, -1, &output_size, data->encoding);
+    }
     bytes_written = uv_fs_write(tc->loop, &req, data->fd, (const void *)output, output_size, -1, NULL);
     if (bytes_written < 0) {
         free(output);
@@ -412,6 +435,7 @@ MVMObject * MVM_file_open_fh(MVMThreadContext *tc, MVMString *filename, MVMStrin
     data->fd          = fd;
     data->filename    = fname;
     data->encoding    = MVM_encoding_type_utf8;
+    MVM_string_decodestream_sep_default(tc, &data->sep);
     result->body.ops  = &op_table;
     result->body.data = data;
 
@@ -424,6 +448,7 @@ MVMObject * MVM_file_handle_from_fd(MVMThreadContext *tc, uv_file fd) {
     MVMIOFileData * const data   = calloc(1, sizeof(MVMIOFileData));
     data->fd          = fd;
     data->encoding    = MVM_encoding_type_utf8;
+    MVM_string_decodestream_sep_default(tc, &data->sep);
     result->body.ops  = &op_table;
     result->body.data = data;
     return (MVMObject *)result;
@@ -85,7 +85,7 @@ MVMObject * MVM_io_syncpipe(MVMThreadContext *tc, uv_stream_t *handle, uv_proces
     data->process     = process;
     data->ss.handle   = handle;
     data->ss.encoding = MVM_encoding_type_utf8;
-    data->ss.sep      = '\n';
+    MVM_string_decodestream_sep_default(tc, &data->ss.sep);
     result->body.ops  = &op_table;
     result->body.data = data;
     return (MVMObject *)result;
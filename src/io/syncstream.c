@@ -39,9 +39,8 @@ MVMint64 MVM_io_syncstream_tell(MVMThreadContext *tc, MVMOSHandle *h) {
 
 /* Set the line separator. */
 void MVM_io_syncstream_set_separator(MVMThreadContext *tc, MVMOSHandle *h, MVMString *sep) {
-    /* For now, take last character. */
     MVMIOSyncStreamData *data = (MVMIOSyncStreamData *)h->body.data;
-    data->sep = (MVMCodepoint32)MVM_string_get_codepoint_at(tc, sep, NUM_GRAPHS(sep) - 1);
+    MVM_string_decodestream_sep_from_string(tc, &data->sep, sep);
 }
 
 /* Read a bunch of bytes into the current decode stream. Returns true if we
@@ -96,7 +95,7 @@ MVMString * MVM_io_syncstream_read_line(MVMThreadContext *tc, MVMOSHandle *h) {
 
     /* Pull data until we can read a line. */
     do {
-        MVMString *line = MVM_string_decodestream_get_until_sep(tc, data->ds, data->sep);
+        MVMString *line = MVM_string_decodestream_get_until_sep(tc, data->ds, &data->sep);
         if (line != NULL)
             return line;
     } while (read_to_buffer(tc, data, CHUNK_SIZE) > 0);
@@ -124,20 +123,23 @@ MVMString * MVM_io_syncstream_read_chars(MVMThreadContext *tc, MVMOSHandle *h, M
     MVMString *result;
     ensure_decode_stream(tc, data);
 
-    /* Do we already have the chars available? */
-    result = MVM_string_decodestream_get_chars(tc, data->ds, chars);
+    /* Do we already have the chars available? Reading more could block
+     * until more input arrives, so we don't wait to see if the last of them
+     * goes on. */
+    result = MVM_string_decodestream_get_chars(tc, data->ds, chars, 1);
     if (result) {
         return result;
     }
     else {
         /* No; read and try again. */
         read_to_buffer(tc, data, CHUNK_SIZE);
-        result = MVM_string_decodestream_get_chars(tc, data->ds, chars);
+        result = MVM_string_decodestream_get_chars(tc, data->ds, chars, 1);
         if (result != NULL)
             return result;
     }
 
-    /* Fetched all we immediately can, so just take what we have. */
+    /* Fetched all we immediately can, which is fewer chars than we wanted,
+     * so just take what we have. */
     return MVM_string_decodestream_get_all(tc, data->ds);
 }
 
@@ -182,10 +184,22 @@ MVMint64 MVM_io_syncstream_write_str(MVMThreadContext *tc, MVMOSHandle *h, MVMSt
     uv_buf_t write_buf;
     int r;
 
-    output = MVM_string_encode(tc, str, 0, -1, &output_size, data->encoding);
-    if (newline) {
-        output = (MVMuint8 *)realloc(output, ++output_size);
-        output[output_size - 1] = '\n';
+    if (data->encoding == MVM_encoding_type_utf8) {
+        /* Size the UTF-8 up front, so it and any newline are encoded
+         * straight into the buffer that's written. */
+        MVMint64 graphs = NUM_GRAPHS(str);
+        output_size = MVM_string_utf8_encode_size(tc, str, 0, graphs);
+        output      = malloc(output_size + 1);
+        MVM_string_utf8_encode_into(tc, str, 0, graphs, output);
+        if (newline)
+            output[output_size++] = '\n';
+    }
+    else {
+        output = MVM_string_encode(tc, str, 0, -1, &output_size, data->encoding);
+        if (newline) {
+            output = (MVMuint8 *)realloc(output, ++output_size);
+            output[output_size - 1] = '\n';
+        }
     }
     req = malloc(sizeof(uv_write_t));
     write_buf = uv_buf_init(output, output_size);
@@ -303,7 +317,7 @@ MVMObject * MVM_io_syncstream_from_uvstream(MVMThreadContext *tc, uv_stream_t *h
     MVMIOSyncStreamData * const data   = calloc(1, sizeof(MVMIOSyncStreamData));
     data->handle      = handle;
     data->encoding    = MVM_encoding_type_utf8;
-    data->sep         = '\n';
+    MVM_string_decodestream_sep_default(tc, &data->sep);
     result->body.ops  = &op_table;
     result->body.data = data;
     return (MVMObject *)result;
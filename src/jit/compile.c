@@ -0,0 +1,668 @@
+#include "moar.h"
+#include "platform/mmap.h"
+
+/* Compiles the optimized graph of a specialization to x86-64 machine code.
+ * It's a simple template compiler: each instruction becomes a fixed sequence
+ * of machine instructions working on the frame's work registers in memory,
+ * so nothing is cached in machine registers from one instruction to the
+ * next, and a GC run in a call we make sees everything it needs to. Where
+ * the interpreter would go through a function anyway (returns and guards),
+ * we call a helper instead. Only a graph made up of ops we know how to
+ * compile is compiled; anything else is left to run as specialized bytecode.
+ *
+ * The code doesn't make calls to bytecode, so a frame running it is always
+ * the one at the top of the stack, and it runs to the end, or to a guard
+ * failing. In the first case, it returns like the return ops do; in the
+ * second, the frame is deoptimized using its candidate's deopt table, just
+ * as the interpreter would, and we hand back to the interpreter. */
+
+#if defined(__x86_64__) || defined(_M_X64)
+
+/* Registers, numbered as in the instruction encoding. */
+#define RAX 0
+#define RCX 1
+#define RDX 2
+#define RBX 3
+#define RSP 4
+#define RBP 5
+#define RSI 6
+#define RDI 7
+#define R8  8
+#define R9  9
+#define R14 14
+
+/* Registers that keep hold of the frame's work registers and the thread
+ * context throughout; both callee-saved in either calling convention. */
+#define WORK RBX
+#define TC   R14
+
+/* Where the first arguments of a call go. */
+#ifdef _WIN32
+static const MVMuint8 arg_regs[] = { RCX, RDX, R8, R9 };
+#else
+static const MVMuint8 arg_regs[] = { RDI, RSI, RDX, RCX };
+#endif
+
+/* Labels past those of the basic blocks: leaving after a failed guard, and
+ * the epilogue. */
+#define LABEL_DEOPT(g)    ((g)->num_bbs)
+#define LABEL_EPILOGUE(g) ((g)->num_bbs + 1)
+
+/* A place in the code where the rel32 of a jump to a label goes. */
+typedef struct {
+    MVMuint32 pos;
+    MVMint32  label;
+} JitFixup;
+
+/* State while compiling. */
+typedef struct {
+    /* The code so far. */
+    MVMuint8  *buf;
+    MVMuint32  pos;
+    MVMuint32  alloc;
+
+    /* Position of each label, or -1 if we've not got to it yet. */
+    MVMint32  *labels;
+
+    /* Jumps to fill in once all the labels are known. */
+    JitFixup  *fixups;
+    MVMuint32  num_fixups;
+    MVMuint32  alloc_fixups;
+
+    /* The guards; allocated up front, as the code refers to them. */
+    MVMJitGuard *guards;
+    MVMuint32    num_guards;
+} JitCompiler;
+
+/* Checks if we know how to compile an op. */
+static MVMint32 is_supported(MVMuint16 opcode) {
+    switch (opcode) {
+    case MVM_SSA_PHI:
+    case MVM_OP_no_op:
+    case MVM_OP_const_i64:
+    case MVM_OP_const_i64_16:
+    case MVM_OP_const_i64_32:
+    case MVM_OP_const_n64:
+    case MVM_OP_const_s:
+    case MVM_OP_set:
+    case MVM_OP_null:
+    case MVM_OP_add_i:
+    case MVM_OP_sub_i:
+    case MVM_OP_mul_i:
+    case MVM_OP_band_i:
+    case MVM_OP_bor_i:
+    case MVM_OP_bxor_i:
+    case MVM_OP_neg_i:
+    case MVM_OP_bnot_i:
+    case MVM_OP_inc_i:
+    case MVM_OP_dec_i:
+    case MVM_OP_eq_i:
+    case MVM_OP_ne_i:
+    case MVM_OP_lt_i:
+    case MVM_OP_le_i:
+    case MVM_OP_gt_i:
+    case MVM_OP_ge_i:
+    case MVM_OP_add_n:
+    case MVM_OP_sub_n:
+    case MVM_OP_mul_n:
+    case MVM_OP_div_n:
+    case MVM_OP_goto:
+    case MVM_OP_if_i:
+    case MVM_OP_unless_i:
+    case MVM_OP_sp_getarg_o:
+    case MVM_OP_sp_getarg_i:
+    case MVM_OP_sp_getarg_n:
+    case MVM_OP_sp_getarg_s:
+    case MVM_OP_sp_getspeshslot:
+    case MVM_OP_sp_guardconc:
+    case MVM_OP_sp_guardtype:
+    case MVM_OP_return_i:
+    case MVM_OP_return_n:
+    case MVM_OP_return_s:
+    case MVM_OP_return_o:
+    case MVM_OP_return:
+        return 1;
+    default:
+        return 0;
+    }
+}
+
+/* Finds the deopt index of the deopt-one annotation on a guard, or -1. */
+static MVMint32 find_deopt_idx(MVMSpeshIns *ins) {
+    MVMSpeshAnn *ann = ins->annotations;
+    while (ann) {
+        if (ann->type == MVM_SPESH_ANN_DEOPT_ONE_INS)
+            return ann->data.deopt_idx;
+        ann = ann->next;
+    }
+    return -1;
+}
+
+/* Helper for returns; sets the result and returns from the frame as the
+ * return ops do. */
+static MVMint32 jit_return(MVMThreadContext *tc, MVMRegister *value, MVMint64 opcode) {
+    switch (opcode) {
+    case MVM_OP_return_i:
+        MVM_args_set_result_int(tc, value->i64, MVM_RETURN_CALLER_FRAME);
+        break;
+    case MVM_OP_return_n:
+        MVM_args_set_result_num(tc, value->n64, MVM_RETURN_CALLER_FRAME);
+        break;
+    case MVM_OP_return_s:
+        MVM_args_set_result_str(tc, value->s, MVM_RETURN_CALLER_FRAME);
+        break;
+    case MVM_OP_return_o:
+        MVM_args_set_result_obj(tc, value->o, MVM_RETURN_CALLER_FRAME);
+        break;
+    default:
+        MVM_args_assert_void_return_ok(tc, MVM_RETURN_CALLER_FRAME);
+        break;
+    }
+    return MVM_frame_try_return(tc) != 0;
+}
+
+/* Helper for guards; checks the guard as the guard ops do, and if it fails
+ * deoptimizes the frame and returns non-zero. */
+static MVMint32 jit_guard(MVMThreadContext *tc, MVMJitGuard *guard) {
+    MVMFrame  *f     = tc->cur_frame;
+    MVMObject *check = f->work[guard->reg].o;
+    MVMSTable *want  = (MVMSTable *)f->effective_spesh_slots[guard->slot];
+    if (check && STABLE(check) == want &&
+            (guard->op == MVM_OP_sp_guardconc ? IS_CONCRETE(check) : !IS_CONCRETE(check)))
+        return 0;
+
+    /* Put the frame where the interpreter would be after the guard in the
+     * specialized bytecode, and deoptimize from there. */
+    f->effective_bytecode        = f->spesh_cand->bytecode;
+    *(tc->interp_bytecode_start) = f->effective_bytecode;
+    *(tc->interp_cur_op)         = f->effective_bytecode + guard->deopt_offset;
+    MVM_spesh_deopt_one(tc);
+    return 1;
+}
+
+static void emit_byte(JitCompiler *jc, MVMuint8 b) {
+    if (jc->pos == jc->alloc) {
+        jc->alloc *= 2;
+        jc->buf    = realloc(jc->buf, jc->alloc);
+    }
+    jc->buf[jc->pos++] = b;
+}
+
+static void emit_int32(JitCompiler *jc, MVMint32 v) {
+    MVMuint32 u = (MVMuint32)v;
+    emit_byte(jc, u & 0xFF);
+    emit_byte(jc, (u >> 8) & 0xFF);
+    emit_byte(jc, (u >> 16) & 0xFF);
+    emit_byte(jc, (u >> 24) & 0xFF);
+}
+
+static void emit_int64(JitCompiler *jc, MVMint64 v) {
+    MVMuint64 u = (MVMuint64)v;
+    emit_int32(jc, (MVMint32)(u & 0xFFFFFFFF));
+    emit_int32(jc, (MVMint32)(u >> 32));
+}
+
+/* A REX prefix for a 64-bit operation, with the high bits of the register
+ * in the ModRM reg field and of the base (or r/m) register. */
+static void emit_rex_w(JitCompiler *jc, MVMuint8 reg, MVMuint8 base) {
+    emit_byte(jc, 0x48 | ((reg >> 3) << 2) | (base >> 3));
+}
+
+/* A ModRM for [base + disp32], with a SIB where the base needs one. */
+static void emit_mem(JitCompiler *jc, MVMuint8 reg, MVMuint8 base, MVMint32 disp) {
+    emit_byte(jc, 0x80 | ((reg & 7) << 3) | (base & 7));
+    if ((base & 7) == RSP)
+        emit_byte(jc, 0x24);
+    emit_int32(jc, disp);
+}
+
+/* A 64-bit instruction with a register and a memory operand. */
+static void emit_rm(JitCompiler *jc, MVMuint8 opcode, MVMuint8 reg, MVMuint8 base, MVMint32 disp) {
+    emit_rex_w(jc, reg, base);
+    emit_byte(jc, opcode);
+    emit_mem(jc, reg, base, disp);
+}
+
+/* mov dst, src */
+static void emit_mov_rr(JitCompiler *jc, MVMuint8 dst, MVMuint8 src) {
+    emit_rex_w(jc, src, dst);
+    emit_byte(jc, 0x89);
+    emit_byte(jc, 0xC0 | ((src & 7) << 3) | (dst & 7));
+}
+
+/* mov reg, imm64 */
+static void emit_mov_imm(JitCompiler *jc, MVMuint8 reg, MVMint64 value) {
+    emit_byte(jc, 0x48 | (reg >> 3));
+    emit_byte(jc, 0xB8 + (reg & 7));
+    emit_int64(jc, value);
+}
+
+/* Loads and stores of work registers, and loads through a pointer. */
+static void emit_load_reg(JitCompiler *jc, MVMuint8 reg, MVMSpeshOperand o) {
+    emit_rm(jc, 0x8B, reg, WORK, o.reg.orig * sizeof(MVMRegister));
+}
+static void emit_store_reg(JitCompiler *jc, MVMuint8 reg, MVMSpeshOperand o) {
+    emit_rm(jc, 0x89, reg, WORK, o.reg.orig * sizeof(MVMRegister));
+}
+static void emit_load(JitCompiler *jc, MVMuint8 reg, MVMuint8 base, size_t offset) {
+    emit_rm(jc, 0x8B, reg, base, (MVMint32)offset);
+}
+
+/* Calls a function; the arguments must already be in place. */
+static void emit_call(JitCompiler *jc, MVMuint64 func) {
+    emit_mov_imm(jc, RAX, (MVMint64)func);
+    emit_byte(jc, 0xFF);
+    emit_byte(jc, 0xD0);
+}
+
+/* A jump (given the opcode bytes) to a label, filled in at the end. */
+static void emit_jump(JitCompiler *jc, MVMuint8 op1, MVMuint8 op2, MVMint32 label) {
+    if (op1)
+        emit_byte(jc, op1);
+    emit_byte(jc, op2);
+    if (jc->num_fixups == jc->alloc_fixups) {
+        jc->alloc_fixups = jc->alloc_fixups ? jc->alloc_fixups * 2 : 16;
+        jc->fixups       = realloc(jc->fixups, jc->alloc_fixups * sizeof(JitFixup));
+    }
+    jc->fixups[jc->num_fixups].pos   = jc->pos;
+    jc->fixups[jc->num_fixups].label = label;
+    jc->num_fixups++;
+    emit_int32(jc, 0);
+}
+
+/* Lets a GC run go ahead if one is waiting for us, as the interpreter does
+ * on branches; we do it on backward ones, so loops can't hold it up. */
+static void emit_gc_sync_point(JitCompiler *jc) {
+    MVMuint32 skip;
+    emit_rex_w(jc, 0, TC);
+    emit_byte(jc, 0x83);
+    emit_mem(jc, 7, TC, (MVMint32)offsetof(MVMThreadContext, gc_status));
+    emit_byte(jc, 0x00);
+    emit_byte(jc, 0x74);
+    skip = jc->pos;
+    emit_byte(jc, 0);
+    emit_mov_rr(jc, arg_regs[0], TC);
+    emit_call(jc, (MVMuint64)(uintptr_t)MVM_gc_enter_from_interrupt);
+    jc->buf[skip] = (MVMuint8)(jc->pos - skip - 1);
+}
+
+/* Compiles a branch, with a GC sync point first if it goes backwards. */
+static void emit_branch(JitCompiler *jc, MVMSpeshIns *ins, MVMint32 cond_reg_idx,
+                        MVMuint8 jcc) {
+    MVMSpeshBB *target = ins->operands[cond_reg_idx < 0 ? 0 : 1].ins_bb;
+    if (jc->labels[target->idx] >= 0)
+        emit_gc_sync_point(jc);
+    if (cond_reg_idx < 0) {
+        emit_jump(jc, 0, 0xE9, target->idx);
+    }
+    else {
+        /* cmp qword [reg], 0 */
+        emit_rex_w(jc, 0, WORK);
+        emit_byte(jc, 0x83);
+        emit_mem(jc, 7, WORK, ins->operands[cond_reg_idx].reg.orig * sizeof(MVMRegister));
+        emit_byte(jc, 0x00);
+        emit_jump(jc, 0x0F, jcc, target->idx);
+    }
+}
+
+/* Compiles an instruction. */
+static void compile_ins(JitCompiler *jc, MVMSpeshGraph *g, MVMSpeshIns *ins) {
+    MVMSpeshOperand *o = ins->operands;
+    switch (ins->info->opcode) {
+    case MVM_SSA_PHI:
+    case MVM_OP_no_op:
+        break;
+    case MVM_OP_const_i64:
+        emit_mov_imm(jc, RAX, o[1].lit_i64);
+        emit_store_reg(jc, RAX, o[0]);
+        break;
+    case MVM_OP_const_i64_16:
+        emit_mov_imm(jc, RAX, o[1].lit_i16);
+        emit_store_reg(jc, RAX, o[0]);
+        break;
+    case MVM_OP_const_i64_32:
+        emit_mov_imm(jc, RAX, o[1].lit_i32);
+        emit_store_reg(jc, RAX, o[0]);
+        break;
+    case MVM_OP_const_n64: {
+        MVMint64 bits;
+        memcpy(&bits, &o[1].lit_n64, sizeof(MVMint64));
+        emit_mov_imm(jc, RAX, bits);
+        emit_store_reg(jc, RAX, o[0]);
+        break;
+    }
+    case MVM_OP_const_s:
+        emit_load(jc, RAX, TC, offsetof(MVMThreadContext, cur_frame));
+        emit_load(jc, RAX, RAX, offsetof(MVMFrame, static_info));
+        emit_load(jc, RAX, RAX, offsetof(MVMStaticFrame, body.cu));
+        emit_load(jc, RAX, RAX, offsetof(MVMCompUnit, body.strings));
+        emit_load(jc, RAX, RAX, o[1].lit_str_idx * sizeof(MVMString *));
+        emit_store_reg(jc, RAX, o[0]);
+        break;
+    case MVM_OP_set:
+        emit_load_reg(jc, RAX, o[1]);
+        emit_store_reg(jc, RAX, o[0]);
+        break;
+    case MVM_OP_null:
+        emit_load(jc, RAX, TC, offsetof(MVMThreadContext, instance));
+        emit_load(jc, RAX, RAX, offsetof(MVMInstance, VMNull));
+        emit_store_reg(jc, RAX, o[0]);
+        break;
+    case MVM_OP_add_i:
+    case MVM_OP_sub_i:
+    case MVM_OP_band_i:
+    case MVM_OP_bor_i:
+    case MVM_OP_bxor_i: {
+        MVMuint8 opcode;
+        switch (ins->info->opcode) {
+        case MVM_OP_add_i:  opcode = 0x03; break;
+        case MVM_OP_sub_i:  opcode = 0x2B; break;
+        case MVM_OP_band_i: opcode = 0x23; break;
+        case MVM_OP_bor_i:  opcode = 0x0B; break;
+        default:            opcode = 0x33; break;
+        }
+        emit_load_reg(jc, RAX, o[1]);
+        emit_rm(jc, opcode, RAX, WORK, o[2].reg.orig * sizeof(MVMRegister));
+        emit_store_reg(jc, RAX, o[0]);
+        break;
+    }
+    case MVM_OP_mul_i:
+        emit_load_reg(jc, RAX, o[1]);
+        emit_rex_w(jc, RAX, WORK);
+        emit_byte(jc, 0x0F);
+        emit_byte(jc, 0xAF);
+        emit_mem(jc, RAX, WORK, o[2].reg.orig * sizeof(MVMRegister));
+        emit_store_reg(jc, RAX, o[0]);
+        break;
+    case MVM_OP_neg_i:
+    case MVM_OP_bnot_i:
+        emit_load_reg(jc, RAX, o[1]);
+        emit_byte(jc, 0x48);
+        emit_byte(jc, 0xF7);
+        emit_byte(jc, ins->info->opcode == MVM_OP_neg_i ? 0xD8 : 0xD0);
+        emit_store_reg(jc, RAX, o[0]);
+        break;
+    case MVM_OP_inc_i:
+    case MVM_OP_dec_i:
+        emit_rex_w(jc, 0, WORK);
+        emit_byte(jc, 0xFF);
+        emit_mem(jc, ins->info->opcode == MVM_OP_inc_i ? 0 : 1, WORK,
+            o[0].reg.orig * sizeof(MVMRegister));
+        break;
+    case MVM_OP_eq_i:
+    case MVM_OP_ne_i:
+    case MVM_OP_lt_i:
+    case MVM_OP_le_i:
+    case MVM_OP_gt_i:
+    case MVM_OP_ge_i: {
+        MVMuint8 setcc;
+        switch (ins->info->opcode) {
+        case MVM_OP_eq_i: setcc = 0x94; break;
+        case MVM_OP_ne_i: setcc = 0x95; break;
+        case MVM_OP_lt_i: setcc = 0x9C; break;
+        case MVM_OP_le_i: setcc = 0x9E; break;
+        case MVM_OP_gt_i: setcc = 0x9F; break;
+        default:          setcc = 0x9D; break;
+        }
+        emit_load_reg(jc, RAX, o[1]);
+        emit_rm(jc, 0x3B, RAX, WORK, o[2].reg.orig * sizeof(MVMRegister));
+        emit_byte(jc, 0x0F);
+        emit_byte(jc, setcc);
+        emit_byte(jc, 0xC0);
+        /* movzx eax, al; which clears the rest of rax too */
+        emit_byte(jc, 0x0F);
+        emit_byte(jc, 0xB6);
+        emit_byte(jc, 0xC0);
+        emit_store_reg(jc, RAX, o[0]);
+        break;
+    }
+    case MVM_OP_add_n:
+    case MVM_OP_sub_n:
+    case MVM_OP_mul_n:
+    case MVM_OP_div_n: {
+        MVMuint8 opcode;
+        switch (ins->info->opcode) {
+        case MVM_OP_add_n: opcode = 0x58; break;
+        case MVM_OP_sub_n: opcode = 0x5C; break;
+        case MVM_OP_mul_n: opcode = 0x59; break;
+        default:           opcode = 0x5E; break;
+        }
+        /* movsd xmm0, [a]; op xmm0, [b]; movsd [dest], xmm0 */
+        emit_byte(jc, 0xF2);
+        emit_byte(jc, 0x0F);
+        emit_byte(jc, 0x10);
+        emit_mem(jc, 0, WORK, o[1].reg.orig * sizeof(MVMRegister));
+        emit_byte(jc, 0xF2);
+        emit_byte(jc, 0x0F);
+        emit_byte(jc, opcode);
+        emit_mem(jc, 0, WORK, o[2].reg.orig * sizeof(MVMRegister));
+        emit_byte(jc, 0xF2);
+        emit_byte(jc, 0x0F);
+        emit_byte(jc, 0x11);
+        emit_mem(jc, 0, WORK, o[0].reg.orig * sizeof(MVMRegister));
+        break;
+    }
+    case MVM_OP_goto:
+        emit_branch(jc, ins, -1, 0);
+        break;
+    case MVM_OP_if_i:
+        emit_branch(jc, ins, 0, 0x85);
+        break;
+    case MVM_OP_unless_i:
+        emit_branch(jc, ins, 0, 0x84);
+        break;
+    case MVM_OP_sp_getarg_o:
+    case MVM_OP_sp_getarg_i:
+    case MVM_OP_sp_getarg_n:
+    case MVM_OP_sp_getarg_s:
+        emit_load(jc, RAX, TC, offsetof(MVMThreadContext, cur_frame));
+        emit_load(jc, RAX, RAX, offsetof(MVMFrame, params.args));
+        emit_load(jc, RAX, RAX, o[1].lit_i16 * sizeof(MVMRegister));
+        emit_store_reg(jc, RAX, o[0]);
+        break;
+    case MVM_OP_sp_getspeshslot:
+        emit_load(jc, RAX, TC, offsetof(MVMThreadContext, cur_frame));
+        emit_load(jc, RAX, RAX, offsetof(MVMFrame, effective_spesh_slots));
+        emit_load(jc, RAX, RAX, o[1].lit_i16 * sizeof(MVMCollectable *));
+        emit_store_reg(jc, RAX, o[0]);
+        break;
+    case MVM_OP_sp_guardconc:
+    case MVM_OP_sp_guardtype: {
+        MVMJitGuard *guard  = &jc->guards[jc->num_guards++];
+        guard->op           = ins->info->opcode;
+        guard->reg          = o[0].reg.orig;
+        guard->slot         = o[1].lit_i16;
+        guard->deopt_offset = g->deopt_addrs[2 * find_deopt_idx(ins) + 1];
+        emit_mov_rr(jc, arg_regs[0], TC);
+        emit_mov_imm(jc, arg_regs[1], (MVMint64)(uintptr_t)guard);
+        emit_call(jc, (MVMuint64)(uintptr_t)jit_guard);
+        /* test eax, eax; jnz deopt */
+        emit_byte(jc, 0x85);
+        emit_byte(jc, 0xC0);
+        emit_jump(jc, 0x0F, 0x85, LABEL_DEOPT(g));
+        break;
+    }
+    case MVM_OP_return_i:
+    case MVM_OP_return_n:
+    case MVM_OP_return_s:
+    case MVM_OP_return_o:
+    case MVM_OP_return:
+        emit_mov_rr(jc, arg_regs[0], TC);
+        if (ins->info->opcode == MVM_OP_return)
+            emit_mov_imm(jc, arg_regs[1], 0);
+        else
+            emit_rm(jc, 0x8D, arg_regs[1], WORK, o[0].reg.orig * sizeof(MVMRegister));
+        emit_mov_imm(jc, arg_regs[2], ins->info->opcode);
+        emit_call(jc, (MVMuint64)(uintptr_t)jit_return);
+        emit_jump(jc, 0, 0xE9, LABEL_EPILOGUE(g));
+        break;
+    }
+}
+
+/* Machine code goes in chunks of pages mapped for it, so each candidate
+ * doesn't need a mapping of its own. Code is written while its pages are
+ * only readable and writable, then they're made executable and are never
+ * written again, so no page is ever writable and executable at once. That
+ * means each candidate's code starts on a page of its own, as adding to a
+ * page already made executable would mean making code other threads may be
+ * running writable again. */
+#define MVM_JIT_CODE_CHUNK_SIZE (256 * 1024)
+
+static MVMuint8 * place_code(MVMThreadContext *tc, MVMuint8 *buf, size_t size) {
+    MVMInstance *instance = tc->instance;
+    size_t       page     = MVM_platform_page_size();
+    size_t       pages    = (size + page - 1) / page * page;
+    MVMuint8    *code     = NULL;
+
+    /* Take the pages from the current chunk, mapping another if it has too
+     * few left; code too big for a chunk gets pages of its own. */
+    uv_mutex_lock(&instance->mutex_jit_code);
+    if (pages > MVM_JIT_CODE_CHUNK_SIZE) {
+        code = MVM_platform_alloc_pages(pages, 0);
+    }
+    else {
+        if (!instance->jit_code_chunk ||
+                instance->jit_code_chunk_pos + pages > MVM_JIT_CODE_CHUNK_SIZE) {
+            instance->jit_code_chunk     = MVM_platform_alloc_pages(MVM_JIT_CODE_CHUNK_SIZE, 0);
+            instance->jit_code_chunk_pos = 0;
+        }
+        if (instance->jit_code_chunk) {
+            code = instance->jit_code_chunk + instance->jit_code_chunk_pos;
+            instance->jit_code_chunk_pos += pages;
+        }
+    }
+    uv_mutex_unlock(&instance->mutex_jit_code);
+
+    /* The pages are ours alone, so can be filled in without the lock. */
+    if (!code)
+        return NULL;
+    memcpy(code, buf, size);
+    return MVM_platform_make_executable(code, pages) ? code : NULL;
+}
+
+/* Compiles the graph of a specialization to machine code, if it only has
+ * ops we know how to compile; returns NULL otherwise. */
+MVMJitCode * MVM_jit_compile_graph(MVMThreadContext *tc, MVMSpeshGraph *g) {
+    JitCompiler  jc;
+    MVMJitCode  *code;
+    MVMSpeshBB  *bb;
+    MVMuint32    num_guards = 0;
+    MVMuint32    i;
+
+    /* Frames with handlers need the interpreter to find them, and the
+     * specialized bytecode to tell where they are. */
+    if (g->sf->body.num_handlers)
+        return NULL;
+    for (bb = g->entry; bb; bb = bb->linear_next) {
+        MVMSpeshIns *ins = bb->first_ins;
+        while (ins) {
+            if (!is_supported(ins->info->opcode))
+                return NULL;
+            if (ins->info->opcode == MVM_OP_sp_guardconc || ins->info->opcode == MVM_OP_sp_guardtype) {
+                if (find_deopt_idx(ins) < 0)
+                    return NULL;
+                num_guards++;
+            }
+            ins = ins->next;
+        }
+    }
+
+    jc.alloc        = 1024;
+    jc.buf          = malloc(jc.alloc);
+    jc.pos          = 0;
+    jc.labels       = malloc((g->num_bbs + 2) * sizeof(MVMint32));
+    jc.fixups       = NULL;
+    jc.num_fixups   = 0;
+    jc.alloc_fixups = 0;
+    jc.guards       = num_guards ? malloc(num_guards * sizeof(MVMJitGuard)) : NULL;
+    jc.num_guards   = 0;
+    for (i = 0; i < (MVMuint32)g->num_bbs + 2; i++)
+        jc.labels[i] = -1;
+
+    /* Prologue: save the registers we use that the caller expects to keep,
+     * keep the stack aligned and leave room for the callee to save argument
+     * registers, as Win64 needs. */
+    emit_byte(&jc, 0x55);                           /* push rbp */
+    emit_mov_rr(&jc, RBP, RSP);
+    emit_byte(&jc, 0x53);                           /* push rbx */
+    emit_byte(&jc, 0x41);                           /* push r14 */
+    emit_byte(&jc, 0x56);
+    emit_byte(&jc, 0x48);                           /* sub rsp, 32 */
+    emit_byte(&jc, 0x83);
+    emit_byte(&jc, 0xEC);
+    emit_byte(&jc, 0x20);
+    emit_mov_rr(&jc, TC, arg_regs[0]);
+    emit_mov_rr(&jc, WORK, arg_regs[1]);
+
+    /* The code, a basic block at a time, in the same order as code-gen lays
+     * it out, so falling through to the next block works the same. */
+    for (bb = g->entry; bb; bb = bb->linear_next) {
+        MVMSpeshIns *ins = bb->first_ins;
+        jc.labels[bb->idx] = jc.pos;
+        while (ins) {
+            compile_ins(&jc, g, ins);
+            ins = ins->next;
+        }
+    }
+
+    /* Leaving after a guard failed; the interpreter carries on. */
+    jc.labels[LABEL_DEOPT(g)] = jc.pos;
+    emit_byte(&jc, 0xB8);                           /* mov eax, 1 */
+    emit_int32(&jc, 1);
+
+    /* Epilogue. */
+    jc.labels[LABEL_EPILOGUE(g)] = jc.pos;
+    emit_byte(&jc, 0x48);                           /* add rsp, 32 */
+    emit_byte(&jc, 0x83);
+    emit_byte(&jc, 0xC4);
+    emit_byte(&jc, 0x20);
+    emit_byte(&jc, 0x41);                           /* pop r14 */
+    emit_byte(&jc, 0x5E);
+    emit_byte(&jc, 0x5B);                           /* pop rbx */
+    emit_byte(&jc, 0x5D);                           /* pop rbp */
+    emit_byte(&jc, 0xC3);                           /* ret */
+
+    /* Fill in the jumps. */
+    for (i = 0; i < jc.num_fixups; i++) {
+        MVMuint32 pos = jc.fixups[i].pos;
+        MVMint32  rel = jc.labels[jc.fixups[i].label] - (MVMint32)(pos + 4);
+        jc.buf[pos]     = (MVMuint32)rel & 0xFF;
+        jc.buf[pos + 1] = ((MVMuint32)rel >> 8) & 0xFF;
+        jc.buf[pos + 2] = ((MVMuint32)rel >> 16) & 0xFF;
+        jc.buf[pos + 3] = ((MVMuint32)rel >> 24) & 0xFF;
+    }
+
+    /* Put it in executable memory. */
+    code       = malloc(sizeof(MVMJitCode));
+    code->size = jc.pos;
+    code->code = place_code(tc, jc.buf, code->size);
+    if (!code->code) {
+        free(code);
+        code = NULL;
+    }
+    else {
+        code->func       = (MVMJitFunc)code->code;
+        code->guards     = jc.guards;
+        code->num_guards = jc.num_guards;
+        code->bytecode   = malloc(sizeof(MVMuint16));
+        *((MVMuint16 *)code->bytecode) = MVM_OP_sp_jit_enter;
+        jc.guards = NULL;
+    }
+
+    free(jc.buf);
+    free(jc.labels);
+    if (jc.fixups)
+        free(jc.fixups);
+    if (jc.guards)
+        free(jc.guards);
+    return code;
+}
+
+#else
+
+/* We only know how to produce x86-64 machine code. */
+MVMJitCode * MVM_jit_compile_graph(MVMThreadContext *tc, MVMSpeshGraph *g) {
+    return NULL;
+}
+
+#endif
@@ -0,0 +1,42 @@
+/* The machine code for a specialization. Called with the thread context and
+ * the frame's work registers, it runs the frame until it returns or has to
+ * deoptimize. In both cases the interpreter's current op is left where the
+ * interpreter should carry on; the return value is zero if it should stop,
+ * having returned from the frame it was entered with, as the return ops do
+ * when MVM_frame_try_return says so. */
+typedef MVMint32 (*MVMJitFunc)(MVMThreadContext *tc, MVMRegister *work);
+
+/* A guard in compiled code; enough to check it and to find where to
+ * deoptimize to in the specialized bytecode if it fails. */
+struct MVMJitGuard {
+    /* The guard op, the register it checks and the spesh slot with the
+     * STable it wants. */
+    MVMuint16 op;
+    MVMuint16 reg;
+    MVMuint16 slot;
+
+    /* The offset just after the guard in the specialized bytecode, which is
+     * what its entry in the candidate's deopt table maps from. */
+    MVMint32 deopt_offset;
+};
+
+/* Machine code compiled from the graph of a specialization. */
+struct MVMJitCode {
+    /* The entry point. */
+    MVMJitFunc func;
+
+    /* The executable memory the code lives in, and its size. */
+    MVMuint8 *code;
+    size_t    size;
+
+    /* Bytecode for frames running the code to start out at; a single
+     * sp_jit_enter, which calls func. */
+    MVMuint8 *bytecode;
+
+    /* Guards in the code, and the number of them. */
+    MVMJitGuard *guards;
+    MVMuint32    num_guards;
+};
+
+/* Functions. */
+MVMJitCode * MVM_jit_compile_graph(MVMThreadContext *tc, MVMSpeshGraph *g);
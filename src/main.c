@@ -25,7 +25,8 @@ enum {
     FLAG_VERSION,
 
     OPT_EXECNAME,
-    OPT_LIBPATH
+    OPT_LIBPATH,
+    OPT_NURSERY_SIZE
 };
 
 static const char *const FLAGS[] = {
@@ -38,7 +39,7 @@ static const char *const FLAGS[] = {
 };
 
 static const char USAGE[] = "\
-USAGE: moar [--dump] [--crash] [--libpath=...] " TRACING_OPT "input.moarvm [program args]\n\
+USAGE: moar [--dump] [--crash] [--libpath=...] [--nursery-size=...] " TRACING_OPT "input.moarvm [program args]\n\
        moar [--help]\n\
 \n\
     --help            display this message\n\
@@ -46,6 +47,7 @@ USAGE: moar [--dump] [--crash] [--libpath=...] " TRACING_OPT "input.moarvm [prog
     --full-cleanup    try to free all memory and exit cleanly\n\
     --crash           abort instead of exiting on unhandled exception\n\
     --libpath         specify path loadbytecode should search in\n\
+    --nursery-size    initial size of each thread's nursery, in bytes\n\
     --version         show version information"
     TRACING_USAGE;
 
@@ -77,6 +79,8 @@ static int parse_flag(const char *arg)
         return OPT_LIBPATH;
     else if (starts_with(arg, "--execname="))
         return OPT_EXECNAME;
+    else if (starts_with(arg, "--nursery-size="))
+        return OPT_NURSERY_SIZE;
     else
         return UNKNOWN_FLAG;
 }
@@ -87,6 +91,8 @@ int main(int argc, char *argv[])
     const char  *input_file;
     const char  *executable_name = NULL;
     const char  *lib_path[8];
+    MVMuint64    nursery_size = 0;
+    const char  *nursery_arg;
 
     int dump         = 0;
     int full_cleanup = 0;
@@ -131,6 +137,14 @@ int main(int argc, char *argv[])
             lib_path[lib_path_i++] = argv[argi] + strlen("--libpath=");
             continue;
 
+            case OPT_NURSERY_SIZE:
+            nursery_arg = argv[argi] + strlen("--nursery-size=");
+            if (!MVM_vm_parse_nursery_size(nursery_arg, &nursery_size)) {
+                fprintf(stderr, "ERROR: Invalid nursery size %s.\n", nursery_arg);
+                return EXIT_FAILURE;
+            }
+            continue;
+
             case FLAG_VERSION:
             printf("This is MoarVM version %s\n", MVM_VERSION);
             return EXIT_SUCCESS;
@@ -151,6 +165,9 @@ int main(int argc, char *argv[])
     instance   = MVM_vm_create_instance();
     input_file = argv[argi++];
 
+    if (nursery_size)
+        MVM_vm_set_nursery_size(instance, nursery_size);
+
     /* stash the rest of the raw command line args in the instance */
     instance->num_clargs = argc - argi;
     instance->raw_clargs = argv + argi;
@@ -8,21 +8,96 @@
 	} \
 } while (0)
 
+/* Keeps a requested nursery size within the bounds we allow. */
+static MVMuint32 clamp_nursery_size(MVMuint64 size) {
+    if (size < MVM_NURSERY_MIN_SIZE)
+        return MVM_NURSERY_MIN_SIZE;
+    if (size > MVM_NURSERY_MAX_SIZE)
+        return MVM_NURSERY_MAX_SIZE;
+    return (MVMuint32)size;
+}
+
+/* Parses a nursery size, in bytes, as given to --nursery-size or in
+ * MVM_GC_NURSERY_SIZE. Returns zero if it isn't a plain decimal number that
+ * fits; otherwise puts it in size (it's clamped when it's set) and returns
+ * non-zero. */
+MVMint32 MVM_vm_parse_nursery_size(const char *text, MVMuint64 *size) {
+    char *end;
+    unsigned long long parsed;
+    if (!text || *text < '0' || *text > '9')
+        return 0;
+    errno  = 0;
+    parsed = strtoull(text, &end, 10);
+    if (errno || *end)
+        return 0;
+    *size = (MVMuint64)parsed;
+    return 1;
+}
+
+/* Makes a seed for the string hash that can't be guessed from outside: from
+ * the OS's random source where there is one, mixed with the time and the
+ * process ID in case it can't be read. The mixing is splitmix64's. */
+static MVMuint64 random_hash_seed(MVMThreadContext *tc) {
+    MVMuint64 seed = uv_hrtime() ^ ((MVMuint64)MVM_proc_getpid(tc) << 32)
+        ^ (MVMuint64)(uintptr_t)tc;
+#ifndef _WIN32
+    FILE *urandom = fopen("/dev/urandom", "rb");
+    if (urandom) {
+        MVMuint64 random;
+        if (fread(&random, sizeof(random), 1, urandom) == 1)
+            seed ^= random;
+        fclose(urandom);
+    }
+#endif
+    seed += 0x9E3779B97F4A7C15ULL;
+    seed  = (seed ^ (seed >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    seed  = (seed ^ (seed >> 27)) * 0x94D049BB133111EBULL;
+    return seed ^ (seed >> 31);
+}
+
 /* Create a new instance of the VM. */
 static void string_consts(MVMThreadContext *tc);
 static void setup_std_handles(MVMThreadContext *tc);
 MVMInstance * MVM_vm_create_instance(void) {
     MVMInstance *instance;
-    char *spesh_log, *spesh_disable;
+    char *spesh_log, *spesh_disable, *spesh_blocking, *spesh_report, *spesh_threshold;
+    char *spesh_inline_disable;
+    char *jit_disable;
+    char *gc_steal_disable, *gc_mark_budget;
+    char *nursery_size, *nursery_fixed, *gc_stats_log, *gc_pretenure_disable;
+    char *hash_seed;
     int init_stat;
 
     /* Set up instance data structure. */
     instance = calloc(1, sizeof(MVMInstance));
 
+    /* Work out how big thread nurseries start out (in bytes), and whether
+     * they adapt from there; this is needed before creating any thread. */
+    instance->nursery_size = MVM_NURSERY_SIZE;
+    nursery_size = getenv("MVM_GC_NURSERY_SIZE");
+    if (nursery_size && strlen(nursery_size)) {
+        MVMuint64 size;
+        if (MVM_vm_parse_nursery_size(nursery_size, &size))
+            instance->nursery_size = clamp_nursery_size(size);
+        else
+            fprintf(stderr, "MoarVM: Ignoring invalid MVM_GC_NURSERY_SIZE %s\n",
+                nursery_size);
+    }
+    nursery_fixed = getenv("MVM_GC_NURSERY_FIXED");
+    if (!nursery_fixed || strlen(nursery_fixed) == 0)
+        instance->nursery_adaptive = 1;
+
     /* Create the main thread's ThreadContext and stash it. */
     instance->main_thread = MVM_tc_create(instance);
     instance->main_thread->thread_id = 1;
 
+    /* Seed the string hash before anything gets hashed. A fixed seed can be
+     * given, to make the ordering of hashes reproducible. */
+    hash_seed = getenv("MVM_HASH_SEED");
+    MVM_string_hash_seed(instance->main_thread, hash_seed && strlen(hash_seed)
+        ? (MVMuint64)strtoull(hash_seed, NULL, 10)
+        : random_hash_seed(instance->main_thread));
+
     /* No user threads when we start, and next thread to be created gets ID 2
      * (the main thread got ID 1). */
     instance->num_user_threads    = 0;
@@ -58,6 +133,16 @@ MVMInstance * MVM_vm_create_instance(void) {
     /* Set up container registry mutex. */
     init_mutex(instance->mutex_container_registry, "container registry");
 
+    /* Set up the barrier threads wait at during GC. */
+    MVM_gc_barrier_init(instance);
+
+    /* Set up GC statistics, and check if we've a file we should log each
+     * GC run to. */
+    MVM_gc_stats_init(instance);
+    gc_stats_log = getenv("MVM_GC_STATS_LOG");
+    if (gc_stats_log && strlen(gc_stats_log))
+        instance->gc_stats->log_fh = fopen(gc_stats_log, "w");
+
     /* Allocate all things during following setup steps directly in gen2, as
      * they will have program lifetime. */
     MVM_gc_allocate_gen2_default_set(instance->main_thread);
@@ -99,10 +184,17 @@ MVMInstance * MVM_vm_create_instance(void) {
     /* Initialize string cclass handling. */
     MVM_string_cclass_init(instance->main_thread);
 
+    /* Set up NFG, for synthetic graphemes. */
+    MVM_nfg_init(instance->main_thread);
+
     /* Create callsite intern pool. */
     instance->callsite_interns = calloc(1, sizeof(MVMCallsiteInterns));
     init_mutex(instance->mutex_callsite_interns, "callsite interns");
 
+    /* Create string intern table. */
+    instance->string_interns = calloc(1, sizeof(MVMStrHashTable));
+    init_mutex(instance->mutex_string_interns, "string interns");
+
     /* Mutex for spesh installations, and check if we've a file we
      * should log specializations to. */
     init_mutex(instance->mutex_spesh_install, "spesh installations");
@@ -113,6 +205,56 @@ MVMInstance * MVM_vm_create_instance(void) {
     if (!spesh_disable || strlen(spesh_disable) == 0)
         instance->spesh_enabled = 1;
 
+    /* Work out how hot frames must get before they're specialized, and see
+     * if we're to report on which were. */
+    instance->spesh_threshold = MVM_SPESH_DEFAULT_THRESHOLD;
+    spesh_threshold = getenv("MVM_SPESH_THRESHOLD");
+    if (spesh_threshold && strlen(spesh_threshold))
+        instance->spesh_threshold = (MVMuint32)strtoul(spesh_threshold, NULL, 10);
+    spesh_report = getenv("MVM_SPESH_REPORT");
+    if (spesh_report && strlen(spesh_report))
+        instance->spesh_report_fh = fopen(spesh_report, "w");
+
+    /* Queue for the spesh worker, and check if we're to do without it and
+     * specialize on the threads that need it instead. */
+    init_mutex(instance->mutex_spesh_queue, "spesh worker queue");
+    if ((init_stat = uv_cond_init(&instance->cond_spesh_queue)) < 0) {
+        fprintf(stderr, "MoarVM: Initialization of spesh worker condition variable failed\n    %s\n",
+            uv_strerror(init_stat));
+        exit(1);
+    }
+    spesh_blocking = getenv("MVM_SPESH_BLOCKING");
+    if (spesh_blocking && strlen(spesh_blocking))
+        instance->spesh_blocking = 1;
+
+    /* Inline small callees into specializations unless told not to. */
+    spesh_inline_disable = getenv("MVM_SPESH_INLINE_DISABLE");
+    if (!spesh_inline_disable || strlen(spesh_inline_disable) == 0)
+        instance->spesh_inline_enabled = 1;
+
+    /* Compile specializations to machine code unless told not to. */
+    jit_disable = getenv("MVM_JIT_DISABLE");
+    if (!jit_disable || strlen(jit_disable) == 0)
+        instance->jit_enabled = 1;
+    init_mutex(instance->mutex_jit_code, "machine code chunk");
+
+    /* Idle threads steal marking work in full collections unless told not
+     * to. */
+    gc_steal_disable = getenv("MVM_GC_STEAL_DISABLE");
+    if (!gc_steal_disable || strlen(gc_steal_disable) == 0)
+        instance->gc_steal_enabled = 1;
+
+    /* Pretenure long-lived types unless told not to. */
+    gc_pretenure_disable = getenv("MVM_GC_PRETENURE_DISABLE");
+    if (!gc_pretenure_disable || strlen(gc_pretenure_disable) == 0)
+        instance->gc_pretenure_enabled = 1;
+
+    /* If we're given a time budget (in microseconds), mark generation 2
+     * incrementally rather than all at once. */
+    gc_mark_budget = getenv("MVM_GC_MARK_BUDGET");
+    if (gc_mark_budget && strlen(gc_mark_budget))
+        instance->gc_mark_budget = (MVMuint64)strtoul(gc_mark_budget, NULL, 10) * 1000;
+
     /* Create std[in/out/err]. */
     setup_std_handles(instance->main_thread);
 
@@ -137,11 +279,26 @@ static void setup_std_handles(MVMThreadContext *tc) {
 /* This callback is passed to the interpreter code. It takes care of making
  * the initial invocation. */
 static void toplevel_initial_invoke(MVMThreadContext *tc, void *data) {
-    /* Dummy, 0-arg callsite. */
-    static MVMCallsite no_arg_callsite = { NULL, 0, 0, 0 };
+    /* Create initial frame, which sets up all of the interpreter state also.
+     * The 0-arg callsite is interned, so the mainline can be specialized. */
+    MVM_frame_invoke(tc, (MVMStaticFrame *)data, MVM_callsite_get_no_arg(tc),
+        NULL, NULL, NULL);
+}
 
-    /* Create initial frame, which sets up all of the interpreter state also. */
-    MVM_frame_invoke(tc, (MVMStaticFrame *)data, &no_arg_callsite, NULL, NULL, NULL);
+/* Sets the size (in bytes) that thread nurseries start out at. This is meant
+ * to be called right after the instance is created, while the main thread's
+ * nursery is still empty, so that can be resized straight away too. */
+void MVM_vm_set_nursery_size(MVMInstance *instance, MVMuint64 size) {
+    MVMThreadContext *tc = instance->main_thread;
+    instance->nursery_size = clamp_nursery_size(size);
+    tc->nursery_size       = instance->nursery_size;
+    if (tc->nursery_alloc == tc->nursery_tospace) {
+        free(tc->nursery_tospace);
+        tc->nursery_tospace_size = tc->nursery_size;
+        tc->nursery_tospace      = calloc(1, tc->nursery_tospace_size);
+        tc->nursery_alloc        = tc->nursery_tospace;
+        tc->nursery_alloc_limit  = (char *)tc->nursery_alloc + tc->nursery_tospace_size;
+    }
 }
 
 /* Loads bytecode from the specified file name and runs it. */
@@ -150,8 +307,12 @@ void MVM_vm_run_file(MVMInstance *instance, const char *filename) {
 
     /* Map the compilation unit into memory and dissect it. */
     MVMThreadContext *tc = instance->main_thread;
-    MVMCompUnit      *cu = MVM_cu_map_from_file(tc, filename);
+    MVMCompUnit      *cu;
+
+    /* Get the spesh worker going, so it's there once frames get hot. */
+    MVM_spesh_worker_start(tc);
 
+    cu = MVM_cu_map_from_file(tc, filename);
     MVMROOT(tc, cu, {
         /* The call to MVM_string_utf8_decode() may allocate, invalidating the
            location cu->body.filename */
@@ -189,9 +350,12 @@ void MVM_vm_exit(MVMInstance *instance) {
     /* Join any foreground threads. */
     MVM_thread_join_foreground(instance->main_thread);
 
-    /* Close any spesh log. */
+    /* Stop the spesh worker, then close any spesh log and report. */
+    MVM_spesh_worker_stop(instance->main_thread);
     if (instance->spesh_log_fh)
         fclose(instance->spesh_log_fh);
+    if (instance->spesh_report_fh)
+        fclose(instance->spesh_report_fh);
 
     /* And, we're done. */
     exit(0);
@@ -204,6 +368,9 @@ void MVM_vm_destroy_instance(MVMInstance *instance) {
     /* Join any foreground threads. */
     MVM_thread_join_foreground(instance->main_thread);
 
+    /* Stop the spesh worker, so it's not using anything we clean up. */
+    MVM_spesh_worker_stop(instance->main_thread);
+
     /* Run the GC global destruction phase. After this,
      * no 6model object pointers should be accessed. */
     MVM_gc_global_destruction(instance->main_thread);
@@ -246,16 +413,36 @@ void MVM_vm_destroy_instance(MVMInstance *instance) {
     uv_mutex_destroy(&instance->mutex_container_registry);
     MVM_HASH_DESTROY(hash_handle, MVMContainerRegistry, instance->container_registry);
 
+    /* Clean up the string intern table. It's emptied by the strings in it
+     * being freed during global destruction. */
+    uv_mutex_destroy(&instance->mutex_string_interns);
+    MVM_str_hash_demolish(instance->main_thread, instance->string_interns);
+    MVM_checked_free_null(instance->string_interns);
+
+    /* Clean up NFG state, which holds the synthetics. */
+    MVM_nfg_destroy(instance->main_thread);
+
     /* Clean up Hash of compiler objects keyed by name. */
     uv_mutex_destroy(&instance->mutex_compiler_registry);
 
     /* Clean up Hash of hashes of symbol tables per hll. */
     uv_mutex_destroy(&instance->mutex_hll_syms);
 
-    /* Clean up spesh install mutex and close any log. */
+    /* Clean up spesh install mutex and worker queue, and close any log and
+     * report. */
     uv_mutex_destroy(&instance->mutex_spesh_install);
+    MVM_spesh_worker_destroy(instance->main_thread);
     if (instance->spesh_log_fh)
         fclose(instance->spesh_log_fh);
+    if (instance->spesh_report_fh)
+        fclose(instance->spesh_report_fh);
+
+    /* Clean up machine code chunk mutex. */
+    uv_mutex_destroy(&instance->mutex_jit_code);
+
+    /* Clean up the GC barrier and statistics. */
+    MVM_gc_barrier_destroy(instance);
+    MVM_gc_stats_destroy(instance);
 
     /* Clean up event loop starting mutex. */
     uv_mutex_destroy(&instance->mutex_event_loop_start);
@@ -11,6 +11,7 @@
 
 /* stuff for uthash */
 #define uthash_fatal(msg) MVM_exception_throw_adhoc(tc, "internal hash error: " msg)
+#define HASH_KEYMATCH(a, alen, b, blen) MVM_string_hash_key_match((a), (alen), (b), (blen))
 
 #include <uthash.h>
 
@@ -71,8 +72,9 @@ typedef double   MVMnum64;
 
 /* Headers for various other data structures and APIs. */
 #include "6model/6model.h"
-#include "gc/wb.h"
+#include "gc/barrier.h"
 #include "core/threadcontext.h"
+#include "gc/wb.h"
 #include "core/instance.h"
 #include "core/interp.h"
 #include "core/callsite.h"
@@ -93,6 +95,7 @@ typedef double   MVMnum64;
 #include "core/ext.h"
 #include "core/nativecall.h"
 #include "core/continuation.h"
+#include "core/str_hash_table.h"
 #include "6model/reprs.h"
 #include "6model/reprconv.h"
 #include "6model/bootstrap.h"
@@ -104,6 +107,8 @@ typedef double   MVMnum64;
 #include "gc/collect.h"
 #include "gc/orchestrate.h"
 #include "gc/gen2.h"
+#include "gc/stats.h"
+#include "gc/snapshot.h"
 #include "gc/roots.h"
 #include "spesh/dump.h"
 #include "spesh/graph.h"
@@ -113,13 +118,19 @@ typedef double   MVMnum64;
 #include "spesh/args.h"
 #include "spesh/facts.h"
 #include "spesh/optimize.h"
+#include "spesh/inline.h"
 #include "spesh/deopt.h"
+#include "spesh/osr.h"
 #include "spesh/log.h"
+#include "spesh/worker.h"
+#include "jit/compile.h"
 #include "strings/decode_stream.h"
 #include "strings/ascii.h"
 #include "strings/utf8.h"
 #include "strings/utf16.h"
 #include "strings/ops.h"
+#include "strings/nfg.h"
+#include "strings/intern.h"
 #include "strings/unicode_gen.h"
 #include "strings/unicode.h"
 #include "strings/latin1.h"
@@ -145,6 +156,8 @@ MVMObject *MVM_backend_config(MVMThreadContext *tc);
 
 /* Top level VM API functions. */
 MVM_PUBLIC MVMInstance * MVM_vm_create_instance(void);
+MVM_PUBLIC MVMint32 MVM_vm_parse_nursery_size(const char *text, MVMuint64 *size);
+MVM_PUBLIC void MVM_vm_set_nursery_size(MVMInstance *instance, MVMuint64 size);
 MVM_PUBLIC void MVM_vm_run_file(MVMInstance *instance, const char *filename);
 MVM_PUBLIC void MVM_vm_dump_file(MVMInstance *instance, const char *filename);
 MVM_PUBLIC void MVM_vm_exit(MVMInstance *instance);
@@ -1,5 +1,6 @@
 #include <stddef.h>
 #include <sys/mman.h>
+#include <unistd.h>
 #include "platform/mmap.h"
 
 /* MAP_ANONYMOUS is Linux, MAP_ANON is BSD */
@@ -31,6 +32,29 @@ int MVM_platform_free_pages(void *block, size_t size)
     return munmap(block, size) == 0;
 }
 
+size_t MVM_platform_page_size(void)
+{
+    return (size_t)sysconf(_SC_PAGESIZE);
+}
+
+/* Makes pages that have been written to read-only and executable. */
+int MVM_platform_make_executable(void *block, size_t size)
+{
+    return mprotect(block, size, PROT_READ | PROT_EXEC) == 0;
+}
+
+/* Lets the OS take back the whole pages within a block of memory that is
+ * no longer needed, even if it's going back to malloc. They read as zeros,
+ * or as they were, if touched again. */
+void MVM_platform_discard_pages(void *block, size_t size)
+{
+    size_t page  = MVM_platform_page_size();
+    char  *start = (char *)(((size_t)block + page - 1) / page * page);
+    char  *end   = (char *)(((size_t)block + size) / page * page);
+    if (start < end)
+        madvise(start, end - start, MADV_DONTNEED);
+}
+
 void *MVM_platform_map_file(int fd, void **handle, size_t size, int writable)
 {
     void *block = mmap(NULL, size,
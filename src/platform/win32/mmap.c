@@ -14,6 +14,33 @@ int MVM_platform_free_pages(void *pages, size_t size)
     return VirtualFree(pages, 0, MEM_RELEASE);
 }
 
+size_t MVM_platform_page_size(void)
+{
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return info.dwPageSize;
+}
+
+/* Makes pages that have been written to read-only and executable. */
+int MVM_platform_make_executable(void *block, size_t size)
+{
+    DWORD old;
+    if (!VirtualProtect(block, size, PAGE_EXECUTE_READ, &old))
+        return 0;
+    return FlushInstructionCache(GetCurrentProcess(), block, size);
+}
+
+/* Lets the OS take back the whole pages within a block of memory that is
+ * no longer needed, even if it's going back to malloc. */
+void MVM_platform_discard_pages(void *block, size_t size)
+{
+    size_t page  = MVM_platform_page_size();
+    char  *start = (char *)(((size_t)block + page - 1) / page * page);
+    char  *end   = (char *)(((size_t)block + size) / page * page);
+    if (start < end)
+        VirtualAlloc(start, end - start, MEM_RESET, PAGE_READWRITE);
+}
+
 void *MVM_platform_map_file(int fd, void **handle, size_t size, int writable)
 {
     HANDLE fh, mapping;
@@ -1,5 +1,24 @@
 #include "moar.h"
 
+/* Writes a line to the specialization report, saying what happened with a
+ * candidate of a static frame, and how hot the frame was at the time. */
+static void report(MVMThreadContext *tc, MVMStaticFrame *static_frame,
+        MVMSpeshCandidate *candidate, const char *what) {
+    char *c_name = MVM_string_utf8_encode_C_string(tc, static_frame->body.name);
+    char *c_cuid = MVM_string_utf8_encode_C_string(tc, static_frame->body.cuuid);
+    fprintf(tc->instance->spesh_report_fh,
+        "%s candidate %d of '%s' (cuid: %s): %u invocations, %u loop iterations "
+        "(threshold %u); %d positional args, %u guards, %u inlines, %u bytes of bytecode%s\n",
+        what, (int)(candidate - static_frame->body.spesh_candidates) + 1,
+        c_name, c_cuid,
+        static_frame->body.invocations, static_frame->body.back_edges,
+        tc->instance->spesh_threshold, (int)candidate->cs->num_pos,
+        candidate->num_guards, candidate->num_inlines, candidate->bytecode_size,
+        candidate->jitcode ? ", compiled to machine code" : "");
+    free(c_name);
+    free(c_cuid);
+}
+
 /* Tries to set up a specialization of the bytecode for a given arg tuple.
  * Doesn't do the actual optimizations, just works out the guards and does
  * any simple argument transformations, and then inserts logging to record
@@ -66,6 +85,14 @@ MVMSpeshCandidate * MVM_spesh_candidate_setup(MVMThreadContext *tc,
             result->spesh_slots         = spesh_slots;
             result->num_deopts          = num_deopts;
             result->deopts              = deopts;
+            result->num_locals          = static_frame->body.num_locals;
+            result->local_types         = static_frame->body.local_types;
+            result->work_size           = static_frame->body.work_size;
+            result->inlines             = NULL;
+            result->num_inlines         = 0;
+            result->osr_entries         = NULL;
+            result->num_osr_entries     = 0;
+            result->jitcode             = NULL;
             result->num_log_slots       = num_log_slots;
             result->log_slots           = log_slots;
             result->sg                  = sg;
@@ -88,6 +115,8 @@ MVMSpeshCandidate * MVM_spesh_candidate_setup(MVMThreadContext *tc,
                 free(c_name);
                 free(c_cuid);
             }
+            if (tc->instance->spesh_report_fh)
+                report(tc, static_frame, result, "Logging");
         }
     }
     if (!result) {
@@ -114,6 +143,7 @@ void MVM_spesh_candidate_specialize(MVMThreadContext *tc, MVMStaticFrame *static
     MVMSpeshGraph *sg = candidate->sg;
     MVM_spesh_facts_discover(tc, sg);
     MVM_spesh_optimize(tc, sg);
+    MVM_spesh_osr_find_entries(tc, sg);
 
     /* Dump updated graph if needed. */
     if (tc->instance->spesh_log_fh) {
@@ -141,10 +171,34 @@ void MVM_spesh_candidate_specialize(MVMThreadContext *tc, MVMStaticFrame *static
     candidate->deopts        = sg->deopt_addrs;
     free(sc);
 
+    /* Note where frames can switch over to it mid-run. */
+    candidate->num_osr_entries = sg->num_osr_entries;
+    candidate->osr_entries     = sg->osr_entries;
+
     /* Update spesh slots. */
     candidate->num_spesh_slots = sg->num_spesh_slots;
     candidate->spesh_slots     = sg->spesh_slots;
 
+    /* If we inlined anything, we've more locals than the static frame, so
+     * frames running the specialization need a bigger work area. */
+    if (sg->num_inlines) {
+        candidate->local_types = malloc(sg->num_locals * sizeof(MVMuint16));
+        memcpy(candidate->local_types, sg->local_types,
+            sg->num_locals * sizeof(MVMuint16));
+        candidate->num_locals  = sg->num_locals;
+        candidate->work_size   = sizeof(MVMRegister) *
+            (sg->num_locals + static_frame->body.cu->body.max_callsite_size);
+        candidate->inlines     = sg->inlines;
+        candidate->num_inlines = sg->num_inlines;
+    }
+
+    /* Compile it to machine code too, if we can. */
+    if (tc->instance->jit_enabled)
+        candidate->jitcode = MVM_jit_compile_graph(tc, sg);
+
+    if (tc->instance->spesh_report_fh)
+        report(tc, static_frame, candidate, "Specialized");
+
     /* May now be referencing nursery objects, so barrier just in case. */
     if (static_frame->common.header.flags & MVM_CF_SECOND_GEN)
         if (!(static_frame->common.header.flags & MVM_CF_IN_GEN2_ROOT_LIST))
@@ -156,3 +210,56 @@ void MVM_spesh_candidate_specialize(MVMThreadContext *tc, MVMStaticFrame *static
     MVM_barrier();
     candidate->sg = NULL;
 }
+
+/* Looks through the finished and logging candidates of a static frame for
+ * one matching the given callsite and arguments; that is, one for the same
+ * callsite, all of whose guards the arguments pass. */
+MVMSpeshCandidate * MVM_spesh_candidate_find(MVMThreadContext *tc,
+        MVMStaticFrame *static_frame, MVMCallsite *callsite, MVMRegister *args) {
+    MVMint32 num_spesh = static_frame->body.num_spesh_candidates;
+    MVMint32 i, j;
+    for (i = 0; i < num_spesh; i++) {
+        MVMSpeshCandidate *cand = &static_frame->body.spesh_candidates[i];
+        if (cand->cs == callsite) {
+            MVMint32 match = 1;
+            for (j = 0; j < cand->num_guards; j++) {
+                MVMint32   pos = cand->guards[j].slot;
+                MVMSTable *st  = (MVMSTable *)cand->guards[j].match;
+                MVMObject *arg = args[pos].o;
+                if (!arg) {
+                    match = 0;
+                    break;
+                }
+                switch (cand->guards[j].kind) {
+                case MVM_SPESH_GUARD_CONC:
+                    if (!IS_CONCRETE(arg) || STABLE(arg) != st)
+                        match = 0;
+                    break;
+                case MVM_SPESH_GUARD_TYPE:
+                    if (IS_CONCRETE(arg) || STABLE(arg) != st)
+                        match = 0;
+                    break;
+                case MVM_SPESH_GUARD_DC_CONC: {
+                    MVMRegister dc;
+                    STABLE(arg)->container_spec->fetch(tc, arg, &dc);
+                    if (!dc.o || !IS_CONCRETE(dc.o) || STABLE(dc.o) != st)
+                        match = 0;
+                    break;
+                }
+                case MVM_SPESH_GUARD_DC_TYPE: {
+                    MVMRegister dc;
+                    STABLE(arg)->container_spec->fetch(tc, arg, &dc);
+                    if (!dc.o || IS_CONCRETE(dc.o) || STABLE(dc.o) != st)
+                        match = 0;
+                    break;
+                }
+                }
+                if (!match)
+                    break;
+            }
+            if (match)
+                return cand;
+        }
+    }
+    return NULL;
+}
@@ -30,6 +30,26 @@ struct MVMSpeshCandidate {
     /* Deoptimization mappings. */
     MVMint32 *deopts;
 
+    /* The number of locals the specialized code uses, their types, and the
+     * size of the work area frames running it need. These are more than the
+     * static frame's if callees were inlined. */
+    MVMuint32  num_locals;
+    MVMuint16 *local_types;
+    MVMuint32  work_size;
+
+    /* Callees inlined into the specialized code, and the number of them. */
+    MVMSpeshInline *inlines;
+    MVMuint32       num_inlines;
+
+    /* Places frames running the original bytecode can switch over to the
+     * specialized code at, as pairs of offsets into each, and the number of
+     * them. */
+    MVMint32  *osr_entries;
+    MVMuint32  num_osr_entries;
+
+    /* Machine code compiled from the specialized code, if we could. */
+    MVMJitCode *jitcode;
+
     /* Atomic integer for the number of times we've entered the code so far
      * for the purpose of logging, in the trace phase. We used this as an
      * index into the log slots when running logging code. Once it hits the
@@ -57,6 +77,10 @@ struct MVMSpeshCandidate {
 /* The number of specializations we'll allow per static frame. */
 #define MVM_SPESH_LIMIT 4
 
+/* How hot (invocations plus loop iterations) a static frame must get before
+ * we specialize it, unless MVM_SPESH_THRESHOLD says otherwise. */
+#define MVM_SPESH_DEFAULT_THRESHOLD 100
+
 /* A specialization guard. */
 struct MVMSpeshGuard {
     /* The kind of guard this is. */
@@ -75,8 +99,10 @@ struct MVMSpeshGuard {
 #define MVM_SPESH_GUARD_DC_CONC 3   /* Decont'd value is concrete with match type. */
 #define MVM_SPESH_GUARD_DC_TYPE 4   /* Decont'd value is type object with match type. */
 
-/* Functions for generating a specialization. */
+/* Functions for generating and finding specializations. */
 MVMSpeshCandidate * MVM_spesh_candidate_setup(MVMThreadContext *tc,
     MVMStaticFrame *static_frame, MVMCallsite *callsite, MVMRegister *args);
 void MVM_spesh_candidate_specialize(MVMThreadContext *tc, MVMStaticFrame *static_frame,
         MVMSpeshCandidate *candidate);
+MVMSpeshCandidate * MVM_spesh_candidate_find(MVMThreadContext *tc,
+    MVMStaticFrame *static_frame, MVMCallsite *callsite, MVMRegister *args);
@@ -244,12 +244,27 @@ MVMSpeshCode * MVM_spesh_codegen(MVMThreadContext *tc, MVMSpeshGraph *g) {
     for (i = 0; i < g->num_deopt_addrs; i++)
         g->deopt_addrs[i * 2 + 1] = -1;
 
+    /* Likewise for where inlined code starts and ends. */
+    for (i = 0; i < g->num_inlines; i++) {
+        g->inlines[i].start = -1;
+        g->inlines[i].end   = -1;
+    }
+
     /* Write out each of the basic blocks, in linear order. Skip the first,
-     * dummy, block. */
+     * dummy, block. The blocks of an inlined callee are always together, so
+     * we can note the range of its code as we go. */
     bb = g->entry->linear_next;
     while (bb) {
         ws->bb_offsets[bb->idx] = ws->bytecode_pos;
+        if (bb->osr_entry)
+            g->osr_entries[2 * (bb->osr_entry - 1) + 1] = ws->bytecode_pos;
         write_instructions(tc, g, ws, bb);
+        if (bb->inlined) {
+            MVMSpeshInline *inl = &g->inlines[bb->inlined - 1];
+            if (inl->start == -1)
+                inl->start = ws->bb_offsets[bb->idx];
+            inl->end = ws->bytecode_pos;
+        }
         bb = bb->linear_next;
     }
 
@@ -4,6 +4,43 @@
  * back out of it, because some assumption it made has been invalidated. This
  * file contains implementations of those various forms of de-opt. */
  
+/* Finds the inline, if any, that the given offset in a candidate's bytecode
+ * is in. De-opt offsets are those just after an instruction, so the start of
+ * the inlined code is not in it, but the end is. */
+static MVMSpeshInline * find_inline(MVMSpeshCandidate *cand, MVMint32 offset) {
+    MVMuint32 i;
+    for (i = 0; i < cand->num_inlines; i++)
+        if (offset > cand->inlines[i].start && offset <= cand->inlines[i].end)
+            return &cand->inlines[i];
+    return NULL;
+}
+
+/* De-optimizes a frame that is running code inlined into it. We switch the
+ * frame back to its original code, as though it had just made the call, and
+ * then make the frame that the inlined callee would have had, moving its
+ * registers over. It carries on from the given offset in its original code,
+ * and returns to the caller in the usual way. */
+static void uninline(MVMThreadContext *tc, MVMFrame *f, MVMSpeshInline *inl,
+                     MVMint32 offset) {
+    MVMCode        *code = (MVMCode *)f->spesh_cand->spesh_slots[inl->code_ref_idx];
+    MVMStaticFrame *sf   = code->body.sf;
+    MVMRegister    *work = f->work;
+    MVMFrame       *callee;
+
+    f->return_address        = f->static_info->body.bytecode + inl->return_offset;
+    f->return_value          = inl->res_type == MVM_RETURN_VOID ? NULL : work + inl->res_reg;
+    f->return_type           = inl->res_type;
+    f->effective_bytecode    = f->static_info->body.bytecode;
+    f->effective_handlers    = f->static_info->body.handlers;
+    f->effective_spesh_slots = NULL;
+    f->spesh_cand            = NULL;
+
+    callee = MVM_frame_create_for_deopt(tc, sf, code, inl->cs);
+    memcpy(callee->work, work + inl->locals_start,
+        sf->body.num_locals * sizeof(MVMRegister));
+    *(tc->interp_cur_op) = callee->effective_bytecode + offset;
+}
+
 /* De-optimizes the currently executing frame, provided it is specialized and
  * at a valid de-optimization point. Typically used when a guard fails. */
 void MVM_spesh_deopt_one(MVMThreadContext *tc) {
@@ -13,7 +50,15 @@ void MVM_spesh_deopt_one(MVMThreadContext *tc) {
         MVMint32 i;
         for (i = 0; i < f->spesh_cand->num_deopts * 2; i += 2) {
             if (f->spesh_cand->deopts[i + 1] == deopt_offset) {
-                /* Found it; switch back to the original code. */
+                /* Found it. If it's in inlined code, the original code to
+                 * go back to is the callee's. */
+                MVMSpeshInline *inl = find_inline(f->spesh_cand, deopt_offset);
+                if (inl) {
+                    uninline(tc, f, inl, f->spesh_cand->deopts[i]);
+                    return;
+                }
+
+                /* Otherwise, switch back to the original code. */
                 f->effective_bytecode        = f->static_info->body.bytecode;
                 f->effective_handlers        = f->static_info->body.handlers;
                 *(tc->interp_cur_op)         = f->effective_bytecode + f->spesh_cand->deopts[i];
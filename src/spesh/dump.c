@@ -48,7 +48,12 @@ static void dump_bb(MVMThreadContext *tc, DumpStr *ds, MVMSpeshGraph *g, MVMSpes
     MVMint64     i;
 
     /* Heading. */
-    appendf(ds, "  BB %d:\n", bb->idx);
+    if (bb->inlined)
+        appendf(ds, "  BB %d (inline %d):\n", bb->idx, bb->inlined - 1);
+    else if (bb->osr_entry)
+        appendf(ds, "  BB %d (OSR entry from %d):\n", bb->idx, bb->orig_offset);
+    else
+        appendf(ds, "  BB %d:\n", bb->idx);
 
     /* Instructions. */
     append(ds, "    Instructions:\n");
@@ -163,7 +168,7 @@ static void dump_bb(MVMThreadContext *tc, DumpStr *ds, MVMSpeshGraph *g, MVMSpes
 /* Dumps the facts table. */
 static void dump_facts(MVMThreadContext *tc, DumpStr *ds, MVMSpeshGraph *g) {
     MVMuint16 i, j, num_locals, num_facts;
-    num_locals = g->sf->body.num_locals;
+    num_locals = g->num_locals;
     for (i = 0; i < num_locals; i++) {
         num_facts = g->fact_counts[i];
         for (j = 0; j < num_facts; j++) {
@@ -64,9 +64,10 @@ static MVMOpInfo * get_op_info(MVMThreadContext *tc, MVMCompUnit *cu, MVMuint16
     }
 }
 
-/* Records a de-optimization annotation and mapping pair. */
+/* Records a de-optimization annotation and mapping pair. The offset is that
+ * of the place to resume in the original bytecode. */
 static void add_deopt_annotation(MVMThreadContext *tc, MVMSpeshGraph *g, MVMSpeshIns *ins_node,
-                                 MVMuint8 *pc, MVMint32 type) {
+                                 MVMint32 orig_offset, MVMint32 type) {
     /* Add an the annotations. */
     MVMSpeshAnn *ann      = MVM_spesh_alloc(tc, g, sizeof(MVMSpeshAnn));
     ann->type             = type;
@@ -83,15 +84,18 @@ static void add_deopt_annotation(MVMThreadContext *tc, MVMSpeshGraph *g, MVMSpes
         else
             g->deopt_addrs = malloc(g->alloc_deopt_addrs * sizeof(MVMint32) * 2);
     }
-    g->deopt_addrs[2 * g->num_deopt_addrs] = pc - g->sf->body.bytecode;
+    g->deopt_addrs[2 * g->num_deopt_addrs] = orig_offset;
     g->num_deopt_addrs++;
 }
 
 /* Builds the control flow graph, populating the passed spesh graph structure
- * with it. This also makes nodes for all of the instruction. */
+ * with it. This also makes nodes for all of the instruction. If we're building
+ * it from a specialization candidate's bytecode, its de-optimization table is
+ * passed, so the de-opt points can be carried over. */
 #define MVM_CFG_BB_START    1
 #define MVM_CFG_BB_END      2
-static void build_cfg(MVMThreadContext *tc, MVMSpeshGraph *g, MVMStaticFrame *sf) {
+static void build_cfg(MVMThreadContext *tc, MVMSpeshGraph *g, MVMStaticFrame *sf,
+                      MVMint32 *existing_deopts, MVMint32 num_existing_deopts) {
     MVMSpeshBB  *cur_bb, *prev_bb;
     MVMSpeshIns *last_ins;
     MVMint64     i;
@@ -99,7 +103,7 @@ static void build_cfg(MVMThreadContext *tc, MVMSpeshGraph *g, MVMStaticFrame *sf
 
     /* Temporary array of all MVMSpeshIns we create (one per instruction).
      * Overestimate at size. Has the flat view, matching the bytecode. */
-    MVMSpeshIns **ins_flat = calloc(sf->body.bytecode_size / 2, sizeof(MVMSpeshIns *));
+    MVMSpeshIns **ins_flat = calloc(g->bytecode_size / 2, sizeof(MVMSpeshIns *));
 
     /* Temporary array where each byte in the input bytecode gets a 32-bit
      * integer. This is used for two things:
@@ -110,7 +114,7 @@ static void build_cfg(MVMThreadContext *tc, MVMSpeshGraph *g, MVMStaticFrame *sf
      *    a basic block. The second bit is "I can branch" - that is, end of
      *    a basic block. It's possible to have both bits set.
      * Anything that's just a zero has no instruction starting there. */
-    MVMuint32 *byte_to_ins_flags = calloc(sf->body.bytecode_size, sizeof(MVMuint32));
+    MVMuint32 *byte_to_ins_flags = calloc(g->bytecode_size, sizeof(MVMuint32));
 
     /* Instruction to basic block mapping. Initialized later. */
     MVMSpeshBB **ins_to_bb = NULL;
@@ -119,12 +123,12 @@ static void build_cfg(MVMThreadContext *tc, MVMSpeshGraph *g, MVMStaticFrame *sf
      * nodes for each instruction and set the start/end of block bits. Also
      * set handler targets as basic block starters. */
     MVMCompUnit *cu       = sf->body.cu;
-    MVMuint8    *pc       = sf->body.bytecode;
-    MVMuint8    *end      = sf->body.bytecode + sf->body.bytecode_size;
+    MVMuint8    *pc       = g->bytecode;
+    MVMuint8    *end      = g->bytecode + g->bytecode_size;
     MVMuint32    ins_idx  = 0;
     MVMuint8     next_bbs = 1; /* Next iteration (here, first) starts a BB. */
     for (i = 0; i < sf->body.num_handlers; i++)
-        byte_to_ins_flags[sf->body.handlers[i].goto_offset] |= MVM_CFG_BB_START;
+        byte_to_ins_flags[g->handlers[i].goto_offset] |= MVM_CFG_BB_START;
     while (pc < end) {
         /* Look up op info. */
         MVMuint16  opcode   = *(MVMuint16 *)pc;
@@ -135,11 +139,11 @@ static void build_cfg(MVMThreadContext *tc, MVMSpeshGraph *g, MVMStaticFrame *sf
         /* Create an instruction node, add it, and record its position. */
         MVMSpeshIns *ins_node = MVM_spesh_alloc(tc, g, sizeof(MVMSpeshIns));
         ins_flat[ins_idx] = ins_node;
-        byte_to_ins_flags[pc - sf->body.bytecode] |= ins_idx << 2;
+        byte_to_ins_flags[pc - g->bytecode] |= ins_idx << 2;
 
         /* Did previous instruction end a basic block? */
         if (next_bbs) {
-            byte_to_ins_flags[pc - sf->body.bytecode] |= MVM_CFG_BB_START;
+            byte_to_ins_flags[pc - g->bytecode] |= MVM_CFG_BB_START;
             next_bbs = 0;
         }
 
@@ -147,8 +151,8 @@ static void build_cfg(MVMThreadContext *tc, MVMSpeshGraph *g, MVMStaticFrame *sf
          * target, in which case we should ensure our prior is marked as
          * a BB end. */
         else {
-            if (byte_to_ins_flags[pc - sf->body.bytecode] & MVM_CFG_BB_START) {
-                MVMuint32 hunt = pc - sf->body.bytecode;
+            if (byte_to_ins_flags[pc - g->bytecode] & MVM_CFG_BB_START) {
+                MVMuint32 hunt = pc - g->bytecode;
                 while (!byte_to_ins_flags[--hunt]);
                 byte_to_ins_flags[hunt] |= MVM_CFG_BB_END;
             }
@@ -219,12 +223,12 @@ static void build_cfg(MVMThreadContext *tc, MVMSpeshGraph *g, MVMStaticFrame *sf
                     ins_node->operands[i].ins_offset = target;
 
                     /* This is a branching instruction, so it's a BB end. */
-                    byte_to_ins_flags[pc - sf->body.bytecode] |= MVM_CFG_BB_END;
+                    byte_to_ins_flags[pc - g->bytecode] |= MVM_CFG_BB_END;
 
                     /* Its target is a BB start, and any previous instruction
                      * we already passed needs marking as a BB end. */
                     byte_to_ins_flags[target] |= MVM_CFG_BB_START;
-                    if (target > 0 && target < pc - sf->body.bytecode) {
+                    if (target > 0 && target < pc - g->bytecode) {
                         while (!byte_to_ins_flags[--target]);
                         byte_to_ins_flags[target] |= MVM_CFG_BB_END;
                     }
@@ -249,22 +253,41 @@ static void build_cfg(MVMThreadContext *tc, MVMSpeshGraph *g, MVMStaticFrame *sf
         if (opcode == MVM_OP_jumplist) {
             MVMint64 n = MVM_BC_get_I64(args, 0);
             for (i = 0; i <= n; i++)
-                byte_to_ins_flags[(pc - sf->body.bytecode) + 12 + i * 6] |= MVM_CFG_BB_START;
-            byte_to_ins_flags[pc - sf->body.bytecode] |= MVM_CFG_BB_END;
+                byte_to_ins_flags[(pc - g->bytecode) + 12 + i * 6] |= MVM_CFG_BB_START;
+            byte_to_ins_flags[pc - g->bytecode] |= MVM_CFG_BB_END;
         }
 
         /* Final instruction is basic block end. */
         if (pc + 2 + arg_size == end)
-            byte_to_ins_flags[pc - sf->body.bytecode] |= MVM_CFG_BB_END;
+            byte_to_ins_flags[pc - g->bytecode] |= MVM_CFG_BB_END;
 
         /* Caculate next instruction's PC. */
         pc += 2 + arg_size;
 
         /* If this is a deopt point opcode... */
-        if (info->deopt_point & MVM_DEOPT_MARK_ONE)
-            add_deopt_annotation(tc, g, ins_node, pc, MVM_SPESH_ANN_DEOPT_ONE_INS);
-        if (info->deopt_point & MVM_DEOPT_MARK_ALL)
-            add_deopt_annotation(tc, g, ins_node, pc, MVM_SPESH_ANN_DEOPT_ALL_INS);
+        if (existing_deopts) {
+            /* Specialized code; look for where it was a deopt point. An op
+             * that is both kinds of deopt point has two entries. */
+            MVMint32 num_added = 0;
+            for (i = 0; i < num_existing_deopts; i++) {
+                if (existing_deopts[2 * i + 1] == pc - g->bytecode) {
+                    MVMint32 type = info->deopt_point == MVM_DEOPT_MARK_ALL ||
+                        (num_added && (info->deopt_point & MVM_DEOPT_MARK_ALL))
+                            ? MVM_SPESH_ANN_DEOPT_ALL_INS
+                            : MVM_SPESH_ANN_DEOPT_ONE_INS;
+                    add_deopt_annotation(tc, g, ins_node, existing_deopts[2 * i], type);
+                    num_added++;
+                }
+            }
+        }
+        else {
+            if (info->deopt_point & MVM_DEOPT_MARK_ONE)
+                add_deopt_annotation(tc, g, ins_node, pc - g->bytecode,
+                    MVM_SPESH_ANN_DEOPT_ONE_INS);
+            if (info->deopt_point & MVM_DEOPT_MARK_ALL)
+                add_deopt_annotation(tc, g, ins_node, pc - g->bytecode,
+                    MVM_SPESH_ANN_DEOPT_ALL_INS);
+        }
 
         /* Go to next instruction. */
         ins_idx++;
@@ -272,9 +295,9 @@ static void build_cfg(MVMThreadContext *tc, MVMSpeshGraph *g, MVMStaticFrame *sf
 
     /* Annotate instructions that are handler-significant. */
     for (i = 0; i < sf->body.num_handlers; i++) {
-        MVMSpeshIns *start_ins = ins_flat[byte_to_ins_flags[sf->body.handlers[i].start_offset] >> 2];
-        MVMSpeshIns *end_ins   = ins_flat[byte_to_ins_flags[sf->body.handlers[i].end_offset] >> 2];
-        MVMSpeshIns *goto_ins  = ins_flat[byte_to_ins_flags[sf->body.handlers[i].goto_offset] >> 2];
+        MVMSpeshIns *start_ins = ins_flat[byte_to_ins_flags[g->handlers[i].start_offset] >> 2];
+        MVMSpeshIns *end_ins   = ins_flat[byte_to_ins_flags[g->handlers[i].end_offset] >> 2];
+        MVMSpeshIns *goto_ins  = ins_flat[byte_to_ins_flags[g->handlers[i].goto_offset] >> 2];
         MVMSpeshAnn *start_ann = MVM_spesh_alloc(tc, g, sizeof(MVMSpeshAnn));
         MVMSpeshAnn *end_ann   = MVM_spesh_alloc(tc, g, sizeof(MVMSpeshAnn));
         MVMSpeshAnn *goto_ann  = MVM_spesh_alloc(tc, g, sizeof(MVMSpeshAnn));
@@ -305,13 +328,14 @@ static void build_cfg(MVMThreadContext *tc, MVMSpeshGraph *g, MVMStaticFrame *sf
     g->entry->first_ins->info = get_op_info(tc, cu, 0);
     g->entry->last_ins        = g->entry->first_ins;
     g->entry->idx             = 0;
+    g->entry->orig_offset     = -1;
     cur_bb                    = NULL;
     prev_bb                   = g->entry;
     last_ins                  = NULL;
     ins_to_bb                 = calloc(ins_idx, sizeof(MVMSpeshBB *));
     ins_idx                   = 0;
     bb_idx                    = 1;
-    for (i = 0; i < sf->body.bytecode_size; i++) {
+    for (i = 0; i < g->bytecode_size; i++) {
         MVMSpeshIns *cur_ins;
 
         /* Skip zeros; no instruction here. */
@@ -333,6 +357,7 @@ static void build_cfg(MVMThreadContext *tc, MVMSpeshGraph *g, MVMStaticFrame *sf
             cur_bb = MVM_spesh_alloc(tc, g, sizeof(MVMSpeshBB));
             cur_bb->first_ins = cur_ins;
             cur_bb->idx = bb_idx;
+            cur_bb->orig_offset = i;
             bb_idx++;
 
             /* Record instruction -> BB start mapping. */
@@ -378,7 +403,7 @@ static void build_cfg(MVMThreadContext *tc, MVMSpeshGraph *g, MVMStaticFrame *sf
             cur_bb->succ     = MVM_spesh_alloc(tc, g, cur_bb->num_succ * sizeof(MVMSpeshBB *));
             cur_bb->succ[0]  = cur_bb->linear_next;
             for (i = 0; i < sf->body.num_handlers; i++) {
-                MVMuint32 offset = sf->body.handlers[i].goto_offset;
+                MVMuint32 offset = g->handlers[i].goto_offset;
                 cur_bb->succ[i + 1] = ins_to_bb[byte_to_ins_flags[offset] >> 2];
             }
         }
@@ -711,7 +736,7 @@ typedef struct {
 /* Creates an SSAVarInfo for each local, initializing it with a list of nodes
  * that assign to the local. */
 SSAVarInfo * initialize_ssa_var_info(MVMThreadContext *tc, MVMSpeshGraph *g) {
-    SSAVarInfo *var_info = calloc(sizeof(SSAVarInfo), g->sf->body.num_locals);
+    SSAVarInfo *var_info = calloc(sizeof(SSAVarInfo), g->num_locals);
     MVMint32 i;
 
     /* Visit all instructions, looking for local writes. */
@@ -748,7 +773,7 @@ SSAVarInfo * initialize_ssa_var_info(MVMThreadContext *tc, MVMSpeshGraph *g) {
 
     /* Set stack top to -1 sentinel for all nodes, and count = 1 (as we may
      * read the default value of a register). */
-    for (i = 0; i < g->sf->body.num_locals; i++) {
+    for (i = 0; i < g->num_locals; i++) {
         var_info[i].count     = 1;
         var_info[i].stack_top = -1;
     }
@@ -781,7 +806,7 @@ static void insert_phi_functions(MVMThreadContext *tc, MVMSpeshGraph *g, SSAVarI
 
     /* Go over all locals. */
     MVMint32 var, i, j, found;
-    for (var = 0; var < g->sf->body.num_locals; var++) {
+    for (var = 0; var < g->num_locals; var++) {
         /* Move to next iteration. */
         iter_count++;
 
@@ -934,7 +959,7 @@ static void ssa(MVMThreadContext *tc, MVMSpeshGraph *g) {
 
     /* Allocate space for spesh facts for each local; clean up stacks while
      * we're at it. */
-    num_locals     = g->sf->body.num_locals;
+    num_locals     = g->num_locals;
     g->facts       = MVM_spesh_alloc(tc, g, num_locals * sizeof(MVMSpeshFacts *));
     g->fact_counts = MVM_spesh_alloc(tc, g, num_locals * sizeof(MVMuint16));
     for (i = 0; i < num_locals; i++) {
@@ -950,7 +975,12 @@ static void ssa(MVMThreadContext *tc, MVMSpeshGraph *g) {
 MVMSpeshGraph * MVM_spesh_graph_create(MVMThreadContext *tc, MVMStaticFrame *sf) {
     /* Create top-level graph object. */
     MVMSpeshGraph *g = calloc(1, sizeof(MVMSpeshGraph));
-    g->sf = sf;
+    g->sf            = sf;
+    g->bytecode      = sf->body.bytecode;
+    g->bytecode_size = sf->body.bytecode_size;
+    g->handlers      = sf->body.handlers;
+    g->num_locals    = sf->body.num_locals;
+    g->local_types   = sf->body.local_types;
 
     /* Ensure the frame is validated, since we'll rely on this. */
     if (!sf->body.invoked) {
@@ -959,7 +989,42 @@ MVMSpeshGraph * MVM_spesh_graph_create(MVMThreadContext *tc, MVMStaticFrame *sf)
     }
 
     /* Build the CFG out of the static frame, and transform it to SSA. */
-    build_cfg(tc, g, sf);
+    build_cfg(tc, g, sf, NULL, 0);
+    eliminate_dead(tc, g);
+    add_predecessors(tc, g);
+    ssa(tc, g);
+
+    /* Hand back the completed graph. */
+    return g;
+}
+
+/* Takes a static frame and a finished specialization candidate of it, and
+ * creates a spesh graph out of the specialized bytecode. Used when we want
+ * to inline the candidate somewhere. The graph gets its own copy of the
+ * candidate's spesh slots, and its de-opt points map to offsets in the
+ * static frame's original bytecode. */
+MVMSpeshGraph * MVM_spesh_graph_create_from_cand(MVMThreadContext *tc, MVMStaticFrame *sf,
+                                                 MVMSpeshCandidate *cand) {
+    /* Create top-level graph object. */
+    MVMSpeshGraph *g = calloc(1, sizeof(MVMSpeshGraph));
+    g->sf            = sf;
+    g->bytecode      = cand->bytecode;
+    g->bytecode_size = cand->bytecode_size;
+    g->handlers      = cand->handlers;
+    g->num_locals    = cand->num_locals;
+    g->local_types   = cand->local_types;
+
+    /* Take a copy of the spesh slots. */
+    if (cand->num_spesh_slots) {
+        g->num_spesh_slots   = cand->num_spesh_slots;
+        g->alloc_spesh_slots = cand->num_spesh_slots;
+        g->spesh_slots       = malloc(g->alloc_spesh_slots * sizeof(MVMCollectable *));
+        memcpy(g->spesh_slots, cand->spesh_slots,
+            g->num_spesh_slots * sizeof(MVMCollectable *));
+    }
+
+    /* Build the CFG out of the specialized code, and transform it to SSA. */
+    build_cfg(tc, g, sf, cand->deopts, cand->num_deopts);
     eliminate_dead(tc, g);
     add_predecessors(tc, g);
     ssa(tc, g);
@@ -976,7 +1041,7 @@ void MVM_spesh_graph_mark(MVMThreadContext *tc, MVMSpeshGraph *g, MVMGCWorklist
     MVM_gc_worklist_add(tc, worklist, &g->sf);
 
     /* Mark facts. */
-    num_locals = g->sf->body.num_locals;
+    num_locals = g->num_locals;
     for (i = 0; i < num_locals; i++) {
         num_facts = g->fact_counts[i];
         for (j = 0; j < num_facts; j++) {
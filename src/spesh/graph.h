@@ -4,6 +4,17 @@ struct MVMSpeshGraph {
     /* The static frame this is the spesh graph for. */
     MVMStaticFrame *sf;
 
+    /* The bytecode the graph was built from, and its frame handlers; either
+     * the static frame's own, or those of a specialization candidate. */
+    MVMuint8        *bytecode;
+    MVMuint32        bytecode_size;
+    MVMFrameHandler *handlers;
+
+    /* The number of locals, and their types. These start out as the static
+     * frame's, and grow as callees are inlined. */
+    MVMuint16 *local_types;
+    MVMuint32  num_locals;
+
     /* The entry basic block. */
     MVMSpeshBB *entry;
 
@@ -44,6 +55,17 @@ struct MVMSpeshGraph {
     MVMCollectable **log_slots;
     MVMint32 num_log_slots;
 
+    /* Callees inlined into the graph, along with the number of them. */
+    MVMSpeshInline *inlines;
+    MVMint32 num_inlines;
+
+    /* Places a frame running the original bytecode can switch over to the
+     * specialized code at, as pairs of integers; the offset of a loop head
+     * in the original bytecode, and (filled in by code-gen) the offset of
+     * the same place in the specialized bytecode. */
+    MVMint32 *osr_entries;
+    MVMint32  num_osr_entries;
+
     /* Number of basic blocks we have. */
     MVMint32 num_bbs;
 };
@@ -98,6 +120,18 @@ struct MVMSpeshBB {
     /* Index (just an ascending integer along the linear_next chain), used as
      * the block identifier in dominance computation and for debug output. */
     MVMint32 idx;
+
+    /* If the block came from an inlined callee, one more than the index of
+     * that inline; zero otherwise. */
+    MVMint32 inlined;
+
+    /* The offset in the bytecode the graph was built from that the block
+     * starts at, or -1 if it was made during optimization. */
+    MVMint32 orig_offset;
+
+    /* If the block is a place frames can switch over to the specialized code
+     * at, one more than the index of its OSR entry; zero otherwise. */
+    MVMint32 osr_entry;
 };
 
 /* The SSA phi instruction. */
@@ -167,6 +201,8 @@ struct MVMSpeshAnn {
 
 /* Functions to create/destory the spesh graph. */
 MVMSpeshGraph * MVM_spesh_graph_create(MVMThreadContext *tc, MVMStaticFrame *sf);
+MVMSpeshGraph * MVM_spesh_graph_create_from_cand(MVMThreadContext *tc, MVMStaticFrame *sf,
+    MVMSpeshCandidate *cand);
 void MVM_spesh_graph_mark(MVMThreadContext *tc, MVMSpeshGraph *g, MVMGCWorklist *worklist);
 void MVM_spesh_graph_destroy(MVMThreadContext *tc, MVMSpeshGraph *g);
 void * MVM_spesh_alloc(MVMThreadContext *tc, MVMSpeshGraph *g, size_t bytes);
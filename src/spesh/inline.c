@@ -0,0 +1,599 @@
+#include "moar.h"
+
+/* Inlining takes the graph of a specialization of a callee and splices it
+ * into the caller's graph in place of the call to it, so the invocation and
+ * the argument passing go away, and the callee's code runs in the caller's
+ * frame with its locals tacked on to the end of the caller's. We only do it
+ * for small callees that we know for sure will be called, where a candidate
+ * that the arguments certainly pass the guards of is already specialized,
+ * and whose code doesn't look at the frame it runs in. Should we need to
+ * deoptimize while in the inlined code, the callee's frame is created and
+ * the caller set up as if it had made the call (see deopt.c). */
+
+/* Checks if an op does something with the frame it runs in, its caller or
+ * its outer, or makes a call; such code would behave differently if it ran
+ * in the caller's frame, so isn't inlined. */
+static MVMint32 is_frame_sensitive(MVMuint16 opcode) {
+    switch (opcode) {
+    case MVM_OP_prepargs:
+    case MVM_OP_invoke_v:
+    case MVM_OP_invoke_i:
+    case MVM_OP_invoke_n:
+    case MVM_OP_invoke_s:
+    case MVM_OP_invoke_o:
+    case MVM_OP_invokewithcapture:
+    case MVM_OP_checkarity:
+    case MVM_OP_param_rp_i:
+    case MVM_OP_param_rp_n:
+    case MVM_OP_param_rp_s:
+    case MVM_OP_param_rp_o:
+    case MVM_OP_param_op_i:
+    case MVM_OP_param_op_n:
+    case MVM_OP_param_op_s:
+    case MVM_OP_param_op_o:
+    case MVM_OP_param_rn_i:
+    case MVM_OP_param_rn_n:
+    case MVM_OP_param_rn_s:
+    case MVM_OP_param_rn_o:
+    case MVM_OP_param_on_i:
+    case MVM_OP_param_on_n:
+    case MVM_OP_param_on_s:
+    case MVM_OP_param_on_o:
+    case MVM_OP_param_rn2_i:
+    case MVM_OP_param_rn2_n:
+    case MVM_OP_param_rn2_s:
+    case MVM_OP_param_rn2_o:
+    case MVM_OP_param_on2_i:
+    case MVM_OP_param_on2_n:
+    case MVM_OP_param_on2_s:
+    case MVM_OP_param_on2_o:
+    case MVM_OP_param_sp:
+    case MVM_OP_param_sn:
+    case MVM_OP_paramnamesused:
+    case MVM_OP_assertparamcheck:
+    case MVM_OP_usecapture:
+    case MVM_OP_savecapture:
+    case MVM_OP_getlex:
+    case MVM_OP_bindlex:
+    case MVM_OP_getlex_ni:
+    case MVM_OP_getlex_nn:
+    case MVM_OP_getlex_ns:
+    case MVM_OP_getlex_no:
+    case MVM_OP_bindlex_ni:
+    case MVM_OP_bindlex_nn:
+    case MVM_OP_bindlex_ns:
+    case MVM_OP_bindlex_no:
+    case MVM_OP_getlex_ng:
+    case MVM_OP_bindlex_ng:
+    case MVM_OP_getdynlex:
+    case MVM_OP_binddynlex:
+    case MVM_OP_setlexvalue:
+    case MVM_OP_lexprimspec:
+    case MVM_OP_getlexstatic_o:
+    case MVM_OP_getlexperinvtype_o:
+    case MVM_OP_getlexouter:
+    case MVM_OP_getlexrel:
+    case MVM_OP_getlexreldyn:
+    case MVM_OP_getlexrelcaller:
+    case MVM_OP_getlexcaller:
+    case MVM_OP_getcode:
+    case MVM_OP_caller:
+    case MVM_OP_callercode:
+    case MVM_OP_curcode:
+    case MVM_OP_capturelex:
+    case MVM_OP_takeclosure:
+    case MVM_OP_ctx:
+    case MVM_OP_ctxouter:
+    case MVM_OP_ctxcaller:
+    case MVM_OP_ctxlexpad:
+    case MVM_OP_ctxouterskipthunks:
+    case MVM_OP_ctxcallerskipthunks:
+    case MVM_OP_takedispatcher:
+    case MVM_OP_throwlex:
+    case MVM_OP_throwlexotic:
+    case MVM_OP_throwcatlex:
+    case MVM_OP_throwcatlexotic:
+    case MVM_OP_rethrow:
+    case MVM_OP_resume:
+    case MVM_OP_exception:
+    case MVM_OP_takehandlerresult:
+    case MVM_OP_newlexotic:
+    case MVM_OP_lexoticresult:
+    case MVM_OP_exreturnafterunwind:
+    case MVM_OP_backtrace:
+    case MVM_OP_backtracestrings:
+    case MVM_OP_continuationclone:
+    case MVM_OP_continuationreset:
+    case MVM_OP_continuationcontrol:
+    case MVM_OP_continuationinvoke:
+    case MVM_OP_loadbytecode:
+    case MVM_OP_nativecallinvoke:
+    case MVM_OP_sp_log:
+        return 1;
+    default:
+        return 0;
+    }
+}
+
+/* Checks if the facts we have about an argument mean it's sure to pass a
+ * guard of the candidate. */
+static MVMint32 guard_satisfied(MVMSpeshGuard *guard, MVMSpeshCallInfo *call_info) {
+    MVMSpeshFacts *facts;
+    if (guard->slot >= MAX_ARGS_FOR_OPT || call_info->arg_is_const[guard->slot])
+        return 0;
+    facts = call_info->arg_facts[guard->slot];
+    switch (guard->kind) {
+    case MVM_SPESH_GUARD_CONC:
+        return (facts->flags & MVM_SPESH_FACT_KNOWN_TYPE) &&
+            (facts->flags & MVM_SPESH_FACT_CONCRETE) &&
+            STABLE(facts->type) == (MVMSTable *)guard->match;
+    case MVM_SPESH_GUARD_TYPE:
+        return (facts->flags & MVM_SPESH_FACT_KNOWN_TYPE) &&
+            (facts->flags & MVM_SPESH_FACT_TYPEOBJ) &&
+            STABLE(facts->type) == (MVMSTable *)guard->match;
+    case MVM_SPESH_GUARD_DC_CONC:
+        return (facts->flags & MVM_SPESH_FACT_KNOWN_DECONT_TYPE) &&
+            (facts->flags & MVM_SPESH_FACT_DECONT_CONCRETE) &&
+            STABLE(facts->decont_type) == (MVMSTable *)guard->match;
+    case MVM_SPESH_GUARD_DC_TYPE:
+        return (facts->flags & MVM_SPESH_FACT_KNOWN_DECONT_TYPE) &&
+            (facts->flags & MVM_SPESH_FACT_DECONT_TYPEOBJ) &&
+            STABLE(facts->decont_type) == (MVMSTable *)guard->match;
+    default:
+        return 0;
+    }
+}
+
+/* Finds a specialized candidate of the static frame that the call is sure
+ * to end up running, if there is one. */
+static MVMSpeshCandidate * find_candidate(MVMThreadContext *tc, MVMStaticFrame *sf,
+                                          MVMSpeshCallInfo *call_info) {
+    MVMint32 num_spesh = sf->body.num_spesh_candidates;
+    MVMint32 i;
+    MVMuint32 j;
+    for (i = 0; i < num_spesh; i++) {
+        MVMSpeshCandidate *cand = &sf->body.spesh_candidates[i];
+        if (cand->cs != call_info->cs || cand->sg)
+            continue;
+        for (j = 0; j < cand->num_guards; j++)
+            if (!guard_satisfied(&cand->guards[j], call_info))
+                break;
+        if (j == cand->num_guards)
+            return cand;
+    }
+    return NULL;
+}
+
+/* Checks if a return op in the callee is compatible with the invoke op. */
+static MVMint32 return_matches(MVMuint16 invoke_op, MVMuint16 return_op) {
+    switch (invoke_op) {
+    case MVM_OP_invoke_v: return 1;
+    case MVM_OP_invoke_i: return return_op == MVM_OP_return_i;
+    case MVM_OP_invoke_n: return return_op == MVM_OP_return_n;
+    case MVM_OP_invoke_s: return return_op == MVM_OP_return_s;
+    case MVM_OP_invoke_o: return return_op == MVM_OP_return_o;
+    default:              return 0;
+    }
+}
+
+/* Finds the deopt index of the deopt-all annotation on an invoke, or -1. */
+static MVMint32 find_invoke_deopt_idx(MVMSpeshIns *invoke_ins) {
+    MVMSpeshAnn *ann = invoke_ins->annotations;
+    while (ann) {
+        if (ann->type == MVM_SPESH_ANN_DEOPT_ALL_INS)
+            return ann->data.deopt_idx;
+        ann = ann->next;
+    }
+    return -1;
+}
+
+/* Sees if we can inline the target of a call. If so, hands back a graph of
+ * its specialized code, ready for MVM_spesh_inline; otherwise, NULL. */
+MVMSpeshGraph * MVM_spesh_inline_try_get_graph(MVMThreadContext *tc, MVMSpeshGraph *g,
+        MVMSpeshBB *bb, MVMSpeshIns *invoke_ins, MVMCode *target, MVMSpeshCallInfo *call_info) {
+    MVMStaticFrame    *sf = target->body.sf;
+    MVMCallsite       *cs = call_info->cs;
+    MVMSpeshCandidate *cand;
+    MVMSpeshGraph     *ig;
+    MVMSpeshBB        *ibb;
+    MVMint32           num_returns = 0;
+    MVMint32           i;
+
+    /* The arguments must all be simple positionals, each set up by an
+     * instruction in the same block as the invoke, so we can replace them. */
+    if (!call_info->prepargs_ins || call_info->prepargs_bb != bb)
+        return NULL;
+    if (cs->arg_count > MAX_ARGS_FOR_OPT || cs->has_flattening || cs->arg_count != cs->num_pos)
+        return NULL;
+    for (i = 0; i < cs->arg_count; i++)
+        if (!call_info->arg_ins[i])
+            return NULL;
+    if (find_invoke_deopt_idx(invoke_ins) < 0)
+        return NULL;
+
+    /* The callee must not be the caller itself, must be from the same
+     * compilation unit (so strings and callsites mean the same), and must
+     * not have lexicals or handlers, which need a frame of their own. */
+    if (target->body.is_compiler_stub || sf == g->sf || sf->body.cu != g->sf->body.cu)
+        return NULL;
+    if (sf->body.num_lexicals || sf->body.num_handlers || sf->body.has_exit_handler)
+        return NULL;
+
+    /* Need a small, finished specialization we're sure to run, which has
+     * nothing inlined into it itself. */
+    cand = find_candidate(tc, sf, call_info);
+    if (!cand || cand->num_inlines || cand->bytecode_size > MVM_SPESH_MAX_INLINE_SIZE)
+        return NULL;
+
+    /* Build its graph, and check the code is fine to run in the caller. */
+    ig = MVM_spesh_graph_create_from_cand(tc, sf, cand);
+    MVM_spesh_facts_discover(tc, ig);
+    for (ibb = ig->entry; ibb; ibb = ibb->linear_next) {
+        MVMSpeshIns *ins = ibb->first_ins;
+        while (ins) {
+            MVMuint16 opcode = ins->info->opcode;
+            if (opcode == MVM_SSA_PHI) {
+                ins = ins->next;
+                continue;
+            }
+            if (opcode == (MVMuint16)-1 || opcode >= MVM_OP_EXT_BASE || is_frame_sensitive(opcode))
+                goto not_inlinable;
+            for (i = 0; i < ins->info->num_operands; i++) {
+                MVMuint8 rw = ins->info->operands[i] & MVM_operand_rw_mask;
+                if (rw == MVM_operand_read_lex || rw == MVM_operand_write_lex)
+                    goto not_inlinable;
+            }
+            switch (opcode) {
+            case MVM_OP_return_i:
+            case MVM_OP_return_n:
+            case MVM_OP_return_s:
+            case MVM_OP_return_o:
+            case MVM_OP_return:
+                /* Each return sets the call's result, so if it has one,
+                 * only a single return will keep it in SSA form. */
+                if (!return_matches(invoke_ins->info->opcode, opcode))
+                    goto not_inlinable;
+                if (++num_returns > 1 && invoke_ins->info->opcode != MVM_OP_invoke_v)
+                    goto not_inlinable;
+                break;
+            case MVM_OP_sp_getarg_i:
+            case MVM_OP_sp_getarg_n:
+            case MVM_OP_sp_getarg_s:
+            case MVM_OP_sp_getarg_o:
+                if (ins->operands[1].lit_i16 >= cs->arg_count)
+                    goto not_inlinable;
+                break;
+            }
+            ins = ins->next;
+        }
+    }
+    return ig;
+
+  not_inlinable:
+    if (ig->spesh_slots)
+        free(ig->spesh_slots);
+    if (ig->deopt_addrs)
+        free(ig->deopt_addrs);
+    MVM_spesh_graph_destroy(tc, ig);
+    return NULL;
+}
+
+/* Moves the spesh slot operands of an instruction along by an offset, as
+ * the inlinee's spesh slots now come after the caller's. */
+static void fix_spesh_slots(MVMSpeshIns *ins, MVMint16 offset) {
+    switch (ins->info->opcode) {
+    case MVM_OP_sp_guardcontconc:
+    case MVM_OP_sp_guardconttype:
+        ins->operands[2].lit_i16 += offset;
+        ins->operands[1].lit_i16 += offset;
+        break;
+    case MVM_OP_sp_guardconc:
+    case MVM_OP_sp_guardtype:
+    case MVM_OP_sp_getspeshslot:
+        ins->operands[1].lit_i16 += offset;
+        break;
+    case MVM_OP_sp_fastcreate:
+        ins->operands[2].lit_i16 += offset;
+        break;
+    case MVM_OP_sp_findmeth:
+    case MVM_OP_sp_p6ogetvt_o:
+    case MVM_OP_sp_p6ogetvc_o:
+        ins->operands[3].lit_i16 += offset;
+        break;
+    }
+}
+
+/* Turns an instruction fetching an argument into one taking it from what
+ * the caller passed. */
+static void rewrite_getarg(MVMThreadContext *tc, MVMSpeshGraph *g, MVMSpeshIns *ins,
+                           MVMSpeshIns *arg_ins) {
+    switch (arg_ins->info->opcode) {
+    case MVM_OP_arg_i:
+    case MVM_OP_arg_n:
+    case MVM_OP_arg_s:
+    case MVM_OP_arg_o:
+        ins->info        = MVM_op_get_op(MVM_OP_set);
+        ins->operands[1] = arg_ins->operands[1];
+        MVM_spesh_get_facts(tc, g, ins->operands[1])->usages++;
+        break;
+    case MVM_OP_argconst_i:
+        ins->info                = MVM_op_get_op(MVM_OP_const_i64);
+        ins->operands[1].lit_i64 = arg_ins->operands[1].lit_i64;
+        break;
+    case MVM_OP_argconst_n:
+        ins->info                = MVM_op_get_op(MVM_OP_const_n64);
+        ins->operands[1].lit_n64 = arg_ins->operands[1].lit_n64;
+        break;
+    case MVM_OP_argconst_s:
+        ins->info                    = MVM_op_get_op(MVM_OP_const_s);
+        ins->operands[1].lit_str_idx = arg_ins->operands[1].lit_str_idx;
+        break;
+    }
+}
+
+/* Turns a return into setting the result register, if there is one, and
+ * going to the block after the call; anything after it in the block is
+ * dropped. */
+static void rewrite_return(MVMThreadContext *tc, MVMSpeshGraph *g, MVMSpeshBB *bb,
+                           MVMSpeshIns *ins, MVMSpeshIns *invoke_ins, MVMSpeshBB *post_bb) {
+    /* The block after the call follows the last block of the inlinee, so
+     * only the others need a goto. */
+    MVMint32 need_goto = bb->linear_next != NULL;
+    ins->next    = NULL;
+    bb->last_ins = ins;
+
+    /* It no longer falls through to the block after it. */
+    while (bb->num_succ)
+        MVM_spesh_manipulate_remove_successor(tc, bb, bb->succ[0]);
+
+    if (invoke_ins->info->opcode == MVM_OP_invoke_v) {
+        /* No result; the return just becomes the goto, if any. */
+        if (ins->info->opcode != MVM_OP_return)
+            MVM_spesh_get_facts(tc, g, ins->operands[0])->usages--;
+        if (need_goto) {
+            ins->info     = MVM_op_get_op(MVM_OP_goto);
+            ins->operands = MVM_spesh_alloc(tc, g, sizeof(MVMSpeshOperand));
+            ins->operands[0].ins_bb = post_bb;
+        }
+        else {
+            MVM_spesh_manipulate_delete_ins(tc, bb, ins);
+        }
+    }
+    else {
+        MVMSpeshOperand *operands = MVM_spesh_alloc(tc, g, 2 * sizeof(MVMSpeshOperand));
+        operands[0]   = invoke_ins->operands[0];
+        operands[1]   = ins->operands[0];
+        ins->info     = MVM_op_get_op(MVM_OP_set);
+        ins->operands = operands;
+        if (need_goto) {
+            MVMSpeshIns *goto_ins = MVM_spesh_alloc(tc, g, sizeof(MVMSpeshIns));
+            goto_ins->info        = MVM_op_get_op(MVM_OP_goto);
+            goto_ins->operands    = MVM_spesh_alloc(tc, g, sizeof(MVMSpeshOperand));
+            goto_ins->operands[0].ins_bb = post_bb;
+            MVM_spesh_manipulate_insert_ins(tc, bb, ins, goto_ins);
+        }
+    }
+
+    bb->succ     = MVM_spesh_alloc(tc, g, sizeof(MVMSpeshBB *));
+    bb->succ[0]  = post_bb;
+    bb->num_succ = 1;
+}
+
+/* Splices the graph of a callee, obtained from MVM_spesh_inline_try_get_graph,
+ * into the caller in place of the invoke. The inlinee graph is used up. */
+void MVM_spesh_inline(MVMThreadContext *tc, MVMSpeshGraph *g, MVMSpeshCallInfo *call_info,
+                      MVMSpeshBB *invoke_bb, MVMSpeshIns *invoke_ins, MVMSpeshGraph *inlinee,
+                      MVMCode *target) {
+    MVMuint16         locals_start = g->num_locals;
+    MVMint16          slots_start  = g->num_spesh_slots;
+    MVMint32          deopts_start = g->num_deopt_addrs;
+    MVMint32          inline_idx   = g->num_inlines;
+    MVMint32          deopt_idx    = find_invoke_deopt_idx(invoke_ins);
+    MVMuint16         invoke_op    = invoke_ins->info->opcode;
+    MVMSpeshBB       *first_bb     = inlinee->entry->linear_next;
+    MVMSpeshBB       *last_bb      = NULL;
+    MVMSpeshBB       *post_bb;
+    MVMSpeshBB       *bb;
+    MVMSpeshInline   *inl;
+    MVMSpeshMemBlock *block;
+    MVMuint16        *local_types;
+    MVMSpeshFacts   **facts;
+    MVMuint16        *fact_counts;
+    MVMint32          num_returns = 0;
+    MVMint32          i;
+
+    /* The inlinee's nodes now live as long as the caller's graph does. */
+    block = inlinee->mem_block;
+    while (block->prev)
+        block = block->prev;
+    block->prev = g->mem_block->prev;
+    g->mem_block->prev = inlinee->mem_block;
+    inlinee->mem_block = NULL;
+
+    /* The inlinee's locals go after the caller's, along with their facts. */
+    local_types = MVM_spesh_alloc(tc, g, (g->num_locals + inlinee->num_locals) * sizeof(MVMuint16));
+    memcpy(local_types, g->local_types, g->num_locals * sizeof(MVMuint16));
+    memcpy(local_types + g->num_locals, inlinee->local_types, inlinee->num_locals * sizeof(MVMuint16));
+    facts = MVM_spesh_alloc(tc, g, (g->num_locals + inlinee->num_locals) * sizeof(MVMSpeshFacts *));
+    memcpy(facts, g->facts, g->num_locals * sizeof(MVMSpeshFacts *));
+    memcpy(facts + g->num_locals, inlinee->facts, inlinee->num_locals * sizeof(MVMSpeshFacts *));
+    fact_counts = MVM_spesh_alloc(tc, g, (g->num_locals + inlinee->num_locals) * sizeof(MVMuint16));
+    memcpy(fact_counts, g->fact_counts, g->num_locals * sizeof(MVMuint16));
+    memcpy(fact_counts + g->num_locals, inlinee->fact_counts, inlinee->num_locals * sizeof(MVMuint16));
+    g->local_types  = local_types;
+    g->facts        = facts;
+    g->fact_counts  = fact_counts;
+    g->num_locals  += inlinee->num_locals;
+
+    /* So do its spesh slots and deopt entries. */
+    for (i = 0; i < inlinee->num_spesh_slots; i++)
+        MVM_spesh_add_spesh_slot(tc, g, inlinee->spesh_slots[i]);
+    if (inlinee->num_deopt_addrs) {
+        if (g->num_deopt_addrs + inlinee->num_deopt_addrs > g->alloc_deopt_addrs) {
+            g->alloc_deopt_addrs = g->num_deopt_addrs + inlinee->num_deopt_addrs;
+            if (g->deopt_addrs)
+                g->deopt_addrs = realloc(g->deopt_addrs, g->alloc_deopt_addrs * sizeof(MVMint32) * 2);
+            else
+                g->deopt_addrs = malloc(g->alloc_deopt_addrs * sizeof(MVMint32) * 2);
+        }
+        memcpy(g->deopt_addrs + 2 * g->num_deopt_addrs, inlinee->deopt_addrs,
+            inlinee->num_deopt_addrs * sizeof(MVMint32) * 2);
+        g->num_deopt_addrs += inlinee->num_deopt_addrs;
+    }
+
+    /* Split the block with the invoke in it; what follows the invoke goes
+     * into a new block, which takes over its successors and its children in
+     * the dominator tree. The block with the invoke dominates both that and
+     * the inlinee's code, so they become its children. */
+    post_bb = MVM_spesh_alloc(tc, g, sizeof(MVMSpeshBB));
+    post_bb->first_ins    = invoke_ins->next;
+    post_bb->last_ins     = invoke_ins->next ? invoke_bb->last_ins : NULL;
+    post_bb->succ         = invoke_bb->succ;
+    post_bb->num_succ     = invoke_bb->num_succ;
+    post_bb->children     = invoke_bb->children;
+    post_bb->num_children = invoke_bb->num_children;
+    post_bb->linear_next  = invoke_bb->linear_next;
+    post_bb->orig_offset  = -1;
+    if (invoke_ins->next)
+        invoke_ins->next->prev = NULL;
+    invoke_ins->next     = NULL;
+    invoke_bb->last_ins  = invoke_ins;
+    for (i = 0; i < post_bb->num_succ; i++) {
+        MVMSpeshBB *succ = post_bb->succ[i];
+        MVMint32    j;
+        for (j = 0; j < succ->num_pred; j++)
+            if (succ->pred[j] == invoke_bb)
+                succ->pred[j] = post_bb;
+    }
+    invoke_bb->succ            = MVM_spesh_alloc(tc, g, sizeof(MVMSpeshBB *));
+    invoke_bb->succ[0]         = first_bb;
+    invoke_bb->num_succ        = 1;
+    invoke_bb->children        = MVM_spesh_alloc(tc, g, 2 * sizeof(MVMSpeshBB *));
+    invoke_bb->children[0]     = first_bb;
+    invoke_bb->children[1]     = post_bb;
+    invoke_bb->num_children    = 2;
+    invoke_bb->linear_next     = first_bb;
+    for (i = 0; i < first_bb->num_pred; i++)
+        if (first_bb->pred[i] == inlinee->entry)
+            first_bb->pred[i] = invoke_bb;
+
+    /* Go through the inlinee's code, moving its registers, spesh slots and
+     * deopt entries along, taking arguments from the caller and turning
+     * returns into going to the block after the call. */
+    for (bb = first_bb; bb; bb = bb->linear_next) {
+        MVMSpeshIns *ins = bb->first_ins;
+        bb->inlined = inline_idx + 1;
+        while (ins) {
+            MVMSpeshIns *next = ins->next;
+            MVMSpeshAnn *ann  = ins->annotations;
+            MVMuint16    opcode = ins->info->opcode;
+            if (opcode == MVM_SSA_PHI) {
+                for (i = 0; i < ins->info->num_operands; i++)
+                    ins->operands[i].reg.orig += locals_start;
+            }
+            else {
+                for (i = 0; i < ins->info->num_operands; i++) {
+                    MVMuint8 rw = ins->info->operands[i] & MVM_operand_rw_mask;
+                    if (rw == MVM_operand_read_reg || rw == MVM_operand_write_reg)
+                        ins->operands[i].reg.orig += locals_start;
+                }
+                fix_spesh_slots(ins, slots_start);
+            }
+            while (ann) {
+                if (ann->type == MVM_SPESH_ANN_DEOPT_ONE_INS || ann->type == MVM_SPESH_ANN_DEOPT_ALL_INS)
+                    ann->data.deopt_idx += deopts_start;
+                ann = ann->next;
+            }
+            switch (opcode) {
+            case MVM_OP_sp_getarg_i:
+            case MVM_OP_sp_getarg_n:
+            case MVM_OP_sp_getarg_s:
+            case MVM_OP_sp_getarg_o:
+                rewrite_getarg(tc, g, ins, call_info->arg_ins[ins->operands[1].lit_i16]);
+                break;
+            case MVM_OP_return_i:
+            case MVM_OP_return_n:
+            case MVM_OP_return_s:
+            case MVM_OP_return_o:
+            case MVM_OP_return:
+                rewrite_return(tc, g, bb, ins, invoke_ins, post_bb);
+                num_returns++;
+                next = NULL;
+                break;
+            }
+            ins = next;
+        }
+        last_bb = bb;
+    }
+    last_bb->linear_next = post_bb;
+
+    /* The block after the call is reached from the returns. */
+    post_bb->pred     = MVM_spesh_alloc(tc, g, num_returns * sizeof(MVMSpeshBB *));
+    post_bb->num_pred = 0;
+    for (bb = first_bb; bb != post_bb; bb = bb->linear_next)
+        if (bb->num_succ == 1 && bb->succ[0] == post_bb)
+            post_bb->pred[post_bb->num_pred++] = bb;
+
+    /* Now get rid of the argument passing and the invoke. */
+    for (i = 0; i < call_info->cs->arg_count; i++) {
+        MVMSpeshIns *arg_ins = call_info->arg_ins[i];
+        switch (arg_ins->info->opcode) {
+        case MVM_OP_arg_i:
+        case MVM_OP_arg_n:
+        case MVM_OP_arg_s:
+        case MVM_OP_arg_o:
+            MVM_spesh_get_facts(tc, g, arg_ins->operands[1])->usages--;
+            break;
+        }
+        MVM_spesh_manipulate_delete_ins(tc, invoke_bb, arg_ins);
+    }
+    MVM_spesh_manipulate_delete_ins(tc, invoke_bb, call_info->prepargs_ins);
+    MVM_spesh_get_facts(tc, g,
+        invoke_ins->operands[invoke_op == MVM_OP_invoke_v ? 0 : 1])->usages--;
+    invoke_ins->annotations = NULL;
+    MVM_spesh_manipulate_delete_ins(tc, invoke_bb, invoke_ins);
+    invoke_ins->next = NULL;
+
+    /* Record the inline, so we can deoptimize out of it. */
+    if (g->inlines)
+        g->inlines = realloc(g->inlines, (g->num_inlines + 1) * sizeof(MVMSpeshInline));
+    else
+        g->inlines = malloc(sizeof(MVMSpeshInline));
+    inl = &g->inlines[g->num_inlines++];
+    inl->start         = -1;
+    inl->end           = -1;
+    inl->code_ref_idx  = MVM_spesh_add_spesh_slot(tc, g, (MVMCollectable *)target);
+    inl->locals_start  = locals_start;
+    inl->cs            = call_info->cs;
+    inl->return_offset = g->deopt_addrs[2 * deopt_idx];
+    inl->res_reg       = invoke_op == MVM_OP_invoke_v ? 0 : invoke_ins->operands[0].reg.orig;
+    switch (invoke_op) {
+    case MVM_OP_invoke_i:
+        inl->res_type = MVM_RETURN_INT;
+        break;
+    case MVM_OP_invoke_n:
+        inl->res_type = MVM_RETURN_NUM;
+        break;
+    case MVM_OP_invoke_s:
+        inl->res_type = MVM_RETURN_STR;
+        break;
+    case MVM_OP_invoke_o:
+        inl->res_type = MVM_RETURN_OBJ;
+        break;
+    default:
+        inl->res_type = MVM_RETURN_VOID;
+        break;
+    }
+
+    /* Keep the block indexes ascending along the linear_next chain. */
+    g->num_bbs = 0;
+    for (bb = g->entry; bb; bb = bb->linear_next)
+        bb->idx = g->num_bbs++;
+
+    /* The rest of the inlinee graph is no longer needed. */
+    if (inlinee->spesh_slots)
+        free(inlinee->spesh_slots);
+    if (inlinee->deopt_addrs)
+        free(inlinee->deopt_addrs);
+    free(inlinee);
+}
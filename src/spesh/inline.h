@@ -0,0 +1,33 @@
+/* A callee inlined into a specialization. */
+struct MVMSpeshInline {
+    /* The range of the specialized bytecode the inlined code occupies; an
+     * offset just after an instruction in it satisfies start < offset <= end.
+     * Filled out by code-gen. */
+    MVMint32 start;
+    MVMint32 end;
+
+    /* The spesh slot holding the inlined code object. */
+    MVMuint16 code_ref_idx;
+
+    /* The first of the caller's locals that hold the callee's locals. */
+    MVMuint16 locals_start;
+
+    /* The callsite the callee was invoked with. */
+    MVMCallsite *cs;
+
+    /* Where the caller carries on in its original bytecode once the call is
+     * done, the register the result goes in, and what kind of result it is;
+     * used to set up the caller as if it had made the call if we deopt. */
+    MVMint32      return_offset;
+    MVMuint16     res_reg;
+    MVMReturnType res_type;
+};
+
+/* The most specialized bytecode a callee can have for us to inline it. */
+#define MVM_SPESH_MAX_INLINE_SIZE 384
+
+/* Functions. */
+MVMSpeshGraph * MVM_spesh_inline_try_get_graph(MVMThreadContext *tc, MVMSpeshGraph *g,
+    MVMSpeshBB *bb, MVMSpeshIns *invoke_ins, MVMCode *target, MVMSpeshCallInfo *call_info);
+void MVM_spesh_inline(MVMThreadContext *tc, MVMSpeshGraph *g, MVMSpeshCallInfo *call_info,
+    MVMSpeshBB *invoke_bb, MVMSpeshIns *invoke_ins, MVMSpeshGraph *inlinee, MVMCode *target);
@@ -49,7 +49,7 @@ void MVM_spesh_log_add_logging(MVMThreadContext *tc, MVMSpeshGraph *g) {
         while (ins) {
             switch (ins->info->opcode) {
             case MVM_OP_getlex:
-                if (g->sf->body.local_types[ins->operands[0].reg.orig] == MVM_reg_obj)
+                if (g->local_types[ins->operands[0].reg.orig] == MVM_reg_obj)
                     insert_log(tc, g, bb, ins);
                 break;
             case MVM_OP_getlex_no:
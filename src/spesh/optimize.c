@@ -432,6 +432,16 @@ static void optimize_call(MVMThreadContext *tc, MVMSpeshGraph *g, MVMSpeshBB *bb
             /* XXX TODO: Do this differently so we can eliminate the original
              * lookup of the enclosing code object also. */
         }
+
+        /* If it's small enough and we're sure what specialization it'll
+         * run, inline it, so the invocation goes away too. */
+        if (target && !((MVMCode *)target)->body.is_compiler_stub
+                && tc->instance->spesh_inline_enabled) {
+            MVMSpeshGraph *inline_graph = MVM_spesh_inline_try_get_graph(tc, g, bb, ins,
+                (MVMCode *)target, arg_info);
+            if (inline_graph)
+                MVM_spesh_inline(tc, g, arg_info, bb, ins, inline_graph, (MVMCode *)target);
+        }
     }
 }
 
@@ -439,6 +449,7 @@ static void optimize_call(MVMThreadContext *tc, MVMSpeshGraph *g, MVMSpeshBB *bb
 static void optimize_bb(MVMThreadContext *tc, MVMSpeshGraph *g, MVMSpeshBB *bb) {
     MVMSpeshCallInfo arg_info;
     MVMint32 i;
+    memset(&arg_info, 0, sizeof(MVMSpeshCallInfo));
 
     /* Look for instructions that are interesting to optimize. */
     MVMSpeshIns *ins = bb->first_ins;
@@ -456,7 +467,10 @@ static void optimize_bb(MVMThreadContext *tc, MVMSpeshGraph *g, MVMSpeshBB *bb)
             optimize_iffy(tc, g, ins, bb);
             break;
         case MVM_OP_prepargs:
-            arg_info.cs = g->sf->body.cu->body.callsites[ins->operands[0].callsite_idx];
+            arg_info.cs           = g->sf->body.cu->body.callsites[ins->operands[0].callsite_idx];
+            arg_info.prepargs_bb  = bb;
+            arg_info.prepargs_ins = ins;
+            memset(arg_info.arg_ins, 0, sizeof(arg_info.arg_ins));
             break;
         case MVM_OP_arg_i:
         case MVM_OP_arg_n:
@@ -466,6 +480,7 @@ static void optimize_bb(MVMThreadContext *tc, MVMSpeshGraph *g, MVMSpeshBB *bb)
             if (idx < MAX_ARGS_FOR_OPT) {
                 arg_info.arg_is_const[idx] = 0;
                 arg_info.arg_facts[idx]    = MVM_spesh_get_facts(tc, g, ins->operands[1]);
+                arg_info.arg_ins[idx]      = ins;
             }
             break;
         }
@@ -473,8 +488,10 @@ static void optimize_bb(MVMThreadContext *tc, MVMSpeshGraph *g, MVMSpeshBB *bb)
         case MVM_OP_argconst_n:
         case MVM_OP_argconst_s: {
             MVMint16 idx = ins->operands[0].lit_i16;
-            if (idx < MAX_ARGS_FOR_OPT)
+            if (idx < MAX_ARGS_FOR_OPT) {
                 arg_info.arg_is_const[idx] = 1;
+                arg_info.arg_ins[idx]      = ins;
+            }
             break;
         }
         case MVM_OP_invoke_v:
@@ -7,6 +7,12 @@ struct MVMSpeshCallInfo {
     MVMCallsite   *cs;
     MVMint8        arg_is_const[MAX_ARGS_FOR_OPT];
     MVMSpeshFacts *arg_facts[MAX_ARGS_FOR_OPT];
+
+    /* The instructions that set up the call, and the block they're in; we
+     * need these if we are to inline the callee. */
+    MVMSpeshBB    *prepargs_bb;
+    MVMSpeshIns   *prepargs_ins;
+    MVMSpeshIns   *arg_ins[MAX_ARGS_FOR_OPT];
 };
 
 void MVM_spesh_optimize(MVMThreadContext *tc, MVMSpeshGraph *g);
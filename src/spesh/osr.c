@@ -0,0 +1,200 @@
+#include "moar.h"
+
+/* On-stack replacement. A frame that is invoked once and then loops for a
+ * long time, such as a mainline, never picks up a specialization of itself
+ * at invocation time, so frames running the original bytecode also look at
+ * switching over to specialized code at the heads of hot loops. This is the
+ * reverse of de-optimization: the registers stay as they are, and the frame
+ * carries on at the matching place in the specialized bytecode.
+ *
+ * That's only sound at a place where what the specialized code knows about
+ * the registers is sure to hold for the values the original code put in
+ * them. Facts from the argument guards are checked before switching over;
+ * others come from guards in the code itself, so only a loop head that
+ * dominates every guard will do, since then the code after it can't be
+ * relying on a guard that the frame skipped. */
+
+/* Checks if a block is still in the graph; the optimizer drops unreachable
+ * blocks from the linear order, but they may linger in the predecessors and
+ * dominator tree children of others. */
+static MVMint32 is_live(MVMSpeshGraph *g, MVMSpeshBB **bbs, MVMSpeshBB *bb) {
+    return bb->idx < g->num_bbs && bbs[bb->idx] == bb;
+}
+
+/* Marks the blocks in the dominator tree under (and including) the given
+ * one. */
+static void mark_dominated(MVMSpeshGraph *g, MVMSpeshBB **bbs, MVMSpeshBB *head,
+                           MVMuint8 *dominated, MVMSpeshBB **stack) {
+    MVMint32 num_stack = 0;
+    memset(dominated, 0, g->num_bbs);
+    stack[num_stack++] = head;
+    while (num_stack) {
+        MVMSpeshBB *bb = stack[--num_stack];
+        MVMint32    i;
+        dominated[bb->idx] = 1;
+        for (i = 0; i < bb->num_children; i++)
+            if (is_live(g, bbs, bb->children[i]))
+                stack[num_stack++] = bb->children[i];
+    }
+}
+
+/* Checks if a block is the head of a loop, meaning it is branched to from
+ * itself or a later block. */
+static MVMint32 is_loop_head(MVMSpeshGraph *g, MVMSpeshBB **bbs, MVMSpeshBB *bb) {
+    MVMint32 i;
+    for (i = 0; i < bb->num_pred; i++)
+        if (is_live(g, bbs, bb->pred[i]) && bb->pred[i]->idx >= bb->idx)
+            return 1;
+    return 0;
+}
+
+/* Called on the optimized graph of a candidate, just before code-gen. Finds
+ * the loop heads frames running the original code can switch over at, and
+ * sets up OSR entries for them. */
+void MVM_spesh_osr_find_entries(MVMThreadContext *tc, MVMSpeshGraph *g) {
+    MVMSpeshBB **bbs, **guard_bbs, **stack, *bb;
+    MVMuint8    *dominated;
+    MVMint32     num_guard_bbs, alloc_entries, i;
+
+    /* Frames with handlers are never switched over. */
+    if (g->sf->body.num_handlers)
+        return;
+
+    /* Index the blocks that are left. */
+    bbs = calloc(g->num_bbs, sizeof(MVMSpeshBB *));
+    for (bb = g->entry; bb; bb = bb->linear_next)
+        bbs[bb->idx] = bb;
+
+    /* Find the blocks with guards in. */
+    guard_bbs     = malloc(g->num_bbs * sizeof(MVMSpeshBB *));
+    num_guard_bbs = 0;
+    for (bb = g->entry; bb; bb = bb->linear_next) {
+        MVMSpeshIns *ins;
+        for (ins = bb->first_ins; ins; ins = ins->next) {
+            MVMuint16 opcode = ins->info->opcode;
+            if (opcode == MVM_OP_sp_guardconc || opcode == MVM_OP_sp_guardtype ||
+                    opcode == MVM_OP_sp_guardcontconc || opcode == MVM_OP_sp_guardconttype) {
+                guard_bbs[num_guard_bbs++] = bb;
+                break;
+            }
+        }
+    }
+
+    /* Go through the loop heads, keeping those that dominate all the guards. */
+    dominated     = malloc(g->num_bbs);
+    stack         = malloc(g->num_bbs * sizeof(MVMSpeshBB *));
+    alloc_entries = 0;
+    for (bb = g->entry->linear_next; bb; bb = bb->linear_next) {
+        if (bb->inlined || bb->orig_offset < 0 || !is_loop_head(g, bbs, bb))
+            continue;
+        mark_dominated(g, bbs, bb, dominated, stack);
+        for (i = 0; i < num_guard_bbs; i++)
+            if (!dominated[guard_bbs[i]->idx])
+                break;
+        if (i < num_guard_bbs)
+            continue;
+        if (g->num_osr_entries == alloc_entries) {
+            alloc_entries += 4;
+            g->osr_entries = realloc(g->osr_entries, alloc_entries * sizeof(MVMint32) * 2);
+        }
+        g->osr_entries[2 * g->num_osr_entries]     = bb->orig_offset;
+        g->osr_entries[2 * g->num_osr_entries + 1] = -1;
+        bb->osr_entry = ++g->num_osr_entries;
+    }
+
+    free(stack);
+    free(dominated);
+    free(guard_bbs);
+    free(bbs);
+}
+
+/* Takes the rest of a candidate's logging runs, as though they had been and
+ * gone, so it gets specialized with what has been logged so far. A frame
+ * looping in the original code has no way to do the logging itself, and
+ * might never be invoked again to have it done. */
+static void finish_logging(MVMThreadContext *tc, MVMStaticFrame *sf, MVMSpeshCandidate *cand) {
+    AO_t cur_idx;
+    do {
+        cur_idx = MVM_load(&(cand->log_enter_idx));
+        if (cur_idx >= MVM_SPESH_LOG_RUNS)
+            return;
+    } while (MVM_cas(&(cand->log_enter_idx), cur_idx, MVM_SPESH_LOG_RUNS) != cur_idx);
+    while (cur_idx++ < MVM_SPESH_LOG_RUNS)
+        if (MVM_decr(&(cand->log_exits_remaining)) == 1)
+            MVM_spesh_worker_specialize(tc, sf, cand);
+}
+
+/* Switches the current frame over to a candidate's specialized bytecode, at
+ * the given offset in it. If the candidate has more locals, because of
+ * inlining, the work area is grown to fit them. */
+static MVMuint8 * enter(MVMThreadContext *tc, MVMFrame *f, MVMSpeshCandidate *cand,
+                        MVMint32 offset) {
+    MVMuint32 num_locals = f->static_info->body.num_locals;
+    if (f->allocd_work < cand->work_size) {
+        MVMRegister *work = calloc(1, cand->work_size);
+        if (f->work) {
+            memcpy(work, f->work, num_locals * sizeof(MVMRegister));
+            free(f->work);
+        }
+        f->work        = work;
+        f->allocd_work = cand->work_size;
+    }
+    else if (cand->num_locals > num_locals) {
+        memset(f->work + num_locals, 0,
+            (cand->num_locals - num_locals) * sizeof(MVMRegister));
+    }
+
+    /* No call is being made at a loop head, so the args buffer can move. */
+    f->args                  = f->work + cand->num_locals;
+    f->cur_args_callsite     = NULL;
+    f->effective_bytecode    = cand->bytecode;
+    f->effective_handlers    = cand->handlers;
+    f->effective_spesh_slots = cand->spesh_slots;
+    f->spesh_cand            = cand;
+    f->spesh_log_idx         = -1;
+
+    *(tc->interp_reg_base)       = f->work;
+    *(tc->interp_bytecode_start) = f->effective_bytecode;
+    return f->effective_bytecode + offset;
+}
+
+/* Called by the interpreter on a backward branch now and then, when the
+ * current frame is running its original bytecode. Looks for a candidate
+ * matching the frame's arguments, and if it has an OSR entry for the place
+ * being branched to, switches the frame over to it and returns where to go
+ * in the specialized bytecode. Otherwise, gets a candidate on its way if
+ * there isn't one, and returns the target unchanged. */
+MVMuint8 * MVM_spesh_osr(MVMThreadContext *tc, MVMuint8 *target) {
+    MVMFrame          *f  = tc->cur_frame;
+    MVMStaticFrame    *sf = f->static_info;
+    MVMCallsite       *cs = f->params.callsite;
+    MVMSpeshCandidate *cand;
+    MVMint32           offset;
+    MVMuint32          i;
+
+    /* Only hot frames with interned callsites are specialized, and frames
+     * with handlers are never switched over. */
+    if (sf->body.invocations + sf->body.back_edges < tc->instance->spesh_threshold ||
+            !cs || !cs->is_interned || sf->body.num_handlers)
+        return target;
+
+    /* Find the candidate. If there's none, set one up. If it's still logging,
+     * get it specialized. Either way, it'll be ready on a later go. */
+    cand = MVM_spesh_candidate_find(tc, sf, cs, f->params.args);
+    if (!cand) {
+        if (sf->body.num_spesh_candidates < MVM_SPESH_LIMIT && tc->instance->spesh_enabled)
+            MVM_spesh_worker_setup(tc, sf, cs, f->params.args);
+        return target;
+    }
+    if (cand->sg) {
+        finish_logging(tc, sf, cand);
+        return target;
+    }
+
+    /* Switch over if we can enter here. */
+    offset = target - sf->body.bytecode;
+    for (i = 0; i < cand->num_osr_entries; i++)
+        if (cand->osr_entries[2 * i] == offset)
+            return enter(tc, f, cand, cand->osr_entries[2 * i + 1]);
+    return target;
+}
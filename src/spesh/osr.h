@@ -0,0 +1,8 @@
+/* Frames running their original bytecode look at switching over to the
+ * specialized code when the count of backward branches taken in their
+ * static frame's code, masked with this, is zero; so every 64 iterations. */
+#define MVM_SPESH_OSR_MASK 63
+
+/* Functions. */
+void MVM_spesh_osr_find_entries(MVMThreadContext *tc, MVMSpeshGraph *g);
+MVMuint8 * MVM_spesh_osr(MVMThreadContext *tc, MVMuint8 *target);
@@ -0,0 +1,211 @@
+#include "moar.h"
+#include <platform/threads.h>
+
+/* Setting up specialization candidates and doing the specialization itself
+ * both take a while, so rather than doing them on whatever thread happens
+ * to need them, they're queued up for a worker thread. Meanwhile, frames go
+ * on running the unspecialized (or, once set up, the logging) code until a
+ * candidate is installed. The worker is started in the usual way, but like
+ * the event loop thread never ends up running any bytecode.
+ *
+ * A work item stays at the head of the queue until it's done, so whatever it
+ * references is kept up to date by any GC run that happens while it waits.
+ * Once the worker is going on an item, no GC run can start until it's done,
+ * as it neither allocates nor reaches a point where GC can take place until
+ * it marks itself blocked to wait for more work.
+ *
+ * If the worker isn't running, which is the case with MVM_SPESH_BLOCKING
+ * set, the work is done on the thread that needs it, as soon as it does;
+ * that's useful for getting the same specializations on every run.
+ *
+ * Before the VM exits or is destroyed, the worker is stopped, so it isn't
+ * writing to the spesh log or using the queue as they go away. It finishes
+ * the item it's on, if any, and the rest are just freed. */
+
+/* Adds an item to the end of the queue, and wakes the worker. */
+static void enqueue(MVMThreadContext *tc, MVMSpeshWorkItem *item) {
+    MVMInstance *instance = tc->instance;
+    item->next = NULL;
+    uv_mutex_lock(&instance->mutex_spesh_queue);
+    if (instance->spesh_queue_tail)
+        instance->spesh_queue_tail->next = item;
+    else
+        instance->spesh_queue_head = item;
+    instance->spesh_queue_tail = item;
+    uv_cond_signal(&instance->cond_spesh_queue);
+    uv_mutex_unlock(&instance->mutex_spesh_queue);
+}
+
+/* Does a piece of work. */
+static void do_work(MVMThreadContext *tc, MVMSpeshWorkItem *item) {
+    switch (item->kind) {
+    case MVM_SPESH_WORK_SETUP:
+        MVM_spesh_candidate_setup(tc, item->sf, item->cs, item->args);
+        MVM_store(&item->sf->body.spesh_setup_pending, 0);
+        break;
+    case MVM_SPESH_WORK_SPECIALIZE:
+        MVM_spesh_candidate_specialize(tc, item->sf, item->cand);
+        break;
+    }
+}
+
+/* The worker thread, which takes work off the queue until it's asked to
+ * stop. */
+static void worker(MVMThreadContext *tc, MVMCallsite *callsite, MVMRegister *args) {
+    MVMInstance *instance = tc->instance;
+    while (1) {
+        MVMSpeshWorkItem *item;
+
+        /* Wait for some work, letting any GC run go ahead without us. */
+        MVM_gc_mark_thread_blocked(tc);
+        uv_mutex_lock(&instance->mutex_spesh_queue);
+        while (!instance->spesh_queue_head && !instance->spesh_worker_stopping)
+            uv_cond_wait(&instance->cond_spesh_queue, &instance->mutex_spesh_queue);
+
+        /* If we're to stop, say we have, and end the thread. It never ran
+         * any bytecode, so there's nothing to return to; it stays marked as
+         * blocked, so GC runs don't wait for it. */
+        if (instance->spesh_worker_stopping) {
+            instance->spesh_worker_stopped = 1;
+            uv_cond_broadcast(&instance->cond_spesh_queue);
+            uv_mutex_unlock(&instance->mutex_spesh_queue);
+            MVM_platform_thread_exit(NULL);
+        }
+        item = instance->spesh_queue_head;
+        uv_mutex_unlock(&instance->mutex_spesh_queue);
+        MVM_gc_mark_thread_unblocked(tc);
+
+        do_work(tc, item);
+
+        /* Now it's done, take it off the queue. */
+        uv_mutex_lock(&instance->mutex_spesh_queue);
+        instance->spesh_queue_head = item->next;
+        if (!instance->spesh_queue_head)
+            instance->spesh_queue_tail = NULL;
+        uv_mutex_unlock(&instance->mutex_spesh_queue);
+        if (item->args)
+            free(item->args);
+        free(item);
+    }
+}
+
+/* Starts the spesh worker thread, unless spesh is disabled or is to be done
+ * on the threads that need it. */
+void MVM_spesh_worker_start(MVMThreadContext *tc) {
+    MVMInstance *instance = tc->instance;
+    MVMObject   *thread, *runner;
+    if (!instance->spesh_enabled || instance->spesh_blocking || instance->spesh_thread)
+        return;
+    runner = MVM_repr_alloc_init(tc, instance->boot_types.BOOTCCode);
+    ((MVMCFunction *)runner)->body.func = worker;
+    thread = MVM_thread_new(tc, runner, 1);
+    MVM_thread_run(tc, thread);
+    instance->spesh_thread = ((MVMThread *)thread)->body.tc;
+}
+
+/* Stops the spesh worker thread, if it's running, waiting until it has
+ * finished any item it's on. Work queued up after that is never done. */
+void MVM_spesh_worker_stop(MVMThreadContext *tc) {
+    MVMInstance *instance = tc->instance;
+    if (!instance->spesh_thread)
+        return;
+    MVM_gc_mark_thread_blocked(tc);
+    uv_mutex_lock(&instance->mutex_spesh_queue);
+    instance->spesh_worker_stopping = 1;
+    uv_cond_broadcast(&instance->cond_spesh_queue);
+    while (!instance->spesh_worker_stopped)
+        uv_cond_wait(&instance->cond_spesh_queue, &instance->mutex_spesh_queue);
+    uv_mutex_unlock(&instance->mutex_spesh_queue);
+    MVM_gc_mark_thread_unblocked(tc);
+}
+
+/* Asks for a specialization candidate to be set up for a static frame,
+ * given the callsite and arguments it's being invoked with. If there's a
+ * worker, it's queued up and NULL is returned; no more is queued for the
+ * frame until that's done. Otherwise, it's set up right away. */
+MVMSpeshCandidate * MVM_spesh_worker_setup(MVMThreadContext *tc, MVMStaticFrame *sf,
+        MVMCallsite *cs, MVMRegister *args) {
+    MVMSpeshWorkItem *item;
+
+    if (!tc->instance->spesh_thread)
+        return MVM_spesh_candidate_setup(tc, sf, cs, args);
+
+    if (MVM_load(&sf->body.spesh_setup_pending) ||
+            MVM_cas(&sf->body.spesh_setup_pending, 0, 1) != 0)
+        return NULL;
+
+    /* Only the positionals are looked at, and they're copied, as they'll be
+     * gone by the time the worker gets to them. */
+    item       = malloc(sizeof(MVMSpeshWorkItem));
+    item->kind = MVM_SPESH_WORK_SETUP;
+    item->sf   = sf;
+    item->cs   = cs;
+    item->cand = NULL;
+    item->args = NULL;
+    if (cs->num_pos) {
+        item->args = malloc(cs->num_pos * sizeof(MVMRegister));
+        memcpy(item->args, args, cs->num_pos * sizeof(MVMRegister));
+    }
+    enqueue(tc, item);
+    return NULL;
+}
+
+/* Asks for a candidate that has finished logging to be specialized; done by
+ * the worker if there is one, and right away otherwise. Until it's done, the
+ * candidate is not used. */
+void MVM_spesh_worker_specialize(MVMThreadContext *tc, MVMStaticFrame *sf,
+        MVMSpeshCandidate *cand) {
+    MVMSpeshWorkItem *item;
+
+    if (!tc->instance->spesh_thread) {
+        MVM_spesh_candidate_specialize(tc, sf, cand);
+        return;
+    }
+
+    item       = malloc(sizeof(MVMSpeshWorkItem));
+    item->kind = MVM_SPESH_WORK_SPECIALIZE;
+    item->sf   = sf;
+    item->cs   = NULL;
+    item->args = NULL;
+    item->cand = cand;
+    enqueue(tc, item);
+}
+
+/* Marks what the queued work items reference. */
+void MVM_spesh_worker_gc_mark(MVMThreadContext *tc, MVMGCWorklist *worklist) {
+    MVMSpeshWorkItem *item;
+    MVMuint16         i;
+    uv_mutex_lock(&tc->instance->mutex_spesh_queue);
+    for (item = tc->instance->spesh_queue_head; item; item = item->next) {
+        MVM_gc_worklist_add(tc, worklist, &item->sf);
+        if (item->args) {
+            for (i = 0; i < item->cs->num_pos; i++) {
+                switch (item->cs->arg_flags[i] & MVM_CALLSITE_ARG_MASK) {
+                case MVM_CALLSITE_ARG_OBJ:
+                    MVM_gc_worklist_add(tc, worklist, &item->args[i].o);
+                    break;
+                case MVM_CALLSITE_ARG_STR:
+                    MVM_gc_worklist_add(tc, worklist, &item->args[i].s);
+                    break;
+                }
+            }
+        }
+    }
+    uv_mutex_unlock(&tc->instance->mutex_spesh_queue);
+}
+
+/* Frees any work left in the queue, and the queue's locks. */
+void MVM_spesh_worker_destroy(MVMThreadContext *tc) {
+    MVMInstance      *instance = tc->instance;
+    MVMSpeshWorkItem *item     = instance->spesh_queue_head;
+    while (item) {
+        MVMSpeshWorkItem *next = item->next;
+        if (item->args)
+            free(item->args);
+        free(item);
+        item = next;
+    }
+    instance->spesh_queue_head = instance->spesh_queue_tail = NULL;
+    uv_cond_destroy(&instance->cond_spesh_queue);
+    uv_mutex_destroy(&instance->mutex_spesh_queue);
+}
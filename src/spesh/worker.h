@@ -0,0 +1,33 @@
+/* A piece of specialization work, waiting on the spesh worker's queue. */
+struct MVMSpeshWorkItem {
+    /* What to do; one of the MVM_SPESH_WORK_* kinds below. */
+    MVMuint8 kind;
+
+    /* The static frame the work is for. */
+    MVMStaticFrame *sf;
+
+    /* For setting up a candidate, the callsite and a copy of the positional
+     * arguments it was seen with. */
+    MVMCallsite *cs;
+    MVMRegister *args;
+
+    /* For specializing, the candidate that has finished logging. */
+    MVMSpeshCandidate *cand;
+
+    /* The next item in the queue. */
+    MVMSpeshWorkItem *next;
+};
+
+/* Kinds of work item. */
+#define MVM_SPESH_WORK_SETUP      1
+#define MVM_SPESH_WORK_SPECIALIZE 2
+
+/* Functions. */
+void MVM_spesh_worker_start(MVMThreadContext *tc);
+void MVM_spesh_worker_stop(MVMThreadContext *tc);
+MVMSpeshCandidate * MVM_spesh_worker_setup(MVMThreadContext *tc, MVMStaticFrame *sf,
+    MVMCallsite *cs, MVMRegister *args);
+void MVM_spesh_worker_specialize(MVMThreadContext *tc, MVMStaticFrame *sf,
+    MVMSpeshCandidate *cand);
+void MVM_spesh_worker_gc_mark(MVMThreadContext *tc, MVMGCWorklist *worklist);
+void MVM_spesh_worker_destroy(MVMThreadContext *tc);
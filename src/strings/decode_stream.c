@@ -89,8 +89,23 @@ static run_decode(MVMThreadContext *tc, MVMDecodeStream *ds, MVMint32 *stopper_c
     }
 }
 
-/* Gets the specified number of characters. If we are not yet able to decode
- * that many, returns NULL. This may mean more input buffers are needed. */
+/* Puts a string assembled from decoded codepoints into NFG, if anything in
+ * it might need that. It's done here rather than as each chunk is decoded,
+ * so that a grapheme split across input buffers comes out whole. Only UTF-8
+ * can produce anything that needs it. */
+static void normalize_chars(MVMThreadContext *tc, MVMDecodeStream *ds, MVMString *result) {
+    MVMint64        num_graphs;
+    MVMCodepoint32 *graphs;
+    if (ds->encoding != MVM_encoding_type_utf8 ||
+            !MVM_nfg_needs_normalization(tc, result->body.int32s, result->body.graphs))
+        return;
+    graphs = MVM_nfg_normalize(tc, result->body.int32s, result->body.graphs, &num_graphs);
+    free(result->body.int32s);
+    result->body.int32s = graphs;
+    result->body.graphs = num_graphs;
+}
+
+/* Finds how many of the specified number of codepoints are not yet decoded. */
 static MVMint32 missing_chars(MVMThreadContext *tc, MVMDecodeStream *ds, MVMint32 wanted) {
     MVMint32 got = 0;
     MVMDecodeStreamChars *cur_chars = ds->chars_head;
@@ -103,6 +118,8 @@ static MVMint32 missing_chars(MVMThreadContext *tc, MVMDecodeStream *ds, MVMint3
     }
     return got >= wanted ? 0 : wanted - got;
 }
+
+/* Takes the specified number of decoded codepoints, making a string of them. */
 static MVMString * take_chars(MVMThreadContext *tc, MVMDecodeStream *ds, MVMint32 chars) {
     MVMint32 found = 0;
     MVMString *result = (MVMString *)MVM_repr_alloc_init(tc, tc->instance->VMString);
@@ -137,10 +154,60 @@ static MVMString * take_chars(MVMThreadContext *tc, MVMDecodeStream *ds, MVMint3
             ds->chars_head_pos += take;
         }
     }
+    normalize_chars(tc, ds, result);
     return result;
 }
-MVMString * MVM_string_decodestream_get_chars(MVMThreadContext *tc, MVMDecodeStream *ds, MVMint32 chars) {
-    MVMint32 missing;
+
+/* Finds how many of the decoded codepoints make up the first so many
+ * graphemes, which is only known once the codepoint after them has been
+ * decoded too, as it might extend the last of them; unless at_end is set,
+ * saying nothing more will be decoded, and so the last grapheme ends with
+ * the last codepoint. Returns 0 if that isn't known yet, with the number of
+ * graphemes that are complete put in found. Only UTF-8 decodes to anything
+ * that can extend a grapheme, so for other encodings each codepoint is one. */
+static MVMint32 grapheme_codepoints(MVMThreadContext *tc, MVMDecodeStream *ds, MVMint32 wanted,
+                                    MVMint32 at_end, MVMint32 *found) {
+    MVMDecodeStreamChars *cur_chars = ds->chars_head;
+    MVMCodepoint32        last      = 0;
+    MVMint32              graphs    = 0;
+    MVMint32              cps       = 0;
+    if (ds->encoding != MVM_encoding_type_utf8) {
+        *found = wanted - missing_chars(tc, ds, wanted);
+        return *found == wanted ? wanted : 0;
+    }
+    while (cur_chars) {
+        MVMint32 i = cur_chars == ds->chars_head ? ds->chars_head_pos : 0;
+        for (; i < cur_chars->length; i++) {
+            MVMCodepoint32 cp = cur_chars->chars[i];
+            if (cps && MVM_nfg_is_concat_stable(tc, last, cp)) {
+                /* The grapheme before this one is complete. */
+                if (++graphs == wanted) {
+                    *found = graphs;
+                    return cps;
+                }
+            }
+            last = cp;
+            cps++;
+        }
+        cur_chars = cur_chars->next;
+    }
+    if (at_end && cps && graphs + 1 == wanted) {
+        *found = wanted;
+        return cps;
+    }
+    *found = graphs;
+    return 0;
+}
+
+/* Gets the specified number of characters, as graphemes. If we are not yet
+ * able to decode that many, and to tell the last of them is complete,
+ * returns NULL. This may mean more input buffers are needed. If eof is set,
+ * the caller has no more input to give, or can't wait for it, so the end of
+ * what there is ends the last grapheme. */
+MVMString * MVM_string_decodestream_get_chars(MVMThreadContext *tc, MVMDecodeStream *ds, MVMint32 chars,
+                                              MVMint32 eof) {
+    MVMint32 cps, found;
+    MVMint32 at_end = 0;
 
     /* If we request nothing, give empty string. */
     if (chars == 0) {
@@ -151,44 +218,238 @@ MVMString * MVM_string_decodestream_get_chars(MVMThreadContext *tc, MVMDecodeStr
         return result;
     }
 
-    /* If we don't already have enough chars, try and decode more. */
-    missing = missing_chars(tc, ds, chars);
-    if (missing)
-        run_decode(tc, ds, &missing, NULL);
+    /* If we don't already have enough chars, try and decode more, until the
+     * last of them is known to be a whole grapheme. Each grapheme is at least
+     * one codepoint, and one more is needed to see where the last ends. */
+    while (!(cps = grapheme_codepoints(tc, ds, chars, at_end, &found))) {
+        MVMint64 before = ds->abs_byte_pos;
+        MVMint32 more   = chars - found + 1;
+        if (at_end)
+            return NULL;
+        if (ds->bytes_head)
+            run_decode(tc, ds, &more, NULL);
+        if (ds->abs_byte_pos == before) {
+            if (!eof)
+                return NULL;
+            at_end = 1;
+        }
+    }
 
-    /* If we've got enough, assemble a string. Otherwise, give up. */
-    if (missing_chars(tc, ds, chars) == 0)
-        return take_chars(tc, ds, chars);
-    else
-        return NULL;
+    /* We've got enough, so assemble a string. */
+    return take_chars(tc, ds, cps);
 }
 
-/* Gets characters up until the specified string is encountered. If we do
- * not encounter it, returns NULL. This may mean more input buffers are needed
- * or that we reached the end of the stream. */
-MVMint32 find_separator(MVMThreadContext *tc, MVMDecodeStream *ds, MVMCodepoint32 sep) {
-    MVMint32 sep_loc = 0;
+/* Copies bytes that have not been decoded yet into the supplied buffer,
+ * starting the specified number of bytes in. The bytes must be there. */
+static void copy_pending_bytes(MVMDecodeStream *ds, MVMint64 from, MVMint64 length, char *dest) {
+    MVMDecodeStreamBytes *cur_bytes = ds->bytes_head;
+    MVMint32 pos = ds->bytes_head_pos;
+    while (length) {
+        MVMint64 available = cur_bytes->length - pos;
+        if (from >= available) {
+            from -= available;
+        }
+        else {
+            MVMint64 take = available - from < length ? available - from : length;
+            memcpy(dest, cur_bytes->bytes + pos + from, take);
+            dest   += take;
+            length -= take;
+            from    = 0;
+        }
+        cur_bytes = cur_bytes->next;
+        pos = 0;
+    }
+}
+
+/* Gets the bytes the separator is made of, if we can look for it among the
+ * bytes without decoding them: it must be ASCII, for UTF-8 and ASCII, as
+ * bytes below 0x80 are never part of a multi-byte UTF-8 sequence, or any
+ * Latin-1 for Latin-1. */
+static MVMint32 separator_bytes(MVMDecodeStream *ds, const MVMDecodeStreamSeparator *sep, MVMuint8 *sep_bytes) {
+    MVMCodepoint32 limit;
+    MVMint32 i;
+    switch (ds->encoding) {
+        case MVM_encoding_type_utf8:
+        case MVM_encoding_type_ascii:
+            limit = 0x80;
+            break;
+        case MVM_encoding_type_latin1:
+            limit = 0x100;
+            break;
+        default:
+            return 0;
+    }
+    for (i = 0; i < sep->length; i++) {
+        if (sep->cps[i] < 0 || sep->cps[i] >= limit)
+            return 0;
+        sep_bytes[i] = (MVMuint8)sep->cps[i];
+    }
+    return 1;
+}
+
+/* Joins the byte buffers from the head up to and including the specified
+ * one into a single buffer, which replaces them at the head. */
+static void join_bytes(MVMThreadContext *tc, MVMDecodeStream *ds, MVMDecodeStreamBytes *end_bytes) {
+    MVMDecodeStreamBytes *joined    = calloc(1, sizeof(MVMDecodeStreamBytes));
+    MVMDecodeStreamBytes *cur_bytes = ds->bytes_head;
+    MVMint32              length    = 0;
+    while (1) {
+        length += cur_bytes == ds->bytes_head
+            ? cur_bytes->length - ds->bytes_head_pos
+            : cur_bytes->length;
+        if (cur_bytes == end_bytes)
+            break;
+        cur_bytes = cur_bytes->next;
+    }
+    joined->bytes  = malloc(length);
+    joined->length = length;
+    joined->next   = end_bytes->next;
+    copy_pending_bytes(ds, 0, length, joined->bytes);
+
+    cur_bytes = ds->bytes_head;
+    while (cur_bytes != joined->next) {
+        MVMDecodeStreamBytes *next_bytes = cur_bytes->next;
+        free(cur_bytes->bytes);
+        free(cur_bytes);
+        cur_bytes = next_bytes;
+    }
+    ds->bytes_head     = joined;
+    ds->bytes_head_pos = 0;
+    if (!joined->next)
+        ds->bytes_tail = joined;
+}
+
+/* Takes a line that has been found among the bytes, decoding it straight
+ * into a string. The line ends at the specified position in the specified
+ * byte buffer, and is the specified number of bytes long. */
+static MVMString * take_line_bytes(MVMThreadContext *tc, MVMDecodeStream *ds,
+        MVMDecodeStreamBytes *end_bytes, MVMint32 end_pos, MVMint64 line_bytes) {
+    MVMString *result;
+    char      *bytes;
+
+    /* A line that is all in one buffer is decoded from there; otherwise,
+     * the buffers it's in are joined first. The stream owns the joined
+     * buffer, so it isn't lost if the bytes turn out not to decode. */
+    if (end_bytes != ds->bytes_head) {
+        join_bytes(tc, ds, end_bytes);
+        end_bytes = ds->bytes_head;
+        end_pos   = (MVMint32)line_bytes;
+    }
+    bytes = ds->bytes_head->bytes + ds->bytes_head_pos;
+
+    switch (ds->encoding) {
+    case MVM_encoding_type_utf8:
+        result = MVM_string_utf8_decode(tc, tc->instance->VMString, (MVMuint8 *)bytes, line_bytes);
+        break;
+    case MVM_encoding_type_ascii:
+        result = MVM_string_ascii_decode(tc, tc->instance->VMString, bytes, line_bytes);
+        break;
+    default:
+        result = MVM_string_latin1_decode(tc, tc->instance->VMString, (MVMuint8 *)bytes, line_bytes);
+    }
+
+    MVM_string_decodestream_discard_to(tc, ds, end_bytes, end_pos);
+    return result;
+}
+
+/* Looks for the separator among the bytes not yet decoded, going through
+ * them with memchr for its last byte. If it is found, the line up to and
+ * including it is decoded and returned; otherwise, returns NULL without
+ * decoding anything. Only to be used when there are no decoded chars, so
+ * the bytes start on a character boundary. */
+static MVMString * get_line_from_bytes(MVMThreadContext *tc, MVMDecodeStream *ds,
+        const MVMuint8 *sep_bytes, MVMint32 sep_length) {
+    MVMuint8              last_byte = sep_bytes[sep_length - 1];
+    MVMDecodeStreamBytes *cur_bytes = ds->bytes_head;
+    MVMint64              before    = 0;
+    while (cur_bytes) {
+        MVMint32  start = cur_bytes == ds->bytes_head ? ds->bytes_head_pos : 0;
+        MVMint32  pos   = start;
+        MVMuint8 *bytes = (MVMuint8 *)cur_bytes->bytes;
+        while (pos < cur_bytes->length) {
+            MVMuint8 *found = memchr(bytes + pos, last_byte, cur_bytes->length - pos);
+            MVMint64  line_bytes;
+            if (!found)
+                break;
+            pos        = found - bytes + 1;
+            line_bytes = before + pos - start;
+            if (sep_length == 1)
+                return take_line_bytes(tc, ds, cur_bytes, pos, line_bytes);
+            if (line_bytes >= sep_length) {
+                /* Check the rest of the separator is there too; it may
+                 * start back in an earlier buffer. */
+                MVMuint8 tail[MVM_DECODE_STREAM_SEP_MAX];
+                if (pos - start >= sep_length) {
+                    if (memcmp(found + 1 - sep_length, sep_bytes, sep_length) == 0)
+                        return take_line_bytes(tc, ds, cur_bytes, pos, line_bytes);
+                }
+                else {
+                    copy_pending_bytes(ds, line_bytes - sep_length, sep_length, (char *)tail);
+                    if (memcmp(tail, sep_bytes, sep_length) == 0)
+                        return take_line_bytes(tc, ds, cur_bytes, pos, line_bytes);
+                }
+            }
+        }
+        before += cur_bytes->length - start;
+        cur_bytes = cur_bytes->next;
+    }
+    return NULL;
+}
+
+/* Finds the separator among the decoded chars, returning the number of
+ * chars up to and including it, or 0 if it's not there. The last few chars
+ * are kept in a ring, so they can be checked against the whole separator
+ * whenever its last char is seen. */
+static MVMint32 find_separator(MVMThreadContext *tc, MVMDecodeStream *ds, const MVMDecodeStreamSeparator *sep) {
+    MVMint32              sep_loc   = 0;
+    MVMint32              length    = sep->length;
+    MVMCodepoint32        last      = sep->cps[length - 1];
+    MVMCodepoint32        recent[MVM_DECODE_STREAM_SEP_MAX];
     MVMDecodeStreamChars *cur_chars = ds->chars_head;
     while (cur_chars) {
         MVMint32 start = cur_chars == ds->chars_head ? ds->chars_head_pos : 0;
-        MVMint32 i = 0;
+        MVMint32 i;
         for (i = start; i < cur_chars->length; i++) {
+            MVMCodepoint32 cp = cur_chars->chars[i];
+            recent[sep_loc % length] = cp;
             sep_loc++;
-            if (cur_chars->chars[i] == sep)
-                return sep_loc;
+            if (cp == last && sep_loc >= length) {
+                MVMint32 j;
+                for (j = 0; j < length; j++)
+                    if (recent[(sep_loc - length + j) % length] != sep->cps[j])
+                        break;
+                if (j == length)
+                    return sep_loc;
+            }
         }
         cur_chars = cur_chars->next;
     }
     return 0;
 }
-MVMString * MVM_string_decodestream_get_until_sep(MVMThreadContext *tc, MVMDecodeStream *ds, MVMCodepoint32 sep) {
-    MVMint32 sep_loc;
 
-    /* Look for separator, trying more decoding if it fails. We get the place
-     * just beyond the separator, so can use take_chars to get what's need. */
+/* Gets characters up until the specified separator is encountered. If we do
+ * not encounter it, returns NULL. This may mean more input buffers are needed
+ * or that we reached the end of the stream. When there are no decoded chars
+ * waiting, and the separator allows it, the separator is looked for among
+ * the bytes, and just the line is decoded. */
+MVMString * MVM_string_decodestream_get_until_sep(MVMThreadContext *tc, MVMDecodeStream *ds, const MVMDecodeStreamSeparator *sep) {
+    MVMuint8       sep_bytes[MVM_DECODE_STREAM_SEP_MAX];
+    MVMCodepoint32 stopper = sep->cps[sep->length - 1];
+    MVMint32       sep_loc;
+
+    if (!ds->chars_head && separator_bytes(ds, sep, sep_bytes))
+        return get_line_from_bytes(tc, ds, sep_bytes, sep->length);
+
+    /* Look for separator, trying more decoding if it fails. Decoding stops
+     * after each occurrence of the separator's last char, so we keep going
+     * for as long as that gets us somewhere. We get the place just beyond
+     * the separator, so can use take_chars to get what's need. */
     sep_loc = find_separator(tc, ds, sep);
-    if (!sep_loc) {
-        run_decode(tc, ds, NULL, &sep);
+    while (!sep_loc && ds->bytes_head) {
+        MVMint64 before = ds->abs_byte_pos;
+        run_decode(tc, ds, NULL, &stopper);
+        if (ds->abs_byte_pos == before)
+            break;
         sep_loc = find_separator(tc, ds, sep);
     }
     if (sep_loc)
@@ -247,10 +508,11 @@ MVMString * MVM_string_decodestream_get_all(MVMThreadContext *tc, MVMDecodeStrea
         /* Copy all the things into the target, freeing as we go. */
         cur_chars = ds->chars_head;
         while (cur_chars) {
+            MVMDecodeStreamChars *next_chars = cur_chars->next;
             if (cur_chars == ds->chars_head) {
                 MVMint32 to_copy = ds->chars_head->length - ds->chars_head_pos;
                 memcpy(result->body.int32s + pos, cur_chars->chars + ds->chars_head_pos,
-                    cur_chars->length * sizeof(MVMCodepoint32));
+                    to_copy * sizeof(MVMCodepoint32));
                 pos += to_copy;
             }
             else {
@@ -258,11 +520,15 @@ MVMString * MVM_string_decodestream_get_all(MVMThreadContext *tc, MVMDecodeStrea
                     cur_chars->length * sizeof(MVMCodepoint32));
                 pos += cur_chars->length;
             }
-            cur_chars = cur_chars->next;
+            free(cur_chars->chars);
+            free(cur_chars);
+            cur_chars = next_chars;
         }
         ds->chars_head = ds->chars_tail = NULL;
+        ds->chars_head_pos = 0;
     }
 
+    normalize_chars(tc, ds, result);
     return result;
 }
 
@@ -341,3 +607,22 @@ void MVM_string_decodestream_destory(MVMThreadContext *tc, MVMDecodeStream *ds)
     }
     free(ds);
 }
+
+/* Sets up the default line separator, a single newline. */
+void MVM_string_decodestream_sep_default(MVMThreadContext *tc, MVMDecodeStreamSeparator *sep) {
+    sep->cps[0] = '\n';
+    sep->length = 1;
+}
+
+/* Sets up a line separator from a string. */
+void MVM_string_decodestream_sep_from_string(MVMThreadContext *tc, MVMDecodeStreamSeparator *sep, MVMString *str) {
+    MVMStringIndex length = NUM_GRAPHS(str), i;
+    if (length == 0)
+        MVM_exception_throw_adhoc(tc, "Line separator cannot be empty");
+    if (length > MVM_DECODE_STREAM_SEP_MAX)
+        MVM_exception_throw_adhoc(tc, "Line separator cannot be longer than %d characters",
+            MVM_DECODE_STREAM_SEP_MAX);
+    for (i = 0; i < length; i++)
+        sep->cps[i] = MVM_string_get_codepoint_at_nocheck(tc, str, i);
+    sep->length = length;
+}
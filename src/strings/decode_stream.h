@@ -36,15 +36,26 @@ struct MVMDecodeStreamChars {
     MVMDecodeStreamChars *next;
 };
 
+/* The most codepoints a line separator may have. */
+#define MVM_DECODE_STREAM_SEP_MAX 16
+
+/* A line separator; a line ends after all of its codepoints, in order. */
+struct MVMDecodeStreamSeparator {
+    MVMCodepoint32 cps[MVM_DECODE_STREAM_SEP_MAX];
+    MVMint32       length;
+};
+
 MVMDecodeStream * MVM_string_decodestream_create(MVMThreadContext *tc, MVMint32 encoding, MVMint64 abs_byte_pos);
 void MVM_string_decodestream_add_bytes(MVMThreadContext *tc, MVMDecodeStream *ds, char *bytes, MVMint32 length);
 void MVM_string_decodestream_add_chars(MVMThreadContext *tc, MVMDecodeStream *ds, MVMCodepoint32 *chars, MVMint32 length);
 void MVM_string_decodestream_discard_to(MVMThreadContext *tc, MVMDecodeStream *ds, MVMDecodeStreamBytes *bytes, MVMint32 pos);
-MVMString * MVM_string_decodestream_get_chars(MVMThreadContext *tc, MVMDecodeStream *ds, MVMint32 chars);
-MVMString * MVM_string_decodestream_get_until_sep(MVMThreadContext *tc, MVMDecodeStream *ds, MVMCodepoint32 sep);
+MVMString * MVM_string_decodestream_get_chars(MVMThreadContext *tc, MVMDecodeStream *ds, MVMint32 chars, MVMint32 eof);
+MVMString * MVM_string_decodestream_get_until_sep(MVMThreadContext *tc, MVMDecodeStream *ds, const MVMDecodeStreamSeparator *sep);
 MVMString * MVM_string_decodestream_get_all(MVMThreadContext *tc, MVMDecodeStream *ds);
 MVMint64 MVM_string_decodestream_have_bytes(MVMThreadContext *tc, MVMDecodeStream *ds, MVMint32 bytes);
 MVMint64 MVM_string_decodestream_bytes_to_buf(MVMThreadContext *tc, MVMDecodeStream *ds, char **buf, MVMint32 bytes);
 MVMint64 MVM_string_decodestream_tell_bytes(MVMThreadContext *tc, MVMDecodeStream *ds);
 MVMint32 MVM_string_decodestream_is_empty(MVMThreadContext *tc, MVMDecodeStream *ds);
 void MVM_string_decodestream_destory(MVMThreadContext *tc, MVMDecodeStream *ds);
+void MVM_string_decodestream_sep_default(MVMThreadContext *tc, MVMDecodeStreamSeparator *sep);
+void MVM_string_decodestream_sep_from_string(MVMThreadContext *tc, MVMDecodeStreamSeparator *sep, MVMString *str);
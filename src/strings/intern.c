@@ -0,0 +1,97 @@
+#include "moar.h"
+
+/* Interning gives equal strings a single shared copy, so that they take up
+ * memory once and can be compared by pointer (which hash lookups try before
+ * anything else). Interned strings are allocated in generation 2, so they
+ * never move, and are stored flat. The table holds them weakly: an interned
+ * string is taken out of it when it's freed.
+ *
+ * The table's mutex is never held while allocating, so that a thread that
+ * wants it can't hold up a GC run. */
+
+/* Looks up the interned string equal to the given one, or NULL
+ * if there is none. A string found while generation 2 is being marked may
+ * not have been marked yet, and nothing else might refer to it, so it gets
+ * marked now, as it's about to be referred to again. */
+static MVMString * find_interned(MVMThreadContext *tc, MVMString *s) {
+    MVMStrHashEntry *entry = MVM_str_hash_fetch(tc, tc->instance->string_interns, s);
+    MVMString *interned = entry ? entry->key : NULL;
+    if (interned && tc->gc_gen2_marking
+            && !(interned->common.header.flags & MVM_CF_GEN2_LIVE))
+        MVM_gc_write_barrier_shade(tc, (MVMCollectable *)interned);
+    return interned;
+}
+
+/* Gets the interned string equal to the given one, interning it if there
+ * isn't one yet. */
+MVMString * MVM_string_intern(MVMThreadContext *tc, MVMString *s) {
+    MVMInstance *i = tc->instance;
+    MVMString   *interned;
+
+    if (s->body.flags & MVM_STRING_INTERNED)
+        return s;
+
+    /* Getting the hash code caches it for the table, so do it before taking
+     * the lock. Ropes are flattened, as interned strings are kept flat. */
+    if (IS_ROPE(s))
+        MVM_string_flatten(tc, s);
+    MVM_string_hash_code(tc, s);
+
+    uv_mutex_lock(&i->mutex_string_interns);
+    interned = find_interned(tc, s);
+    uv_mutex_unlock(&i->mutex_string_interns);
+    if (interned)
+        return interned;
+
+    /* Not there yet, so we'll add the string itself if it's in generation 2
+     * already, and otherwise a copy made there. */
+    if (s->common.header.flags & MVM_CF_SECOND_GEN) {
+        interned = s;
+    }
+    else {
+        /* Allocating in generation 2 can't trigger GC, so there's no need
+         * to root the string. */
+        MVMStringIndex graphs = s->body.graphs;
+        size_t         size   = graphs * (IS_WIDE(s) ? sizeof(MVMCodepoint32) : sizeof(MVMCodepoint8));
+        if (tc->allocate_in == MVMAllocate_Nursery) {
+            MVM_gc_allocate_gen2_default_set(tc);
+            interned = (MVMString *)MVM_repr_alloc_init(tc, i->VMString);
+            MVM_gc_allocate_gen2_default_clear(tc);
+        }
+        else {
+            interned = (MVMString *)MVM_repr_alloc_init(tc, i->VMString);
+        }
+        interned->body.flags            = STR_FLAGS(s);
+        interned->body.graphs           = graphs;
+        interned->body.codes            = s->body.codes;
+        interned->body.cached_hash_code = s->body.cached_hash_code;
+        interned->body.storage          = malloc(size ? size : 1);
+        memcpy(interned->body.storage, s->body.storage, size);
+    }
+
+    /* Another thread may have interned an equal string meanwhile, in which
+     * case we go with that one. Adding to the table can throw, if it has too
+     * many colliding keys, so the mutex is released should it do so. */
+    uv_mutex_lock(&i->mutex_string_interns);
+    MVM_tc_set_ex_release_mutex(tc, &i->mutex_string_interns);
+    if (!(s = find_interned(tc, interned))) {
+        MVMStrHashEntry *entry = MVM_str_hash_lvalue_fetch(tc, i->string_interns, interned);
+        entry->key = interned;
+        interned->body.flags |= MVM_STRING_INTERNED;
+        s = interned;
+    }
+    uv_mutex_unlock(&i->mutex_string_interns);
+    MVM_tc_clear_ex_release_mutex(tc);
+    return s;
+}
+
+/* Called when an interned string is freed, to take it out of the table. */
+void MVM_string_intern_remove(MVMThreadContext *tc, MVMString *s) {
+    MVMInstance     *i = tc->instance;
+    MVMStrHashEntry *entry;
+    uv_mutex_lock(&i->mutex_string_interns);
+    entry = MVM_str_hash_fetch(tc, i->string_interns, s);
+    if (entry && entry->key == s)
+        MVM_str_hash_delete(tc, i->string_interns, s);
+    uv_mutex_unlock(&i->mutex_string_interns);
+}
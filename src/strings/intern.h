@@ -0,0 +1,2 @@
+MVMString * MVM_string_intern(MVMThreadContext *tc, MVMString *s);
+void MVM_string_intern_remove(MVMThreadContext *tc, MVMString *s);
@@ -2,19 +2,17 @@
 
 /* Decodes the specified number of bytes of latin1 into an NFG string,
  * creating a result of the specified type. The type must have the MVMString
- * REPR. */
+ * REPR. Latin-1 is exactly what fits in 8-bit storage, so the bytes are just
+ * copied. */
 MVMString * MVM_string_latin1_decode(MVMThreadContext *tc, MVMObject *result_type,
                                      MVMuint8 *latin1, size_t bytes) {
     MVMString *result = (MVMString *)REPR(result_type)->allocate(tc, STABLE(result_type));
-    size_t i;
 
     result->body.codes  = bytes;
     result->body.graphs = bytes;
-    result->body.flags  = MVM_STRING_TYPE_INT32;
-    result->body.int32s = malloc(sizeof(MVMint32) * bytes);
-
-    for (i = 0; i < bytes; i++)
-        result->body.int32s[i] = latin1[i];
+    result->body.flags  = MVM_STRING_TYPE_UINT8;
+    result->body.uint8s = malloc(bytes ? bytes : 1);
+    memcpy(result->body.uint8s, latin1, bytes);
 
     return result;
 }
@@ -0,0 +1,568 @@
+#include "moar.h"
+
+/* Normalization to NFG. A run of codepoints is canonically decomposed,
+ * has its combining marks put in canonical order, and is canonically
+ * composed again, which gives NFC; then it's split into grapheme clusters,
+ * and each cluster of more than one codepoint is turned into a synthetic.
+ * This is only ever done for input that has something at or above
+ * MVM_NFG_QUICK_CHECK_MIN in it, so need not be especially quick. */
+
+/* Hangul syllables are decomposed and composed algorithmically. */
+#define HANGUL_S_BASE  0xAC00
+#define HANGUL_L_BASE  0x1100
+#define HANGUL_V_BASE  0x1161
+#define HANGUL_T_BASE  0x11A7
+#define HANGUL_L_COUNT 19
+#define HANGUL_V_COUNT 21
+#define HANGUL_T_COUNT 28
+#define HANGUL_N_COUNT (HANGUL_V_COUNT * HANGUL_T_COUNT)
+#define HANGUL_S_COUNT (HANGUL_L_COUNT * HANGUL_N_COUNT)
+
+/* The kinds of codepoint the grapheme cluster boundary rules care about. */
+#define GCB_OTHER        0
+#define GCB_CR           1
+#define GCB_LF           2
+#define GCB_CONTROL      3
+#define GCB_EXTEND       4
+#define GCB_RI           5
+#define GCB_SPACINGMARK  6
+#define GCB_L            7
+#define GCB_V            8
+#define GCB_T            9
+#define GCB_LV           10
+#define GCB_LVT          11
+#define GCB_NUM_KINDS    12
+static const char *gcb_names[GCB_NUM_KINDS] = {
+    "Other", "CR", "LF", "Control", "Extend", "Regional_Indicator",
+    "SpacingMark", "L", "V", "T", "LV", "LVT"
+};
+
+/* Property values we resolve once, in MVM_nfg_init: the kind of each value
+ * of Grapheme_Cluster_Break, the combining class each value of
+ * Canonical_Combining_Class stands for, and the value of
+ * Decomposition_Type for canonical decompositions. */
+static MVMuint8 gcb_of_value[32];
+static MVMuint8 ccc_of_value[64];
+static MVMint64 UPV_Canonical = 0;
+
+/* Gets the kind of a codepoint for grapheme cluster boundaries. */
+static MVMuint8 gcb_kind(MVMThreadContext *tc, MVMCodepoint32 cp) {
+    MVMint64 value = MVM_unicode_codepoint_get_property_int(tc, cp,
+        MVM_UNICODE_PROPERTY_GRAPHEME_CLUSTER_BREAK);
+    return value >= 0 && value < 32 ? gcb_of_value[value] : GCB_OTHER;
+}
+
+/* Gets the canonical combining class of a codepoint. */
+static MVMuint8 ccc(MVMThreadContext *tc, MVMCodepoint32 cp) {
+    MVMint64 value;
+    if (cp < MVM_NFG_QUICK_CHECK_MIN)
+        return 0;
+    value = MVM_unicode_codepoint_get_property_int(tc, cp,
+        MVM_UNICODE_PROPERTY_CANONICAL_COMBINING_CLASS);
+    return value >= 0 && value < 64 ? ccc_of_value[value] : 0;
+}
+
+/* Checks if there's a grapheme cluster boundary between two codepoints of
+ * the specified kinds. This follows UAX #29, apart from CR LF. */
+static MVMint32 is_boundary(MVMuint8 before, MVMuint8 after) {
+    switch (before) {
+        case GCB_CR:
+        case GCB_LF:
+        case GCB_CONTROL:
+            return 1;
+        case GCB_L:
+            if (after == GCB_L || after == GCB_V || after == GCB_LV || after == GCB_LVT)
+                return 0;
+            break;
+        case GCB_LV:
+        case GCB_V:
+            if (after == GCB_V || after == GCB_T)
+                return 0;
+            break;
+        case GCB_LVT:
+        case GCB_T:
+            if (after == GCB_T)
+                return 0;
+            break;
+        case GCB_RI:
+            if (after == GCB_RI)
+                return 0;
+            break;
+    }
+    if (after == GCB_CR || after == GCB_LF || after == GCB_CONTROL)
+        return 1;
+    return after != GCB_EXTEND && after != GCB_SPACINGMARK;
+}
+
+/* Sets up the NFG state for an instance, and resolves the property values
+ * we need. */
+void MVM_nfg_init(MVMThreadContext *tc) {
+    MVMNFGState *nfg = calloc(1, sizeof(MVMNFGState));
+    MVMint64     value;
+    MVMuint32    i;
+    char         name[8];
+    int          init_stat;
+
+    nfg->alloc_synthetics = 16;
+    nfg->synthetics       = malloc(nfg->alloc_synthetics * sizeof(MVMNFGSynthetic));
+    nfg->table            = calloc(1, sizeof(MVMNFGTable));
+    nfg->table->num_slots = 64;
+    nfg->table->slots     = calloc(nfg->table->num_slots, sizeof(MVMint32));
+    if ((init_stat = uv_mutex_init(&nfg->update_mutex)) < 0)
+        MVM_exception_throw_adhoc(tc, "Failed to initialize NFG mutex: %s",
+            uv_strerror(init_stat));
+    tc->instance->nfg = nfg;
+
+    for (i = 1; i < GCB_NUM_KINDS; i++) {
+        value = MVM_unicode_name_to_property_value_code(tc,
+            MVM_UNICODE_PROPERTY_GRAPHEME_CLUSTER_BREAK,
+            MVM_string_ascii_decode_nt(tc, tc->instance->VMString, gcb_names[i]));
+        if (value > 0 && value < 32)
+            gcb_of_value[value] = (MVMuint8)i;
+    }
+    for (i = 1; i < 256; i++) {
+        sprintf(name, "%u", i);
+        value = MVM_unicode_name_to_property_value_code(tc,
+            MVM_UNICODE_PROPERTY_CANONICAL_COMBINING_CLASS,
+            MVM_string_ascii_decode_nt(tc, tc->instance->VMString, name));
+        if (value > 0 && value < 64)
+            ccc_of_value[value] = (MVMuint8)i;
+    }
+    UPV_Canonical = MVM_unicode_name_to_property_value_code(tc,
+        MVM_UNICODE_PROPERTY_DECOMPOSITION_TYPE,
+        MVM_string_ascii_decode_nt(tc, tc->instance->VMString, "Canonical"));
+}
+
+/* Frees the NFG state of an instance. */
+void MVM_nfg_destroy(MVMThreadContext *tc) {
+    MVMNFGState *nfg = tc->instance->nfg;
+    MVMuint32    i;
+    if (!nfg)
+        return;
+    for (i = 0; i < nfg->num_synthetics; i++)
+        free(nfg->synthetics[i].combs);
+    for (i = 0; i < nfg->num_retired; i++)
+        free(nfg->retired[i]);
+    free(nfg->retired);
+    free(nfg->synthetics);
+    free(nfg->table->slots);
+    free(nfg->table);
+    free(nfg->compositions);
+    uv_mutex_destroy(&nfg->update_mutex);
+    free(nfg);
+    tc->instance->nfg = NULL;
+}
+
+/* Keeps storage that has been replaced until the state is destroyed. */
+static void retire(MVMNFGState *nfg, void *storage) {
+    if (nfg->num_retired == nfg->alloc_retired) {
+        nfg->alloc_retired = nfg->alloc_retired ? nfg->alloc_retired * 2 : 8;
+        nfg->retired       = realloc(nfg->retired, nfg->alloc_retired * sizeof(void *));
+    }
+    nfg->retired[nfg->num_retired++] = storage;
+}
+
+/* Hashes a base codepoint and the combining codepoints after it, for the
+ * synthetic table. */
+static MVMuint32 hash_codes(MVMCodepoint32 base, const MVMCodepoint32 *combs, MVMint32 num_combs) {
+    MVMuint32 hash = (0x811C9DC5 ^ (MVMuint32)base) * 0x01000193;
+    MVMint32  i;
+    for (i = 0; i < num_combs; i++) {
+        hash ^= (MVMuint32)combs[i];
+        hash *= 0x01000193;
+    }
+    return hash ^ (hash >> 15);
+}
+
+/* Checks if a synthetic is made up of the specified codepoints. */
+static MVMint32 synthetic_matches(const MVMNFGSynthetic *synth, const MVMCodepoint32 *codes, MVMint32 num_codes) {
+    return synth->num_combs == num_codes - 1 && synth->base == codes[0]
+        && memcmp(synth->combs, codes + 1, synth->num_combs * sizeof(MVMCodepoint32)) == 0;
+}
+
+/* Looks for the synthetic for a sequence of codepoints, returning its index
+ * plus one, or zero if there isn't one. The synthetics are only loaded once
+ * a slot has been found, so that they can't be older than the table. */
+static MVMint32 find_synthetic(MVMNFGState *nfg, const MVMCodepoint32 *codes, MVMint32 num_codes, MVMuint32 hash) {
+    MVMNFGTable *table = (MVMNFGTable *)MVM_load(&nfg->table);
+    MVMuint32    mask  = table->num_slots - 1;
+    MVMuint32    slot  = hash & mask;
+    MVMint32     found;
+    while ((found = table->slots[slot])) {
+        MVMNFGSynthetic *synthetics = (MVMNFGSynthetic *)MVM_load(&nfg->synthetics);
+        if (synthetic_matches(&synthetics[found - 1], codes, num_codes))
+            return found;
+        slot = (slot + 1) & mask;
+    }
+    return 0;
+}
+
+/* Puts a synthetic's index plus one into a free slot in a table. */
+static void table_insert(MVMNFGTable *table, MVMuint32 hash, MVMint32 value) {
+    MVMuint32 mask = table->num_slots - 1;
+    MVMuint32 slot = hash & mask;
+    while (table->slots[slot])
+        slot = (slot + 1) & mask;
+    table->slots[slot] = value;
+    table->num_used++;
+}
+
+/* Adds a synthetic for a sequence of codepoints; must be called with the
+ * update mutex held. Everything is written before it's published, so that
+ * readers never see it half done. */
+static MVMint32 add_synthetic(MVMThreadContext *tc, MVMNFGState *nfg, const MVMCodepoint32 *codes, MVMint32 num_codes, MVMuint32 hash) {
+    MVMNFGSynthetic *synth;
+    MVMNFGTable     *table = nfg->table;
+    MVMint32         value;
+
+    if (nfg->num_synthetics >= (MVMuint32)0x7FFFFFFE)
+        MVM_exception_throw_adhoc(tc, "Too many synthetic graphemes");
+
+    if (nfg->num_synthetics == nfg->alloc_synthetics) {
+        MVMNFGSynthetic *old = nfg->synthetics;
+        MVMNFGSynthetic *new = malloc(nfg->alloc_synthetics * 2 * sizeof(MVMNFGSynthetic));
+        memcpy(new, old, nfg->num_synthetics * sizeof(MVMNFGSynthetic));
+        nfg->alloc_synthetics *= 2;
+        MVM_store(&nfg->synthetics, new);
+        retire(nfg, old);
+    }
+    synth            = &nfg->synthetics[nfg->num_synthetics];
+    synth->base      = codes[0];
+    synth->num_combs = num_codes - 1;
+    synth->combs     = malloc(synth->num_combs * sizeof(MVMCodepoint32));
+    memcpy(synth->combs, codes + 1, synth->num_combs * sizeof(MVMCodepoint32));
+    value = (MVMint32)++nfg->num_synthetics;
+    MVM_barrier();
+
+    /* Keep the table at most half full; a bigger one is filled in before
+     * being put in place of the current one. */
+    if ((table->num_used + 1) * 2 > table->num_slots) {
+        MVMNFGTable *bigger = calloc(1, sizeof(MVMNFGTable));
+        MVMuint32    i;
+        bigger->num_slots = table->num_slots * 2;
+        bigger->slots     = calloc(bigger->num_slots, sizeof(MVMint32));
+        for (i = 0; i < nfg->num_synthetics; i++) {
+            MVMNFGSynthetic *s = &nfg->synthetics[i];
+            table_insert(bigger, hash_codes(s->base, s->combs, s->num_combs), (MVMint32)i + 1);
+        }
+        MVM_store(&nfg->table, bigger);
+        retire(nfg, table->slots);
+        retire(nfg, table);
+    }
+    else {
+        table_insert(table, hash, value);
+    }
+    return value;
+}
+
+/* Gets the grapheme for a sequence of codepoints, which must already be in
+ * NFC and make up a single grapheme cluster. A single codepoint is its own
+ * grapheme; otherwise, the synthetic for it is found, or made if there is
+ * none yet. Finding one takes no lock. */
+MVMCodepoint32 MVM_nfg_codes_to_grapheme(MVMThreadContext *tc, const MVMCodepoint32 *codes, MVMint32 num_codes) {
+    MVMNFGState *nfg = tc->instance->nfg;
+    MVMuint32    hash;
+    MVMint32     found;
+
+    if (num_codes == 1)
+        return codes[0];
+    if (num_codes < 1)
+        MVM_exception_throw_adhoc(tc, "Cannot make a grapheme from no codepoints");
+
+    hash  = hash_codes(codes[0], codes + 1, num_codes - 1);
+    found = find_synthetic(nfg, codes, num_codes, hash);
+    if (!found) {
+        uv_mutex_lock(&nfg->update_mutex);
+        found = find_synthetic(nfg, codes, num_codes, hash);
+        if (!found)
+            found = add_synthetic(tc, nfg, codes, num_codes, hash);
+        uv_mutex_unlock(&nfg->update_mutex);
+    }
+    return -found;
+}
+
+/* Gets what a synthetic is made up of. The result stays valid for as long
+ * as the instance does. */
+MVMNFGSynthetic * MVM_nfg_get_synthetic_info(MVMThreadContext *tc, MVMCodepoint32 synth) {
+    MVMNFGState     *nfg        = tc->instance->nfg;
+    MVMNFGSynthetic *synthetics = (MVMNFGSynthetic *)MVM_load(&nfg->synthetics);
+    MVMuint32        index      = (MVMuint32)(-(MVMint64)synth) - 1;
+    if (synth >= 0 || index >= nfg->num_synthetics)
+        MVM_exception_throw_adhoc(tc, "Invalid synthetic grapheme %d", synth);
+    return &synthetics[index];
+}
+
+/* Finds the slot for a pair of codepoints in the composition table. */
+static MVMuint32 composition_slot(MVMNFGComposition *compositions, MVMCodepoint32 first, MVMCodepoint32 second) {
+    MVMuint32 mask = MVM_NFG_COMPOSITION_SLOTS - 1;
+    MVMuint32 slot = ((MVMuint32)first * 0x9E3779B1u ^ (MVMuint32)second * 0x85EBCA77u) >> 20 & mask;
+    while (compositions[slot].composed
+            && (compositions[slot].first != first || compositions[slot].second != second))
+        slot = (slot + 1) & mask;
+    return slot;
+}
+
+/* Builds the composition table from the canonical decompositions of two
+ * codepoints, other than those excluded from composition. Nothing beyond
+ * the supplementary ideographic plane has a canonical decomposition. */
+static MVMNFGComposition * build_compositions(MVMThreadContext *tc) {
+    MVMNFGComposition *compositions = calloc(MVM_NFG_COMPOSITION_SLOTS, sizeof(MVMNFGComposition));
+    MVMCodepoint32     cp;
+    for (cp = 0xC0; cp < 0x30000; cp++) {
+        const char     *spec;
+        char           *end;
+        MVMCodepoint32  first, second;
+        MVMuint32       slot;
+        if (MVM_unicode_codepoint_get_property_int(tc, cp, MVM_UNICODE_PROPERTY_DECOMPOSITION_TYPE) != UPV_Canonical)
+            continue;
+        if (MVM_unicode_codepoint_get_property_int(tc, cp, MVM_UNICODE_PROPERTY_FULL_COMPOSITION_EXCLUSION))
+            continue;
+        spec  = MVM_unicode_codepoint_get_property_cstr(tc, cp, MVM_UNICODE_PROPERTY_DECOMP_SPEC);
+        first = (MVMCodepoint32)strtol(spec, &end, 16);
+        if (end == spec || !*end)
+            continue;
+        spec   = end;
+        second = (MVMCodepoint32)strtol(spec, &end, 16);
+        if (end == spec || *end)
+            continue;
+        slot = composition_slot(compositions, first, second);
+        compositions[slot].first    = first;
+        compositions[slot].second   = second;
+        compositions[slot].composed = cp;
+    }
+    return compositions;
+}
+
+/* Gets what a pair of codepoints canonically composes to, or 0 if they
+ * don't compose. */
+static MVMCodepoint32 compose_pair(MVMThreadContext *tc, MVMCodepoint32 first, MVMCodepoint32 second) {
+    MVMNFGState       *nfg = tc->instance->nfg;
+    MVMNFGComposition *compositions;
+
+    /* Hangul L + V and LV + T. */
+    if (first >= HANGUL_L_BASE && first < HANGUL_L_BASE + HANGUL_L_COUNT
+            && second >= HANGUL_V_BASE && second < HANGUL_V_BASE + HANGUL_V_COUNT)
+        return HANGUL_S_BASE + ((first - HANGUL_L_BASE) * HANGUL_V_COUNT
+            + (second - HANGUL_V_BASE)) * HANGUL_T_COUNT;
+    if (first >= HANGUL_S_BASE && first < HANGUL_S_BASE + HANGUL_S_COUNT
+            && (first - HANGUL_S_BASE) % HANGUL_T_COUNT == 0
+            && second > HANGUL_T_BASE && second < HANGUL_T_BASE + HANGUL_T_COUNT)
+        return first + (second - HANGUL_T_BASE);
+
+    compositions = (MVMNFGComposition *)MVM_load(&nfg->compositions);
+    if (!compositions) {
+        uv_mutex_lock(&nfg->update_mutex);
+        compositions = nfg->compositions;
+        if (!compositions) {
+            compositions = build_compositions(tc);
+            MVM_store(&nfg->compositions, compositions);
+        }
+        uv_mutex_unlock(&nfg->update_mutex);
+    }
+    return compositions[composition_slot(compositions, first, second)].composed;
+}
+
+/* A buffer of codepoints being normalized, along with their combining
+ * classes. */
+typedef struct MVMNFGBuffer {
+    MVMCodepoint32 *codes;
+    MVMuint8       *cccs;
+    MVMint64        num;
+    MVMint64        alloc;
+} MVMNFGBuffer;
+
+static void buffer_push(MVMThreadContext *tc, MVMNFGBuffer *buf, MVMCodepoint32 cp) {
+    if (buf->num == buf->alloc) {
+        buf->alloc *= 2;
+        buf->codes  = realloc(buf->codes, buf->alloc * sizeof(MVMCodepoint32));
+        buf->cccs   = realloc(buf->cccs, buf->alloc);
+    }
+    buf->codes[buf->num] = cp;
+    buf->cccs[buf->num]  = ccc(tc, cp);
+    buf->num++;
+}
+
+/* Adds the full canonical decomposition of a codepoint to the buffer. A
+ * synthetic is taken apart into its codepoints, which are decomposed in
+ * turn, as they may reorder or compose with what's around them. */
+static void decompose(MVMThreadContext *tc, MVMNFGBuffer *buf, MVMCodepoint32 cp) {
+    if (cp < 0) {
+        MVMNFGSynthetic *synth = MVM_nfg_get_synthetic_info(tc, cp);
+        MVMint32 i;
+        decompose(tc, buf, synth->base);
+        for (i = 0; i < synth->num_combs; i++)
+            decompose(tc, buf, synth->combs[i]);
+    }
+    else if (cp >= HANGUL_S_BASE && cp < HANGUL_S_BASE + HANGUL_S_COUNT) {
+        MVMint32 index = cp - HANGUL_S_BASE;
+        buffer_push(tc, buf, HANGUL_L_BASE + index / HANGUL_N_COUNT);
+        buffer_push(tc, buf, HANGUL_V_BASE + index % HANGUL_N_COUNT / HANGUL_T_COUNT);
+        if (index % HANGUL_T_COUNT)
+            buffer_push(tc, buf, HANGUL_T_BASE + index % HANGUL_T_COUNT);
+    }
+    else if (cp >= 0xC0 && MVM_unicode_codepoint_get_property_int(tc, cp,
+            MVM_UNICODE_PROPERTY_DECOMPOSITION_TYPE) == UPV_Canonical) {
+        const char *spec = MVM_unicode_codepoint_get_property_cstr(tc, cp,
+            MVM_UNICODE_PROPERTY_DECOMP_SPEC);
+        char *end;
+        while (spec && *spec) {
+            MVMCodepoint32 part = (MVMCodepoint32)strtol(spec, &end, 16);
+            if (end == spec)
+                break;
+            decompose(tc, buf, part);
+            spec = end;
+        }
+    }
+    else {
+        buffer_push(tc, buf, cp);
+    }
+}
+
+/* Puts each run of combining marks into canonical order; a stable sort by
+ * combining class. */
+static void canonical_order(MVMNFGBuffer *buf) {
+    MVMint64 i, j;
+    for (i = 1; i < buf->num; i++) {
+        MVMuint8       cc = buf->cccs[i];
+        MVMCodepoint32 cp = buf->codes[i];
+        if (cc == 0)
+            continue;
+        for (j = i; j > 0 && buf->cccs[j - 1] > cc; j--) {
+            buf->codes[j] = buf->codes[j - 1];
+            buf->cccs[j]  = buf->cccs[j - 1];
+        }
+        buf->codes[j] = cp;
+        buf->cccs[j]  = cc;
+    }
+}
+
+/* Canonically composes the buffer in place. A codepoint composes with the
+ * last starter if nothing between them blocks it, which is when what's
+ * between has a lower combining class, or there's nothing between them. */
+static void canonical_compose(MVMThreadContext *tc, MVMNFGBuffer *buf) {
+    MVMint64 starter = -1, out = 0, i;
+    MVMuint8 last_cc = 0;
+    for (i = 0; i < buf->num; i++) {
+        MVMCodepoint32 cp = buf->codes[i];
+        MVMuint8       cc = buf->cccs[i];
+        if (starter >= 0 && (out == starter + 1 || (last_cc != 0 && last_cc < cc))) {
+            MVMCodepoint32 composed = compose_pair(tc, buf->codes[starter], cp);
+            if (composed) {
+                buf->codes[starter] = composed;
+                continue;
+            }
+        }
+        if (cc == 0) {
+            starter = out;
+            last_cc = 0;
+        }
+        else {
+            last_cc = cc;
+        }
+        buf->codes[out] = cp;
+        buf->cccs[out]  = cc;
+        out++;
+    }
+    buf->num = out;
+}
+
+/* Normalizes a sequence of codepoints to NFG, giving a new array of the
+ * graphemes and how many there are. Synthetics may be included in the
+ * input; they're taken apart and normalized along with the rest. */
+MVMCodepoint32 * MVM_nfg_normalize(MVMThreadContext *tc, const MVMCodepoint32 *codes, MVMint64 num_codes, MVMint64 *num_graphs) {
+    MVMNFGBuffer    buf;
+    MVMCodepoint32 *graphs;
+    MVMint64        i, start = 0, found = 0;
+    MVMuint8        prev_kind = GCB_OTHER;
+
+    buf.num   = 0;
+    buf.alloc = num_codes + 8;
+    buf.codes = malloc(buf.alloc * sizeof(MVMCodepoint32));
+    buf.cccs  = malloc(buf.alloc);
+    for (i = 0; i < num_codes; i++)
+        decompose(tc, &buf, codes[i]);
+    canonical_order(&buf);
+    canonical_compose(tc, &buf);
+
+    /* Split it into grapheme clusters. */
+    graphs = malloc(buf.num ? buf.num * sizeof(MVMCodepoint32) : 1);
+    for (i = 0; i < buf.num; i++) {
+        MVMuint8 kind = gcb_kind(tc, buf.codes[i]);
+        if (i > 0 && is_boundary(prev_kind, kind)) {
+            graphs[found++] = MVM_nfg_codes_to_grapheme(tc, buf.codes + start, (MVMint32)(i - start));
+            start = i;
+        }
+        prev_kind = kind;
+    }
+    if (buf.num)
+        graphs[found++] = MVM_nfg_codes_to_grapheme(tc, buf.codes + start, (MVMint32)(buf.num - start));
+
+    free(buf.codes);
+    free(buf.cccs);
+    *num_graphs = found;
+    return graphs;
+}
+
+/* Checks if a sequence of decoded codepoints has anything in it that
+ * MVM_nfg_normalize may need to do something about. */
+MVMint64 MVM_nfg_needs_normalization(MVMThreadContext *tc, const MVMCodepoint32 *codes, MVMint64 num_codes) {
+    MVMint64 i;
+    for (i = 0; i < num_codes; i++)
+        if (codes[i] >= MVM_NFG_QUICK_CHECK_MIN)
+            return 1;
+    return 0;
+}
+
+/* Checks if two graphemes stay as they are when put next to each other, so
+ * that strings ending and starting with them can be concatenated as they
+ * are. If the second can't start a cluster after the first, they have to
+ * be normalized together. Anything that canonically composes with what's
+ * before it also extends a grapheme, so that needn't be checked for. */
+MVMint64 MVM_nfg_is_concat_stable(MVMThreadContext *tc, MVMCodepoint32 last, MVMCodepoint32 first) {
+    if (first >= 0 && first < MVM_NFG_QUICK_CHECK_MIN)
+        return 1;
+    if (last < 0) {
+        MVMNFGSynthetic *synth = MVM_nfg_get_synthetic_info(tc, last);
+        last = synth->num_combs ? synth->combs[synth->num_combs - 1] : synth->base;
+    }
+    first = MVM_nfg_base_codepoint(tc, first);
+    return ccc(tc, first) == 0 && is_boundary(gcb_kind(tc, last), gcb_kind(tc, first));
+}
+
+/* Changes the case of a synthetic, which is done to its base. If that
+ * gives something that isn't a single grapheme, it's left alone. */
+MVMCodepoint32 MVM_nfg_get_case_change(MVMThreadContext *tc, MVMCodepoint32 synth, MVMint32 case_) {
+    MVMNFGSynthetic *info = MVM_nfg_get_synthetic_info(tc, synth);
+    MVMCodepoint32   base = MVM_unicode_get_case_change(tc, info->base, case_);
+    MVMCodepoint32  *codes, *graphs, result = synth;
+    MVMint64         num_graphs;
+    if (base == info->base)
+        return synth;
+    codes = malloc((info->num_combs + 1) * sizeof(MVMCodepoint32));
+    codes[0] = base;
+    memcpy(codes + 1, info->combs, info->num_combs * sizeof(MVMCodepoint32));
+    graphs = MVM_nfg_normalize(tc, codes, info->num_combs + 1, &num_graphs);
+    if (num_graphs == 1)
+        result = graphs[0];
+    free(graphs);
+    free(codes);
+    return result;
+}
+
+/* Compares two different graphemes by the codepoints they're made of,
+ * returning -1 or 1. */
+MVMint64 MVM_nfg_compare(MVMThreadContext *tc, MVMCodepoint32 a, MVMCodepoint32 b) {
+    MVMNFGSynthetic *sa = a < 0 ? MVM_nfg_get_synthetic_info(tc, a) : NULL;
+    MVMNFGSynthetic *sb = b < 0 ? MVM_nfg_get_synthetic_info(tc, b) : NULL;
+    MVMCodepoint32   base_a = sa ? sa->base : a;
+    MVMCodepoint32   base_b = sb ? sb->base : b;
+    MVMint32         num_a  = sa ? sa->num_combs : 0;
+    MVMint32         num_b  = sb ? sb->num_combs : 0;
+    MVMint32         i;
+    if (base_a != base_b)
+        return base_a < base_b ? -1 : 1;
+    for (i = 0; i < num_a && i < num_b; i++)
+        if (sa->combs[i] != sb->combs[i])
+            return sa->combs[i] < sb->combs[i] ? -1 : 1;
+    return num_a < num_b ? -1 : 1;
+}
@@ -0,0 +1,84 @@
+/* NFG (Normal Form Grapheme) is the form strings are kept in: normalized
+ * to NFC, and then with each grapheme cluster that is more than a single
+ * codepoint replaced by a synthetic. Synthetics are negative numbers, and
+ * are handed out per instance, so each grapheme is a single element of a
+ * string and indexing by grapheme stays O(1). Codepoints below
+ * MVM_NFG_QUICK_CHECK_MIN never need anything doing to them, so decoders
+ * only call in here once they see one that isn't.
+ *
+ * One deliberate difference from UAX #29: CR LF is left as two graphemes,
+ * so that line separators and the rest of the I/O layer can go on working
+ * with codepoints. */
+
+/* The lowest codepoint that can decompose, compose with what's before it,
+ * or extend a grapheme. Everything below it is its own grapheme. */
+#define MVM_NFG_QUICK_CHECK_MIN 0x300
+
+/* A synthetic; a grapheme made up of a base codepoint and the combining
+ * codepoints that follow it. */
+struct MVMNFGSynthetic {
+    MVMCodepoint32  base;
+    MVMint32        num_combs;
+    MVMCodepoint32 *combs;
+};
+
+/* Table for finding the synthetic for a sequence of codepoints. It's open
+ * addressed, and each slot holds a synthetic's index plus one, or zero if
+ * it's empty. Readers don't take any lock, so once a table is in use, the
+ * only change made to it is filling an empty slot. */
+struct MVMNFGTable {
+    MVMint32  *slots;
+    MVMuint32  num_slots;
+    MVMuint32  num_used;
+};
+
+/* A pair of codepoints that canonically compose, and what they compose to. */
+struct MVMNFGComposition {
+    MVMCodepoint32 first;
+    MVMCodepoint32 second;
+    MVMCodepoint32 composed;
+};
+
+/* The per-instance NFG state. */
+struct MVMNFGState {
+    /* The synthetics, and the table to find them by their codepoints. When
+     * either outgrows its storage, it's copied into bigger storage and the
+     * old is kept until the instance goes away, as there may be a reader
+     * still looking at it. */
+    MVMNFGSynthetic *synthetics;
+    MVMuint32        num_synthetics;
+    MVMuint32        alloc_synthetics;
+    MVMNFGTable     *table;
+
+    /* Storage that has been replaced, to be freed along with the state. */
+    void      **retired;
+    MVMuint32   num_retired;
+    MVMuint32   alloc_retired;
+
+    /* The canonical compositions, built the first time some are needed;
+     * MVM_NFG_COMPOSITION_SLOTS of them, open addressed. */
+    MVMNFGComposition *compositions;
+
+    /* Held while adding a synthetic or building the compositions. */
+    uv_mutex_t update_mutex;
+};
+
+/* The number of slots the composition table has; comfortably more than
+ * there are compositions. */
+#define MVM_NFG_COMPOSITION_SLOTS 4096
+
+/* Functions. */
+void MVM_nfg_init(MVMThreadContext *tc);
+void MVM_nfg_destroy(MVMThreadContext *tc);
+MVMCodepoint32 MVM_nfg_codes_to_grapheme(MVMThreadContext *tc, const MVMCodepoint32 *codes, MVMint32 num_codes);
+MVMNFGSynthetic * MVM_nfg_get_synthetic_info(MVMThreadContext *tc, MVMCodepoint32 synth);
+MVMCodepoint32 * MVM_nfg_normalize(MVMThreadContext *tc, const MVMCodepoint32 *codes, MVMint64 num_codes, MVMint64 *num_graphs);
+MVMint64 MVM_nfg_needs_normalization(MVMThreadContext *tc, const MVMCodepoint32 *codes, MVMint64 num_codes);
+MVMint64 MVM_nfg_is_concat_stable(MVMThreadContext *tc, MVMCodepoint32 last, MVMCodepoint32 first);
+MVMCodepoint32 MVM_nfg_get_case_change(MVMThreadContext *tc, MVMCodepoint32 synth, MVMint32 case_);
+MVMint64 MVM_nfg_compare(MVMThreadContext *tc, MVMCodepoint32 a, MVMCodepoint32 b);
+
+/* Gets the codepoint a grapheme starts with; for a synthetic, its base. */
+MVM_STATIC_INLINE MVMCodepoint32 MVM_nfg_base_codepoint(MVMThreadContext *tc, MVMCodepoint32 g) {
+    return g < 0 ? MVM_nfg_get_synthetic_info(tc, g)->base : g;
+}
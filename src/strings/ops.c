@@ -1,16 +1,6 @@
 #include "moar.h"
 
 /*  TODO:
-- add a tunable global determining at what depth it should
-    start flattening.  Write a rope-tree-flattening function
-    (not like string_flatten) that puts all the sub strands
-    in one MVMStrand array.
-    (optimization)
-- add a tunable global determining under which size result
-    string should it just do the old copying behavior, for
-    join, concat, split, and repeat.
-    This might be related to MVMString object size?
-    (optimization)
 - make the uc, lc, tc functions intelligently
     create ropes from the originals when deemed advantageous.
     (optimization)
@@ -46,13 +36,34 @@ MVMuint8 MVM_string_traverse_substring(MVMThreadContext *tc, MVMString *a, MVMSt
                 /* determine how many codepoints to actually consume */
                 if (length < substring_length)
                     substring_length = length;
-                /* call ourself on the sub-strand */
-                return_val = MVM_string_traverse_substring(tc, strand->string,
-                    index - strand->compare_offset + strand->string_offset,
-                    substring_length, top_index + index, consumer, data);
-                /* if we've been instructed to, abort early */
-                if (return_val)
-                    return return_val;
+                if (strand->repeat_count > 1) {
+                    /* go through the repeated piece once per repetition,
+                     * starting partway into it if need be. */
+                    MVMStringIndex unit = (strands[strand_index + 1].compare_offset
+                        - strand->compare_offset) / strand->repeat_count;
+                    MVMStringIndex done = 0;
+                    while (done < substring_length) {
+                        MVMStringIndex piece_offset = (index + done - strand->compare_offset) % unit;
+                        MVMStringIndex piece_length = unit - piece_offset;
+                        if (piece_length > substring_length - done)
+                            piece_length = substring_length - done;
+                        return_val = MVM_string_traverse_substring(tc, strand->string,
+                            strand->string_offset + piece_offset, piece_length,
+                            top_index + index + done, consumer, data);
+                        if (return_val)
+                            return return_val;
+                        done += piece_length;
+                    }
+                }
+                else {
+                    /* call ourself on the sub-strand */
+                    return_val = MVM_string_traverse_substring(tc, strand->string,
+                        index - strand->compare_offset + strand->string_offset,
+                        substring_length, top_index + index, consumer, data);
+                    /* if we've been instructed to, abort early */
+                    if (return_val)
+                        return return_val;
+                }
                 /* reduce the number of codepoints requested by the number
                  * consumed. */
                 length -= substring_length;
@@ -73,27 +84,6 @@ MVMuint8 MVM_string_traverse_substring(MVMThreadContext *tc, MVMString *a, MVMSt
     MVM_exception_throw_adhoc(tc, "internal string corruption");
 }
 
-/* stack record created with each invocation of the string descent. */
-typedef struct CompareCursor {
-    MVMString *string; /* string into which descended */
-    struct CompareCursor *parent; /* parent cursor */
-    MVMint16 *gaps; /* number of gaps can ascend */
-    MVMStringIndex string_idx; /* in string, not strand */
-    MVMStringIndex end_idx; /* index past last codepoint needed */
-    MVMStrandIndex strand_idx; /* current strand index */
-    MVMuint8 owns_buffer; /* whether it owns the last buffer.
-            for ropes, whether it's uninitialized. */
-    MVMuint8 isa; /* whether it's from string tree a */
-} CompareCursor;
-
-typedef struct {
-    CompareCursor *cursora, *cursorb; /* cursors */
-    MVMCodepoint32 *int32s; /* last physical string's buffer */
-    MVMCodepoint8 *uint8s; /* last physical string's buffer */
-    MVMStringIndex available; /* number of codepoints in the buffer */
-    MVMStringIndex needed; /* number of codepoints still needed */
-} CompareDescentState;
-
 /* uses the computed binary search table to find the strand containing the index */
 static MVMStrandIndex find_strand_index(MVMString *s, MVMStringIndex index) {
     MVMStrand *strands = s->body.strands;
@@ -107,138 +97,102 @@ static MVMStrandIndex find_strand_index(MVMString *s, MVMStringIndex index) {
     }
 }
 
-#define descend_sized_chew_success(member, other_member) \
-st->needed -= tocompare; \
-if (!st->needed) { \
-    *result = 2; \
-    return; \
-} \
-else if (wehave > tocompare) { \
-    st->member = c->string->body.member + c->string_idx + tocompare; \
-    st->available = wehave - tocompare; \
-    c->owns_buffer = 1; \
-    st->other_member = NULL; \
-} \
-else { \
-    st->other_member += tocompare; \
-    st->available -= tocompare; \
-} \
+/* Sets a cursor up on the piece of its current strand covering the given
+ * offset into that strand. */
+static void cursor_enter_strand(MVMStringCursor *cursor, MVMStringIndex offset) {
+    MVMStrand     *strand = &cursor->string->body.strands[cursor->strand_idx];
+    MVMStringIndex unit   = (strand[1].compare_offset - strand->compare_offset)
+        / strand->repeat_count;
+    cursor->flat         = strand->string;
+    cursor->piece_start  = strand->string_offset;
+    cursor->piece_length = unit;
+    cursor->pos          = offset % unit;
+    cursor->repeats_left = strand->repeat_count - 1 - offset / unit;
+}
 
-#define descend_sized(member, other_member, size, other_size, cp, other_cp) \
-MVMStringIndex wehave = c->end_idx - c->string_idx; \
-if (st->available) { \
-    MVMStringIndex tocompare = st->available < wehave ? st->available : wehave; \
-    if (st->member) { \
-        if (memcmp(st->member, c->string->body.member + c->string_idx, \
-               wehave * sizeof(size))) { \
-            *result = 1; \
-            return; \
-        } \
-        descend_sized_chew_success(member, other_member) \
-    } \
-    else { \
-        size \
-            *cp = c->string->body.member + c->string_idx, \
-            *final = cp + tocompare; \
-        other_size *other_cp = st->other_member; \
-        for (; cp < final; ) { \
-            if (*cp32++ != (MVMCodepoint32) *cp8++) { \
-                *result = 1; \
-                return; \
-            } \
-        } \
-        descend_sized_chew_success(other_member, member) \
-    } \
-    if (c->isa) { st->cursora = c->parent; } \
-    else { st->cursorb = c->parent; } \
-    return; \
-} \
-st->member = c->string->body.member + c->string_idx; \
-st->other_member = NULL; \
-st->available = wehave; \
-c->owns_buffer = 1; \
-continue;
-
-/* If a is composed of strands, create a descent record, initialize it, and
- * descend into the substring. If result is set when it returns, return.
- * If a is a real string, grab some codepoints from a string, compare
- * with codepoints from the other buffer. If different, set result nonzero and
- * it will fast return. Otherwise, reset buffer indexes
- * to zero. Loop if `needed` for the current string is nonzero. */
-static void compare_descend(MVMThreadContext *tc, CompareDescentState *st,
-        MVMuint8 *result, CompareCursor *orig) {
-    /* while we still need to compare some things */
-    while (st->needed) {
-        /* pick a tree from which to get more characters. */
-        CompareCursor *c = st->cursora->owns_buffer ? st->cursorb : st->cursora;
-
-        if (*c->gaps) {
-            (*c->gaps)--;
-            if (c->isa) { st->cursora = c->parent; }
-            else { st->cursorb = c->parent; }
-            return;
-        }
+/* Sets up a cursor to go through length codepoints of a string, starting
+ * at start. Doesn't check bounds. */
+void MVM_string_cursor_init(MVMThreadContext *tc, MVMStringCursor *cursor, MVMString *s, MVMStringIndex start, MVMStringIndex length) {
+    cursor->string       = s;
+    cursor->strand_idx   = 0;
+    cursor->repeats_left = 0;
+    cursor->remaining    = length;
+    if (IS_ROPE(s) && length) {
+        cursor->strand_idx = find_strand_index(s, start);
+        cursor_enter_strand(cursor, start - s->body.strands[cursor->strand_idx].compare_offset);
+    }
+    else {
+        cursor->flat         = s;
+        cursor->piece_start  = start;
+        cursor->piece_length = IS_ROPE(s) ? 0 : length;
+        cursor->pos          = 0;
+    }
+}
 
-        /* get some characters, comparing as they're found */
-        switch(STR_FLAGS(c->string)) {
-            case MVM_STRING_TYPE_INT32: {
-                descend_sized(int32s, uint8s, MVMCodepoint32, MVMCodepoint8, cp32, cp8)
-            }
-            case MVM_STRING_TYPE_UINT8: {
-                descend_sized(uint8s, int32s, MVMCodepoint8, MVMCodepoint32, cp8, cp32)
-            }
-            case MVM_STRING_TYPE_ROPE: {
-                MVMStrand *strand;
-                MVMStringIndex next_compare_offset, child_length, child_idx, child_end_idx;
-                if (c->owns_buffer) { /* first time we've seen this rope */
-                    c->strand_idx = find_strand_index(c->string, c->string_idx);
-                    c->owns_buffer = 0;
-                }
-                if (c->string_idx == c->end_idx) {
-                    if (c->isa) { st->cursora = c->parent; }
-                    else { st->cursorb = c->parent; }
-                    if (orig == c)
-                        return;
-                    (*c->gaps)++;
-                    continue;
-                }
-                strand = c->string->body.strands + c->strand_idx;
-                child_idx = c->string_idx - strand->compare_offset;
-                next_compare_offset = (strand + 1)->compare_offset;
-                child_length = next_compare_offset - strand->compare_offset;
-                child_length = child_length > c->end_idx - c->string_idx
-                    ? c->end_idx - c->string_idx : child_length;
-                child_end_idx = child_idx + child_length;
-                c->string_idx += child_length;
-                c->strand_idx++;
-                {
-                    CompareCursor child = { strand->string, c, c->gaps, child_idx,
-                        child_end_idx, 0, IS_ROPE(strand->string), c->isa };
-                    if (c->isa) { st->cursora = &child; } else { st->cursorb = &child; }
-                    compare_descend(tc, st, result, &child);
-                }
-                if (*result) return;
-                continue;
-            }
-            default:
-                MVM_exception_throw_adhoc(tc, "internal string corruption");
-        }
+/* Moves a cursor on to the next piece, when it's at the end of the current
+ * one: the next repetition of it, or else the next strand. */
+void MVM_string_cursor_next_piece(MVMThreadContext *tc, MVMStringCursor *cursor) {
+    if (cursor->repeats_left) {
+        cursor->repeats_left--;
+        cursor->pos = 0;
+    }
+    else if (IS_ROPE(cursor->string) && cursor->strand_idx + 1 < cursor->string->body.num_strands) {
+        cursor->strand_idx++;
+        cursor_enter_strand(cursor, 0);
+    }
+    else {
+        MVM_exception_throw_adhoc(tc, "Iteration past end of string");
     }
-    *result = 2;
 }
 
-/* returns nonzero if two substrings are equal, doesn't check bounds */
+/* Makes sure a cursor's current piece has codepoints left in it, and returns
+ * how many it has, up to the number still to be gone through. */
+static MVMStringIndex cursor_run(MVMThreadContext *tc, MVMStringCursor *cursor) {
+    MVMStringIndex run;
+    if (cursor->pos == cursor->piece_length)
+        MVM_string_cursor_next_piece(tc, cursor);
+    run = cursor->piece_length - cursor->pos;
+    return run < cursor->remaining ? run : cursor->remaining;
+}
+
+/* Checks if runs of codepoints in two flat strings are the same. */
+static MVMint64 runs_equal(MVMString *a, MVMStringIndex starta, MVMString *b, MVMStringIndex startb, MVMStringIndex length) {
+    MVMStringIndex i;
+    if (IS_WIDE(a)) {
+        if (IS_WIDE(b))
+            return memcmp(a->body.int32s + starta, b->body.int32s + startb,
+                length * sizeof(MVMCodepoint32)) == 0;
+        for (i = 0; i < length; i++)
+            if (a->body.int32s[starta + i] != (MVMCodepoint32)b->body.uint8s[startb + i])
+                return 0;
+        return 1;
+    }
+    if (IS_WIDE(b))
+        return runs_equal(b, startb, a, starta, length);
+    return memcmp(a->body.uint8s + starta, b->body.uint8s + startb, length) == 0;
+}
+
+/* returns nonzero if two substrings are equal, doesn't check bounds. The
+ * strings are compared a run at a time, a run being as much as both have in
+ * their current pieces. */
 MVMint64 MVM_string_substrings_equal_nocheck(MVMThreadContext *tc, MVMString *a,
         MVMint64 starta, MVMint64 length, MVMString *b, MVMint64 startb) {
-    MVMint16 gapsa = 0, gapsb = 0;
-    MVMuint8 result = 0;
-    CompareCursor
-        cursora = { a, NULL, &gapsa, starta, starta + length, 0, IS_ROPE(a), 1 },
-        cursorb = { b, NULL, &gapsb, startb, startb + length, 0, IS_ROPE(b), 0 };
-    CompareDescentState st = { &cursora, &cursorb, NULL, NULL, 0, length };
-
-    compare_descend(tc, &st, &result, &cursora);
-    return result ? result - 1 : 1;
+    MVMStringCursor cursora, cursorb;
+    MVM_string_cursor_init(tc, &cursora, a, starta, length);
+    MVM_string_cursor_init(tc, &cursorb, b, startb, length);
+    while (cursora.remaining) {
+        MVMStringIndex runa = cursor_run(tc, &cursora);
+        MVMStringIndex runb = cursor_run(tc, &cursorb);
+        MVMStringIndex run  = runa < runb ? runa : runb;
+        if (!runs_equal(cursora.flat, cursora.piece_start + cursora.pos,
+                cursorb.flat, cursorb.piece_start + cursorb.pos, run))
+            return 0;
+        cursora.pos += run;
+        cursora.remaining -= run;
+        cursorb.pos += run;
+        cursorb.remaining -= run;
+    }
+    return 1;
 }
 
 /* returns the codepoint without doing checks, for internal VM use only. */
@@ -252,19 +206,257 @@ MVMCodepoint32 MVM_string_get_codepoint_at_nocheck(MVMThreadContext *tc, MVMStri
             return (MVMCodepoint32)a->body.uint8s[idx];
         case MVM_STRING_TYPE_ROPE: {
             MVMStrand *strand = a->body.strands + find_strand_index(a, idx);
+            MVMStringIndex offset = idx - strand->compare_offset;
+            if (strand->repeat_count > 1)
+                offset %= (strand[1].compare_offset - strand->compare_offset) / strand->repeat_count;
             return MVM_string_get_codepoint_at_nocheck(tc,
-                strand->string, idx - strand->compare_offset + strand->string_offset);
+                strand->string, strand->string_offset + offset);
         }
     }
     MVM_exception_throw_adhoc(tc, "internal string corruption");
     return 0;
 }
 
+/* Copies the codepoints of a substring into a buffer, as a substring
+ * consumer; ropes are handled by traversing them. */
+typedef struct MVMGatherState {
+    MVMCodepoint32 *buffer;
+    MVMStringIndex  position;
+} MVMGatherState;
+
+static MVM_SUBSTRING_CONSUMER(gather_consumer) {
+    MVMGatherState *state = (MVMGatherState *)data;
+    MVMStringIndex i;
+    switch (STR_FLAGS(string)) {
+        case MVM_STRING_TYPE_INT32:
+            memcpy(state->buffer + state->position, string->body.int32s + start,
+                length * sizeof(MVMCodepoint32));
+            break;
+        case MVM_STRING_TYPE_UINT8:
+            for (i = 0; i < length; i++)
+                state->buffer[state->position + i] = string->body.uint8s[start + i];
+            break;
+        default:
+            MVM_exception_throw_adhoc(tc, "internal string corruption");
+    }
+    state->position += length;
+    return 0;
+}
+
+/* Gets the codepoints of part of a string into a newly allocated buffer,
+ * without changing how the string itself is stored. */
+static MVMCodepoint32 * gather_codepoints(MVMThreadContext *tc, MVMString *s, MVMStringIndex start, MVMStringIndex length) {
+    MVMGatherState state;
+    state.buffer   = malloc((length ? length : 1) * sizeof(MVMCodepoint32));
+    state.position = 0;
+    if (length)
+        MVM_string_traverse_substring(tc, s, start, length, 0, gather_consumer, &state);
+    return state.buffer;
+}
+
+/* Needles shorter than this are searched for by scanning for their first
+ * codepoint and then comparing the rest; longer ones use Boyer-Moore-Horspool,
+ * whose skip table is indexed by the low byte of each codepoint. */
+#define MVM_STRING_INDEX_SKIP_MIN 4
+
+static const MVMCodepoint8 * find_first_uint8(const MVMCodepoint8 *from, MVMCodepoint8 cp, MVMStringIndex count) {
+    return (const MVMCodepoint8 *)memchr(from, cp, count);
+}
+static const MVMCodepoint32 * find_first_int32(const MVMCodepoint32 *from, MVMCodepoint32 cp, MVMStringIndex count) {
+    const MVMCodepoint32 *end = from + count;
+    for (; from < end; from++)
+        if (*from == cp)
+            return from;
+    return NULL;
+}
+
+/* Defines a function searching forward from start for a needle in a flat
+ * haystack with the same storage type. Returns the index or -1. The caller
+ * ensures that the needle is not empty and fits in the haystack. */
+#define define_index_forward(name, T, find_first) \
+static MVMint64 name(const T *h, MVMStringIndex hgraphs, const T *n, MVMStringIndex ngraphs, MVMStringIndex start) { \
+    MVMStringIndex last = hgraphs - ngraphs; \
+    if (ngraphs < MVM_STRING_INDEX_SKIP_MIN) { \
+        while (start <= last) { \
+            const T *found = find_first(h + start, n[0], last - start + 1); \
+            if (!found) \
+                break; \
+            start = found - h; \
+            if (memcmp(found + 1, n + 1, (ngraphs - 1) * sizeof(T)) == 0) \
+                return (MVMint64)start; \
+            start++; \
+        } \
+    } \
+    else { \
+        MVMStringIndex skip[256], i; \
+        T final = n[ngraphs - 1]; \
+        for (i = 0; i < 256; i++) \
+            skip[i] = ngraphs; \
+        for (i = 0; i < ngraphs - 1; i++) \
+            skip[n[i] & 0xFF] = ngraphs - 1 - i; \
+        while (start <= last) { \
+            T cp = h[start + ngraphs - 1]; \
+            if (cp == final && memcmp(h + start, n, (ngraphs - 1) * sizeof(T)) == 0) \
+                return (MVMint64)start; \
+            start += skip[cp & 0xFF]; \
+        } \
+    } \
+    return -1; \
+}
+
+/* Defines a function searching backward from start, the last position a
+ * match may begin at, in the same way. Here the skip table is keyed on the
+ * first codepoint under the needle, giving the nearest place after the start
+ * of the needle the codepoint could line up with. */
+#define define_index_backward(name, T) \
+static MVMint64 name(const T *h, const T *n, MVMStringIndex ngraphs, MVMStringIndex start) { \
+    MVMStringIndex pos = start; \
+    if (ngraphs < MVM_STRING_INDEX_SKIP_MIN) { \
+        do { \
+            if (h[pos] == n[0] && memcmp(h + pos + 1, n + 1, (ngraphs - 1) * sizeof(T)) == 0) \
+                return (MVMint64)pos; \
+        } while (pos-- > 0); \
+    } \
+    else { \
+        MVMStringIndex skip[256], i; \
+        for (i = 0; i < 256; i++) \
+            skip[i] = ngraphs; \
+        for (i = ngraphs - 1; i > 0; i--) \
+            skip[n[i] & 0xFF] = i; \
+        for (;;) { \
+            T cp = h[pos]; \
+            if (cp == n[0] && memcmp(h + pos + 1, n + 1, (ngraphs - 1) * sizeof(T)) == 0) \
+                return (MVMint64)pos; \
+            if (skip[cp & 0xFF] > pos) \
+                break; \
+            pos -= skip[cp & 0xFF]; \
+        } \
+    } \
+    return -1; \
+}
+
+define_index_forward(index_forward_uint8, MVMCodepoint8, find_first_uint8)
+define_index_forward(index_forward_int32, MVMCodepoint32, find_first_int32)
+define_index_backward(index_backward_uint8, MVMCodepoint8)
+define_index_backward(index_backward_int32, MVMCodepoint32)
+
+/* Gets the needle as 8-bit codepoints, for searching an 8-bit haystack.
+ * Returns NULL if it has codepoints that can't occur there, meaning it
+ * can't be found. Sets *to_free if a buffer was allocated. */
+static MVMCodepoint8 * needle_uint8(MVMThreadContext *tc, MVMString *needle, MVMStringIndex ngraphs, void **to_free) {
+    MVMCodepoint32 *cps;
+    MVMCodepoint8  *result;
+    MVMStringIndex  i;
+    *to_free = NULL;
+    if (IS_ASCII(needle))
+        return needle->body.uint8s;
+    cps    = IS_WIDE(needle) ? needle->body.int32s : gather_codepoints(tc, needle, 0, ngraphs);
+    result = malloc(ngraphs);
+    for (i = 0; i < ngraphs; i++) {
+        if (cps[i] < 0 || cps[i] > 255)
+            break;
+        result[i] = (MVMCodepoint8)cps[i];
+    }
+    if (cps != needle->body.int32s)
+        free(cps);
+    if (i < ngraphs) {
+        free(result);
+        return NULL;
+    }
+    *to_free = result;
+    return result;
+}
+
+/* Gets the needle as 32-bit codepoints. Sets *to_free if a buffer was
+ * allocated. */
+static MVMCodepoint32 * needle_int32(MVMThreadContext *tc, MVMString *needle, MVMStringIndex ngraphs, void **to_free) {
+    if (IS_WIDE(needle)) {
+        *to_free = NULL;
+        return needle->body.int32s;
+    }
+    return (MVMCodepoint32 *)(*to_free = gather_codepoints(tc, needle, 0, ngraphs));
+}
+
+/* State for searching a rope. Since a rope can only be walked through in
+ * order, this uses Knuth-Morris-Pratt, which never needs to look back at
+ * the haystack. */
+typedef struct MVMIndexState {
+    const MVMCodepoint32 *needle;
+    MVMStringIndex        ngraphs;
+    MVMStringIndex       *failure;
+    MVMStringIndex        matched;
+    MVMStringIndex        position;
+    MVMint64              result;
+} MVMIndexState;
+
+#define index_consumer_iterate(member) \
+for (i = 0; i < length; i++) { \
+    MVMCodepoint32 cp = string->body.member[start + i]; \
+    if (!state->matched) { \
+        while (cp != state->needle[0] && ++i < length) \
+            cp = string->body.member[start + i]; \
+        if (i == length) \
+            break; \
+    } \
+    while (state->matched && state->needle[state->matched] != cp) \
+        state->matched = state->failure[state->matched - 1]; \
+    if (state->needle[state->matched] == cp && ++state->matched == state->ngraphs) { \
+        state->result = (MVMint64)(state->position + i + 1 - state->ngraphs); \
+        return 1; \
+    } \
+} \
+break;
+
+static MVM_SUBSTRING_CONSUMER(index_consumer) {
+    MVMIndexState *state = (MVMIndexState *)data;
+    MVMStringIndex i;
+    switch (STR_FLAGS(string)) {
+        case MVM_STRING_TYPE_INT32: {
+            index_consumer_iterate(int32s);
+        }
+        case MVM_STRING_TYPE_UINT8: {
+            index_consumer_iterate(uint8s);
+        }
+        default:
+            MVM_exception_throw_adhoc(tc, "internal string corruption");
+    }
+    state->position += length;
+    return 0;
+}
+
+static MVMint64 index_rope(MVMThreadContext *tc, MVMString *haystack, MVMStringIndex hgraphs,
+        const MVMCodepoint32 *needle, MVMStringIndex ngraphs, MVMStringIndex start) {
+    MVMIndexState  state;
+    MVMStringIndex i, k = 0;
+
+    /* failure[i] is the length of the longest proper prefix of the first
+     * i + 1 codepoints of the needle that is also a suffix of them. */
+    state.failure    = malloc(ngraphs * sizeof(MVMStringIndex));
+    state.failure[0] = 0;
+    for (i = 1; i < ngraphs; i++) {
+        while (k && needle[i] != needle[k])
+            k = state.failure[k - 1];
+        if (needle[i] == needle[k])
+            k++;
+        state.failure[i] = k;
+    }
+
+    state.needle   = needle;
+    state.ngraphs  = ngraphs;
+    state.matched  = 0;
+    state.position = start;
+    state.result   = -1;
+    MVM_string_traverse_substring(tc, haystack, start, hgraphs - start, 0,
+        index_consumer, &state);
+    free(state.failure);
+    return state.result;
+}
+
 /* Returns the location of one string in another or -1  */
 MVMint64 MVM_string_index(MVMThreadContext *tc, MVMString *haystack, MVMString *needle, MVMint64 start) {
     MVMint64 result = -1;
-    size_t index    = (size_t)start;
     MVMStringIndex hgraphs = NUM_GRAPHS(haystack), ngraphs = NUM_GRAPHS(needle);
+    void *to_free;
 
     if (!IS_CONCRETE((MVMObject *)haystack)) {
         MVM_exception_throw_adhoc(tc, "index needs a concrete search target");
@@ -285,22 +477,35 @@ MVMint64 MVM_string_index(MVMThreadContext *tc, MVMString *haystack, MVMString *
 
     if (ngraphs > hgraphs || ngraphs < 1)
         return -1;
-    /* brute force for now. horrible, yes. halp. */
-    while (index <= hgraphs - ngraphs) {
-        if (MVM_string_substrings_equal_nocheck(tc, needle, 0, ngraphs, haystack, index)) {
-            result = (MVMint64)index;
+
+    switch (STR_FLAGS(haystack)) {
+        case MVM_STRING_TYPE_UINT8: {
+            MVMCodepoint8 *n = needle_uint8(tc, needle, ngraphs, &to_free);
+            if (n)
+                result = index_forward_uint8(haystack->body.uint8s, hgraphs, n, ngraphs, start);
+            break;
+        }
+        case MVM_STRING_TYPE_INT32: {
+            MVMCodepoint32 *n = needle_int32(tc, needle, ngraphs, &to_free);
+            result = index_forward_int32(haystack->body.int32s, hgraphs, n, ngraphs, start);
+            break;
+        }
+        default: {
+            MVMCodepoint32 *n = needle_int32(tc, needle, ngraphs, &to_free);
+            result = index_rope(tc, haystack, hgraphs, n, ngraphs, start);
             break;
         }
-        index++;
     }
+    if (to_free)
+        free(to_free);
     return result;
 }
 
 /* Returns the location of one string in another or -1  */
 MVMint64 MVM_string_index_from_end(MVMThreadContext *tc, MVMString *haystack, MVMString *needle, MVMint64 start) {
     MVMint64 result = -1;
-    size_t index;
     MVMStringIndex hgraphs = NUM_GRAPHS(haystack), ngraphs = NUM_GRAPHS(needle);
+    void *to_free;
 
     if (!IS_CONCRETE((MVMObject *)haystack)) {
         MVM_exception_throw_adhoc(tc, "index needs a concrete search target");
@@ -326,23 +531,277 @@ MVMint64 MVM_string_index_from_end(MVMThreadContext *tc, MVMString *haystack, MV
     if (ngraphs > hgraphs || ngraphs < 1)
         return -1;
 
-    index = start;
+    /* A match can't start any later than this. */
+    if (start > hgraphs - ngraphs)
+        start = hgraphs - ngraphs;
 
-    /* brute force for now. horrible, yes. halp. */
-    do {
-        if (MVM_string_substrings_equal_nocheck(tc, needle, 0, ngraphs, haystack, index)) {
-            result = (MVMint64)index;
+    switch (STR_FLAGS(haystack)) {
+        case MVM_STRING_TYPE_UINT8: {
+            MVMCodepoint8 *n = needle_uint8(tc, needle, ngraphs, &to_free);
+            if (n)
+                result = index_backward_uint8(haystack->body.uint8s, n, ngraphs, start);
             break;
         }
-    } while (index-- > 0);
+        case MVM_STRING_TYPE_INT32: {
+            MVMCodepoint32 *n = needle_int32(tc, needle, ngraphs, &to_free);
+            result = index_backward_int32(haystack->body.int32s, n, ngraphs, start);
+            break;
+        }
+        default: {
+            /* Ropes can't be walked backwards, so search a copy of the part
+             * of the haystack a match could be in. */
+            MVMCodepoint32 *n = needle_int32(tc, needle, ngraphs, &to_free);
+            MVMCodepoint32 *h = gather_codepoints(tc, haystack, 0, start + ngraphs);
+            result = index_backward_int32(h, n, ngraphs, start);
+            free(h);
+            break;
+        }
+    }
+    if (to_free)
+        free(to_free);
     return result;
 }
 
+/* A strand table being built up for a new rope. There is always room for
+ * the end row past the last strand. */
+typedef struct MVMRopeBuilder {
+    MVMStrand      *strands;
+    MVMStrandIndex  num_strands;
+    MVMStrandIndex  alloc_strands;
+    MVMStringIndex  graphs;
+} MVMRopeBuilder;
+
+/* Adds a strand for a piece of a flat string, repeated some number of
+ * times, to a rope being built. If it carries straight on from the last
+ * strand in the same string, that one is extended instead. */
+static void rope_add_piece(MVMRopeBuilder *rb, MVMString *flat, MVMStringIndex offset, MVMStringIndex length, MVMStringIndex repeat_count) {
+    MVMStrand *strand;
+    if (!length || !repeat_count)
+        return;
+    if (rb->num_strands && repeat_count == 1) {
+        MVMStrand *last = &rb->strands[rb->num_strands - 1];
+        if (last->string == flat && last->repeat_count == 1
+                && last->string_offset + (rb->graphs - last->compare_offset) == offset) {
+            rb->graphs += length;
+            return;
+        }
+    }
+    if (rb->num_strands + 1 >= rb->alloc_strands) {
+        rb->alloc_strands = rb->alloc_strands ? rb->alloc_strands * 2 : 8;
+        rb->strands = realloc(rb->strands, rb->alloc_strands * sizeof(MVMStrand));
+    }
+    strand = &rb->strands[rb->num_strands++];
+    strand->compare_offset = rb->graphs;
+    strand->string         = flat;
+    strand->string_offset  = offset;
+    strand->repeat_count   = repeat_count;
+    rb->graphs += length * repeat_count;
+}
+
+/* Adds strands for part of a string to a rope being built. For a rope, its
+ * strands are added rather than the rope itself, so that ropes never nest;
+ * a repeated strand that is only partly covered is split up into the
+ * leading partial piece, the whole repetitions and the trailing piece. */
+static void rope_add_substring(MVMThreadContext *tc, MVMRopeBuilder *rb, MVMString *s, MVMStringIndex start, MVMStringIndex length) {
+    MVMStrandIndex strand_index;
+    if (!length)
+        return;
+    if (!IS_ROPE(s)) {
+        rope_add_piece(rb, s, start, length, 1);
+        return;
+    }
+    strand_index = find_strand_index(s, start);
+    while (length) {
+        MVMStrand     *strand = &s->body.strands[strand_index++];
+        MVMStringIndex offset = start - strand->compare_offset;
+        MVMStringIndex take   = strand[1].compare_offset - start;
+        if (take > length)
+            take = length;
+        start  += take;
+        length -= take;
+        if (strand->repeat_count > 1) {
+            MVMStringIndex unit = (strand[1].compare_offset - strand->compare_offset)
+                / strand->repeat_count;
+            MVMStringIndex head = offset % unit;
+            if (head) {
+                MVMStringIndex head_length = unit - head < take ? unit - head : take;
+                rope_add_piece(rb, strand->string, strand->string_offset + head, head_length, 1);
+                take -= head_length;
+            }
+            rope_add_piece(rb, strand->string, strand->string_offset, unit, take / unit);
+            rope_add_piece(rb, strand->string, strand->string_offset, take % unit, 1);
+        }
+        else {
+            rope_add_piece(rb, strand->string, strand->string_offset + offset, take, 1);
+        }
+    }
+}
+
+/* Copies the codepoints covered by a run of strands into a new buffer. This
+ * holds bytes if wide isn't asked for and all of the strands refer to 8-bit
+ * strings, and 32-bit codepoints otherwise; flags is set to say which. The
+ * row after the run must have its compare_offset set. */
+static void * copy_strands(MVMThreadContext *tc, MVMStrand *strands, MVMStrandIndex num_strands, MVMuint8 wide, MVMuint8 *flags) {
+    MVMStringIndex base   = strands[0].compare_offset;
+    MVMStringIndex graphs = strands[num_strands].compare_offset - base;
+    MVMStrandIndex i;
+    void *buffer;
+
+    for (i = 0; i < num_strands && !wide; i++)
+        if (!IS_ASCII(strands[i].string))
+            wide = 1;
+    buffer = malloc((graphs ? graphs : 1)
+        * (wide ? sizeof(MVMCodepoint32) : sizeof(MVMCodepoint8)));
+
+    for (i = 0; i < num_strands; i++) {
+        MVMStrand     *strand = &strands[i];
+        MVMString     *from   = strand->string;
+        MVMStringIndex unit   = (strand[1].compare_offset - strand->compare_offset)
+            / strand->repeat_count;
+        MVMStringIndex pos    = strand->compare_offset - base;
+        MVMStringIndex r, j;
+        for (r = 0; r < strand->repeat_count; r++, pos += unit) {
+            switch (STR_FLAGS(from)) {
+                case MVM_STRING_TYPE_INT32:
+                    memcpy((MVMCodepoint32 *)buffer + pos, from->body.int32s + strand->string_offset,
+                        unit * sizeof(MVMCodepoint32));
+                    break;
+                case MVM_STRING_TYPE_UINT8:
+                    if (wide) {
+                        MVMCodepoint32 *to = (MVMCodepoint32 *)buffer + pos;
+                        for (j = 0; j < unit; j++)
+                            to[j] = from->body.uint8s[strand->string_offset + j];
+                    }
+                    else {
+                        memcpy((MVMCodepoint8 *)buffer + pos, from->body.uint8s + strand->string_offset, unit);
+                    }
+                    break;
+                default:
+                    free(buffer);
+                    MVM_exception_throw_adhoc(tc, "internal string corruption");
+            }
+        }
+    }
+
+    *flags = wide ? MVM_STRING_TYPE_INT32 : MVM_STRING_TYPE_UINT8;
+    return buffer;
+}
+
+/* Applies the write barrier for the strings referred to by a rope's strands
+ * from the given one on, for when the strand table is filled in after the
+ * rope may have been through a GC run. */
+static void strands_write_barrier(MVMThreadContext *tc, MVMString *rope, MVMStrandIndex from) {
+    MVMStrandIndex i;
+    for (i = from; i < rope->body.num_strands; i++)
+        MVM_gc_write_barrier(tc, (MVMCollectable *)rope,
+            (MVMCollectable *)rope->body.strands[i].string);
+}
+
+/* Cuts down the number of strands in a rope by copying runs of short ones
+ * into new flat strings. A run is added to until the next strand would take
+ * it past a (MVM_STRING_MAX_STRANDS / 4)th of the rope's length, so any two
+ * neighbouring runs together are longer than that, and there are at most
+ * about half MVM_STRING_MAX_STRANDS runs afterwards. Strands that are long
+ * already are left as they are. */
+static void rebalance(MVMThreadContext *tc, MVMString *rope) {
+    MVMStrandIndex  num_strands = rope->body.num_strands;
+    MVMStringIndex  limit       = NUM_ROPE_GRAPHS(rope) / (MVM_STRING_MAX_STRANDS / 4);
+    MVMStrandIndex *run_starts  = malloc((num_strands + 1) * sizeof(MVMStrandIndex));
+    MVMStrandIndex  num_runs    = 0, num_flats = 0, i, r;
+    MVMString     **flats;
+    MVMStrand      *strands;
+
+    /* Work out where the runs start. */
+    for (i = 0; i < num_strands; ) {
+        MVMStringIndex run_start = rope->body.strands[i].compare_offset;
+        run_starts[num_runs++] = i++;
+        while (i < num_strands && rope->body.strands[i + 1].compare_offset - run_start <= limit)
+            i++;
+    }
+    run_starts[num_runs] = num_strands;
+
+    /* Make a flat string for each run of more than one strand. */
+    MVM_gc_root_temp_push(tc, (MVMCollectable **)&rope);
+    flats = calloc(num_runs, sizeof(MVMString *));
+    for (r = 0; r < num_runs; r++) {
+        if (run_starts[r + 1] - run_starts[r] > 1) {
+            MVMString *flat = (MVMString *)REPR(rope)->allocate(tc, STABLE(rope));
+            MVMStrand *first = &rope->body.strands[run_starts[r]];
+            MVMuint8   flags;
+            flat->body.storage = copy_strands(tc, first, run_starts[r + 1] - run_starts[r], 0, &flags);
+            flat->body.flags   = flags;
+            flat->body.graphs  = rope->body.strands[run_starts[r + 1]].compare_offset
+                - first->compare_offset;
+            flats[r] = flat;
+            MVM_gc_root_temp_push(tc, (MVMCollectable **)&flats[r]);
+            num_flats++;
+        }
+    }
+
+    /* Then put together the new strand table. */
+    strands = malloc((num_runs + 1) * sizeof(MVMStrand));
+    for (r = 0; r < num_runs; r++) {
+        MVMStrand *first = &rope->body.strands[run_starts[r]];
+        if (flats[r]) {
+            strands[r].compare_offset = first->compare_offset;
+            strands[r].string         = flats[r];
+            strands[r].string_offset  = 0;
+            strands[r].repeat_count   = 1;
+        }
+        else {
+            strands[r] = *first;
+        }
+    }
+    strands[num_runs] = rope->body.strands[num_strands];
+    free(rope->body.strands);
+    rope->body.strands     = strands;
+    rope->body.num_strands = num_runs;
+    strands_write_barrier(tc, rope, 0);
+
+    MVM_gc_root_temp_pop_n(tc, num_flats + 1);
+    free(flats);
+    free(run_starts);
+}
+
+/* Makes a built up strand table into the body of a new string. A short
+ * string is copied into flat storage instead, and a rope with too many
+ * strands is rebalanced, which can allocate, so the caller must have the
+ * string rooted. */
+static void rope_finish(MVMThreadContext *tc, MVMRopeBuilder *rb, MVMString *result) {
+    if (!rb->graphs) {
+        free(rb->strands);
+        result->body.storage = NULL;
+        result->body.graphs  = 0;
+        result->body.flags   = MVM_STRING_TYPE_UINT8;
+        return;
+    }
+
+    rb->strands[rb->num_strands].graphs       = rb->graphs;
+    rb->strands[rb->num_strands].string       = NULL;
+    rb->strands[rb->num_strands].strand_depth = 1;
+    rb->strands[rb->num_strands].repeat_count = 0;
+
+    if (rb->graphs < MVM_STRING_ROPE_MIN_GRAPHS) {
+        MVMuint8 flags;
+        result->body.storage = copy_strands(tc, rb->strands, rb->num_strands, 0, &flags);
+        result->body.flags   = flags;
+        result->body.graphs  = rb->graphs;
+        free(rb->strands);
+    }
+    else {
+        result->body.strands     = rb->strands;
+        result->body.num_strands = rb->num_strands;
+        result->body.flags       = MVM_STRING_TYPE_ROPE;
+        if (rb->num_strands > MVM_STRING_MAX_STRANDS)
+            rebalance(tc, result);
+    }
+}
+
 /* Returns a substring of the given string */
 MVMString * MVM_string_substring(MVMThreadContext *tc, MVMString *a, MVMint64 offset, MVMint64 length) {
-    MVMString *result;
-    MVMStrand *strands;
-    MVMint64   start_pos, end_pos;
+    MVMString      *result;
+    MVMRopeBuilder  rb = { NULL, 0, 0, 0 };
+    MVMint64        start_pos, end_pos;
 
     /* convert to signed to avoid implicit arithmetic conversions */
     MVMint64 agraphs = (MVMint64)NUM_GRAPHS(a);
@@ -383,23 +842,10 @@ MVMString * MVM_string_substring(MVMThreadContext *tc, MVMString *a, MVMint64 of
     result = (MVMString *)REPR(a)->allocate(tc, STABLE(a));
     MVM_gc_root_temp_pop(tc);
 
-    strands = result->body.strands = calloc(sizeof(MVMStrand), 2);
-    /* if we're substringing a substring, substring the same one */
-    if (IS_ONE_STRING_ROPE(a)) {
-        strands->string_offset = (MVMStringIndex)start_pos + a->body.strands->string_offset;
-        strands->string = a->body.strands->string;
-    }
-    else {
-        strands->string_offset = (MVMStringIndex)start_pos;
-        strands->string = a;
-    }
-    /* result->body.codes  = 0; /* Populate this lazily. */
-    result->body.flags = MVM_STRING_TYPE_ROPE;
-    result->body.num_strands = 1;
-    strands[1].graphs = end_pos - start_pos;
-    _STRAND_DEPTH(result) = STRAND_DEPTH(strands->string) + 1;
-
-    MVM_string_flatten(tc, result);
+    rope_add_substring(tc, &rb, a, (MVMStringIndex)start_pos, (MVMStringIndex)(end_pos - start_pos));
+    MVMROOT(tc, result, {
+        rope_finish(tc, &rb, result);
+    });
 
     return result;
 }
@@ -421,72 +867,151 @@ MVMString * MVM_string_replace(MVMThreadContext *tc, MVMString *original, MVMint
 
     MVM_gc_root_temp_pop_n(tc, 3);
 
-    MVM_string_flatten(tc, result);
+    return result;
+}
 
+/* Makes a flat string from graphemes, taking over the buffer they're in.
+ * It's stored as 8-bit if they all fit. */
+static MVMString * string_from_graphemes(MVMThreadContext *tc, MVMCodepoint32 *graphs, MVMint64 num_graphs) {
+    MVMString *result = (MVMString *)MVM_repr_alloc_init(tc, tc->instance->VMString);
+    MVMint64   i;
+    for (i = 0; i < num_graphs; i++)
+        if (graphs[i] < 0 || graphs[i] > 0xFF)
+            break;
+    if (i == num_graphs) {
+        MVMCodepoint8 *narrow = malloc(num_graphs ? num_graphs : 1);
+        for (i = 0; i < num_graphs; i++)
+            narrow[i] = (MVMCodepoint8)graphs[i];
+        free(graphs);
+        result->body.uint8s = narrow;
+        result->body.flags  = MVM_STRING_TYPE_UINT8;
+    }
+    else {
+        result->body.int32s = graphs;
+        result->body.flags  = MVM_STRING_TYPE_INT32;
+    }
+    result->body.graphs = num_graphs;
     return result;
 }
 
-/* Append one string to another. */
-/* XXX inline parent's strands if it's a rope too? */
-MVMString * MVM_string_concatenate(MVMThreadContext *tc, MVMString *a, MVMString *b) {
-    MVMString *result;
-    MVMStrandIndex strand_count = 0;
-    MVMStrand *strands;
-    MVMStringIndex index = 0;
-    MVMStrandIndex max_strand_depth = 0;
-    MVMStringIndex agraphs = NUM_GRAPHS(a), bgraphs = NUM_GRAPHS(b), rgraphs;
+/* Makes a renormalized copy of a string that has been put together from
+ * pieces that combine where they meet. */
+static MVMString * renormalize(MVMThreadContext *tc, MVMString *s) {
+    MVMStringIndex  graphs = NUM_GRAPHS(s);
+    MVMCodepoint32 *codes  = gather_codepoints(tc, s, 0, graphs);
+    MVMint64        num_graphs;
+    MVMCodepoint32 *normalized = MVM_nfg_normalize(tc, codes, graphs, &num_graphs);
+    free(codes);
+    return string_from_graphemes(tc, normalized, num_graphs);
+}
 
-    if (!IS_CONCRETE((MVMObject *)a) || !IS_CONCRETE((MVMObject *)b)) {
-        MVM_exception_throw_adhoc(tc, "Concatenate needs concrete strings");
-    }
+/* Checks if the first grapheme of b could go straight after the given one,
+ * which it can unless it's something that extends or combines with what
+ * comes before it. */
+static MVMint64 concat_is_stable_after(MVMThreadContext *tc, MVMCodepoint32 last, MVMString *b) {
+    MVMCodepoint32 first;
+    if (!NUM_GRAPHS(b))
+        return 1;
+    first = MVM_string_get_codepoint_at_nocheck(tc, b, 0);
+    if (first >= 0 && first < MVM_NFG_QUICK_CHECK_MIN)
+        return 1;
+    return MVM_nfg_is_concat_stable(tc, last, first);
+}
+
+/* Checks if the first grapheme of b could go straight after the last one of
+ * a. */
+static MVMint64 concat_is_stable(MVMThreadContext *tc, MVMString *a, MVMString *b) {
+    MVMStringIndex agraphs = NUM_GRAPHS(a);
+    if (!agraphs)
+        return 1;
+    return concat_is_stable_after(tc,
+        MVM_string_get_codepoint_at_nocheck(tc, a, agraphs - 1), b);
+}
+
+/* Append one string to another. The strands of either that is a rope are
+ * inlined into the result, so repeatedly appending to a string doesn't make
+ * a deeper and deeper tree. */
+static MVMString * concatenate(MVMThreadContext *tc, MVMString *a, MVMString *b) {
+    MVMString      *result;
+    MVMRopeBuilder  rb = { NULL, 0, 0, 0 };
 
     MVM_gc_root_temp_push(tc, (MVMCollectable **)&a);
     MVM_gc_root_temp_push(tc, (MVMCollectable **)&b);
     result = (MVMString *)REPR(a)->allocate(tc, STABLE(a));
     MVM_gc_root_temp_pop_n(tc, 2);
 
-    /* there could be unattached combining chars at the beginning of b,
-       so, XXX TODO handle this */
-    result->body.flags = MVM_STRING_TYPE_ROPE;
-    rgraphs = agraphs + bgraphs;
-
-    if (agraphs)
-        strand_count = 1;
-    if (bgraphs)
-        ++strand_count;
-    strands = result->body.strands = calloc(sizeof(MVMStrand), strand_count + 1);
-    strand_count = 0;
-    if (agraphs) {
-        strands->string = a;
-        strands->string_offset = 0;
-        strands->compare_offset = index;
-        index = agraphs;
-        strand_count = 1;
-        max_strand_depth = STRAND_DEPTH(a);
-    }
-    if (bgraphs) {
-        strands[strand_count].string = b;
-        strands[strand_count].string_offset = 0;
-        strands[strand_count].compare_offset = index;
-        index += bgraphs;
-        ++strand_count;
-        if (STRAND_DEPTH(b) > max_strand_depth)
-            max_strand_depth = STRAND_DEPTH(b);
-    }
-    strands[strand_count].graphs = index;
-    result->body.num_strands = strand_count;
-    result->body.flags = MVM_STRING_TYPE_ROPE;
-    _STRAND_DEPTH(result) = max_strand_depth + 1;
-
-    MVM_string_flatten(tc, result);
+    rope_add_substring(tc, &rb, a, 0, NUM_GRAPHS(a));
+    rope_add_substring(tc, &rb, b, 0, NUM_GRAPHS(b));
+    MVMROOT(tc, result, {
+        rope_finish(tc, &rb, result);
+    });
 
     return result;
 }
 
+/* Concatenates two strings where the last grapheme of the first and the
+ * first grapheme of the second combine. Those two are normalized together,
+ * and what they become goes between the rest of each string. */
+static MVMString * concatenate_renormalized(MVMThreadContext *tc, MVMString *a, MVMString *b) {
+    MVMStringIndex  agraphs = NUM_GRAPHS(a);
+    MVMCodepoint32  seam[2];
+    MVMCodepoint32 *graphs;
+    MVMint64        num_graphs;
+    MVMString      *before = NULL, *middle = NULL, *after = NULL, *result;
+
+    seam[0] = MVM_string_get_codepoint_at_nocheck(tc, a, agraphs - 1);
+    seam[1] = MVM_string_get_codepoint_at_nocheck(tc, b, 0);
+    graphs  = MVM_nfg_normalize(tc, seam, 2, &num_graphs);
+
+    MVM_gc_root_temp_push(tc, (MVMCollectable **)&a);
+    MVM_gc_root_temp_push(tc, (MVMCollectable **)&b);
+    MVM_gc_root_temp_push(tc, (MVMCollectable **)&before);
+    MVM_gc_root_temp_push(tc, (MVMCollectable **)&middle);
+    MVM_gc_root_temp_push(tc, (MVMCollectable **)&after);
+    middle = string_from_graphemes(tc, graphs, num_graphs);
+    before = MVM_string_substring(tc, a, 0, agraphs - 1);
+    after  = MVM_string_substring(tc, b, 1, -1);
+    before = concatenate(tc, before, middle);
+    result = concatenate(tc, before, after);
+    MVM_gc_root_temp_pop_n(tc, 5);
+
+    return result;
+}
+
+/* Concatenates two strings, renormalizing where they meet if need be. */
+MVMString * MVM_string_concatenate(MVMThreadContext *tc, MVMString *a, MVMString *b) {
+    if (!IS_CONCRETE((MVMObject *)a) || !IS_CONCRETE((MVMObject *)b)) {
+        MVM_exception_throw_adhoc(tc, "Concatenate needs concrete strings");
+    }
+    return concat_is_stable(tc, a, b)
+        ? concatenate(tc, a, b)
+        : concatenate_renormalized(tc, a, b);
+}
+
+/* Repeats a string whose start combines with its end, which is done by
+ * doubling it up with MVM_string_concatenate, so each join is taken care
+ * of. */
+static MVMString * repeat_renormalized(MVMThreadContext *tc, MVMString *a, MVMint64 count) {
+    MVMString *result = tc->instance->str_consts.empty;
+    MVM_gc_root_temp_push(tc, (MVMCollectable **)&a);
+    MVM_gc_root_temp_push(tc, (MVMCollectable **)&result);
+    while (count) {
+        if (count & 1)
+            result = MVM_string_concatenate(tc, result, a);
+        count >>= 1;
+        if (count)
+            a = MVM_string_concatenate(tc, a, a);
+    }
+    MVM_gc_root_temp_pop_n(tc, 2);
+    return result;
+}
+
+/* Repeats a string, which is done with a single repeated strand. If the
+ * string is a rope of more than one piece, it's copied into a flat string
+ * to be repeated first. */
 MVMString * MVM_string_repeat(MVMThreadContext *tc, MVMString *a, MVMint64 count) {
-    MVMString *result;
-    MVMint64 bkup_count = count;
-    MVMStringIndex string_offset = 0, graphs = 0, rgraphs;
+    MVMString      *result;
+    MVMRopeBuilder  rb = { NULL, 0, 0, 0 };
 
     if (!IS_CONCRETE((MVMObject *)a)) {
         MVM_exception_throw_adhoc(tc, "repeat needs a concrete string");
@@ -498,41 +1023,44 @@ MVMString * MVM_string_repeat(MVMThreadContext *tc, MVMString *a, MVMint64 count
     if (count > (1<<30))
         MVM_exception_throw_adhoc(tc, "repeat count > %lld arbitrarily unsupported...", (1<<30));
 
+    /* Repeats are made without copying, so check the result can have the
+     * length it would. */
+    if (count > 1 && NUM_GRAPHS(a) > MVM_STRING_MAX_GRAPHS / (MVMuint64)count)
+        MVM_exception_throw_adhoc(tc, "repeat result > %llu graphemes unsupported",
+            MVM_STRING_MAX_GRAPHS);
+
+    if (count > 1 && !concat_is_stable(tc, a, a))
+        return repeat_renormalized(tc, a, count);
+
     MVM_gc_root_temp_push(tc, (MVMCollectable **)&a);
     result = (MVMString *)REPR(a)->allocate(tc, STABLE(a));
-    MVM_gc_root_temp_pop(tc);
 
-    if (IS_ONE_STRING_ROPE(a)) {
-        string_offset = a->body.strands->string_offset;
-        graphs = a->body.strands[1].graphs;
-        a = a->body.strands->string;
-    }
-    else {
-        graphs = NUM_GRAPHS(a);
+    if (count == 1) {
+        rope_add_substring(tc, &rb, a, 0, NUM_GRAPHS(a));
     }
-
-    rgraphs = graphs * count;
-
-    /* XXX compute tradeoff here of space usage of the strands table vs real string */
-    if (rgraphs) {
-        MVMStrand *strands = result->body.strands = calloc(sizeof(MVMStrand), count + 1);
-        result->body.flags = MVM_STRING_TYPE_ROPE;
-
-        while (count--) {
-            strands[count].compare_offset = count * graphs;
-            strands[count].string = a;
-            strands[count].string_offset = string_offset;
+    else if (count > 1) {
+        if (IS_ROPE(a) && !(IS_ONE_STRING_ROPE(a) && a->body.strands->repeat_count == 1)) {
+            MVMString *flat;
+            MVMuint8   flags;
+            MVMROOT(tc, result, {
+                flat = (MVMString *)REPR(a)->allocate(tc, STABLE(a));
+            });
+            flat->body.storage = copy_strands(tc, a->body.strands, a->body.num_strands, 0, &flags);
+            flat->body.flags   = flags;
+            flat->body.graphs  = NUM_ROPE_GRAPHS(a);
+            a = flat;
         }
-        strands[bkup_count].graphs = rgraphs;
-        result->body.num_strands = bkup_count;
-        _STRAND_DEPTH(result) = STRAND_DEPTH(a) + 1;
-    }
-    else {
-        result->body.flags = MVM_STRING_TYPE_UINT8;
-        /* leave graphs 0 and storage null */
+        if (IS_ROPE(a))
+            rope_add_piece(&rb, a->body.strands->string, a->body.strands->string_offset,
+                NUM_ROPE_GRAPHS(a), (MVMStringIndex)count);
+        else
+            rope_add_piece(&rb, a, 0, NUM_GRAPHS(a), (MVMStringIndex)count);
     }
+    MVM_gc_root_temp_pop(tc);
 
-    MVM_string_flatten(tc, result);
+    MVMROOT(tc, result, {
+        rope_finish(tc, &rb, result);
+    });
 
     return result;
 }
@@ -629,7 +1157,8 @@ MVMint64 MVM_string_have_at(MVMThreadContext *tc, MVMString *a,
     return MVM_string_substrings_equal_nocheck(tc, a, starta, length, b, startb);
 }
 
-/* returns the codepoint (could be a negative synthetic) at a given index of the string */
+/* Returns the codepoint at a given index of the string; for a synthetic,
+ * that's its base codepoint. */
 MVMint64 MVM_string_get_codepoint_at(MVMThreadContext *tc, MVMString *a, MVMint64 index) {
     MVMStringIndex agraphs;
 
@@ -642,93 +1171,145 @@ MVMint64 MVM_string_get_codepoint_at(MVMThreadContext *tc, MVMString *a, MVMint6
     if (index < 0 || index >= agraphs)
         MVM_exception_throw_adhoc(tc, "Invalid string index: max %lld, got %lld",
             agraphs - 1, index);
-    return (MVMint64)MVM_string_get_codepoint_at_nocheck(tc, a, index);
+    return (MVMint64)MVM_nfg_base_codepoint(tc,
+        MVM_string_get_codepoint_at_nocheck(tc, a, index));
+}
+
+/* Gets the number of codepoints a string would have were it not in NFG,
+ * which is its number of graphemes plus the combiners of each synthetic in
+ * it. It's cached in the string once worked out. */
+MVMint64 MVM_string_codes(MVMThreadContext *tc, MVMString *s) {
+    MVMStringIndex  codes;
+    MVMStringCursor cursor;
+
+    if (!IS_CONCRETE((MVMObject *)s)) {
+        MVM_exception_throw_adhoc(tc, "codes needs a concrete string");
+    }
+    if (s->body.codes || !NUM_GRAPHS(s))
+        return s->body.codes;
+
+    codes = NUM_GRAPHS(s);
+    MVM_string_cursor_init(tc, &cursor, s, 0, codes);
+    while (cursor.remaining) {
+        MVMStringIndex run  = cursor_run(tc, &cursor);
+        MVMString     *flat = cursor.flat;
+        if (!IS_ASCII(flat)) {
+            const MVMCodepoint32 *in = flat->body.int32s + cursor.piece_start + cursor.pos;
+            MVMStringIndex i;
+            for (i = 0; i < run; i++)
+                if (in[i] < 0)
+                    codes += MVM_nfg_get_synthetic_info(tc, in[i])->num_combs;
+        }
+        cursor.pos       += run;
+        cursor.remaining -= run;
+    }
+    s->body.codes = codes;
+    return codes;
 }
 
 /* finds the location of a codepoint in a string.  Useful for small character class lookup */
 MVMint64 MVM_string_index_of_codepoint(MVMThreadContext *tc, MVMString *a, MVMint64 codepoint) {
-    size_t index = -1;
-    while (++index < NUM_GRAPHS(a))
-        /* XXX make this use the traversal function */
-        if (MVM_string_get_codepoint_at_nocheck(tc, a, index) == codepoint)
+    MVMStringIndex  index = 0;
+    MVMStringCursor cursor;
+    MVM_string_cursor_init(tc, &cursor, a, 0, NUM_GRAPHS(a));
+    while (cursor.remaining) {
+        if (MVM_string_cursor_next(tc, &cursor) == codepoint)
             return index;
+        index++;
+    }
     return -1;
 }
 
-typedef struct MVMCaseChangeState {
-    MVMString *dest;
-    MVMStringIndex size;
-    MVMint32 case_change_type;
-} MVMCaseChangeState;
-
-#define change_case_iterate(member, dest_member, dest_size) \
-for (i = string->body.member + start; i < string->body.member + start + length; ) { \
-    if (dest->body.graphs == state->size) { \
-        if (!state->size) state->size = 16; \
-        else state->size *= 2; \
-        dest->body.dest_member = realloc(dest->body.dest_member, \
-            state->size * sizeof(dest_size)); \
-    } \
-    dest->body.dest_member[dest->body.graphs++] = \
-        MVM_unicode_get_case_change(tc, (MVMCodepoint32) *i++, state->case_change_type); \
-}
+/* What each Latin-1 codepoint becomes for each kind of case change; filled
+ * in by MVM_string_cclass_init. */
+static MVMCodepoint32 latin1_case_change[3][256];
 
+/* Changes the case of a string. Latin-1 codepoints are mapped through the
+ * table above, and the result stays 8-bit until something maps to beyond
+ * Latin-1, at which point what's been done so far is widened. */
 /* XXX make this handle case changes that change the number of characters.
     Will require some form of buffering/lookahead, or rollback of a placed
     char if a following char forms a composite sequence that case changes
     together. */
-MVM_SUBSTRING_CONSUMER(MVM_string_case_change_consumer) {
-    MVMCaseChangeState *state = (MVMCaseChangeState *)data;
-    MVMString *dest = state->dest;
-    switch (STR_FLAGS(string)) {
-        case MVM_STRING_TYPE_INT32: {
-            MVMCodepoint32 *i;
-            if (!IS_WIDE(dest)) {
-                MVM_string_flatten(tc, dest);
-            }
-            change_case_iterate(int32s, int32s, MVMCodepoint32)
-            break;
+static MVMString * case_change(MVMThreadContext *tc, MVMString *s, MVMint32 type, const char *error) {
+    const MVMCodepoint32 *table = latin1_case_change[type];
+    MVMString            *result;
+    MVMStringIndex        graphs, pos = 0, i;
+    MVMCodepoint8        *narrow;
+    MVMCodepoint32       *wide = NULL;
+    MVMStringCursor       cursor;
+
+    if (!IS_CONCRETE((MVMObject *)s)) {
+        MVM_exception_throw_adhoc(tc, error);
+    }
+
+    MVM_gc_root_temp_push(tc, (MVMCollectable **)&s);
+    result = (MVMString *)REPR(s)->allocate(tc, STABLE(s));
+    MVM_gc_root_temp_pop(tc);
+
+    graphs = NUM_GRAPHS(s);
+    narrow = malloc(graphs ? graphs : 1);
+    MVM_string_cursor_init(tc, &cursor, s, 0, graphs);
+    while (cursor.remaining) {
+        MVMStringIndex run  = cursor_run(tc, &cursor);
+        MVMString     *flat = cursor.flat;
+        MVMStringIndex from = cursor.piece_start + cursor.pos;
+        i = 0;
+        if (IS_ASCII(flat)) {
+            const MVMCodepoint8 *in = flat->body.uint8s + from;
+            if (wide)
+                for (; i < run; i++)
+                    wide[pos + i] = table[in[i]];
+            else
+                for (; i < run && table[in[i]] <= 0xFF; i++)
+                    narrow[pos + i] = (MVMCodepoint8)table[in[i]];
+            pos += i;
         }
-        case MVM_STRING_TYPE_UINT8: {
-            MVMCodepoint8 *i;
-            if (IS_WIDE(dest)) {
-                change_case_iterate(uint8s, int32s, MVMCodepoint32)
+        for (; i < run; i++) {
+            MVMCodepoint32 cp = IS_ASCII(flat)
+                ? (MVMCodepoint32)flat->body.uint8s[from + i]
+                : flat->body.int32s[from + i];
+            cp = cp >= 0 && cp <= 0xFF ? table[cp]
+               : cp < 0                ? MVM_nfg_get_case_change(tc, cp, type)
+               :                         MVM_unicode_get_case_change(tc, cp, type);
+            if (!wide && (cp < 0 || cp > 0xFF)) {
+                MVMStringIndex j;
+                wide = malloc(graphs * sizeof(MVMCodepoint32));
+                for (j = 0; j < pos; j++)
+                    wide[j] = narrow[j];
+                free(narrow);
+                narrow = NULL;
             }
-            else { /* hopefully most common/fast case of ascii->ascii */
-                change_case_iterate(uint8s, uint8s, MVMCodepoint8)
-            }
-            break;
+            if (wide)
+                wide[pos++] = cp;
+            else
+                narrow[pos++] = (MVMCodepoint8)cp;
         }
-        default:
-            MVM_exception_throw_adhoc(tc, "internal string corruption");
+        cursor.pos       += run;
+        cursor.remaining -= run;
     }
-    return 0;
-}
 
-/* Uppercases a string. */
-#define case_change_func(funcname, type, error) \
-MVMString * funcname(MVMThreadContext *tc, MVMString *s) { \
-    MVMString *result; \
-    MVMStringIndex i; \
-    MVMCaseChangeState state = { NULL, 0, type }; \
-    \
-    if (!IS_CONCRETE((MVMObject *)s)) { \
-        MVM_exception_throw_adhoc(tc, error); \
-    } \
-    \
-    MVM_gc_root_temp_push(tc, (MVMCollectable **)&s); \
-    state.dest = result = (MVMString *)REPR(s)->allocate(tc, STABLE(s)); \
-    MVM_gc_root_temp_pop(tc); \
-     \
-    MVM_string_traverse_substring(tc, s, 0, NUM_GRAPHS(s), 0, \
-        MVM_string_case_change_consumer, &state); \
-     \
-    return result; \
+    result->body.graphs = graphs;
+    if (wide) {
+        result->body.flags  = MVM_STRING_TYPE_INT32;
+        result->body.int32s = wide;
+    }
+    else {
+        result->body.flags  = MVM_STRING_TYPE_UINT8;
+        result->body.uint8s = narrow;
+    }
+    return result;
 }
 
-case_change_func(MVM_string_uc, MVM_unicode_case_change_type_upper, "uc needs a concrete string")
-case_change_func(MVM_string_lc, MVM_unicode_case_change_type_lower, "lc needs a concrete string")
-case_change_func(MVM_string_tc, MVM_unicode_case_change_type_title, "tc needs a concrete string")
+MVMString * MVM_string_uc(MVMThreadContext *tc, MVMString *s) {
+    return case_change(tc, s, MVM_unicode_case_change_type_upper, "uc needs a concrete string");
+}
+MVMString * MVM_string_lc(MVMThreadContext *tc, MVMString *s) {
+    return case_change(tc, s, MVM_unicode_case_change_type_lower, "lc needs a concrete string");
+}
+MVMString * MVM_string_tc(MVMThreadContext *tc, MVMString *s) {
+    return case_change(tc, s, MVM_unicode_case_change_type_title, "tc needs a concrete string");
+}
 
 /* decodes a C buffer to an MVMString, dependent on the encoding type flag */
 MVMString * MVM_string_decode(MVMThreadContext *tc,
@@ -903,13 +1484,12 @@ MVMObject * MVM_string_split(MVMThreadContext *tc, MVMString *separator, MVMStri
 }
 
 MVMString * MVM_string_join(MVMThreadContext *tc, MVMString *separator, MVMObject *input) {
-    MVMint64 elems, length = 0, index = -1, position = 0;
+    MVMint64 elems, index = -1;
     MVMString *portion, *result;
-    MVMuint32 codes = 0;
-    MVMStrandIndex portion_index = 0, max_strand_depth;
-    MVMStringIndex sgraphs, rgraphs;
-    MVMStrand *strands;
+    MVMRopeBuilder rb = { NULL, 0, 0, 0 };
     MVMint64 is_str_array;
+    MVMCodepoint32 last = 0;
+    MVMuint8 have_last = 0, stable = 1;
 
     if (!IS_CONCRETE(input)) {
         MVM_exception_throw_adhoc(tc, "join needs a concrete array to join");
@@ -928,11 +1508,11 @@ MVMString * MVM_string_join(MVMThreadContext *tc, MVMString *separator, MVMObjec
             is_str_array = REPR(input)->pos_funcs.get_elem_storage_spec(tc,
                 STABLE(input)).boxed_primitive == MVM_STORAGE_SPEC_BP_STR;
 
-            sgraphs = NUM_GRAPHS(separator);
-            max_strand_depth = STRAND_DEPTH(separator);
-
+            /* Getting the portions can allocate, so the strands are kept in
+             * the result as they are added, for the GC to see. */
+            result->body.flags = MVM_STRING_TYPE_ROPE;
             while (++index < elems) {
-                MVMStringIndex pgraphs;
+                MVMStrandIndex added = rb.num_strands;
 
                 if (is_str_array) {
                     portion = MVM_repr_at_pos_s(tc, input, index);
@@ -947,80 +1527,37 @@ MVMString * MVM_string_join(MVMThreadContext *tc, MVMString *separator, MVMObjec
                     portion = MVM_repr_get_str(tc, item);
                 }
 
-                pgraphs = NUM_GRAPHS(portion);
-                if (pgraphs)
-                    ++portion_index;
-                if (index && sgraphs)
-                    ++portion_index;
-                length += pgraphs + (index ? sgraphs : 0);
-                /* XXX codes += portion->body.codes + (index ? separator->body.codes : 0); */
-                if (STRAND_DEPTH(portion) > max_strand_depth)
-                    max_strand_depth = STRAND_DEPTH(portion);
-            }
-
-            rgraphs = length;
-            /* XXX consider whether to coalesce combining characters
-            if they cause new combining sequences to appear */
-            /* XXX result->body.codes = codes; */
-
-            if (portion_index > (1<<30)) {
-                MVM_exception_throw_adhoc(tc, "join array items > %lld arbitrarily unsupported...", (1<<30));
-            }
-
-            if (portion_index) {
-                index = -1;
-                position = 0;
-                strands = result->body.strands = calloc(sizeof(MVMStrand), portion_index + 1);
-
-                portion_index = 0;
-                while (++index < elems) {
-                    if (is_str_array) {
-                        portion = MVM_repr_at_pos_s(tc, input, index);
-                        if (!portion)
-                            continue;
-                    }
-                    else {
-                        MVMObject *item = MVM_repr_at_pos_o(tc, input, index);
-                        if (!item || !IS_CONCRETE(item))
-                            continue;
-                        portion = MVM_repr_get_str(tc, item);
-                    }
-
-                    /* Note: this allows the separator to precede the empty string. */
-                    if (index && sgraphs) {
-                        strands[portion_index].compare_offset = position;
-                        strands[portion_index].string = separator;
-                        position += sgraphs;
-                        ++portion_index;
-                    }
-
-                    length = NUM_GRAPHS(portion);
-                    if (length) {
-                        strands[portion_index].compare_offset = position;
-                        strands[portion_index].string = portion;
-                        position += length;
-                        ++portion_index;
-                    }
+                /* Note: this allows the separator to precede the empty string.
+                 * Each piece is checked against the last grapheme of the last
+                 * non-empty one for whether they combine where they meet; only
+                 * the grapheme is kept, as the piece itself isn't rooted. */
+                if (index && NUM_GRAPHS(separator)) {
+                    if (have_last && stable)
+                        stable = concat_is_stable_after(tc, last, separator);
+                    rope_add_substring(tc, &rb, separator, 0, NUM_GRAPHS(separator));
+                    last      = MVM_string_get_codepoint_at_nocheck(tc, separator,
+                        NUM_GRAPHS(separator) - 1);
+                    have_last = 1;
                 }
-                strands[portion_index].graphs = position;
-                strands[portion_index].strand_depth = max_strand_depth + 1;
-                result->body.flags = MVM_STRING_TYPE_ROPE;
-                result->body.num_strands = portion_index;
-            }
-            else {
-                /* leave type default of int32 and graphs 0 */
+                if (NUM_GRAPHS(portion)) {
+                    if (have_last && stable)
+                        stable = concat_is_stable_after(tc, last, portion);
+                    rope_add_substring(tc, &rb, portion, 0, NUM_GRAPHS(portion));
+                    last      = MVM_string_get_codepoint_at_nocheck(tc, portion,
+                        NUM_GRAPHS(portion) - 1);
+                    have_last = 1;
+                }
+
+                result->body.strands     = rb.strands;
+                result->body.num_strands = rb.num_strands;
+                strands_write_barrier(tc, result, added);
             }
+            rope_finish(tc, &rb, result);
         });
     });
     });
 
-    /* assertion/check */
-    if (NUM_GRAPHS(result) != position)
-        MVM_exception_throw_adhoc(tc, "join had an internal error");
-
-    MVM_string_flatten(tc, result);
-
-    return result;
+    return stable ? result : renormalize(tc, result);
 }
 
 typedef struct MVMCharAtState {
@@ -1085,53 +1622,144 @@ MVMint64 MVM_string_offset_has_unicode_property_value(MVMThreadContext *tc, MVMS
         MVM_string_get_codepoint_at_nocheck(tc, s, offset), property_code, property_value_code);
 }
 
-/* internal function so hashes can easily compute hashes of hash keys */
+/* Turns a rope into a flat string in place, 8-bit if all of its strands
+ * are. The uthash based registries need this for their keys, which are the
+ * strings' storage. Flat strings are left as they are, since they may be
+ * shared between threads; flattening a rope is not thread-safe. */
 void MVM_string_flatten(MVMThreadContext *tc, MVMString *s) {
-    /* XXX This is temporary until we can get the hashing mechanism
-        to compute the hash (and test for equivalence!) using the
-        codepoint iterator interface.  It's not thread-safe. */
-    MVMStringIndex position = 0, sgraphs = NUM_GRAPHS(s);
-    void *storage = s->body.storage;
-    MVMCodepoint32 *buffer;
-    if (IS_WIDE(s))
-        return;
-    if (!sgraphs) {
-        if (storage) free(storage);
-        s->body.int32s = malloc(1); /* just in case a hash tries to hash */
-        s->body.flags = MVM_STRING_TYPE_INT32;
+    MVMStringIndex sgraphs = NUM_GRAPHS(s);
+    MVMStrand *strands;
+    void *buffer;
+    MVMuint8 flags;
+    if (!IS_ROPE(s))
         return;
+    strands = s->body.strands;
+    buffer  = copy_strands(tc, strands, s->body.num_strands, 0, &flags);
+    s->body.storage = buffer;
+    s->body.graphs  = sgraphs;
+    s->body.flags   = (s->body.flags & ~MVM_STRING_TYPE_MASK) | flags;
+    free(strands); /* not thread-safe */
+}
+
+/* Compares two keys of the uthash based registries, given their lengths.
+ * Those tagged as strings (see MVM_HASH_KEY_LEN) are compared grapheme by
+ * grapheme, whether they're stored 8 or 32 bits wide; others are compared
+ * byte for byte. Returns non-zero if they match. */
+MVMint32 MVM_string_hash_key_match(const void *a, unsigned alen, const void *b, unsigned blen) {
+    MVMStringIndex graphs, i;
+    if (!(alen & MVM_HASH_KEY_STR) || !(blen & MVM_HASH_KEY_STR))
+        return alen == blen && memcmp(a, b, alen) == 0;
+    graphs = alen & ~(MVM_HASH_KEY_STR | MVM_HASH_KEY_WIDE);
+    if (graphs != (blen & ~(MVM_HASH_KEY_STR | MVM_HASH_KEY_WIDE)))
+        return 0;
+    if ((alen & MVM_HASH_KEY_WIDE) == (blen & MVM_HASH_KEY_WIDE))
+        return memcmp(a, b, graphs * (alen & MVM_HASH_KEY_WIDE
+            ? sizeof(MVMCodepoint32) : sizeof(MVMCodepoint8))) == 0;
+    if (alen & MVM_HASH_KEY_WIDE) {
+        const void *t = a;
+        a = b;
+        b = t;
     }
-    buffer = malloc(sizeof(MVMCodepoint32) * sgraphs);
-    if (IS_ROPE(s) && STRAND_DEPTH(s) == 1) {
-        MVMStrandIndex strand;
-        MVMStrandIndex last  = s->body.num_strands;
-        for (strand = 0; strand < last; strand++) {
-            MVMStrand *snd = &s->body.strands[strand];
-            MVMStringIndex end = (s->body.strands[strand + 1].compare_offset - snd->compare_offset);
-            if (IS_WIDE(snd->string)) {
-                memcpy(buffer + snd->compare_offset,
-                       snd->string->body.int32s + snd->string_offset,
-                       end * 4);
-            } else if (IS_ASCII(snd->string)) {
-                MVMStringIndex copy_idx;
-                // we have to turn uint8 into int32 here.
-                for (copy_idx = 0; copy_idx < end; copy_idx++) {
-                    buffer[snd->compare_offset + copy_idx] = snd->string->body.uint8s[copy_idx + snd->string_offset];
-                }
-            } else {
-                MVM_exception_throw_adhoc(tc, "Unexpected rope in string_flatten.");
-            }
-        }
-    } else {
-        for (; position < sgraphs; position++) {
-                /* XXX make this use the iterator */
-            buffer[position] = MVM_string_get_codepoint_at_nocheck(tc, s, position);
-        }
+    for (i = 0; i < graphs; i++)
+        if (((const MVMCodepoint8 *)a)[i] != ((const MVMCodepoint32 *)b)[i])
+            return 0;
+    return 1;
+}
+
+/* The string hash is in the style of wyhash: codepoints are taken four at
+ * a time, as two 64-bit words that are mixed into the state by a 64x64 to
+ * 128 bit multiply. It works on codepoints rather than on the bytes of the
+ * storage, so equal strings hash the same however they are stored, and
+ * ropes are hashed a strand at a time without flattening them. The state
+ * starts from a per-instance random seed, so that which keys collide can't
+ * be worked out in advance. */
+#define HASH_SECRET_0 0xa0761d6478bd642fULL
+#define HASH_SECRET_1 0xe7037ed1a0b428dbULL
+
+/* Multiplies two 64-bit values, and folds the 128-bit result into 64 bits
+ * by xoring its halves together. */
+static MVMuint64 hash_mix(MVMuint64 a, MVMuint64 b) {
+#ifdef __SIZEOF_INT128__
+    unsigned __int128 r = (unsigned __int128)a * b;
+    return (MVMuint64)r ^ (MVMuint64)(r >> 64);
+#else
+    MVMuint64 ha = a >> 32, la = (MVMuint32)a, hb = b >> 32, lb = (MVMuint32)b;
+    MVMuint64 rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb;
+    MVMuint64 t  = rl + (rm0 << 32);
+    MVMuint64 lo = t + (rm1 << 32);
+    MVMuint64 hi = rh + (rm0 >> 32) + (rm1 >> 32) + (t < rl) + (lo < t);
+    return lo ^ hi;
+#endif
+}
+
+/* State for hashing a string a run of codepoints at a time; up to three
+ * codepoints are left over from one run to the next. */
+typedef struct {
+    MVMuint64      state;
+    MVMCodepoint32 pending[4];
+    MVMuint32      num_pending;
+} MVMStringHasher;
+
+#define HASH_WORD(lo, hi) ((MVMuint64)(MVMuint32)(lo) | (MVMuint64)(MVMuint32)(hi) << 32)
+#define HASH_BLOCK(state, c0, c1, c2, c3) \
+    ((state) = hash_mix(HASH_WORD(c0, c1) ^ HASH_SECRET_1, HASH_WORD(c2, c3) ^ (state)))
+
+/* Hashes a run of codepoints in a flat string. */
+#define HASH_RUN(hasher, from, length) do { \
+    MVMStringIndex i_ = 0; \
+    while ((hasher)->num_pending && i_ < (length)) { \
+        (hasher)->pending[(hasher)->num_pending++] = (from)[i_++]; \
+        if ((hasher)->num_pending == 4) { \
+            HASH_BLOCK((hasher)->state, (hasher)->pending[0], (hasher)->pending[1], \
+                (hasher)->pending[2], (hasher)->pending[3]); \
+            (hasher)->num_pending = 0; \
+        } \
+    } \
+    for (; i_ + 4 <= (length); i_ += 4) \
+        HASH_BLOCK((hasher)->state, (from)[i_], (from)[i_ + 1], (from)[i_ + 2], (from)[i_ + 3]); \
+    while (i_ < (length)) \
+        (hasher)->pending[(hasher)->num_pending++] = (from)[i_++]; \
+} while (0)
+
+/* Sets the seed for string hashing. This must happen before any string is
+ * hashed, as hash codes are cached in the strings. */
+void MVM_string_hash_seed(MVMThreadContext *tc, MVMuint64 seed) {
+    tc->instance->string_hash_seed = seed ^ hash_mix(seed ^ HASH_SECRET_0, HASH_SECRET_1);
+}
+
+/* Computes the hash code of a string and caches it. A hash code of 0 means
+ * that none has been cached yet, so it is never produced. */
+MVMuint32 MVM_string_compute_hash_code(MVMThreadContext *tc, MVMString *s) {
+    MVMStringIndex  length = NUM_GRAPHS(s);
+    MVMStringHasher hasher;
+    MVMStringCursor cursor;
+    MVMuint64       hash;
+
+    hasher.state       = tc->instance->string_hash_seed;
+    hasher.num_pending = 0;
+    MVM_string_cursor_init(tc, &cursor, s, 0, length);
+    while (cursor.remaining) {
+        MVMStringIndex run   = cursor_run(tc, &cursor);
+        MVMStringIndex start = cursor.piece_start + cursor.pos;
+        if (IS_WIDE(cursor.flat))
+            HASH_RUN(&hasher, cursor.flat->body.int32s + start, run);
+        else
+            HASH_RUN(&hasher, cursor.flat->body.uint8s + start, run);
+        cursor.pos       += run;
+        cursor.remaining -= run;
     }
-    s->body.flags = MVM_STRING_TYPE_INT32;
-    s->body.graphs = sgraphs;
-    s->body.int32s = buffer;
-    if (storage) free(storage); /* not thread-safe */
+
+    /* Mix in whatever is left over, padded with zeros, and the length, so
+     * that trailing zero codepoints still count. */
+    while (hasher.num_pending < 4)
+        hasher.pending[hasher.num_pending++] = 0;
+    HASH_BLOCK(hasher.state, hasher.pending[0], hasher.pending[1],
+        hasher.pending[2], hasher.pending[3]);
+    hash = hash_mix(hasher.state ^ HASH_SECRET_1, (MVMuint64)length ^ HASH_SECRET_0);
+    hash ^= hash >> 32;
+
+    s->body.cached_hash_code = (MVMuint32)hash ? (MVMuint32)hash : 1;
+    return s->body.cached_hash_code;
 }
 
 /* Escapes a string, replacing various chars like \n with \\n. Can no doubt be
@@ -1139,13 +1767,14 @@ void MVM_string_flatten(MVMThreadContext *tc, MVMString *s) {
 MVMString * MVM_string_escape(MVMThreadContext *tc, MVMString *s) {
     MVMString      *res     = NULL;
     MVMStringIndex  sgraphs = NUM_GRAPHS(s);
-    MVMStringIndex  spos    = 0;
     MVMStringIndex  balloc  = sgraphs;
     MVMCodepoint32 *buffer  = malloc(sizeof(MVMCodepoint32) * balloc);
     MVMStringIndex  bpos    = 0;
+    MVMStringCursor cursor;
 
-    for (; spos < sgraphs; spos++) {
-        MVMCodepoint32 cp = MVM_string_get_codepoint_at_nocheck(tc, s, spos);
+    MVM_string_cursor_init(tc, &cursor, s, 0, sgraphs);
+    while (cursor.remaining) {
+        MVMCodepoint32 cp = MVM_string_cursor_next(tc, &cursor);
         MVMCodepoint32 esc = 0;
         switch (cp) {
             case '\\': esc = '\\'; break;
@@ -1187,12 +1816,13 @@ MVMString * MVM_string_escape(MVMThreadContext *tc, MVMString *s) {
 MVMString * MVM_string_flip(MVMThreadContext *tc, MVMString *s) {
     MVMString      *res     = NULL;
     MVMStringIndex  sgraphs = NUM_GRAPHS(s);
-    MVMStringIndex  spos    = 0;
     MVMCodepoint32 *rbuffer = malloc(sizeof(MVMCodepoint32) * sgraphs);
     MVMStringIndex  rpos    = sgraphs;
+    MVMStringCursor cursor;
 
-    for (; spos < sgraphs; spos++)
-        rbuffer[--rpos] = MVM_string_get_codepoint_at_nocheck(tc, s, spos);
+    MVM_string_cursor_init(tc, &cursor, s, 0, sgraphs);
+    while (cursor.remaining)
+        rbuffer[--rpos] = MVM_string_cursor_next(tc, &cursor);
 
     res = (MVMString *)MVM_repr_alloc_init(tc, tc->instance->VMString);
     res->body.flags = MVM_STRING_TYPE_INT32;
@@ -1207,7 +1837,8 @@ MVMString * MVM_string_flip(MVMThreadContext *tc, MVMString *s) {
 MVMint64 MVM_string_compare(MVMThreadContext *tc, MVMString *a, MVMString *b) {
     MVMStringIndex alen = NUM_GRAPHS(a);
     MVMStringIndex blen = NUM_GRAPHS(b);
-    MVMStringIndex i, scanlen;
+    MVMStringIndex scanlen;
+    MVMStringCursor cursora, cursorb;
 
     /* Simple cases when one or both are zero length. */
     if (alen == 0)
@@ -1217,11 +1848,15 @@ MVMint64 MVM_string_compare(MVMThreadContext *tc, MVMString *a, MVMString *b) {
 
     /* Otherwise, need to scan them. */
     scanlen = alen > blen ? blen : alen;
-    for (i = 0; i < scanlen; i++) {
-        MVMCodepoint32 ai = MVM_string_get_codepoint_at_nocheck(tc, a, i);
-        MVMCodepoint32 bi = MVM_string_get_codepoint_at_nocheck(tc, b, i);
+    MVM_string_cursor_init(tc, &cursora, a, 0, scanlen);
+    MVM_string_cursor_init(tc, &cursorb, b, 0, scanlen);
+    while (cursora.remaining) {
+        MVMCodepoint32 ai = MVM_string_cursor_next(tc, &cursora);
+        MVMCodepoint32 bi = MVM_string_cursor_next(tc, &cursorb);
         if (ai != bi)
-            return ai < bi ? -1 : 1;
+            return ai < 0 || bi < 0
+                ? MVM_nfg_compare(tc, ai, bi)
+                : ai < bi ? -1 : 1;
     }
 
     /* All shared chars equal, so go on length. */
@@ -1332,8 +1967,25 @@ static MVMint64 UPV_Pi = 0;
 static MVMint64 UPV_Pf = 0;
 static MVMint64 UPV_Po = 0;
 
-/* Resolves various unicode property values that we'll need. */
+/* For each Latin-1 codepoint, the character classes it's in, as a mask of
+ * the MVM_CCLASS_* bits; filled in by MVM_string_cclass_init. */
+static MVMuint16 latin1_cclass[256];
+
+static MVMint64 codepoint_is_cclass(MVMThreadContext *tc, MVMint64 cclass, MVMCodepoint32 cp);
+
+/* Resolves various unicode property values that we'll need, and works out
+ * the Latin-1 character class and case change tables from them. */
 void MVM_string_cclass_init(MVMThreadContext *tc) {
+    static const MVMint64 cclasses[] = {
+        MVM_CCLASS_UPPERCASE, MVM_CCLASS_LOWERCASE, MVM_CCLASS_ALPHABETIC,
+        MVM_CCLASS_NUMERIC, MVM_CCLASS_HEXADECIMAL, MVM_CCLASS_WHITESPACE,
+        MVM_CCLASS_PRINTING, MVM_CCLASS_BLANK, MVM_CCLASS_CONTROL,
+        MVM_CCLASS_PUNCTUATION, MVM_CCLASS_ALPHANUMERIC, MVM_CCLASS_NEWLINE,
+        MVM_CCLASS_WORD
+    };
+    MVMCodepoint32 cp;
+    MVMuint32      i;
+
     UPV_Nd = MVM_unicode_name_to_property_value_code(tc,
         MVM_UNICODE_PROPERTY_GENERAL_CATEGORY,
         MVM_string_ascii_decode_nt(tc, tc->instance->VMString, "Nd"));
@@ -1379,20 +2031,21 @@ void MVM_string_cclass_init(MVMThreadContext *tc) {
     UPV_Po = MVM_unicode_name_to_property_value_code(tc,
         MVM_UNICODE_PROPERTY_GENERAL_CATEGORY,
         MVM_string_ascii_decode_nt(tc, tc->instance->VMString, "Po"));
-}
-
-/* Checks if the character at the specified offset is a member of the
- * indicated character class. */
-MVMint64 MVM_string_is_cclass(MVMThreadContext *tc, MVMint64 cclass, MVMString *s, MVMint64 offset) {
-    MVMCodepoint32 cp;
 
-    if (offset < 0 || offset >= NUM_GRAPHS(s))
-        return 0;
-
-    cp = MVM_string_get_codepoint_at(tc, s, offset);
-    if (cp < 0) {
-        MVM_exception_throw_adhoc(tc, "Negative character fed to cclass: '%d'", cp);
+    for (cp = 0; cp <= 0xFF; cp++) {
+        for (i = 0; i < sizeof(cclasses) / sizeof(cclasses[0]); i++)
+            if (codepoint_is_cclass(tc, cclasses[i], cp))
+                latin1_cclass[cp] |= (MVMuint16)cclasses[i];
+        for (i = 0; i < 3; i++)
+            latin1_case_change[i][cp] = MVM_unicode_get_case_change(tc, cp, i);
     }
+}
+
+/* Checks if a codepoint is a member of the indicated character class. */
+static MVMint64 codepoint_is_cclass(MVMThreadContext *tc, MVMint64 cclass, MVMCodepoint32 cp) {
+    /* A synthetic is in whatever classes its base codepoint is in. */
+    if (cp < 0)
+        cp = MVM_nfg_base_codepoint(tc, cp);
 
     switch (cclass) {
         case MVM_CCLASS_ANY:
@@ -1505,36 +2158,103 @@ MVMint64 MVM_string_is_cclass(MVMThreadContext *tc, MVMint64 cclass, MVMString *
     }
 }
 
-/* Searches for the next char that is in the specified character class. */
-MVMint64 MVM_string_find_cclass(MVMThreadContext *tc, MVMint64 cclass, MVMString *s, MVMint64 offset, MVMint64 count) {
-    MVMint64 length = NUM_GRAPHS(s);
-    MVMint64 end    = offset + count;
-    MVMint64 pos;
+/* Whether the Latin-1 table can answer for a character class: it has a
+ * bit for each of them, so any one bit will do. */
+#define LATIN1_CCLASS_OK(cclass) ((cclass) > 0 && (cclass) < MVM_CCLASS_ANY \
+    && !((cclass) & ((cclass) - 1)))
 
-    end = length < end ? length : end;
+/* Checks if the character at the specified offset is a member of the
+ * indicated character class. */
+MVMint64 MVM_string_is_cclass(MVMThreadContext *tc, MVMint64 cclass, MVMString *s, MVMint64 offset) {
+    MVMCodepoint32 cp;
 
-    for (pos = offset; pos < end; pos++)
-        if (MVM_string_is_cclass(tc, cclass, s, pos) > 0)
-            return pos;
+    if (offset < 0 || offset >= NUM_GRAPHS(s))
+        return 0;
 
-    return end;
+    cp = MVM_string_get_codepoint_at_nocheck(tc, s, offset);
+    return MVM_string_codepoint_is_cclass(tc, cclass, cp);
 }
 
-/* Searches for the next char that is not in the specified character class. */
-MVMint64 MVM_string_find_not_cclass(MVMThreadContext *tc, MVMint64 cclass, MVMString *s, MVMint64 offset, MVMint64 count) {
-    MVMint64 length = NUM_GRAPHS(s);
-    MVMint64 end    = offset + count;
-    MVMint64 pos;
+/* Checks if a codepoint is a member of the indicated character class, for
+ * callers that already have it in hand. */
+MVMint64 MVM_string_codepoint_is_cclass(MVMThreadContext *tc, MVMint64 cclass, MVMCodepoint32 cp) {
+    if (cp >= 0 && cp <= 0xFF && LATIN1_CCLASS_OK(cclass))
+        return (latin1_cclass[cp] & cclass) != 0;
+    return codepoint_is_cclass(tc, cclass, cp);
+}
+
+/* Searches from offset for the next char that is (or with negate set, is
+ * not) in the specified character class. This goes through the string a
+ * piece at a time; 8-bit pieces are done entirely by table lookups. */
+static MVMint64 find_cclass(MVMThreadContext *tc, MVMint64 cclass, MVMString *s, MVMint64 offset, MVMint64 count, MVMuint8 negate) {
+    MVMint64        length = NUM_GRAPHS(s);
+    MVMint64        end    = offset + count;
+    MVMint64        pos;
+    MVMuint8        use_table = LATIN1_CCLASS_OK(cclass);
+    MVMuint16       mask      = use_table ? (MVMuint16)cclass : 0;
+    MVMStringCursor cursor;
 
     end = length < end ? length : end;
+    if (offset >= end)
+        return end;
+
+    /* Nothing before the start of the string is in any class. */
+    if (offset < 0) {
+        if (negate)
+            return offset;
+        offset = 0;
+    }
 
-    for (pos = offset; pos < end; pos++)
-        if (MVM_string_is_cclass(tc, cclass, s, pos) == 0)
-            return pos;
+    MVM_string_cursor_init(tc, &cursor, s, offset, end - offset);
+    pos = offset;
+    while (cursor.remaining) {
+        MVMStringIndex run  = cursor_run(tc, &cursor);
+        MVMString     *flat = cursor.flat;
+        MVMStringIndex from = cursor.piece_start + cursor.pos;
+        MVMStringIndex i;
+        if (IS_ASCII(flat) && use_table) {
+            const MVMCodepoint8 *cps = flat->body.uint8s + from;
+            if (negate) {
+                for (i = 0; i < run; i++)
+                    if (!(latin1_cclass[cps[i]] & mask))
+                        return pos + i;
+            }
+            else {
+                for (i = 0; i < run; i++)
+                    if (latin1_cclass[cps[i]] & mask)
+                        return pos + i;
+            }
+        }
+        else {
+            for (i = 0; i < run; i++) {
+                MVMCodepoint32 cp = IS_ASCII(flat)
+                    ? (MVMCodepoint32)flat->body.uint8s[from + i]
+                    : flat->body.int32s[from + i];
+                MVMuint8 in_class = cp >= 0 && cp <= 0xFF && use_table
+                    ? (latin1_cclass[cp] & mask) != 0
+                    : codepoint_is_cclass(tc, cclass, cp) != 0;
+                if (in_class != negate)
+                    return pos + i;
+            }
+        }
+        cursor.pos       += run;
+        cursor.remaining -= run;
+        pos              += run;
+    }
 
     return end;
 }
 
+/* Searches for the next char that is in the specified character class. */
+MVMint64 MVM_string_find_cclass(MVMThreadContext *tc, MVMint64 cclass, MVMString *s, MVMint64 offset, MVMint64 count) {
+    return find_cclass(tc, cclass, s, offset, count, 0);
+}
+
+/* Searches for the next char that is not in the specified character class. */
+MVMint64 MVM_string_find_not_cclass(MVMThreadContext *tc, MVMint64 cclass, MVMString *s, MVMint64 offset, MVMint64 count) {
+    return find_cclass(tc, cclass, s, offset, count, 1);
+}
+
 static MVMint16   encoding_name_init         = 0;
 static MVMString *encoding_utf8_name         = NULL;
 static MVMString *encoding_ascii_name        = NULL;
@@ -46,6 +46,40 @@ struct MVMConcatState {
     MVMuint32 some_state;
 };
 
+/* Results of concatenate, substring, repeat and join shorter than this are
+ * copied into a flat string rather than made into a rope. */
+#define MVM_STRING_ROPE_MIN_GRAPHS 64
+
+/* The most strands a rope may have. Beyond this, runs of neighbouring short
+ * strands are copied into flat strings, leaving about half as many, so that
+ * finding the strand for an index stays fast. */
+#define MVM_STRING_MAX_STRANDS 64
+
+/* A cursor for going through the codepoints of (part of) a string in order.
+ * For ropes, this is much cheaper than looking up each index, as it keeps
+ * its place in the strand table. It holds pointers into the string, so
+ * nothing may allocate while one is in use. */
+struct MVMStringCursor {
+    /* The string being gone through. */
+    MVMString *string;
+
+    /* The flat string holding the current piece, the index of its first
+     * codepoint and the number of codepoints in it, and where we are in
+     * it. A piece is the part of a strand's string that it covers. */
+    MVMString      *flat;
+    MVMStringIndex  piece_start;
+    MVMStringIndex  piece_length;
+    MVMStringIndex  pos;
+
+    /* For ropes, the index of the current strand, and how many more times
+     * its piece repeats after this time. */
+    MVMStrandIndex  strand_idx;
+    MVMStringIndex  repeats_left;
+
+    /* The number of codepoints still to be gone through. */
+    MVMStringIndex  remaining;
+};
+
 /* Character class constants (map to nqp::const::CCLASS_* values). */
 #define MVM_CCLASS_ANY          65535
 #define MVM_CCLASS_UPPERCASE    1
@@ -62,6 +96,9 @@ struct MVMConcatState {
 #define MVM_CCLASS_NEWLINE      4096
 #define MVM_CCLASS_WORD         8192
 
+MVMuint8 MVM_string_traverse_substring(MVMThreadContext *tc, MVMString *a, MVMStringIndex start, MVMStringIndex length, MVMStringIndex top_index, MVMSubstringConsumer consumer, void *data);
+void MVM_string_cursor_init(MVMThreadContext *tc, MVMStringCursor *cursor, MVMString *s, MVMStringIndex start, MVMStringIndex length);
+void MVM_string_cursor_next_piece(MVMThreadContext *tc, MVMStringCursor *cursor);
 MVMCodepoint32 MVM_string_get_codepoint_at_nocheck(MVMThreadContext *tc, MVMString *a, MVMint64 index);
 MVMint64 MVM_string_equal(MVMThreadContext *tc, MVMString *a, MVMString *b);
 MVMint64 MVM_string_index(MVMThreadContext *tc, MVMString *haystack, MVMString *needle, MVMint64 start);
@@ -76,6 +113,7 @@ MVMint64 MVM_string_equal_at(MVMThreadContext *tc, MVMString *a, MVMString *b, M
 MVMint64 MVM_string_equal_at_ignore_case(MVMThreadContext *tc, MVMString *a, MVMString *b, MVMint64 offset);
 MVMint64 MVM_string_have_at(MVMThreadContext *tc, MVMString *a, MVMint64 starta, MVMint64 length, MVMString *b, MVMint64 startb);
 MVMint64 MVM_string_get_codepoint_at(MVMThreadContext *tc, MVMString *a, MVMint64 index);
+MVMint64 MVM_string_codes(MVMThreadContext *tc, MVMString *s);
 MVMint64 MVM_string_index_of_codepoint(MVMThreadContext *tc, MVMString *a, MVMint64 codepoint);
 MVMString * MVM_string_uc(MVMThreadContext *tc, MVMString *s);
 MVMString * MVM_string_lc(MVMThreadContext *tc, MVMString *s);
@@ -90,10 +128,14 @@ MVMint64 MVM_string_char_at_in_string(MVMThreadContext *tc, MVMString *a, MVMint
 MVMint64 MVM_string_offset_has_unicode_property_value(MVMThreadContext *tc, MVMString *s, MVMint64 offset, MVMint64 property_code, MVMint64 property_value_code);
 MVMint64 MVM_unicode_codepoint_has_property_value(MVMThreadContext *tc, MVMCodepoint32 codepoint, MVMint64 property_code, MVMint64 property_value_code);
 MVMString * MVM_unicode_codepoint_get_property_str(MVMThreadContext *tc, MVMCodepoint32 codepoint, MVMint64 property_code);
+const char * MVM_unicode_codepoint_get_property_cstr(MVMThreadContext *tc, MVMCodepoint32 codepoint, MVMint64 property_code);
 MVMint64 MVM_unicode_codepoint_get_property_int(MVMThreadContext *tc, MVMCodepoint32 codepoint, MVMint64 property_code);
 MVMint64 MVM_unicode_codepoint_get_property_bool(MVMThreadContext *tc, MVMCodepoint32 codepoint, MVMint64 property_code);
 MVMString * MVM_unicode_get_name(MVMThreadContext *tc, MVMint64 codepoint);
 void MVM_string_flatten(MVMThreadContext *tc, MVMString *s);
+MVMint32 MVM_string_hash_key_match(const void *a, unsigned alen, const void *b, unsigned blen);
+void MVM_string_hash_seed(MVMThreadContext *tc, MVMuint64 seed);
+MVMuint32 MVM_string_compute_hash_code(MVMThreadContext *tc, MVMString *s);
 MVMString * MVM_string_escape(MVMThreadContext *tc, MVMString *s);
 MVMString * MVM_string_flip(MVMThreadContext *tc, MVMString *s);
 MVMint64 MVM_string_compare(MVMThreadContext *tc, MVMString *a, MVMString *b);
@@ -102,6 +144,27 @@ MVMString * MVM_string_bitor(MVMThreadContext *tc, MVMString *a, MVMString *b);
 MVMString * MVM_string_bitxor(MVMThreadContext *tc, MVMString *a, MVMString *b);
 void MVM_string_cclass_init(MVMThreadContext *tc);
 MVMint64 MVM_string_is_cclass(MVMThreadContext *tc, MVMint64 cclass, MVMString *s, MVMint64 offset);
+MVMint64 MVM_string_codepoint_is_cclass(MVMThreadContext *tc, MVMint64 cclass, MVMCodepoint32 cp);
 MVMint64 MVM_string_find_cclass(MVMThreadContext *tc, MVMint64 cclass, MVMString *s, MVMint64 offset, MVMint64 count);
 MVMint64 MVM_string_find_not_cclass(MVMThreadContext *tc, MVMint64 cclass, MVMString *s, MVMint64 offset, MVMint64 count);
 MVMuint8 MVM_string_find_encoding(MVMThreadContext *tc, MVMString *name);
+
+/* Gets a string's hash code, computing it if it's not cached yet. */
+MVM_STATIC_INLINE MVMuint32 MVM_string_hash_code(MVMThreadContext *tc, MVMString *s) {
+    return s->body.cached_hash_code
+        ? s->body.cached_hash_code
+        : MVM_string_compute_hash_code(tc, s);
+}
+
+/* Gets the next codepoint from a cursor. The caller must check there are
+ * any left first. */
+MVM_STATIC_INLINE MVMCodepoint32 MVM_string_cursor_next(MVMThreadContext *tc, MVMStringCursor *cursor) {
+    MVMStringIndex idx;
+    if (cursor->pos == cursor->piece_length)
+        MVM_string_cursor_next_piece(tc, cursor);
+    cursor->remaining--;
+    idx = cursor->piece_start + cursor->pos++;
+    return IS_WIDE(cursor->flat)
+        ? cursor->flat->body.int32s[idx]
+        : (MVMCodepoint32)cursor->flat->body.uint8s[idx];
+}
@@ -32,30 +32,37 @@ MVMString * MVM_unicode_get_name(MVMThreadContext *tc, MVMint64 codepoint) {
     return MVM_string_ascii_decode(tc, tc->instance->VMString, name, strlen(name));
 }
 
+/* Property lookups on a synthetic are done on its base codepoint. */
 MVMString * MVM_unicode_codepoint_get_property_str(MVMThreadContext *tc, MVMCodepoint32 codepoint, MVMint64 property_code) {
-    const char *s = MVM_unicode_get_property_str(tc, codepoint, property_code);
+    const char *s = MVM_unicode_get_property_str(tc, MVM_nfg_base_codepoint(tc, codepoint), property_code);
     if (!s)
 	s = "";
     return MVM_string_ascii_decode(tc, tc->instance->VMString, s, strlen(s));
 }
 
+/* Gets a string property of a codepoint as a C string, for use within the
+ * VM. It must not be freed. */
+const char * MVM_unicode_codepoint_get_property_cstr(MVMThreadContext *tc, MVMCodepoint32 codepoint, MVMint64 property_code) {
+    return MVM_unicode_get_property_str(tc, codepoint, property_code);
+}
+
 MVMint64 MVM_unicode_codepoint_get_property_int(MVMThreadContext *tc, MVMCodepoint32 codepoint, MVMint64 property_code) {
     if (property_code == 0)
         return 0;
-    return (MVMint64)MVM_unicode_get_property_int(tc, codepoint, property_code);
+    return (MVMint64)MVM_unicode_get_property_int(tc, MVM_nfg_base_codepoint(tc, codepoint), property_code);
 }
 
 MVMint64 MVM_unicode_codepoint_get_property_bool(MVMThreadContext *tc, MVMCodepoint32 codepoint, MVMint64 property_code) {
     if (property_code == 0)
         return 0;
-    return (MVMint64)MVM_unicode_get_property_int(tc, codepoint, property_code) != 0;
+    return (MVMint64)MVM_unicode_get_property_int(tc, MVM_nfg_base_codepoint(tc, codepoint), property_code) != 0;
 }
 
 MVMint64 MVM_unicode_codepoint_has_property_value(MVMThreadContext *tc, MVMCodepoint32 codepoint, MVMint64 property_code, MVMint64 property_value_code) {
     if (property_code == 0)
         return 0;
     return (MVMint64)MVM_unicode_get_property_int(tc,
-        codepoint, property_code) == property_value_code ? 1 : 0;
+        MVM_nfg_base_codepoint(tc, codepoint), property_code) == property_value_code ? 1 : 0;
 }
 
 MVMCodepoint32 MVM_unicode_get_case_change(MVMThreadContext *tc, MVMCodepoint32 codepoint, MVMint32 case_) {
@@ -13,6 +13,7 @@ MVMString * MVM_string_utf16_decode(MVMThreadContext *tc,
     MVMString *result = (MVMString *)REPR(result_type)->allocate(tc, STABLE(result_type));
     size_t byte_pos = 0;
     size_t str_pos = 0;
+    MVMint32 needs_nfg = 0;
     MVMuint8 *utf16_end;
     /* set the default byte order */
 #ifdef MVM_BIGENDIAN
@@ -73,15 +74,37 @@ MVMString * MVM_string_utf16_decode(MVMThreadContext *tc,
         }
         /* TODO: check for invalid values */
         result->body.int32s[str_pos++] = (MVMint32)value;
+        if (value >= MVM_NFG_QUICK_CHECK_MIN)
+            needs_nfg = 1;
+    }
+
+    /* Put it in NFG if anything in it might need that. */
+    if (needs_nfg) {
+        MVMint64 num_graphs;
+        MVMCodepoint32 *graphs = MVM_nfg_normalize(tc, result->body.int32s, str_pos, &num_graphs);
+        free(result->body.int32s);
+        result->body.int32s = graphs;
+        str_pos = num_graphs;
     }
 
-    /* result->body.codes  = str_pos; */
     result->body.flags = MVM_STRING_TYPE_INT32;
     result->body.graphs = str_pos;
 
     return result;
 }
 
+/* Writes a codepoint as UTF-16, returning the position after it. */
+static MVMuint16 * utf16_encode_codepoint(MVMuint16 *result_pos, MVMCodepoint32 value) {
+    if (value < 0x10000) {
+        result_pos[0] = value;
+        return result_pos + 1;
+    }
+    value -= 0x10000;
+    result_pos[0] = 0xD800 + (value >> 10);
+    result_pos[1] = 0xDC00 + (value & 0x3FF);
+    return result_pos + 2;
+}
+
 /* Encodes the specified substring to utf16. The result string is NULL terminated, but
  * the specified size is the non-null part. (This being UTF-16, there are 2 null bytes
  * on the end.) */
@@ -90,7 +113,7 @@ MVMuint8 * MVM_string_utf16_encode_substr(MVMThreadContext *tc, MVMString *str,
     MVMStringIndex strgraphs = NUM_GRAPHS(str);
     MVMuint32 lengthu = (MVMuint32)(length == -1 ? strgraphs - start : length);
     MVMuint16 *result;
-    size_t str_pos;
+    size_t str_pos, alloc;
     MVMuint16 *result_pos;
 
     /* must check start first since it's used in the length check */
@@ -99,21 +122,30 @@ MVMuint8 * MVM_string_utf16_encode_substr(MVMThreadContext *tc, MVMString *str,
     if (length < 0 || start + length > strgraphs)
         MVM_exception_throw_adhoc(tc, "length out of range");
 
-    /* make the result grow as needed instead of allocating so much to start? */
-    result = malloc(length * 4 + 2);
+    /* Room for two units per grapheme, which is enough unless there are
+     * synthetics, in which case it grows as needed. */
+    alloc = length * 2 + 1;
+    result = malloc(alloc * sizeof(MVMuint16));
     result_pos = result;
     for (str_pos = 0; str_pos < length; str_pos++) {
         MVMCodepoint32 value = MVM_string_get_codepoint_at_nocheck(tc, str, start + str_pos);
 
-        if (value < 0x10000) {
-            result_pos[0] = value;
-            result_pos++;
+        if (value >= 0) {
+            result_pos = utf16_encode_codepoint(result_pos, value);
         }
         else {
-            value -= 0x10000;
-            result_pos[0] = 0xD800 + (value >> 10);
-            result_pos[1] = 0xDC00 + (value & 0x3FF);
-            result_pos += 2;
+            MVMNFGSynthetic *synth = MVM_nfg_get_synthetic_info(tc, value);
+            size_t used   = result_pos - result;
+            size_t needed = used + (synth->num_combs + 1) * 2 + (length - str_pos - 1) * 2 + 1;
+            MVMint32 i;
+            if (needed > alloc) {
+                alloc  = needed > alloc * 2 ? needed : alloc * 2;
+                result = realloc(result, alloc * sizeof(MVMuint16));
+                result_pos = result + used;
+            }
+            result_pos = utf16_encode_codepoint(result_pos, synth->base);
+            for (i = 0; i < synth->num_combs; i++)
+                result_pos = utf16_encode_codepoint(result_pos, synth->combs[i]);
         }
     }
     result_pos[0] = 0;
@@ -184,26 +184,71 @@ static void *utf8_encode(void *bytes, MVMCodepoint32 cp)
  /* end not_gerd section */
 
 #define UTF8_MAXINC (32 * 1024 * 1024)
+
+/* Finds how many bytes at the start of a buffer are ASCII. This goes a word
+ * at a time while it can, checking the high bit of all of its bytes at once,
+ * which is about as fast as a vectorized scan for the lengths we see here
+ * while staying portable. */
+static size_t ascii_run_length(const MVMuint8 *bytes, size_t length) {
+    size_t pos = 0;
+    while (pos + sizeof(MVMuint64) <= length) {
+        MVMuint64 word;
+        memcpy(&word, bytes + pos, sizeof(MVMuint64));
+        if (word & 0x8080808080808080ULL)
+            break;
+        pos += sizeof(MVMuint64);
+    }
+    while (pos < length && bytes[pos] < 0x80)
+        pos++;
+    return pos;
+}
+
 /* Decodes the specified number of bytes of utf8 into an NFG string, creating
  * a result of the specified type. The type must have the MVMString REPR.
- * Only bring in the raw codepoints for now. */
+ * Input that is all ASCII is just copied into an 8-bit string; otherwise
+ * runs of ASCII are still copied directly, and only the rest goes through
+ * the decoder. Only if some codepoint is at or beyond
+ * MVM_NFG_QUICK_CHECK_MIN is the result normalized. If nothing is beyond
+ * Latin-1, the result still gets 8-bit storage. */
 MVMString * MVM_string_utf8_decode(MVMThreadContext *tc, MVMObject *result_type, const MVMuint8 *utf8, size_t bytes) {
     MVMString *result = (MVMString *)REPR(result_type)->allocate(tc, STABLE(result_type));
     MVMint32 count = 0;
     MVMCodepoint32 codepoint;
+    MVMCodepoint32 all_codepoints = 0;
+    MVMint32 needs_nfg = 0;
     MVMint32 line_ending = 0;
     MVMint32 state = 0;
     MVMint32 bufsize = bytes;
-    MVMint32 *buffer = malloc(sizeof(MVMint32) * bufsize);
+    MVMint32 *buffer;
     size_t orig_bytes;
     const char *orig_utf8;
     MVMint32 line;
     MVMint32 col;
 
+    /* Fast path for all ASCII. */
+    if (ascii_run_length(utf8, bytes) == bytes) {
+        result->body.uint8s = malloc(bytes ? bytes : 1);
+        memcpy(result->body.uint8s, utf8, bytes);
+        result->body.flags  = MVM_STRING_TYPE_UINT8;
+        result->body.graphs = bytes;
+        return result;
+    }
+
+    buffer = malloc(sizeof(MVMint32) * bufsize);
     orig_bytes = bytes;
     orig_utf8 = utf8;
 
-    for (; bytes; ++utf8, --bytes) {
+    while (bytes) {
+        /* Copy over any run of ASCII in one go. The buffer is big enough,
+         * since it has room for as many codepoints as there are bytes. */
+        if (state == UTF8_ACCEPT && *utf8 < 0x80) {
+            size_t run = ascii_run_length(utf8, bytes), i;
+            for (i = 0; i < run; i++)
+                buffer[count++] = utf8[i];
+            utf8  += run;
+            bytes -= run;
+            continue;
+        }
         switch(decode_utf8_byte(&state, &codepoint, *utf8)) {
         case UTF8_ACCEPT: /* got a codepoint */
             if (count == bufsize) { /* if the buffer's full make a bigger one */
@@ -212,6 +257,9 @@ MVMString * MVM_string_utf8_decode(MVMThreadContext *tc, MVMObject *result_type,
                 ));
             }
             buffer[count++] = codepoint;
+            all_codepoints |= codepoint;
+            if (codepoint >= MVM_NFG_QUICK_CHECK_MIN)
+                needs_nfg = 1;
             break;
         case UTF8_REJECT:
             /* found a malformed sequence; parse it again this time tracking
@@ -245,10 +293,36 @@ MVMString * MVM_string_utf8_decode(MVMThreadContext *tc, MVMObject *result_type,
             MVM_exception_throw_adhoc(tc, "Concurrent modification of UTF-8 input buffer!");
             break;
         }
+        ++utf8;
+        --bytes;
     }
     if (state != UTF8_ACCEPT)
         MVM_exception_throw_adhoc(tc, "Malformed termination of UTF-8 string");
 
+    /* Put it in NFG if anything in it might need that. */
+    if (needs_nfg) {
+        MVMint64 num_graphs, i;
+        MVMCodepoint32 *graphs = MVM_nfg_normalize(tc, buffer, count, &num_graphs);
+        free(buffer);
+        buffer = graphs;
+        count = bufsize = (MVMint32)num_graphs;
+        all_codepoints = 0;
+        for (i = 0; i < count; i++)
+            all_codepoints |= buffer[i];
+    }
+
+    /* If everything fits in 8 bits, store it that way. */
+    if (!(all_codepoints & ~0xFF)) {
+        MVMint32 i;
+        result->body.uint8s = malloc(count);
+        for (i = 0; i < count; i++)
+            result->body.uint8s[i] = (MVMCodepoint8)buffer[i];
+        free(buffer);
+        result->body.flags  = MVM_STRING_TYPE_UINT8;
+        result->body.graphs = count;
+        return result;
+    }
+
     /* just keep the same buffer as the MVMString's buffer.  Later
      * we can add heuristics to resize it if we have enough free
      * memory */
@@ -257,10 +331,8 @@ MVMString * MVM_string_utf8_decode(MVMThreadContext *tc, MVMObject *result_type,
         bufsize = count;
     }
     result->body.int32s = buffer;
-
-    /* XXX set codes */
     result->body.flags = MVM_STRING_TYPE_INT32;
-    result->body.graphs = count; /* XXX Ignore combining chars for now. */
+    result->body.graphs = count;
 
     return result;
 }
@@ -333,14 +405,154 @@ void MVM_string_utf8_decodestream(MVMThreadContext *tc, MVMDecodeStream *ds,
     MVM_string_decodestream_discard_to(tc, ds, last_accept_bytes, last_accept_pos);
 }
 
+/* Gets the number of bytes a codepoint takes up in UTF-8, or 0 if it can't
+ * be encoded. */
+static size_t utf8_encoded_length(MVMCodepoint32 cp) {
+    unsigned cc;
+    if ((MVMuint32)cp < 0x80)
+        return 1;
+    cc = classify(cp);
+    if (!(cc & CP_CHAR))
+        return 0;
+    return cc & U8_SINGLE ? 1 : cc & U8_DOUBLE ? 2 : cc & U8_TRIPLE ? 3 : 4;
+}
+
+/* Gets the number of bytes a grapheme takes up in UTF-8, which for a
+ * synthetic is that of all its codepoints, or 0 if it can't be encoded. */
+static size_t utf8_grapheme_length(MVMThreadContext *tc, MVMCodepoint32 g) {
+    MVMNFGSynthetic *synth;
+    size_t length, comb_length;
+    MVMint32 i;
+    if (g >= 0)
+        return utf8_encoded_length(g);
+    synth  = MVM_nfg_get_synthetic_info(tc, g);
+    length = utf8_encoded_length(synth->base);
+    for (i = 0; i < synth->num_combs && length; i++) {
+        comb_length = utf8_encoded_length(synth->combs[i]);
+        length = comb_length ? length + comb_length : 0;
+    }
+    return length;
+}
+
+/* Encodes a synthetic as its base codepoint followed by its combiners. */
+static MVMuint8 * utf8_encode_synthetic(MVMThreadContext *tc, MVMuint8 *output, MVMCodepoint32 g) {
+    MVMNFGSynthetic *synth = MVM_nfg_get_synthetic_info(tc, g);
+    MVMint32 i;
+    output = utf8_encode(output, synth->base);
+    for (i = 0; i < synth->num_combs; i++)
+        output = utf8_encode(output, synth->combs[i]);
+    return output;
+}
+
+/* Substring consumers for encoding. Both branch on the storage of each
+ * physical string, so that 8-bit strings are handled a run of ASCII at a
+ * time, and only codepoints beyond ASCII are encoded one by one. */
+typedef struct MVMUTF8EncodeState {
+    MVMuint64      size;
+    MVMStringIndex position;
+    MVMuint8      *output;
+} MVMUTF8EncodeState;
+
+static MVM_SUBSTRING_CONSUMER(utf8_size_consumer) {
+    MVMUTF8EncodeState *state = (MVMUTF8EncodeState *)data;
+    MVMStringIndex i;
+    switch (STR_FLAGS(string)) {
+        case MVM_STRING_TYPE_UINT8: {
+            const MVMuint8 *from = string->body.uint8s + start;
+            state->size += length;
+            for (i = 0; i < length; i++) {
+                i += ascii_run_length(from + i, length - i);
+                if (i < length)
+                    state->size++;
+            }
+            break;
+        }
+        case MVM_STRING_TYPE_INT32: {
+            const MVMCodepoint32 *from = string->body.int32s + start;
+            for (i = 0; i < length; i++) {
+                size_t cp_length = utf8_grapheme_length(tc, from[i]);
+                if (!cp_length)
+                    MVM_exception_throw_adhoc(tc,
+                        "Error encoding UTF-8 string near grapheme position %d with codepoint %d",
+                            (int)(state->position + i), from[i]);
+                state->size += cp_length;
+            }
+            break;
+        }
+        default:
+            MVM_exception_throw_adhoc(tc, "internal string corruption");
+    }
+    state->position += length;
+    return 0;
+}
+
+static MVM_SUBSTRING_CONSUMER(utf8_encode_consumer) {
+    MVMUTF8EncodeState *state = (MVMUTF8EncodeState *)data;
+    MVMuint8 *output = state->output;
+    MVMStringIndex i;
+    switch (STR_FLAGS(string)) {
+        case MVM_STRING_TYPE_UINT8: {
+            const MVMuint8 *from = string->body.uint8s + start;
+            for (i = 0; i < length; i++) {
+                size_t run = ascii_run_length(from + i, length - i);
+                memcpy(output, from + i, run);
+                output += run;
+                i      += run;
+                if (i < length) {
+                    output[0] = 0xC0 | (from[i] >> 6);
+                    output[1] = 0x80 | (from[i] & 0x3F);
+                    output   += 2;
+                }
+            }
+            break;
+        }
+        case MVM_STRING_TYPE_INT32: {
+            const MVMCodepoint32 *from = string->body.int32s + start;
+            for (i = 0; i < length; i++) {
+                if ((MVMuint32)from[i] < 0x80)
+                    *output++ = (MVMuint8)from[i];
+                else if (from[i] < 0)
+                    output = utf8_encode_synthetic(tc, output, from[i]);
+                else
+                    output = utf8_encode(output, from[i]);
+            }
+            break;
+        }
+        default:
+            MVM_exception_throw_adhoc(tc, "internal string corruption");
+    }
+    state->output = output;
+    return 0;
+}
+
+/* Gets the number of bytes that the specified part of a string takes up in
+ * UTF-8, throwing if anything in it can't be encoded. */
+MVMuint64 MVM_string_utf8_encode_size(MVMThreadContext *tc, MVMString *str, MVMint64 start, MVMint64 length) {
+    MVMUTF8EncodeState state;
+    state.size     = 0;
+    state.position = start;
+    if (length)
+        MVM_string_traverse_substring(tc, str, start, length, 0, utf8_size_consumer, &state);
+    return state.size;
+}
+
+/* Encodes the specified part of a string to UTF-8 into a buffer supplied by
+ * the caller, which must be at least as big as MVM_string_utf8_encode_size
+ * says, having checked that it can be encoded. Returns the position after
+ * the last byte written. */
+MVMuint8 * MVM_string_utf8_encode_into(MVMThreadContext *tc, MVMString *str, MVMint64 start, MVMint64 length, MVMuint8 *buffer) {
+    MVMUTF8EncodeState state;
+    state.output = buffer;
+    if (length)
+        MVM_string_traverse_substring(tc, str, start, length, 0, utf8_encode_consumer, &state);
+    return state.output;
+}
+
 /* Encodes the specified string to UTF-8. */
 MVMuint8 * MVM_string_utf8_encode_substr(MVMThreadContext *tc,
         MVMString *str, MVMuint64 *output_size, MVMint64 start, MVMint64 length) {
-    /* XXX This is terribly wrong when we get to doing NFG properly too. One graph may
-     * expand to loads of codepoints and overflow the buffer. */
     MVMuint8 *result;
-    MVMuint8 *arr;
-    size_t i = start;
+    MVMuint64 size;
     MVMStringIndex strgraphs = NUM_GRAPHS(str);
 
     if (length == -1)
@@ -352,19 +564,16 @@ MVMuint8 * MVM_string_utf8_encode_substr(MVMThreadContext *tc,
     if (length < 0 || start + length > strgraphs)
         MVM_exception_throw_adhoc(tc, "length out of range");
 
-    /* give it two spaces for padding in case `say` wants to append a \r\n or \n */
-    result = malloc(sizeof(MVMint32) * length + 2);
-    arr = result;
-
-    memset(result, 0, sizeof(MVMint32) * length + 2);
-    while (i < length && (arr = utf8_encode(arr, MVM_string_get_codepoint_at_nocheck(tc, str, i++))));
-    if (!arr)
-        MVM_exception_throw_adhoc(tc,
-            "Error encoding UTF-8 string near grapheme position %d with codepoint %d",
-                i - 1, MVM_string_get_codepoint_at_nocheck(tc, str, i-1));
+    /* Size it exactly, then encode into it. Give it two spaces for padding
+     * in case `say` wants to append a \r\n or \n, which also leaves it
+     * NUL-terminated for those using it as a C string. */
+    size   = MVM_string_utf8_encode_size(tc, str, start, length);
+    result = malloc(size + 2);
+    MVM_string_utf8_encode_into(tc, str, start, length, result);
+    result[size] = result[size + 1] = 0;
 
     if (output_size)
-        *output_size = (MVMuint64)(arr ? arr - result : 0);
+        *output_size = size;
 
     return result;
 }
@@ -43,30 +43,39 @@ typedef struct MVMFrame MVMFrame;
 typedef struct MVMFrameHandler MVMFrameHandler;
 typedef struct MVMGen2Allocator MVMGen2Allocator;
 typedef struct MVMGen2SizeClass MVMGen2SizeClass;
+typedef struct MVMGCBarrier MVMGCBarrier;
 typedef struct MVMGCPassedWork MVMGCPassedWork;
+typedef struct MVMGCRunStats MVMGCRunStats;
+typedef struct MVMGCStats MVMGCStats;
+typedef struct MVMGCTotals MVMGCTotals;
 typedef struct MVMGCWorklist MVMGCWorklist;
 typedef struct MVMHash MVMHash;
 typedef struct MVMHashAttrStore MVMHashAttrStore;
 typedef struct MVMHashAttrStoreBody MVMHashAttrStoreBody;
 typedef struct MVMHashBody MVMHashBody;
-typedef struct MVMHashEntry MVMHashEntry;
 typedef struct MVMHLLConfig MVMHLLConfig;
 typedef struct MVMIntConstCache MVMIntConstCache;
 typedef struct MVMInstance MVMInstance;
 typedef struct MVMInvocationSpec MVMInvocationSpec;
 typedef struct MVMIter MVMIter;
 typedef struct MVMIterBody MVMIterBody;
+typedef struct MVMJitCode MVMJitCode;
+typedef struct MVMJitGuard MVMJitGuard;
 typedef struct MVMKnowHOWAttributeREPR MVMKnowHOWAttributeREPR;
 typedef struct MVMKnowHOWAttributeREPRBody MVMKnowHOWAttributeREPRBody;
 typedef struct MVMKnowHOWREPR MVMKnowHOWREPR;
 typedef struct MVMKnowHOWREPRBody MVMKnowHOWREPRBody;
-typedef struct MVMLexicalRegistry MVMLexicalRegistry;
 typedef struct MVMLexotic MVMLexotic;
 typedef struct MVMLexoticBody MVMLexoticBody;
 typedef struct MVMLoadedCompUnitName MVMLoadedCompUnitName;
 typedef struct MVMNFA MVMNFA;
 typedef struct MVMNFABody MVMNFABody;
+typedef struct MVMNFAScratch MVMNFAScratch;
 typedef struct MVMNFAStateInfo MVMNFAStateInfo;
+typedef struct MVMNFGComposition MVMNFGComposition;
+typedef struct MVMNFGState MVMNFGState;
+typedef struct MVMNFGSynthetic MVMNFGSynthetic;
+typedef struct MVMNFGTable MVMNFGTable;
 typedef struct MVMNativeCall MVMNativeCall;
 typedef struct MVMNativeCallBody MVMNativeCallBody;
 typedef struct MVMNull MVMNull;
@@ -140,13 +149,18 @@ typedef struct MVMSpeshCode MVMSpeshCode;
 typedef struct MVMSpeshCandidate MVMSpeshCandidate;
 typedef struct MVMSpeshGuard MVMSpeshGuard;
 typedef struct MVMSpeshCallInfo MVMSpeshCallInfo;
+typedef struct MVMSpeshInline MVMSpeshInline;
+typedef struct MVMSpeshWorkItem MVMSpeshWorkItem;
 typedef struct MVMSTable MVMSTable;
 typedef struct MVMStaticFrame MVMStaticFrame;
 typedef struct MVMStaticFrameBody MVMStaticFrameBody;
 typedef struct MVMStorageSpec MVMStorageSpec;
 typedef struct MVMStrand MVMStrand;
+typedef struct MVMStrHashEntry MVMStrHashEntry;
+typedef struct MVMStrHashTable MVMStrHashTable;
 typedef struct MVMString MVMString;
 typedef struct MVMStringBody MVMStringBody;
+typedef struct MVMStringCursor MVMStringCursor;
 typedef struct MVMStringConsts MVMStringConsts;
 typedef struct MVMThread MVMThread;
 typedef struct MVMThreadBody MVMThreadBody;
@@ -171,5 +185,6 @@ typedef struct MVMIOSyncPipeData MVMIOSyncPipeData;
 typedef struct MVMDecodeStream MVMDecodeStream;
 typedef struct MVMDecodeStreamBytes MVMDecodeStreamBytes;
 typedef struct MVMDecodeStreamChars MVMDecodeStreamChars;
+typedef struct MVMDecodeStreamSeparator MVMDecodeStreamSeparator;
 typedef struct MVMNativeCallback MVMNativeCallback;
 typedef struct MVMNativeCallbackCacheHead MVMNativeCallbackCacheHead;
@@ -0,0 +1,141 @@
+# -*- coding: utf8 -*-
+
+# Summarizes a heap snapshot written by the heapsnapshot op, showing how many
+# live collectables of each type there were and how much space they took up.
+#
+#     python tools/heapsnapshot.py [--top N] [--by-repr] snapshot.bin
+#
+# Types are shown by their REPR, along with the handle of the SC the type
+# lives in and its index there, which is usually enough to find it in the
+# compiler's output. The format is described in docs/gc.markdown.
+
+from __future__ import print_function
+
+import argparse
+import sys
+from collections import defaultdict
+
+MAGIC = b"MOARHEAP"
+VERSION = 1
+
+
+class Reader(object):
+    def __init__(self, data):
+        self.data = data
+        self.pos = 0
+
+    def byte(self):
+        b = self.data[self.pos]
+        self.pos += 1
+        return b if isinstance(b, int) else ord(b)
+
+    def uint(self):
+        result = 0
+        shift = 0
+        while True:
+            b = self.byte()
+            result |= (b & 0x7F) << shift
+            if not b & 0x80:
+                return result
+            shift += 7
+
+    def str(self):
+        length = self.uint()
+        s = self.data[self.pos:self.pos + length]
+        self.pos += length
+        return s.decode("utf-8", "replace")
+
+
+class Collectable(object):
+    __slots__ = ("kind", "st", "repr", "size", "sc", "sc_idx", "refs")
+
+
+def read_snapshot(data):
+    r = Reader(data)
+    if data[:len(MAGIC)] != MAGIC:
+        raise ValueError("not a MoarVM heap snapshot")
+    r.pos = len(MAGIC)
+    version = r.uint()
+    if version != VERSION:
+        raise ValueError("unsupported heap snapshot version %d" % version)
+
+    scs = {}
+    collectables = {}
+    while True:
+        tag = chr(r.byte())
+        if tag == "E":
+            break
+        if tag == "C":
+            idx = r.uint()
+            scs[idx] = r.str()
+            continue
+        if tag not in "OTS":
+            raise ValueError("unknown record tag %r at offset %d" % (tag, r.pos - 1))
+        c = Collectable()
+        c.kind = tag
+        addr = r.uint()
+        if tag == "S":
+            c.st = addr
+            c.repr = r.str()
+        else:
+            c.st = r.uint()
+            c.repr = None
+        c.size = r.uint()
+        c.sc = r.uint()
+        c.sc_idx = r.uint() if c.sc else None
+        c.refs = [r.uint() for _ in range(r.uint())]
+        collectables[addr] = c
+    return scs, collectables
+
+
+def type_name(st_addr, scs, collectables):
+    st = collectables.get(st_addr)
+    if st is None:
+        return "<unknown STable 0x%x>" % st_addr
+    if st.sc:
+        return "%s (%s #%d)" % (st.repr, scs.get(st.sc, "SC %d" % st.sc), st.sc_idx)
+    return "%s (0x%x)" % (st.repr, st_addr)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Summarize a MoarVM heap snapshot.")
+    parser.add_argument("snapshot")
+    parser.add_argument("--top", type=int, default=30,
+                        help="how many types to show (default 30)")
+    parser.add_argument("--by-repr", action="store_true",
+                        help="group by REPR rather than by type")
+    args = parser.parse_args()
+
+    with open(args.snapshot, "rb") as fh:
+        scs, collectables = read_snapshot(fh.read())
+
+    counts = defaultdict(int)
+    sizes = defaultdict(int)
+    refs = defaultdict(int)
+    total_size = 0
+    for c in collectables.values():
+        if c.kind == "S":
+            key = "STable"
+        elif args.by_repr:
+            st = collectables.get(c.st)
+            key = st.repr if st else "<unknown>"
+        else:
+            key = ("type", c.st)
+        if c.kind == "T":
+            key = "type object"
+        counts[key] += 1
+        sizes[key] += c.size
+        refs[key] += len(c.refs)
+        total_size += c.size
+
+    print("%d live collectables, %d bytes, %d SCs" % (len(collectables), total_size, len(scs)))
+    print()
+    print("%10s %12s %7s %10s  %s" % ("count", "bytes", "%", "refs", "type"))
+    for key in sorted(sizes, key=lambda k: sizes[k], reverse=True)[:args.top]:
+        name = type_name(key[1], scs, collectables) if isinstance(key, tuple) else key
+        print("%10d %12d %6.2f%% %10d  %s" % (
+            counts[key], sizes[key], 100.0 * sizes[key] / (total_size or 1), refs[key], name))
+
+
+if __name__ == "__main__":
+    sys.exit(main())